@@ -90,6 +90,75 @@ if len(os.sys.argv) == 3:
 			print('Failed reading file: %s, skipping scoping.' % os.sys.argv[2])
 			pass
 
+
+def param_name_hash(name, seed):
+	"""
+	32 bit FNV-1a hash of a parameter name, must match param_name_hash() in param.c
+	"""
+	h = (0x811c9dc5 ^ seed) & 0xffffffff
+	for c in name.encode('ascii'):
+		if not isinstance(c, int): # python 2
+			c = ord(c)
+		h ^= c
+		h = (h * 0x01000193) & 0xffffffff
+	return h
+
+
+def generate_perfect_hash(names):
+	"""
+	Build a minimal perfect hash over the parameter names (hash and displace).
+	Returns (displacement, index): a name is looked up by taking its bucket
+	b = hash(name, 0) % size. If displacement[b] < 0, the slot is
+	-displacement[b] - 1, otherwise hash(name, displacement[b]) % size.
+	index[slot] is the parameter index.
+	"""
+	size = max(len(names), 1)
+	buckets = [[] for _ in range(size)]
+	for i, name in enumerate(names):
+		buckets[param_name_hash(name, 0) % size].append(i)
+
+	displacement = [0] * size
+	index = [None] * size
+
+	# place the large buckets first, searching a seed that maps all their names to free slots
+	order = sorted(range(size), key=lambda b: len(buckets[b]), reverse=True)
+	for b in order:
+		bucket = buckets[b]
+		if len(bucket) <= 1:
+			break
+		# displacements are stored as int16_t
+		for d in range(1, 0x8000):
+			slots = [param_name_hash(names[i], d) % size for i in bucket]
+			if len(set(slots)) == len(slots) and all(index[s] is None for s in slots):
+				break
+		else:
+			raise Exception("Failed to generate parameter hash")
+		displacement[b] = d
+		for i, s in zip(bucket, slots):
+			index[s] = i
+
+	# buckets with a single name directly reference a free slot
+	free_slots = [s for s in range(size) if index[s] is None]
+	for b in order:
+		if len(buckets[b]) == 1:
+			s = free_slots.pop()
+			displacement[b] = -s - 1
+			index[s] = buckets[b][0]
+
+	index = [i if i is not None else 0 for i in index]
+	return displacement, index
+
+
+def format_table(values, per_line=16):
+	"""
+	Format a list of integers as the body of a C array initializer
+	"""
+	lines = []
+	for i in range(0, len(values), per_line):
+		lines.append(", ".join(str(v) for v in values[i:i + per_line]))
+	return ",\n\t".join(lines)
+
+
 fp_header = open("px4_parameters.h", "w")
 fp_src = open("px4_parameters.c", "w")
 
@@ -110,6 +179,7 @@ struct px4_parameters_t {
 """
 start_name = ""
 end_name = ""
+param_names = []
 
 for group in root:
 	if group.tag == "group" and "no_code_generation" not in group.attrib:
@@ -128,12 +198,22 @@ for group in root:
 			section =""
 			header += """
 	const struct param_info_s __param__%s;""" % param.attrib["name"]
+			param_names.append(param.attrib["name"])
+
+hash_displacement, hash_index = generate_perfect_hash(param_names)
+
 header += """
 	const unsigned int param_count;
 };
 
 extern const struct px4_parameters_t px4_parameters;
-"""
+
+/* perfect hash over the parameter names, see param_find_internal() */
+#define PX4_PARAMETERS_HASH_SIZE %d
+
+extern const int16_t px4_parameters_hash_displacement[PX4_PARAMETERS_HASH_SIZE];
+extern const uint16_t px4_parameters_hash_index[PX4_PARAMETERS_HASH_SIZE];
+""" % len(hash_index)
 
 # Generate the C file content
 src = """
@@ -181,11 +261,19 @@ src += """
 	%d
 };
 
+const int16_t px4_parameters_hash_displacement[PX4_PARAMETERS_HASH_SIZE] = {
+	%s
+};
+
+const uint16_t px4_parameters_hash_index[PX4_PARAMETERS_HASH_SIZE] = {
+	%s
+};
+
 //extern const struct px4_parameters_t px4_parameters;
 
 __END_DECLS
 
-""" % i
+""" % (i, format_table(hash_displacement), format_table(hash_index))
 
 fp_header.write(header)
 fp_src.write(src)
@@ -142,6 +142,7 @@ set(config_module_list
 	lib/conversion
 	lib/launchdetection
 	lib/terrain_estimation
+	lib/ulog_compression
 	lib/runway_takeoff
 	lib/tailsitter_recovery
 	lib/DriverFramework/framework
@@ -35,6 +35,7 @@ set(config_module_list
 	lib/mathlib/math/filter
 	lib/geo
 	lib/geo_lookup
+	lib/ulog_compression
 	lib/conversion
 	lib/DriverFramework/framework
 
@@ -60,6 +60,7 @@ set(config_module_list
 	lib/geo
 	lib/geo_lookup
 	lib/terrain_estimation
+	lib/ulog_compression
 	lib/runway_takeoff
 	lib/tailsitter_recovery
 	lib/DriverFramework/framework
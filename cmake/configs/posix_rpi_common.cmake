@@ -89,6 +89,7 @@ set(config_module_list
 	lib/external_lgpl
 	lib/conversion
 	lib/terrain_estimation
+	lib/ulog_compression
 	lib/runway_takeoff
 	lib/tailsitter_recovery
 	lib/DriverFramework/framework
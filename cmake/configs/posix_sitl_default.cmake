@@ -71,6 +71,8 @@ set(config_module_list
 	lib/runway_takeoff
 	lib/tailsitter_recovery
 	lib/terrain_estimation
+	lib/ulog_compression
+	lib/ulog_reader
 
 	examples/px4_simple_app
 	examples/mc_att_control_multiplatform
@@ -83,12 +85,16 @@ set(config_module_list
 	#
 	drivers/sf0x/sf0x_tests
 	lib/rc/rc_tests
+	lib/ulog_compression/ulog_compression_tests
+	lib/ulog_reader/ulog_reader_tests
 	modules/commander/commander_tests
 	modules/controllib_test
 	#modules/mavlink/mavlink_tests #TODO: fix mavlink_tests
 	modules/unit_test
 	modules/uORB/uORB_tests
 	systemcmds/tests
+	platforms/posix/tests/hrt_test
+	platforms/posix/tests/vcdev_test
 
 	)
 
@@ -26,6 +26,8 @@ set(config_module_list
 	lib/external_lgpl
 	lib/geo
 	lib/geo_lookup
+	lib/ulog_compression
+	lib/ulog_reader
 	lib/DriverFramework/framework
 	)
 
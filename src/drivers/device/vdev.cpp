@@ -88,13 +88,11 @@ VDev::VDev(const char *name,
 	// private
 	_devname(devname),
 	_registered(false),
-	_open_count(0)
+	_open_count(0),
+	_pollset(nullptr),
+	_max_pollwaiters(0)
 {
 	PX4_DEBUG("VDev::VDev");
-
-	for (unsigned i = 0; i < _max_pollwaiters; i++) {
-		_pollset[i] = nullptr;
-	}
 }
 
 VDev::~VDev()
@@ -104,6 +102,8 @@ VDev::~VDev()
 	if (_registered) {
 		unregister_driver(_devname);
 	}
+
+	delete[] _pollset;
 }
 
 int
@@ -296,6 +296,18 @@ VDev::close(file_t *filep)
 
 	lock();
 
+	/*
+	 * Release the waiters still set up for this file, e.g. by a poll set that
+	 * is deinitialized after closing the descriptor. Clearing priv marks them
+	 * as torn down for px4_pollset_deinit().
+	 */
+	for (unsigned i = 0; i < _max_pollwaiters; i++) {
+		if (nullptr != _pollset[i] && _pollset[i]->priv == (void *)filep) {
+			_pollset[i]->priv = nullptr;
+			_pollset[i] = nullptr;
+		}
+	}
+
 	if (_open_count > 0) {
 		/* decrement the open count */
 		_open_count--;
@@ -429,6 +441,23 @@ VDev::poll(file_t *filep, px4_pollfd_struct_t *fds, bool setup)
 	return ret;
 }
 
+pollevent_t
+VDev::poll_refresh(file_t *filep, px4_pollfd_struct_t *fds)
+{
+	/* lock against poll_notify() updating revents */
+	lock();
+
+	if (fds->revents != 0) {
+		fds->revents = fds->events & poll_state(filep);
+	}
+
+	pollevent_t revents = fds->revents;
+
+	unlock();
+
+	return revents;
+}
+
 void
 VDev::poll_notify(pollevent_t events)
 {
@@ -437,12 +466,18 @@ VDev::poll_notify(pollevent_t events)
 	/* lock against poll() as well as other wakeups */
 	lock();
 
+	poll_notify_locked(events);
+
+	unlock();
+}
+
+void
+VDev::poll_notify_locked(pollevent_t events)
+{
 	for (unsigned i = 0; i < _max_pollwaiters; i++)
 		if (nullptr != _pollset[i]) {
 			poll_notify_one(_pollset[i], events);
 		}
-
-	unlock();
 }
 
 void
@@ -490,7 +525,25 @@ VDev::store_poll_waiter(px4_pollfd_struct_t *fds)
 		}
 	}
 
-	return -ENOMEM;
+	/* no free slot, expand the pollset (poll_notify() iterates it with the lock held as well) */
+	const unsigned new_count = (_max_pollwaiters > 0) ? _max_pollwaiters * 2 : _min_pollwaiters;
+	px4_pollfd_struct_t **new_pollset = new px4_pollfd_struct_t *[new_count];
+
+	if (new_pollset == nullptr) {
+		return -ENOMEM;
+	}
+
+	for (unsigned i = 0; i < new_count; i++) {
+		new_pollset[i] = (i < _max_pollwaiters) ? _pollset[i] : nullptr;
+	}
+
+	new_pollset[_max_pollwaiters] = fds;
+
+	delete[] _pollset;
+	_pollset = new_pollset;
+	_max_pollwaiters = new_count;
+
+	return PX4_OK;
 }
 
 int
@@ -240,6 +240,19 @@ public:
 	 */
 	virtual int	poll(file_t *filep, px4_pollfd_struct_t *fds, bool setup);
 
+	/**
+	 * Collect the reported events of a poll waiter that stays set up across
+	 * several waits. If events were reported, fds->revents is re-evaluated
+	 * with the current state, as they might have been consumed since. Events
+	 * are only reported by poll_notify(), so a waiter without events is left
+	 * as it is. revents is read and updated under the lock.
+	 *
+	 * @param filep	Pointer to the internal file structure.
+	 * @param fds		Poll descriptor previously set up with poll().
+	 * @return		The reported events.
+	 */
+	pollevent_t	poll_refresh(file_t *filep, px4_pollfd_struct_t *fds);
+
 	/**
 	 * Test whether the device is currently open.
 	 *
@@ -367,6 +380,18 @@ protected:
 	 */
 	virtual void	poll_notify(pollevent_t events);
 
+	/**
+	 * Report new poll events to all waiters.
+	 *
+	 * Same as poll_notify(), for callers that already hold the driver lock
+	 * and want to avoid a second lock round-trip.
+	 *
+	 * Lock must already be held when calling this.
+	 *
+	 * @param events	The new event(s) being announced.
+	 */
+	void		poll_notify_locked(pollevent_t events);
+
 	/**
 	 * Internal implementation of poll_notify.
 	 *
@@ -425,13 +450,14 @@ protected:
 	bool		_pub_blocked;		/**< true if publishing should be blocked */
 
 private:
-	static const unsigned _max_pollwaiters = 8;
+	static const unsigned _min_pollwaiters = 8;
 
 	const char	*_devname;		/**< device node name */
 	bool		_registered;		/**< true if device name was registered */
 	unsigned	_open_count;		/**< number of successful opens */
 
-	px4_pollfd_struct_t	*_pollset[_max_pollwaiters];
+	px4_pollfd_struct_t	**_pollset;	/**< poll waiters, persistent poll sets stay registered across waits */
+	unsigned	_max_pollwaiters;	/**< size of _pollset */
 
 	/**
 	 * Store a pollwaiter in a slot where we can find it later.
@@ -59,15 +59,63 @@ bool sim_delay = false;
 
 extern "C" {
 
-#define PX4_MAX_FD 300
-	static device::file_t *filemap[PX4_MAX_FD] = {};
+/*
+ * Size of the descriptor table. Can be raised from the build (e.g. for
+ * multi-vehicle SITL) with -DPX4_MAX_FD=<n>.
+ */
+#ifndef PX4_MAX_FD
+#define PX4_MAX_FD 512
+#endif
+
+	/*
+	 * Descriptor table. Entry fd is the file_t for descriptor fd, so opening
+	 * a file does not allocate. Free entries have vdev == NULL and are kept
+	 * on a LIFO free list threaded through filenext; entries above
+	 * fd_high_water have never been used and are not on the list yet.
+	 * All protected by filemutex.
+	 */
+	static device::file_t filemap[PX4_MAX_FD];
+	static int filenext[PX4_MAX_FD];
+	static int fd_free_head = -1;
+	static int fd_high_water = 0;
 
 	int px4_errno;
 
+	static int fd_alloc(int flags, VDev *dev)
+	{
+		int fd;
+
+		if (fd_free_head >= 0) {
+			fd = fd_free_head;
+			fd_free_head = filenext[fd];
+
+		} else if (fd_high_water < PX4_MAX_FD) {
+			fd = fd_high_water++;
+
+		} else {
+			return -1;
+		}
+
+		filemap[fd].fd = fd;
+		filemap[fd].flags = flags;
+		filemap[fd].priv = NULL;
+		filemap[fd].vdev = dev;
+		return fd;
+	}
+
+	static void fd_free(int fd)
+	{
+		filemap[fd].fd = -1;
+		filemap[fd].priv = NULL;
+		filemap[fd].vdev = NULL;
+		filenext[fd] = fd_free_head;
+		fd_free_head = fd;
+	}
+
 	inline bool valid_fd(int fd)
 	{
 		pthread_mutex_lock(&filemutex);
-		bool ret = (fd < PX4_MAX_FD && fd >= 0 && filemap[fd] != NULL);
+		bool ret = (fd < PX4_MAX_FD && fd >= 0 && filemap[fd].vdev != NULL);
 		pthread_mutex_unlock(&filemutex);
 		return ret;
 	}
@@ -75,11 +123,11 @@ extern "C" {
 	inline VDev *get_vdev(int fd)
 	{
 		pthread_mutex_lock(&filemutex);
-		bool valid = (fd < PX4_MAX_FD && fd >= 0 && filemap[fd] != NULL);
+		bool valid = (fd < PX4_MAX_FD && fd >= 0 && filemap[fd].vdev != NULL);
 		VDev *dev;
 
 		if (valid) {
-			dev = (VDev *)(filemap[fd]->vdev);
+			dev = (VDev *)(filemap[fd].vdev);
 
 		} else {
 			dev = nullptr;
@@ -94,7 +142,7 @@ extern "C" {
 		PX4_DEBUG("px4_open");
 		VDev *dev = VDev::getDev(path);
 		int ret = 0;
-		int i;
+		int fd = -1;
 		mode_t mode;
 
 		if (!dev && (flags & (PX4_F_WRONLY | PX4_F_CREAT)) != 0 &&
@@ -113,21 +161,19 @@ extern "C" {
 		if (dev) {
 
 			pthread_mutex_lock(&filemutex);
-
-			for (i = 0; i < PX4_MAX_FD; ++i) {
-				if (filemap[i] == 0) {
-					filemap[i] = new device::file_t(flags, dev, i);
-					break;
-				}
-			}
-
+			fd = fd_alloc(flags, dev);
 			pthread_mutex_unlock(&filemutex);
 
-			if (i < PX4_MAX_FD) {
-				ret = dev->open(filemap[i]);
+			if (fd >= 0) {
+				ret = dev->open(&filemap[fd]);
 
-			} else {
+				if (ret < 0) {
+					pthread_mutex_lock(&filemutex);
+					fd_free(fd);
+					pthread_mutex_unlock(&filemutex);
+				}
 
+			} else {
 				const unsigned NAMELEN = 32;
 				char thread_name[NAMELEN] = {};
 
@@ -155,8 +201,8 @@ extern "C" {
 			return -1;
 		}
 
-		PX4_DEBUG("px4_open fd = %d", filemap[i]->fd);
-		return filemap[i]->fd;
+		PX4_DEBUG("px4_open fd = %d", fd);
+		return fd;
 	}
 
 	int px4_close(int fd)
@@ -167,8 +213,8 @@ extern "C" {
 
 		if (dev) {
 			pthread_mutex_lock(&filemutex);
-			ret = dev->close(filemap[fd]);
-			filemap[fd] = nullptr;
+			ret = dev->close(&filemap[fd]);
+			fd_free(fd);
 			pthread_mutex_unlock(&filemutex);
 			PX4_DEBUG("px4_close fd = %d", fd);
 
@@ -192,7 +238,7 @@ extern "C" {
 
 		if (dev) {
 			PX4_DEBUG("px4_read fd = %d", fd);
-			ret = dev->read(filemap[fd], (char *)buffer, buflen);
+			ret = dev->read(&filemap[fd], (char *)buffer, buflen);
 
 		} else {
 			ret = -EINVAL;
@@ -214,7 +260,7 @@ extern "C" {
 
 		if (dev) {
 			PX4_DEBUG("px4_write fd = %d", fd);
-			ret = dev->write(filemap[fd], (const char *)buffer, buflen);
+			ret = dev->write(&filemap[fd], (const char *)buffer, buflen);
 
 		} else {
 			ret = -EINVAL;
@@ -236,7 +282,7 @@ extern "C" {
 		VDev *dev = get_vdev(fd);
 
 		if (dev) {
-			ret = dev->ioctl(filemap[fd], cmd, arg);
+			ret = dev->ioctl(&filemap[fd], cmd, arg);
 
 		} else {
 			ret = -EINVAL;
@@ -249,6 +295,69 @@ extern "C" {
 		return ret;
 	}
 
+	static const char *poll_thread_name(char *name, unsigned len)
+	{
+#ifndef __PX4_QURT
+		int nret = pthread_getname_np(pthread_self(), name, len);
+
+		if (nret || name[0] == 0) {
+			PX4_WARN("failed getting thread name");
+		}
+
+#endif
+		return name;
+	}
+
+	/**
+	 * Absolute deadline for a poll timeout in ms (timeout > 0 only).
+	 */
+	static void poll_deadline(int timeout, struct timespec *ts)
+	{
+		// FIXME: check if QURT should probably be using CLOCK_MONOTONIC
+		px4_clock_gettime(CLOCK_REALTIME, ts);
+
+		// Calculate an absolute time in the future
+		const unsigned billion = (1000 * 1000 * 1000);
+		unsigned tdiff = timeout;
+		uint64_t nsecs = ts->tv_nsec + (tdiff * 1000 * 1000);
+		ts->tv_sec += nsecs / billion;
+		nsecs -= (nsecs / billion) * billion;
+		ts->tv_nsec = nsecs;
+	}
+
+	/**
+	 * Block on a poll semaphore.
+	 *
+	 * @param deadline	absolute deadline if timeout > 0
+	 * @return		0 when posted, -ETIMEDOUT or another negative errno otherwise
+	 */
+	static int poll_sem_wait(px4_sem_t *sem, int timeout, const struct timespec *deadline)
+	{
+		int ret = 0;
+
+		if (timeout > 0) {
+			// Execute a blocking wait for that time in the future
+			errno = 0;
+			ret = px4_sem_timedwait(sem, deadline);
+#ifndef __PX4_DARWIN
+			ret = errno;
+#endif
+
+			// Ensure ret is negative on failure
+			if (ret > 0) {
+				ret = -ret;
+			}
+
+		} else if (timeout < 0) {
+			px4_sem_wait(sem);
+
+		} else {
+			ret = -ETIMEDOUT;
+		}
+
+		return ret;
+	}
+
 	int px4_poll(px4_pollfd_struct_t *fds, nfds_t nfds, int timeout)
 	{
 		if (nfds == 0) {
@@ -264,15 +373,6 @@ extern "C" {
 		const unsigned NAMELEN = 32;
 		char thread_name[NAMELEN] = {};
 
-#ifndef __PX4_QURT
-		int nret = pthread_getname_np(pthread_self(), thread_name, NAMELEN);
-
-		if (nret || thread_name[0] == 0) {
-			PX4_WARN("failed getting thread name");
-		}
-
-#endif
-
 		while (sim_delay) {
 			usleep(100);
 		}
@@ -292,12 +392,12 @@ extern "C" {
 
 			// If fd is valid
 			if (dev) {
-				PX4_DEBUG("%s: px4_poll: VDev->poll(setup) %d", thread_name, fds[i].fd);
-				ret = dev->poll(filemap[fds[i].fd], &fds[i], true);
+				PX4_DEBUG("px4_poll: VDev->poll(setup) %d", fds[i].fd);
+				ret = dev->poll(&filemap[fds[i].fd], &fds[i], true);
 
 				if (ret < 0) {
 					PX4_WARN("%s: px4_poll() error: %s",
-						 thread_name, strerror(errno));
+						 poll_thread_name(thread_name, NAMELEN), strerror(errno));
 					break;
 				}
 
@@ -310,39 +410,18 @@ extern "C" {
 		// If any FD can be polled, lock the semaphore and
 		// check for new data
 		if (fd_pollable) {
-			if (timeout > 0) {
-
-				// Get the current time
+			if (timeout != 0) {
 				struct timespec ts;
-				// FIXME: check if QURT should probably be using CLOCK_MONOTONIC
-				px4_clock_gettime(CLOCK_REALTIME, &ts);
-
-				// Calculate an absolute time in the future
-				const unsigned billion = (1000 * 1000 * 1000);
-				unsigned tdiff = timeout;
-				uint64_t nsecs = ts.tv_nsec + (tdiff * 1000 * 1000);
-				ts.tv_sec += nsecs / billion;
-				nsecs -= (nsecs / billion) * billion;
-				ts.tv_nsec = nsecs;
-
-				// Execute a blocking wait for that time in the future
-				errno = 0;
-				ret = px4_sem_timedwait(&sem, &ts);
-#ifndef __PX4_DARWIN
-				ret = errno;
-#endif
 
-				// Ensure ret is negative on failure
-				if (ret > 0) {
-					ret = -ret;
+				if (timeout > 0) {
+					poll_deadline(timeout, &ts);
 				}
 
+				ret = poll_sem_wait(&sem, timeout, &ts);
+
 				if (ret && ret != -ETIMEDOUT) {
-					PX4_WARN("%s: px4_poll() sem error", thread_name);
+					PX4_WARN("%s: px4_poll() sem error", poll_thread_name(thread_name, NAMELEN));
 				}
-
-			} else if (timeout < 0) {
-				px4_sem_wait(&sem);
 			}
 
 			// We have waited now (or not, depending on timeout),
@@ -353,11 +432,11 @@ extern "C" {
 
 				// If fd is valid
 				if (dev) {
-					PX4_DEBUG("%s: px4_poll: VDev->poll(teardown) %d", thread_name, fds[i].fd);
-					ret = dev->poll(filemap[fds[i].fd], &fds[i], false);
+					PX4_DEBUG("px4_poll: VDev->poll(teardown) %d", fds[i].fd);
+					ret = dev->poll(&filemap[fds[i].fd], &fds[i], false);
 
 					if (ret < 0) {
-						PX4_WARN("%s: px4_poll() 2nd poll fail", thread_name);
+						PX4_WARN("%s: px4_poll() 2nd poll fail", poll_thread_name(thread_name, NAMELEN));
 						break;
 					}
 
@@ -375,6 +454,133 @@ extern "C" {
 		return (count) ? count : ret;
 	}
 
+	int px4_pollset_init(px4_pollset_t *set, px4_pollfd_struct_t *fds, nfds_t nfds)
+	{
+		set->fds = fds;
+		set->nfds = nfds;
+		px4_sem_init(&set->sem, 0, 0);
+
+		for (nfds_t i = 0; i < nfds; ++i) {
+			fds[i].sem     = &set->sem;
+			fds[i].revents = 0;
+			fds[i].priv    = NULL;
+		}
+
+		for (nfds_t i = 0; i < nfds; ++i) {
+			VDev *dev = get_vdev(fds[i].fd);
+
+			// Invalid fds are ignored, as in px4_poll()
+			if (dev) {
+				int ret = dev->poll(&filemap[fds[i].fd], &fds[i], true);
+
+				if (ret < 0) {
+					px4_pollset_deinit(set);
+					px4_errno = -ret;
+					return PX4_ERROR;
+				}
+			}
+		}
+
+		return PX4_OK;
+	}
+
+	/**
+	 * Re-evaluate the descriptors that were ready and count the ready ones.
+	 * revents is updated by poll_notify() with the device lock held, so it
+	 * is only accessed through VDev::poll_refresh().
+	 */
+	static int pollset_refresh(px4_pollset_t *set)
+	{
+		int count = 0;
+
+		for (nfds_t i = 0; i < set->nfds; ++i) {
+			px4_pollfd_struct_t *fds = &set->fds[i];
+
+			// Descriptors that were not set up (or released by close) never report events
+			if (fds->priv == NULL) {
+				continue;
+			}
+
+			VDev *dev = get_vdev(fds->fd);
+
+			if (dev && dev->poll_refresh(&filemap[fds->fd], fds) != 0) {
+				count++;
+			}
+		}
+
+		return count;
+	}
+
+	int px4_pollset_wait(px4_pollset_t *set, int timeout)
+	{
+		while (sim_delay) {
+			usleep(100);
+		}
+
+		/*
+		 * Consume wakeups left over from earlier waits before looking at
+		 * revents: a notification arriving after this either shows up in
+		 * the refresh below or wakes the wait. Only this thread takes the
+		 * semaphore, so a positive count never blocks.
+		 */
+		int value = 0;
+		px4_sem_getvalue(&set->sem, &value);
+
+		while (value-- > 0) {
+			px4_sem_wait(&set->sem);
+		}
+
+		int count = pollset_refresh(set);
+
+		if (count > 0 || timeout == 0) {
+			return count;
+		}
+
+		struct timespec ts;
+
+		if (timeout > 0) {
+			poll_deadline(timeout, &ts);
+		}
+
+		while (count == 0) {
+			int ret = poll_sem_wait(&set->sem, timeout, &ts);
+
+			count = pollset_refresh(set);
+
+			if (ret != 0) {
+				if (ret != -ETIMEDOUT) {
+					const unsigned NAMELEN = 32;
+					char thread_name[NAMELEN] = {};
+					PX4_WARN("%s: px4_pollset_wait() sem error", poll_thread_name(thread_name, NAMELEN));
+				}
+
+				break;
+			}
+		}
+
+		return count;
+	}
+
+	void px4_pollset_deinit(px4_pollset_t *set)
+	{
+		for (nfds_t i = 0; i < set->nfds; ++i) {
+			px4_pollfd_struct_t *fds = &set->fds[i];
+
+			// priv is only set for descriptors that were set up
+			if (fds->priv != NULL) {
+				VDev *dev = get_vdev(fds->fd);
+
+				if (dev) {
+					dev->poll(&filemap[fds->fd], fds, false);
+				}
+
+				fds->priv = NULL;
+			}
+		}
+
+		px4_sem_destroy(&set->sem);
+	}
+
 	int px4_fsync(int fd)
 	{
 		return 0;
@@ -186,6 +186,15 @@ __EXPORT extern	void	hrt_start_delay(void);
  */
 __EXPORT extern void	hrt_stop_delay(void);
 
+/**
+ * Set the HRT to a given time and hold it there (lockstep simulation).
+ *
+ * Like hrt_start_delay(), but the HRT calls return the given time, which
+ * may be ahead of real-time. Call again to advance the time, or call
+ * hrt_stop_delay() to continue in real-time from the last set time.
+ */
+__EXPORT extern void	hrt_set_absolute_time(hrt_abstime time);
+
 #endif
 
 __END_DECLS
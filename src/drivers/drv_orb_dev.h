@@ -93,4 +93,16 @@
 /** Get the minimum interval at which the topic can be seen to be updated for this subscription */
 #define ORBIOCGETINTERVAL	_ORBIOC(16)
 
+/** Borrow the latest data of the topic for in-place reading, arg is a (uORB::orb_borrowdata *) */
+#define ORBIOCBORROW		_ORBIOC(17)
+
+/** Release data previously borrowed with ORBIOCBORROW, arg is a (uORB::orb_borrowdata *) */
+#define ORBIOCRELEASE		_ORBIOC(18)
+
+/** Attach an update notification queue to the subscription, arg is a (uORB::orb_updatequeuedata *) */
+#define ORBIOCSETUPDATEQUEUE	_ORBIOC(19)
+
+/** Copy the data of the topic if it has been updated since it was last read, arg is a (uORB::orb_copydata *) */
+#define ORBIOCCOPYUPDATED	_ORBIOC(20)
+
 #endif /* _DRV_UORB_H */
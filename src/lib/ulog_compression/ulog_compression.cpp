@@ -0,0 +1,341 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ulog_compression.cpp
+ *
+ * The compressed data is a sequence of LZ4-style sequences:
+ *   token | [literal length bytes] | literals | offset (2 bytes LE) | [match length bytes]
+ * The high nibble of the token is the number of literals, the low nibble the match
+ * length minus MIN_MATCH. A nibble of 15 is followed by bytes that are added to the length,
+ * until a byte is not 255. The last sequence consists of literals only.
+ */
+
+#include "ulog_compression.h"
+
+#include <string.h>
+#include <crc32.h>
+
+namespace ulog_compression
+{
+
+static constexpr uint8_t BLOCK_MAGIC[4] = {'U', 'L', 'z', 0x01};
+static constexpr size_t MIN_MATCH = 4;
+
+static inline uint32_t read32(const uint8_t *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline unsigned hash32(uint32_t v)
+{
+	return (v * 2654435761u) >> (32 - HASH_TABLE_BITS);
+}
+
+/** write an extended length (the part that does not fit into the token nibble) */
+static inline uint8_t *write_length(uint8_t *op, size_t len)
+{
+	while (len >= 255) {
+		*op++ = 255;
+		len -= 255;
+	}
+
+	*op++ = (uint8_t)len;
+	return op;
+}
+
+/**
+ * Write a sequence.
+ * @return new output position, nullptr if the output does not fit
+ */
+static uint8_t *write_sequence(uint8_t *op, uint8_t *oend, const uint8_t *literals, size_t num_literals,
+			       size_t offset, size_t match_len)
+{
+	/* worst case: token, literal length, literals, offset, match length */
+	size_t max_size = 1 + num_literals / 255 + 1 + num_literals + 2 + match_len / 255 + 1;
+
+	if (max_size > (size_t)(oend - op)) {
+		return nullptr;
+	}
+
+	uint8_t *token = op++;
+	*token = (num_literals >= 15 ? 15 : num_literals) << 4;
+
+	if (num_literals >= 15) {
+		op = write_length(op, num_literals - 15);
+	}
+
+	memcpy(op, literals, num_literals);
+	op += num_literals;
+
+	if (offset > 0) {
+		*op++ = (uint8_t)offset;
+		*op++ = (uint8_t)(offset >> 8);
+		match_len -= MIN_MATCH;
+		*token |= (match_len >= 15 ? 15 : match_len);
+
+		if (match_len >= 15) {
+			op = write_length(op, match_len - 15);
+		}
+	}
+
+	return op;
+}
+
+/**
+ * Compress src into dst.
+ * @return compressed size, 0 if it does not fit into dst_size
+ */
+static size_t compress(const uint8_t *src, size_t size, uint8_t *dst, size_t dst_size, uint16_t *hash_table)
+{
+	const uint8_t *ip = src;
+	const uint8_t *anchor = src;
+	const uint8_t *const end = src + size;
+	uint8_t *op = dst;
+	uint8_t *const oend = dst + dst_size;
+	unsigned misses = 0;
+
+	memset(hash_table, 0, HASH_TABLE_SIZE * sizeof(hash_table[0]));
+
+	while (ip + MIN_MATCH <= end) {
+		uint32_t seq = read32(ip);
+		unsigned h = hash32(seq);
+		const uint8_t *ref = src + hash_table[h];
+		hash_table[h] = (uint16_t)(ip - src);
+
+		if (ref >= ip || read32(ref) != seq) {
+			/* skip faster over data that does not compress */
+			ip += 1 + (misses++ >> 5);
+			continue;
+		}
+
+		misses = 0;
+
+		const size_t offset = ip - ref;
+		const uint8_t *match_end = ip + MIN_MATCH;
+		ref += MIN_MATCH;
+
+		while (match_end < end && *match_end == *ref) {
+			++match_end;
+			++ref;
+		}
+
+		op = write_sequence(op, oend, anchor, ip - anchor, offset, match_end - ip);
+
+		if (!op) {
+			return 0;
+		}
+
+		ip = match_end;
+		anchor = ip;
+	}
+
+	op = write_sequence(op, oend, anchor, end - anchor, 0, 0);
+
+	return op ? op - dst : 0;
+}
+
+/**
+ * Decompress src into dst.
+ * @return decompressed size, -1 on invalid data
+ */
+static int decompress(const uint8_t *src, size_t size, uint8_t *dst, size_t dst_size)
+{
+	const uint8_t *ip = src;
+	const uint8_t *const iend = src + size;
+	uint8_t *op = dst;
+	uint8_t *const oend = dst + dst_size;
+
+	while (ip < iend) {
+		uint8_t token = *ip++;
+		size_t len = token >> 4;
+
+		if (len == 15) {
+			uint8_t b;
+
+			do {
+				if (ip >= iend) {
+					return -1;
+				}
+
+				b = *ip++;
+				len += b;
+			} while (b == 255);
+		}
+
+		if (len > (size_t)(iend - ip) || len > (size_t)(oend - op)) {
+			return -1;
+		}
+
+		memcpy(op, ip, len);
+		op += len;
+		ip += len;
+
+		if (ip == iend) {
+			/* last sequence */
+			break;
+		}
+
+		if (iend - ip < 2) {
+			return -1;
+		}
+
+		size_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+
+		if (offset == 0 || offset > (size_t)(op - dst)) {
+			return -1;
+		}
+
+		len = token & 15;
+
+		if (len == 15) {
+			uint8_t b;
+
+			do {
+				if (ip >= iend) {
+					return -1;
+				}
+
+				b = *ip++;
+				len += b;
+			} while (b == 255);
+		}
+
+		len += MIN_MATCH;
+
+		if (len > (size_t)(oend - op)) {
+			return -1;
+		}
+
+		/* byte-wise, the match may overlap with the output */
+		const uint8_t *match = op - offset;
+
+		while (len-- > 0) {
+			*op++ = *match++;
+		}
+	}
+
+	return op - dst;
+}
+
+size_t write_block(const uint8_t *src, size_t size, uint8_t *block, uint16_t *hash_table)
+{
+	if (size == 0 || size > MAX_BLOCK_SIZE) {
+		return 0;
+	}
+
+	block_header_s header;
+	memcpy(header.magic, BLOCK_MAGIC, sizeof(header.magic));
+	header.raw_size = (uint16_t)size;
+	header.crc = crc32(src, size);
+
+	uint8_t *data = block + sizeof(header);
+
+	/* only keep the compressed data if it is smaller */
+	size_t data_size = compress(src, size, data, size - 1, hash_table);
+
+	if (data_size == 0) {
+		memcpy(data, src, size);
+		data_size = size;
+	}
+
+	header.data_size = (uint16_t)data_size;
+	memcpy(block, &header, sizeof(header));
+
+	return sizeof(header) + data_size;
+}
+
+size_t check_block_header(const uint8_t *buf)
+{
+	block_header_s header;
+	memcpy(&header, buf, sizeof(header));
+
+	if (memcmp(header.magic, BLOCK_MAGIC, sizeof(header.magic)) != 0 ||
+	    header.raw_size == 0 || header.raw_size > MAX_BLOCK_SIZE ||
+	    header.data_size == 0 || header.data_size > header.raw_size) {
+		return 0;
+	}
+
+	return sizeof(header) + header.data_size;
+}
+
+int read_block(const uint8_t *block, uint8_t *dst)
+{
+	block_header_s header;
+	memcpy(&header, block, sizeof(header));
+	const uint8_t *data = block + sizeof(header);
+	int size;
+
+	if (header.data_size == header.raw_size) {
+		memcpy(dst, data, header.raw_size);
+		size = header.raw_size;
+
+	} else {
+		size = decompress(data, header.data_size, dst, MAX_BLOCK_SIZE);
+	}
+
+	if (size != header.raw_size || crc32(dst, size) != header.crc) {
+		return -1;
+	}
+
+	return size;
+}
+
+int next_block(const uint8_t *buf, size_t size, size_t &offset, uint8_t *dst)
+{
+	for (; offset + sizeof(block_header_s) <= size; ++offset) {
+		size_t block_size = check_block_header(buf + offset);
+
+		if (block_size == 0 || block_size > size - offset) {
+			continue;
+		}
+
+		int ret = read_block(buf + offset, dst);
+
+		if (ret > 0) {
+			return ret;
+		}
+	}
+
+	return -1;
+}
+
+bool is_compressed(const uint8_t *buf, size_t size)
+{
+	return size >= sizeof(block_header_s) && check_block_header(buf) > 0;
+}
+
+} // namespace ulog_compression
@@ -0,0 +1,122 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ulog_compression.h
+ *
+ * Block-framed compression of ULog data.
+ *
+ * A compressed log is a sequence of independent blocks, each holding up to
+ * MAX_BLOCK_SIZE bytes of the uncompressed ULog stream:
+ *
+ *   block_header_s | data
+ *
+ * The data is LZ4-style compressed (sequences of literals and back references
+ * within the same block), or stored as-is if it does not compress
+ * (data_size == raw_size). Each header starts with a magic and contains the
+ * CRC32 of the uncompressed data, so a reader can verify every block and
+ * resynchronize on the next valid block after corrupt or missing data. A
+ * truncated log thus decodes up to the last complete block.
+ *
+ * Concatenating the uncompressed data of all blocks gives the original ULog
+ * stream, starting with the ULog file header.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace ulog_compression
+{
+
+static constexpr size_t MAX_BLOCK_SIZE = 4096; ///< maximum uncompressed size of a block
+
+static constexpr unsigned HASH_TABLE_BITS = 12;
+static constexpr size_t HASH_TABLE_SIZE = 1 << HASH_TABLE_BITS; ///< number of entries of the compressor hash table
+
+#pragma pack(push, 1)
+struct block_header_s {
+	uint8_t magic[4];
+	uint16_t raw_size; ///< size of the uncompressed data
+	uint16_t data_size; ///< size of the data following the header. Equal to raw_size if stored uncompressed
+	uint32_t crc; ///< CRC32 of the uncompressed data
+};
+#pragma pack(pop)
+
+static constexpr size_t MAX_FRAMED_BLOCK_SIZE = sizeof(block_header_s) + MAX_BLOCK_SIZE;
+
+/**
+ * Compress data into a framed block.
+ * @param src uncompressed data
+ * @param size size of src, at most MAX_BLOCK_SIZE
+ * @param block output buffer of at least MAX_FRAMED_BLOCK_SIZE bytes
+ * @param hash_table working memory of HASH_TABLE_SIZE entries
+ * @return size of the framed block (header and data), 0 if size is invalid
+ */
+size_t write_block(const uint8_t *src, size_t size, uint8_t *block, uint16_t *hash_table);
+
+/**
+ * Check if a buffer starts with a block header.
+ * This only checks the magic and the sizes, use read_block() to verify the content.
+ * @param buf at least sizeof(block_header_s) bytes
+ * @return size of the framed block, 0 if buf does not start with a header
+ */
+size_t check_block_header(const uint8_t *buf);
+
+/**
+ * Decode a framed block and verify its checksum.
+ * @param block framed block of size check_block_header(block)
+ * @param dst output buffer of at least MAX_BLOCK_SIZE bytes
+ * @return uncompressed size, -1 if the block is corrupt
+ */
+int read_block(const uint8_t *block, uint8_t *dst);
+
+/**
+ * Find and decode the next valid block in a buffer, skipping corrupt or incomplete data.
+ * @param buf compressed data
+ * @param size size of buf
+ * @param offset where to start searching. Set to the offset of the block found.
+ * @param dst output buffer of at least MAX_BLOCK_SIZE bytes
+ * @return uncompressed size, -1 if there is no further valid block
+ */
+int next_block(const uint8_t *buf, size_t size, size_t &offset, uint8_t *dst);
+
+/**
+ * Check if a file starts with a compressed block (as opposed to an uncompressed ULog file)
+ * @param buf first bytes of the file
+ * @param size size of buf
+ */
+bool is_compressed(const uint8_t *buf, size_t size);
+
+} // namespace ulog_compression
@@ -0,0 +1,301 @@
+#include <unit_test/unit_test.h>
+
+#include <systemlib/err.h>
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <drivers/drv_hrt.h>
+
+#include <lib/ulog_compression/ulog_compression.h>
+
+#if !defined(CONFIG_ARCH_BOARD_SITL)
+#define TEST_DATA_PATH "/fs/microsd/"
+#else
+#define TEST_DATA_PATH "./test_data/"
+#endif
+
+using namespace ulog_compression;
+
+extern "C" __EXPORT int ulog_compression_tests_main(int argc, char *argv[]);
+
+class ULogCompressionTest : public UnitTest
+{
+public:
+	virtual ~ULogCompressionTest();
+
+	virtual bool run_tests(void);
+
+private:
+	bool roundtripTest();
+	bool incompressibleTest();
+	bool resyncTest();
+	bool benchmarkTest();
+
+	/** fill buf with ULog data messages of a few topics with changing values */
+	static void generateULogData(uint8_t *buf, size_t size);
+
+	/** compress size bytes of src into _compressed, @return compressed size */
+	size_t compress(const uint8_t *src, size_t size);
+
+	/** decompress all valid blocks of _compressed into dst, @return decompressed size */
+	size_t decompress(size_t compressed_size, uint8_t *dst, size_t dst_size);
+
+	/** measure compression and decompression on a buffer */
+	bool benchmark(const char *name, const uint8_t *data, size_t size);
+
+	uint16_t _hash_table[HASH_TABLE_SIZE];
+	uint8_t *_compressed = nullptr;
+	size_t _compressed_size = 0;
+};
+
+ULogCompressionTest::~ULogCompressionTest()
+{
+	free(_compressed);
+}
+
+bool ULogCompressionTest::run_tests(void)
+{
+	ut_run_test(roundtripTest);
+	ut_run_test(incompressibleTest);
+	ut_run_test(resyncTest);
+	ut_run_test(benchmarkTest);
+
+	return (_tests_failed == 0);
+}
+
+void ULogCompressionTest::generateULogData(uint8_t *buf, size_t size)
+{
+	const unsigned num_topics = 6;
+	float values[num_topics][8] = {};
+	uint64_t timestamp = 1000000;
+	size_t pos = 0;
+	unsigned i = 0;
+
+	while (pos < size) {
+		unsigned topic = i++ % num_topics;
+		unsigned num_values = 2 + topic;
+		uint8_t msg[5 + 8 + 8 * 4];
+		size_t msg_size = 5 + 8 + num_values * 4;
+
+		timestamp += 250 + rand() % 10;
+
+		// like in real logs, most fields change rarely (eg. status flags, setpoints)
+		for (unsigned k = 0; k < num_values; ++k) {
+			if (k < 2 || rand() % 16 == 0) {
+				values[topic][k] += (rand() % 100 - 50) * 0.001f;
+			}
+		}
+
+		msg[0] = (uint8_t)(msg_size - 3);
+		msg[1] = 0;
+		msg[2] = 'D';
+		msg[3] = topic;
+		msg[4] = 0;
+		memcpy(msg + 5, &timestamp, sizeof(timestamp));
+		memcpy(msg + 13, values[topic], num_values * 4);
+
+		size_t n = msg_size < size - pos ? msg_size : size - pos;
+		memcpy(buf + pos, msg, n);
+		pos += n;
+	}
+}
+
+size_t ULogCompressionTest::compress(const uint8_t *src, size_t size)
+{
+	size_t needed = (size / MAX_BLOCK_SIZE + 1) * MAX_FRAMED_BLOCK_SIZE;
+
+	if (needed > _compressed_size) {
+		free(_compressed);
+		_compressed = (uint8_t *)malloc(needed);
+		_compressed_size = _compressed ? needed : 0;
+	}
+
+	if (!_compressed) {
+		return 0;
+	}
+
+	size_t compressed_size = 0;
+
+	for (size_t offset = 0; offset < size; offset += MAX_BLOCK_SIZE) {
+		size_t n = size - offset < MAX_BLOCK_SIZE ? size - offset : MAX_BLOCK_SIZE;
+		compressed_size += write_block(src + offset, n, _compressed + compressed_size, _hash_table);
+	}
+
+	return compressed_size;
+}
+
+size_t ULogCompressionTest::decompress(size_t compressed_size, uint8_t *dst, size_t dst_size)
+{
+	uint8_t block[MAX_BLOCK_SIZE];
+	size_t offset = 0;
+	size_t size = 0;
+	int ret;
+
+	while ((ret = next_block(_compressed, compressed_size, offset, block)) > 0) {
+		if (size + ret > dst_size) {
+			break;
+		}
+
+		memcpy(dst + size, block, ret);
+		size += ret;
+		offset += check_block_header(_compressed + offset);
+	}
+
+	return size;
+}
+
+bool ULogCompressionTest::roundtripTest(void)
+{
+	const size_t size = 100 * 1024 + 123;
+	uint8_t *data = (uint8_t *)malloc(size);
+	uint8_t *result = (uint8_t *)malloc(size);
+	ut_test(data != nullptr && result != nullptr);
+
+	generateULogData(data, size);
+
+	size_t compressed_size = compress(data, size);
+	ut_test(compressed_size > 0);
+	ut_test(compressed_size < size * 3 / 4);
+	ut_test(is_compressed(_compressed, compressed_size));
+	ut_test(!is_compressed((const uint8_t *)"ULog\x01\x12\x35\x00\x00\x00\x00\x00", 12));
+
+	ut_compare("decompressed size", decompress(compressed_size, result, size), size);
+	ut_test(memcmp(data, result, size) == 0);
+
+	free(data);
+	free(result);
+	return true;
+}
+
+bool ULogCompressionTest::incompressibleTest(void)
+{
+	const size_t size = 3 * MAX_BLOCK_SIZE;
+	uint8_t *data = (uint8_t *)malloc(size);
+	uint8_t *result = (uint8_t *)malloc(size);
+	ut_test(data != nullptr && result != nullptr);
+
+	for (size_t i = 0; i < size; ++i) {
+		data[i] = rand();
+	}
+
+	// random data is stored as-is: no expansion except for the headers
+	size_t compressed_size = compress(data, size);
+	ut_compare("stored size", compressed_size, size + 3 * sizeof(block_header_s));
+
+	ut_compare("decompressed size", decompress(compressed_size, result, size), size);
+	ut_test(memcmp(data, result, size) == 0);
+
+	free(data);
+	free(result);
+	return true;
+}
+
+bool ULogCompressionTest::resyncTest(void)
+{
+	const size_t size = 10 * MAX_BLOCK_SIZE;
+	uint8_t *data = (uint8_t *)malloc(size);
+	uint8_t *result = (uint8_t *)malloc(size);
+	ut_test(data != nullptr && result != nullptr);
+
+	generateULogData(data, size);
+	size_t compressed_size = compress(data, size);
+
+	// find the start of the 4. block
+	size_t offset = 0;
+
+	for (int i = 0; i < 3; ++i) {
+		offset += check_block_header(_compressed + offset);
+	}
+
+	// corrupt the 4. block and truncate the last one: both must be skipped, the rest decoded
+	_compressed[offset + sizeof(block_header_s) + 10] ^= 0x55;
+	size_t decompressed_size = decompress(compressed_size - 10, result, size);
+	ut_compare("decompressed size", decompressed_size, size - 2 * MAX_BLOCK_SIZE);
+	ut_test(memcmp(data, result, 3 * MAX_BLOCK_SIZE) == 0);
+	ut_test(memcmp(data + 4 * MAX_BLOCK_SIZE, result + 3 * MAX_BLOCK_SIZE, 5 * MAX_BLOCK_SIZE) == 0);
+
+	free(data);
+	free(result);
+	return true;
+}
+
+bool ULogCompressionTest::benchmark(const char *name, const uint8_t *data, size_t size)
+{
+	uint8_t *result = (uint8_t *)malloc(size);
+	ut_test(result != nullptr);
+
+	hrt_abstime start = hrt_absolute_time();
+	size_t compressed_size = compress(data, size);
+	hrt_abstime compress_time = hrt_elapsed_time(&start);
+
+	start = hrt_absolute_time();
+	size_t decompressed_size = decompress(compressed_size, result, size);
+	hrt_abstime decompress_time = hrt_elapsed_time(&start);
+
+	ut_compare("decompressed size", decompressed_size, size);
+	ut_test(memcmp(data, result, size) == 0);
+
+	PX4_INFO("%s: %zu -> %zu bytes, ratio %.2f, compress %.1f MB/s, decompress %.1f MB/s", name, size,
+		 compressed_size, (double)size / compressed_size,
+		 (double)size / (compress_time > 0 ? compress_time : 1),
+		 (double)size / (decompress_time > 0 ? decompress_time : 1));
+
+	free(result);
+	return true;
+}
+
+bool ULogCompressionTest::benchmarkTest(void)
+{
+	int num_files = 0;
+	DIR *dir = opendir(TEST_DATA_PATH);
+
+	if (dir) {
+		struct dirent *entry;
+
+		while ((entry = readdir(dir)) != nullptr) {
+			const char *extension = strrchr(entry->d_name, '.');
+
+			if (!extension || strcmp(extension, ".ulg") != 0) {
+				continue;
+			}
+
+			char file_name[256];
+			snprintf(file_name, sizeof(file_name), "%s%s", TEST_DATA_PATH, entry->d_name);
+			FILE *fp = fopen(file_name, "rb");
+			ut_test(fp != nullptr);
+
+			fseek(fp, 0, SEEK_END);
+			size_t size = ftell(fp);
+			fseek(fp, 0, SEEK_SET);
+			uint8_t *data = (uint8_t *)malloc(size);
+			ut_test(data != nullptr);
+			ut_compare("read size", fread(data, 1, size, fp), size);
+			fclose(fp);
+
+			bool ret = benchmark(entry->d_name, data, size);
+			free(data);
+			ut_test(ret);
+			++num_files;
+		}
+
+		closedir(dir);
+	}
+
+	if (num_files == 0) {
+		// no logs available, use generated data instead
+		const size_t size = 1024 * 1024;
+		uint8_t *data = (uint8_t *)malloc(size);
+		ut_test(data != nullptr);
+		generateULogData(data, size);
+		bool ret = benchmark("generated ULog data", data, size);
+		free(data);
+		ut_test(ret);
+	}
+
+	return true;
+}
+
+ut_declare_test_c(ulog_compression_tests_main, ULogCompressionTest)
@@ -0,0 +1,310 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file merge_iterator.cpp
+ */
+
+#include "merge_iterator.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace ulog_reader
+{
+
+void MergeIterator::addTopic(uint16_t msg_id, uint64_t start_offset, uint16_t data_size, uint16_t timestamp_offset)
+{
+	if (msg_id >= _topics.size()) {
+		_topics.resize(msg_id + 1);
+	}
+
+	Topic &topic = _topics[msg_id];
+	clearQueue(topic);
+	topic.valid = true;
+	topic.data_size = data_size;
+	topic.timestamp_offset = timestamp_offset;
+	topic.search_offset = start_offset;
+	topic.has_next = false;
+
+	if (_initialized) {
+		topic.synced = start_offset >= _scan_offset;
+		advance(msg_id);
+		rebuildHeap();
+	}
+}
+
+void MergeIterator::init()
+{
+	// the shared scan starts at the first topic
+	bool found = false;
+
+	for (const Topic &topic : _topics) {
+		if (topic.valid && (!found || topic.search_offset < _scan_offset)) {
+			_scan_offset = topic.search_offset;
+			found = true;
+		}
+	}
+
+	_scan_end = !found;
+
+	for (Topic &topic : _topics) {
+		topic.synced = true;
+	}
+
+	_initialized = true;
+
+	for (size_t i = 0; i < _topics.size(); ++i) {
+		if (_topics[i].valid) {
+			advance(i);
+		}
+	}
+
+	rebuildHeap();
+}
+
+bool MergeIterator::isDataMessage(const MessageView &msg, uint16_t &topic_msg_id)
+{
+	if (msg.type != (uint8_t)ULogMessageType::DATA || msg.size < sizeof(uint16_t)) {
+		return false;
+	}
+
+	topic_msg_id = msg.payload[0] | (msg.payload[1] << 8);
+
+	if (topic_msg_id >= _topics.size() || !_topics[topic_msg_id].valid) {
+		return false;
+	}
+
+	if (msg.size != _topics[topic_msg_id].data_size + sizeof(uint16_t)) {
+		++_size_mismatches;
+		return false;
+	}
+
+	return true;
+}
+
+void MergeIterator::setNext(Topic &topic, uint16_t msg_id, const MessageView &msg)
+{
+	topic.has_next = true;
+	topic.next.offset = msg.offset;
+	topic.next.msg_id = msg_id;
+	topic.next.data = msg.payload + sizeof(uint16_t);
+	memcpy(&topic.next.timestamp, topic.next.data + topic.timestamp_offset, sizeof(topic.next.timestamp));
+	topic.search_offset = msg.offset + msg.totalSize();
+}
+
+void MergeIterator::clearQueue(Topic &topic)
+{
+	_num_queued -= topic.queue.size();
+	topic.queue.clear();
+}
+
+void MergeIterator::advance(uint16_t msg_id)
+{
+	Topic &topic = _topics[msg_id];
+	MessageView msg;
+	uint16_t found_msg_id;
+	topic.has_next = false;
+
+	// the part before the shared scan position that the topic has not searched yet
+	if (!topic.synced) {
+		uint64_t offset = topic.search_offset;
+
+		while (offset < _scan_offset && _reader.messageAt(offset, msg)) {
+			offset += msg.totalSize();
+
+			if (isDataMessage(msg, found_msg_id) && found_msg_id == msg_id) {
+				setNext(topic, msg_id, msg);
+				return;
+			}
+		}
+
+		topic.search_offset = offset;
+		topic.synced = true;
+	}
+
+	// messages found by the shared scan
+	while (!topic.queue.empty()) {
+		uint64_t offset = topic.queue.front();
+		topic.queue.pop_front();
+		--_num_queued;
+
+		if (offset >= topic.search_offset && _reader.messageAt(offset, msg)) {
+			setNext(topic, msg_id, msg);
+			return;
+		}
+	}
+
+	if (_num_queued >= MAX_QUEUED) {
+		// too many queued messages already: search on our own, without queuing the other topics
+		uint64_t offset = std::max(topic.search_offset, _scan_offset);
+
+		while (_reader.messageAt(offset, msg)) {
+			offset += msg.totalSize();
+
+			if (isDataMessage(msg, found_msg_id) && found_msg_id == msg_id) {
+				setNext(topic, msg_id, msg);
+				return;
+			}
+		}
+
+		topic.search_offset = offset;
+		return;
+	}
+
+	// continue the shared scan until we find a message of this topic
+	while (!_scan_end) {
+		if (!_reader.messageAt(_scan_offset, msg)) {
+			_scan_end = true;
+			break;
+		}
+
+		_scan_offset += msg.totalSize();
+
+		if (!isDataMessage(msg, found_msg_id)) {
+			continue;
+		}
+
+		Topic &found_topic = _topics[found_msg_id];
+
+		if (msg.offset < found_topic.search_offset || !found_topic.synced) {
+			continue;
+		}
+
+		if (found_msg_id == msg_id) {
+			setNext(topic, msg_id, msg);
+			return;
+		}
+
+		found_topic.queue.push_back(msg.offset);
+		++_num_queued;
+	}
+}
+
+void MergeIterator::rebuildHeap()
+{
+	_heap.clear();
+
+	for (size_t i = 0; i < _topics.size(); ++i) {
+		const Topic &topic = _topics[i];
+
+		if (topic.valid && topic.has_next) {
+			_heap.push_back({topic.next.timestamp, topic.next.offset, (uint16_t)i});
+		}
+	}
+
+	std::make_heap(_heap.begin(), _heap.end());
+}
+
+bool MergeIterator::next(DataMessageView &msg)
+{
+	if (!_initialized) {
+		init();
+	}
+
+	if (_heap.empty()) {
+		return false;
+	}
+
+	std::pop_heap(_heap.begin(), _heap.end());
+	uint16_t msg_id = _heap.back().msg_id;
+	_heap.pop_back();
+
+	Topic &topic = _topics[msg_id];
+	msg = topic.next;
+	advance(msg_id);
+
+	if (topic.has_next) {
+		_heap.push_back({topic.next.timestamp, topic.next.offset, msg_id});
+		std::push_heap(_heap.begin(), _heap.end());
+	}
+
+	return true;
+}
+
+void MergeIterator::seekTopic(uint16_t msg_id, uint64_t offset)
+{
+	if (!_initialized) {
+		init();
+	}
+
+	if (msg_id >= _topics.size() || !_topics[msg_id].valid) {
+		return;
+	}
+
+	Topic &topic = _topics[msg_id];
+
+	if (!topic.has_next || offset <= topic.next.offset) {
+		return;
+	}
+
+	clearQueue(topic);
+	topic.search_offset = offset;
+	topic.synced = offset >= _scan_offset;
+	advance(msg_id);
+	rebuildHeap();
+}
+
+void MergeIterator::skipUntil(uint64_t timestamp)
+{
+	if (!_initialized) {
+		init();
+	}
+
+	for (size_t i = 0; i < _topics.size(); ++i) {
+		while (_topics[i].valid && _topics[i].has_next && _topics[i].next.timestamp < timestamp) {
+			advance(i);
+		}
+	}
+
+	rebuildHeap();
+}
+
+uint64_t MergeIterator::minOffset()
+{
+	if (!_initialized) {
+		init();
+	}
+
+	uint64_t offset = _reader.size();
+
+	for (const Topic &topic : _topics) {
+		if (topic.valid && topic.has_next && topic.next.offset < offset) {
+			offset = topic.next.offset;
+		}
+	}
+
+	return offset;
+}
+
+} // namespace ulog_reader
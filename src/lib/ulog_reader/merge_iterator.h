@@ -0,0 +1,170 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file merge_iterator.h
+ *
+ * Iteration over the data messages of an ULog file in timestamp order.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+
+#include "ulog_reader.h"
+
+namespace ulog_reader
+{
+
+/**
+ * Data message of a topic, returned by MergeIterator. The data pointer points into
+ * the file data of the Reader.
+ */
+struct DataMessageView {
+	uint64_t offset; ///< file offset of the message header
+	uint64_t timestamp;
+	uint16_t msg_id;
+	const uint8_t *data; ///< topic data (after the msg_id)
+};
+
+/**
+ * Iterates over the DATA messages of a set of logged topics (message ids) in timestamp order.
+ *
+ * Messages of different topics are not necessarily in timestamp order in the file, so each
+ * topic has its own position and the topic with the smallest next timestamp is returned
+ * (using a min-heap). To parse each message header only once, the file is read by a shared
+ * scan, which queues the messages it passes to their topic. If the queues get too large
+ * (e.g. a topic has no data for a long time), a topic searches the file on its own instead.
+ */
+class MergeIterator
+{
+public:
+	explicit MergeIterator(const Reader &reader) : _reader(reader) {}
+
+	/**
+	 * Add a topic. Topics can also be added after next() was called (e.g. for topics
+	 * added later in the log), their messages are then returned from start_offset on.
+	 * @param msg_id message id of the topic (from the ADD_LOGGED_MSG message)
+	 * @param start_offset data messages are searched from here on, e.g. the offset of the ADD_LOGGED_MSG message
+	 * @param data_size size of the topic data. Messages with another size are skipped
+	 * @param timestamp_offset offset of the uint64_t timestamp within the topic data
+	 */
+	void addTopic(uint16_t msg_id, uint64_t start_offset, uint16_t data_size, uint16_t timestamp_offset);
+
+	/**
+	 * Get the next data message
+	 * @return false if there are no more messages
+	 */
+	bool next(DataMessageView &msg);
+
+	/**
+	 * Move a topic forward to a given data message, e.g. from an index.
+	 * Ignored if the offset is not after the current position of the topic.
+	 */
+	void seekTopic(uint16_t msg_id, uint64_t offset);
+
+	/**
+	 * Skip all messages with a timestamp smaller than the given one
+	 */
+	void skipUntil(uint64_t timestamp);
+
+	/**
+	 * Smallest file offset of the next messages of all topics, the end of the file if there are none
+	 */
+	uint64_t minOffset();
+
+	/** number of data messages skipped because of a wrong size */
+	unsigned sizeMismatches() const { return _size_mismatches; }
+
+private:
+	struct Topic {
+		bool valid = false;
+		uint16_t data_size = 0;
+		uint16_t timestamp_offset = 0;
+		uint64_t search_offset = 0; ///< the next message is at or after this offset
+		/**
+		 * If synced, all messages of this topic between search_offset and the shared scan position
+		 * are queued. Otherwise that part of the file still needs to be searched by the topic.
+		 */
+		bool synced = false;
+		std::deque<uint64_t> queue; ///< offsets of data messages found by the shared scan
+		bool has_next = false;
+		DataMessageView next;
+	};
+
+	struct HeapEntry {
+		uint64_t timestamp;
+		uint64_t offset;
+		uint16_t msg_id;
+
+		/** heap order: smallest timestamp first, then file order */
+		bool operator<(const HeapEntry &other) const
+		{
+			return timestamp > other.timestamp || (timestamp == other.timestamp && offset > other.offset);
+		}
+	};
+
+	void init();
+
+	/**
+	 * Find the next message of a topic after search_offset and set has_next
+	 */
+	void advance(uint16_t msg_id);
+
+	/**
+	 * Check if a message is a valid data message of a topic.
+	 * @param topic_msg_id if not null, set to the msg_id of the message
+	 */
+	bool isDataMessage(const MessageView &msg, uint16_t &topic_msg_id);
+
+	void setNext(Topic &topic, uint16_t msg_id, const MessageView &msg);
+
+	void clearQueue(Topic &topic);
+
+	void rebuildHeap();
+
+	static constexpr size_t MAX_QUEUED = 1 << 20; ///< maximum number of queued messages of all topics
+
+	const Reader &_reader;
+	std::vector<Topic> _topics; ///< indexed by msg_id
+	std::vector<HeapEntry> _heap;
+	bool _initialized = false;
+	uint64_t _scan_offset = 0; ///< position of the shared scan
+	bool _scan_end = false; ///< shared scan reached the end
+	size_t _num_queued = 0;
+	unsigned _size_mismatches = 0;
+};
+
+} // namespace ulog_reader
@@ -0,0 +1,118 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ulog_reader.cpp
+ */
+
+#include "ulog_reader.h"
+
+#include <string.h>
+
+#include <ulog_compression/ulog_compression.h>
+
+namespace ulog_reader
+{
+
+bool Reader::open(const char *file_name)
+{
+	close();
+
+	if (!_file.open(file_name)) {
+		return false;
+	}
+
+	if (!ulog_compression::is_compressed(_file.data(), _file.size())) {
+		_file.adviseSequential();
+		_data = _file.data();
+		_size = _file.size();
+		return true;
+	}
+
+	// decompress all valid blocks, skipping corrupt and incomplete data
+	_compressed = true;
+	_decompressed.reserve(_file.size() * 2);
+	uint8_t block[ulog_compression::MAX_BLOCK_SIZE];
+	size_t offset = 0;
+
+	while (true) {
+		size_t search_start = offset;
+		int raw_size = ulog_compression::next_block(_file.data(), _file.size(), offset, block);
+
+		if (raw_size <= 0) {
+			_skipped_bytes += _file.size() - search_start;
+			break;
+		}
+
+		_skipped_bytes += offset - search_start;
+		_decompressed.insert(_decompressed.end(), block, block + raw_size);
+		offset += ulog_compression::check_block_header(_file.data() + offset);
+	}
+
+	_file.close();
+
+	if (_decompressed.empty()) {
+		return false;
+	}
+
+	_data = _decompressed.data();
+	_size = _decompressed.size();
+	return true;
+}
+
+void Reader::close()
+{
+	_file.close();
+	_decompressed.clear();
+	_data = nullptr;
+	_size = 0;
+	_compressed = false;
+	_skipped_bytes = 0;
+}
+
+bool Reader::readHeader(uint64_t &start_time) const
+{
+	if (_size < sizeof(ulog_file_header_s)) {
+		return false;
+	}
+
+	ulog_file_header_s header;
+	memcpy(&header, _data, sizeof(header));
+	start_time = header.timestamp;
+
+	// the last byte is the file version
+	const uint8_t magic[] = {'U', 'L', 'o', 'g', 0x01, 0x12, 0x35};
+	return memcmp(magic, header.magic, sizeof(magic)) == 0;
+}
+
+} // namespace ulog_reader
@@ -0,0 +1,131 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ulog_reader.h
+ *
+ * Zero-copy access to the messages of an ULog file.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include <logger/messages.h>
+
+#include "mapped_file.h"
+
+namespace ulog_reader
+{
+
+/**
+ * View of one ULog message. The pointers point into the file data of the Reader
+ * and are valid as long as the Reader is open.
+ */
+struct MessageView {
+	uint64_t offset; ///< file offset of the message header
+	uint8_t type; ///< ULogMessageType
+	uint16_t size; ///< payload size (without the header)
+	const uint8_t *payload;
+
+	/** size including the header, i.e. the offset to the next message */
+	size_t totalSize() const { return ULOG_MSG_HEADER_LEN + size; }
+};
+
+/**
+ * ULog file in memory: uncompressed files are mapped, compressed files
+ * (@see ulog_compression.h) are decompressed into memory once on open.
+ * The data can then be accessed directly at any offset.
+ */
+class Reader
+{
+public:
+	Reader() = default;
+
+	/**
+	 * Open a compressed or uncompressed ULog file
+	 * @return false if the file cannot be read
+	 */
+	bool open(const char *file_name);
+
+	void close();
+
+	bool isCompressed() const { return _compressed; }
+
+	/** number of corrupt or incomplete bytes skipped in a compressed file */
+	size_t skippedBytes() const { return _skipped_bytes; }
+
+	/** uncompressed ULog data */
+	const uint8_t *data() const { return _data; }
+
+	size_t size() const { return _size; }
+
+	/**
+	 * Check the file magic and get the start time from the file header
+	 * @return false if this is not an ULog file
+	 */
+	bool readHeader(uint64_t &start_time) const;
+
+	/**
+	 * Get the message at a file offset
+	 * @return false if there is no complete message at offset (end of the file)
+	 */
+	bool messageAt(uint64_t offset, MessageView &msg) const
+	{
+		if (offset + ULOG_MSG_HEADER_LEN > _size) {
+			return false;
+		}
+
+		const uint8_t *header = _data + offset;
+		msg.offset = offset;
+		msg.size = header[0] | (header[1] << 8);
+		msg.type = header[2];
+		msg.payload = header + ULOG_MSG_HEADER_LEN;
+		return offset + msg.totalSize() <= _size;
+	}
+
+	/** offset of the first message after the file header */
+	static constexpr uint64_t FIRST_MESSAGE_OFFSET = sizeof(ulog_file_header_s);
+
+private:
+	MappedFile _file;
+	std::vector<uint8_t> _decompressed;
+	const uint8_t *_data = nullptr;
+	size_t _size = 0;
+	bool _compressed = false;
+	size_t _skipped_bytes = 0;
+};
+
+} // namespace ulog_reader
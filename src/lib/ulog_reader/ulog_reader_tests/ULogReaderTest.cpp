@@ -0,0 +1,561 @@
+#include <unit_test/unit_test.h>
+
+#include <systemlib/err.h>
+
+#include <algorithm>
+#include <dirent.h>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include <drivers/drv_hrt.h>
+
+#include <lib/ulog_compression/ulog_compression.h>
+#include <lib/ulog_reader/merge_iterator.h>
+#include <lib/ulog_reader/ulog_reader.h>
+
+#if !defined(CONFIG_ARCH_BOARD_SITL)
+#define TEST_DATA_PATH "/fs/microsd/"
+#else
+#define TEST_DATA_PATH "./test_data/"
+#endif
+
+#define TEST_FILE TEST_DATA_PATH "ulog_reader_test.ulg"
+#define TEST_FILE_COMPRESSED TEST_DATA_PATH "ulog_reader_test.ulgz"
+
+using namespace ulog_reader;
+
+extern "C" __EXPORT int ulog_reader_tests_main(int argc, char *argv[]);
+
+class ULogReaderTest : public UnitTest
+{
+public:
+	virtual ~ULogReaderTest();
+
+	virtual bool run_tests(void);
+
+private:
+	bool mergeOrderTest();
+	bool truncatedTest();
+	bool compressedTest();
+	bool seekTest();
+	bool benchmarkTest();
+
+	struct GeneratedMessage {
+		uint64_t offset;
+		uint64_t timestamp;
+		uint16_t msg_id;
+
+		bool operator<(const GeneratedMessage &other) const
+		{
+			return timestamp < other.timestamp || (timestamp == other.timestamp && offset < other.offset);
+		}
+	};
+
+	struct TopicInfo {
+		bool valid = false;
+		uint64_t start_offset = 0;
+		uint16_t data_size = 0;
+	};
+
+	static constexpr unsigned NUM_TOPICS = 8;
+
+	static uint16_t topicDataSize(uint16_t msg_id) { return 8 + 4 * (msg_id + 1); }
+
+	/**
+	 * Generate an ULog file with NUM_TOPICS topics with different rates. The topics
+	 * of each logger cycle are written in random order, so that the timestamps are not
+	 * sorted across topics. The last topic is added in the middle of the log.
+	 * @param messages the generated data messages in file order
+	 */
+	void generateULog(unsigned num_cycles, std::vector<uint8_t> &log, std::vector<GeneratedMessage> &messages);
+
+	static bool writeFile(const char *file_name, const uint8_t *data, size_t size);
+
+	/** find the ADD_LOGGED_MSG message and the data size of each topic */
+	static void findTopics(const Reader &reader, std::vector<TopicInfo> &topics);
+
+	/** add all topics to an iterator */
+	static void addTopics(MergeIterator &iterator, const std::vector<TopicInfo> &topics);
+
+	/** iterate over all messages and compare them with the expected (sorted) messages */
+	bool compareMessages(MergeIterator &iterator, const std::vector<GeneratedMessage> &expected, size_t first);
+
+	/**
+	 * Read a log file with per-topic reads through an ifstream (the way replay read files before)
+	 * @return number of messages read
+	 */
+	static unsigned readBaseline(const char *file_name, const std::vector<TopicInfo> &topics);
+
+	bool benchmark(const char *name, const char *file_name);
+
+	uint16_t _hash_table[ulog_compression::HASH_TABLE_SIZE];
+};
+
+ULogReaderTest::~ULogReaderTest()
+{
+	unlink(TEST_FILE);
+	unlink(TEST_FILE_COMPRESSED);
+}
+
+bool ULogReaderTest::run_tests(void)
+{
+	ut_run_test(mergeOrderTest);
+	ut_run_test(truncatedTest);
+	ut_run_test(compressedTest);
+	ut_run_test(seekTest);
+	ut_run_test(benchmarkTest);
+
+	return (_tests_failed == 0);
+}
+
+void ULogReaderTest::generateULog(unsigned num_cycles, std::vector<uint8_t> &log,
+				  std::vector<GeneratedMessage> &messages)
+{
+	log.clear();
+	messages.clear();
+
+	ulog_file_header_s header;
+	const uint8_t magic[] = {'U', 'L', 'o', 'g', 0x01, 0x12, 0x35, 0x00};
+	memcpy(header.magic, magic, sizeof(header.magic));
+	header.timestamp = 1000000;
+	log.insert(log.end(), (const uint8_t *)&header, (const uint8_t *)&header + sizeof(header));
+
+	auto add_topic = [&log](uint16_t msg_id) {
+		char name[16];
+		int name_len = snprintf(name, sizeof(name), "topic%i", (int)msg_id);
+		uint16_t msg_size = 3 + name_len;
+		const uint8_t msg[] = {(uint8_t)msg_size, (uint8_t)(msg_size >> 8), (uint8_t)ULogMessageType::ADD_LOGGED_MSG,
+				       0, (uint8_t)msg_id, (uint8_t)(msg_id >> 8)
+				      };
+		log.insert(log.end(), msg, msg + sizeof(msg));
+		log.insert(log.end(), name, name + name_len);
+	};
+
+	for (uint16_t msg_id = 0; msg_id < NUM_TOPICS - 1; ++msg_id) {
+		add_topic(msg_id);
+	}
+
+	uint16_t order[NUM_TOPICS];
+
+	for (unsigned cycle = 0; cycle < num_cycles; ++cycle) {
+		const uint64_t cycle_time = header.timestamp + cycle * 1000;
+
+		if (cycle == num_cycles / 2) {
+			add_topic(NUM_TOPICS - 1);
+		}
+
+		for (unsigned i = 0; i < NUM_TOPICS; ++i) {
+			order[i] = i;
+		}
+
+		for (unsigned i = NUM_TOPICS - 1; i > 0; --i) {
+			std::swap(order[i], order[rand() % (i + 1)]);
+		}
+
+		for (unsigned i = 0; i < NUM_TOPICS; ++i) {
+			const uint16_t msg_id = order[i];
+
+			if (cycle % (msg_id + 1) != 0 || (msg_id == NUM_TOPICS - 1 && cycle <= num_cycles / 2)) {
+				continue;
+			}
+
+			const uint16_t data_size = topicDataSize(msg_id);
+			const uint16_t msg_size = 2 + data_size;
+			GeneratedMessage message;
+			message.offset = log.size();
+			message.timestamp = cycle_time + rand() % 900;
+			message.msg_id = msg_id;
+			messages.push_back(message);
+
+			const uint8_t msg[] = {(uint8_t)msg_size, (uint8_t)(msg_size >> 8), (uint8_t)ULogMessageType::DATA,
+					       (uint8_t)msg_id, (uint8_t)(msg_id >> 8)
+					      };
+			log.insert(log.end(), msg, msg + sizeof(msg));
+			log.insert(log.end(), (const uint8_t *)&message.timestamp,
+				   (const uint8_t *)&message.timestamp + sizeof(message.timestamp));
+			log.insert(log.end(), data_size - sizeof(message.timestamp), (uint8_t)msg_id);
+		}
+
+		// the logger writes other messages in between
+		if (cycle % 100 == 50) {
+			const uint8_t sync[] = {8, 0, (uint8_t)ULogMessageType::SYNC, 0x2F, 0x73, 0x13, 0x20, 0x25, 0x0C, 0xBB, 0x12};
+			log.insert(log.end(), sync, sync + sizeof(sync));
+		}
+	}
+}
+
+bool ULogReaderTest::writeFile(const char *file_name, const uint8_t *data, size_t size)
+{
+	FILE *fp = fopen(file_name, "wb");
+
+	if (!fp) {
+		return false;
+	}
+
+	bool ret = fwrite(data, 1, size, fp) == size;
+	fclose(fp);
+	return ret;
+}
+
+void ULogReaderTest::findTopics(const Reader &reader, std::vector<TopicInfo> &topics)
+{
+	topics.clear();
+	MessageView msg;
+
+	for (uint64_t offset = Reader::FIRST_MESSAGE_OFFSET; reader.messageAt(offset, msg); offset += msg.totalSize()) {
+		if (msg.size < 2) {
+			continue;
+		}
+
+		const uint16_t msg_id = msg.type == (uint8_t)ULogMessageType::ADD_LOGGED_MSG ?
+					msg.payload[1] | (msg.payload[2] << 8) : msg.payload[0] | (msg.payload[1] << 8);
+
+		if (msg.type == (uint8_t)ULogMessageType::ADD_LOGGED_MSG) {
+			if (topics.size() <= msg_id) {
+				topics.resize(msg_id + 1);
+			}
+
+			if (!topics[msg_id].valid) {
+				topics[msg_id].valid = true;
+				topics[msg_id].start_offset = offset;
+			}
+
+		} else if (msg.type == (uint8_t)ULogMessageType::DATA && msg_id < topics.size() &&
+			   topics[msg_id].valid && topics[msg_id].data_size == 0) {
+			topics[msg_id].data_size = msg.size - 2;
+		}
+	}
+}
+
+void ULogReaderTest::addTopics(MergeIterator &iterator, const std::vector<TopicInfo> &topics)
+{
+	for (size_t msg_id = 0; msg_id < topics.size(); ++msg_id) {
+		// all topics start with the timestamp
+		if (topics[msg_id].valid && topics[msg_id].data_size >= sizeof(uint64_t)) {
+			iterator.addTopic(msg_id, topics[msg_id].start_offset, topics[msg_id].data_size, 0);
+		}
+	}
+}
+
+bool ULogReaderTest::compareMessages(MergeIterator &iterator, const std::vector<GeneratedMessage> &expected,
+				     size_t first)
+{
+	DataMessageView msg;
+	size_t i = first;
+
+	while (iterator.next(msg)) {
+		ut_test(i < expected.size());
+		ut_compare("offset", msg.offset, expected[i].offset);
+		ut_compare("msg_id", msg.msg_id, expected[i].msg_id);
+		ut_test(msg.timestamp == expected[i].timestamp);
+		ut_compare("data", msg.data[sizeof(uint64_t)], (uint8_t)expected[i].msg_id);
+		++i;
+	}
+
+	ut_compare("number of messages", i, expected.size());
+	ut_compare("size mismatches", iterator.sizeMismatches(), 0);
+	return true;
+}
+
+bool ULogReaderTest::mergeOrderTest(void)
+{
+	std::vector<uint8_t> log;
+	std::vector<GeneratedMessage> messages;
+	generateULog(2000, log, messages);
+	ut_test(writeFile(TEST_FILE, log.data(), log.size()));
+
+	Reader reader;
+	ut_test(reader.open(TEST_FILE));
+	ut_test(!reader.isCompressed());
+	ut_compare("size", reader.size(), log.size());
+
+	uint64_t start_time;
+	ut_test(reader.readHeader(start_time));
+	ut_test(start_time == 1000000);
+
+	std::vector<TopicInfo> topics;
+	findTopics(reader, topics);
+	ut_compare("number of topics", topics.size(), NUM_TOPICS);
+
+	// the timestamps in the file are not sorted, the iterator must sort them
+	ut_test(!std::is_sorted(messages.begin(), messages.end()));
+	std::sort(messages.begin(), messages.end());
+
+	MergeIterator iterator(reader);
+	addTopics(iterator, topics);
+	return compareMessages(iterator, messages, 0);
+}
+
+bool ULogReaderTest::truncatedTest(void)
+{
+	std::vector<uint8_t> log;
+	std::vector<GeneratedMessage> messages;
+	generateULog(500, log, messages);
+
+	// cut the last message in half: it must be ignored
+	const uint64_t truncated_size = messages.back().offset + 7;
+	messages.pop_back();
+	ut_test(writeFile(TEST_FILE, log.data(), truncated_size));
+
+	Reader reader;
+	ut_test(reader.open(TEST_FILE));
+	ut_test(reader.size() == truncated_size);
+
+	std::vector<TopicInfo> topics;
+	findTopics(reader, topics);
+	std::sort(messages.begin(), messages.end());
+
+	MergeIterator iterator(reader);
+	addTopics(iterator, topics);
+	return compareMessages(iterator, messages, 0);
+}
+
+bool ULogReaderTest::compressedTest(void)
+{
+	std::vector<uint8_t> log;
+	std::vector<GeneratedMessage> messages;
+	generateULog(1000, log, messages);
+
+	std::vector<uint8_t> compressed((log.size() / ulog_compression::MAX_BLOCK_SIZE + 1) *
+					ulog_compression::MAX_FRAMED_BLOCK_SIZE);
+	size_t compressed_size = 0;
+
+	for (size_t offset = 0; offset < log.size(); offset += ulog_compression::MAX_BLOCK_SIZE) {
+		size_t n = std::min(log.size() - offset, (size_t)ulog_compression::MAX_BLOCK_SIZE);
+		compressed_size += ulog_compression::write_block(log.data() + offset, n, compressed.data() + compressed_size,
+				   _hash_table);
+	}
+
+	ut_test(writeFile(TEST_FILE_COMPRESSED, compressed.data(), compressed_size));
+
+	Reader reader;
+	ut_test(reader.open(TEST_FILE_COMPRESSED));
+	ut_test(reader.isCompressed());
+	ut_compare("skipped bytes", reader.skippedBytes(), 0);
+	ut_compare("size", reader.size(), log.size());
+	ut_test(memcmp(reader.data(), log.data(), log.size()) == 0);
+
+	std::vector<TopicInfo> topics;
+	findTopics(reader, topics);
+	std::sort(messages.begin(), messages.end());
+
+	MergeIterator iterator(reader);
+	addTopics(iterator, topics);
+	return compareMessages(iterator, messages, 0);
+}
+
+bool ULogReaderTest::seekTest(void)
+{
+	std::vector<uint8_t> log;
+	std::vector<GeneratedMessage> messages;
+	generateULog(2000, log, messages);
+	ut_test(writeFile(TEST_FILE, log.data(), log.size()));
+
+	Reader reader;
+	ut_test(reader.open(TEST_FILE));
+
+	std::vector<TopicInfo> topics;
+	findTopics(reader, topics);
+
+	std::vector<GeneratedMessage> sorted = messages;
+	std::sort(sorted.begin(), sorted.end());
+
+	// read a part, then skip forward without index
+	const uint64_t seek_time = sorted[sorted.size() / 3].timestamp;
+	MergeIterator iterator(reader);
+	addTopics(iterator, topics);
+
+	DataMessageView msg;
+
+	for (int i = 0; i < 100; ++i) {
+		ut_test(iterator.next(msg));
+	}
+
+	iterator.skipUntil(seek_time);
+
+	size_t first = std::lower_bound(sorted.begin(), sorted.end(), GeneratedMessage{0, seek_time, 0}) - sorted.begin();
+	ut_test(iterator.minOffset() <= sorted[first].offset);
+
+	if (!compareMessages(iterator, sorted, first)) {
+		return false;
+	}
+
+	// skip forward with an index: move each topic to its last message before the target time
+	const uint64_t index_seek_time = sorted[sorted.size() * 2 / 3].timestamp;
+	MergeIterator index_iterator(reader);
+	addTopics(index_iterator, topics);
+
+	for (uint16_t msg_id = 0; msg_id < NUM_TOPICS; ++msg_id) {
+		uint64_t offset = 0;
+
+		for (const GeneratedMessage &message : messages) {
+			if (message.msg_id == msg_id && message.timestamp < index_seek_time) {
+				offset = message.offset;
+			}
+		}
+
+		index_iterator.seekTopic(msg_id, offset);
+	}
+
+	index_iterator.skipUntil(index_seek_time);
+
+	first = std::lower_bound(sorted.begin(), sorted.end(), GeneratedMessage{0, index_seek_time, 0}) - sorted.begin();
+	return compareMessages(index_iterator, sorted, first);
+}
+
+unsigned ULogReaderTest::readBaseline(const char *file_name, const std::vector<TopicInfo> &topics)
+{
+	struct BaselineTopic {
+		bool valid;
+		std::streampos next_read_pos;
+		uint64_t next_timestamp;
+	};
+
+	std::ifstream file(file_name, std::ios::in | std::ios::binary);
+	std::vector<BaselineTopic> state(topics.size());
+	std::vector<uint8_t> buffer(UINT16_MAX);
+	ulog_message_header_s header;
+	unsigned num_messages = 0;
+
+	// find the next message of a topic, starting after the message at next_read_pos
+	auto next_data_message = [&](BaselineTopic & topic, uint16_t msg_id) {
+		file.clear();
+		file.seekg(topic.next_read_pos);
+		file.read((char *)&header, ULOG_MSG_HEADER_LEN);
+		file.seekg(header.msg_size, std::ios::cur);
+
+		while (file) {
+			std::streampos cur_pos = file.tellg();
+			file.read((char *)&header, ULOG_MSG_HEADER_LEN);
+			uint16_t file_msg_id;
+
+			if (file && header.msg_type == (uint8_t)ULogMessageType::DATA &&
+			    file.read((char *)&file_msg_id, sizeof(file_msg_id)) && file_msg_id == msg_id) {
+				topic.next_read_pos = cur_pos;
+				file.read((char *)&topic.next_timestamp, sizeof(topic.next_timestamp));
+				return;
+			}
+
+			file.seekg(cur_pos + (std::streamoff)(ULOG_MSG_HEADER_LEN + header.msg_size));
+		}
+
+		topic.valid = false;
+	};
+
+	for (size_t msg_id = 0; msg_id < topics.size(); ++msg_id) {
+		state[msg_id].valid = topics[msg_id].valid && topics[msg_id].data_size >= sizeof(uint64_t);
+		state[msg_id].next_read_pos = topics[msg_id].start_offset;
+
+		if (state[msg_id].valid) {
+			next_data_message(state[msg_id], msg_id);
+		}
+	}
+
+	while (true) {
+		int next_msg_id = -1;
+
+		for (size_t msg_id = 0; msg_id < state.size(); ++msg_id) {
+			if (state[msg_id].valid && (next_msg_id == -1 ||
+						    state[msg_id].next_timestamp < state[next_msg_id].next_timestamp)) {
+				next_msg_id = msg_id;
+			}
+		}
+
+		if (next_msg_id == -1) {
+			break;
+		}
+
+		BaselineTopic &topic = state[next_msg_id];
+		file.clear();
+		file.seekg(topic.next_read_pos + (std::streamoff)(ULOG_MSG_HEADER_LEN + 2));
+		file.read((char *)buffer.data(), topics[next_msg_id].data_size);
+		++num_messages;
+		next_data_message(topic, next_msg_id);
+	}
+
+	return num_messages;
+}
+
+bool ULogReaderTest::benchmark(const char *name, const char *file_name)
+{
+	hrt_abstime start = hrt_absolute_time();
+	Reader reader;
+	ut_test(reader.open(file_name));
+
+	std::vector<TopicInfo> topics;
+	findTopics(reader, topics);
+	MergeIterator iterator(reader);
+	addTopics(iterator, topics);
+
+	DataMessageView msg;
+	unsigned num_messages = 0;
+	uint8_t checksum = 0;
+
+	while (iterator.next(msg)) {
+		checksum += msg.data[0];
+		++num_messages;
+	}
+
+	hrt_abstime merge_time = hrt_elapsed_time(&start);
+
+	if (reader.isCompressed()) {
+		PX4_INFO("%s: %u msgs, merge iterator %.0f msgs/s (compressed)", name, num_messages,
+			 num_messages * 1e6 / (merge_time > 0 ? merge_time : 1));
+		return true;
+	}
+
+	start = hrt_absolute_time();
+	unsigned baseline_messages = readBaseline(file_name, topics);
+	hrt_abstime baseline_time = hrt_elapsed_time(&start);
+
+	ut_compare("number of messages", baseline_messages, num_messages);
+
+	PX4_INFO("%s: %u msgs, %zu topics, ifstream %.0f msgs/s, merge iterator %.0f msgs/s (checksum %i)", name,
+		 num_messages, topics.size(), num_messages * 1e6 / (baseline_time > 0 ? baseline_time : 1),
+		 num_messages * 1e6 / (merge_time > 0 ? merge_time : 1), (int)checksum);
+	return true;
+}
+
+bool ULogReaderTest::benchmarkTest(void)
+{
+	int num_files = 0;
+	DIR *dir = opendir(TEST_DATA_PATH);
+
+	if (dir) {
+		struct dirent *entry;
+
+		while ((entry = readdir(dir)) != nullptr) {
+			const char *extension = strrchr(entry->d_name, '.');
+
+			if (!extension || (strcmp(extension, ".ulg") != 0 && strcmp(extension, ".ulgz") != 0) ||
+			    strncmp(entry->d_name, "ulog_reader_test.", 17) == 0) {
+				continue;
+			}
+
+			char file_name[256];
+			snprintf(file_name, sizeof(file_name), "%s%s", TEST_DATA_PATH, entry->d_name);
+			bool ret = benchmark(entry->d_name, file_name);
+			ut_test(ret);
+			++num_files;
+		}
+
+		closedir(dir);
+	}
+
+	if (num_files == 0) {
+		// no logs available, use generated data instead
+		std::vector<uint8_t> log;
+		std::vector<GeneratedMessage> messages;
+		generateULog(20000, log, messages);
+		ut_test(writeFile(TEST_FILE, log.data(), log.size()));
+		bool ret = benchmark("generated ULog data", TEST_FILE);
+		ut_test(ret);
+	}
+
+	return true;
+}
+
+ut_declare_test_c(ulog_reader_tests_main, ULogReaderTest)
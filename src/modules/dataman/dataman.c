@@ -52,6 +52,7 @@
 #include <string.h>
 #include <semaphore.h>
 #include <unistd.h>
+#include <sys/stat.h>
 
 #include "dataman.h"
 #include <systemlib/param/param.h>
@@ -70,6 +71,10 @@ __EXPORT int dm_clear(dm_item_t item);
 __EXPORT void dm_lock(dm_item_t item);
 __EXPORT void dm_unlock(dm_item_t item);
 __EXPORT int dm_restart(dm_reset_reason restart_type);
+__EXPORT ssize_t dm_read_range(dm_item_t item, unsigned char index, unsigned num_items, void *buffer,
+			       size_t item_size);
+__EXPORT ssize_t dm_write_range(dm_item_t item, unsigned char index, unsigned num_items, dm_persitence_t persistence,
+				const void *buffer, size_t item_size);
 
 /** Types of function calls supported by the worker task */
 typedef enum {
@@ -77,6 +82,8 @@ typedef enum {
 	dm_read_func,
 	dm_clear_func,
 	dm_restart_func,
+	dm_read_range_func,
+	dm_write_range_func,
 	dm_number_of_funcs
 } dm_function_t;
 
@@ -107,6 +114,21 @@ typedef struct {
 		struct {
 			dm_reset_reason reason;
 		} restart_params;
+		struct {
+			dm_item_t item;
+			unsigned char index;
+			unsigned num_items;
+			void *buf;
+			size_t item_size;
+		} read_range_params;
+		struct {
+			dm_item_t item;
+			unsigned char index;
+			unsigned num_items;
+			dm_persitence_t persistence;
+			const void *buf;
+			size_t item_size;
+		} write_range_params;
 	};
 } work_q_item_t;
 
@@ -159,7 +181,57 @@ static px4_sem_t g_init_sema;
 static bool g_task_should_exit;	/**< if true, dataman task should exit */
 
 #define DM_SECTOR_HDR_SIZE 4	/* data manager per item header overhead */
-static const unsigned k_sector_size = DM_MAX_DATA_SIZE + DM_SECTOR_HDR_SIZE; /* total item sorage space */
+#define DM_SECTOR_SIZE (DM_MAX_DATA_SIZE + DM_SECTOR_HDR_SIZE)
+static const unsigned k_sector_size = DM_SECTOR_SIZE; /* total item sorage space */
+
+/*
+ * Caller context access
+ *
+ * On POSIX the data manager file is mapped into memory and all requests
+ * are served directly in the caller's context. Writes are synced to the
+ * file before they return. On NuttX a small direct-mapped RAM cache holds
+ * recently used sectors: hits are served in the caller's context, writes of
+ * volatile data are written back by the worker thread. Data that survives
+ * a power-on reset (missions, fence and rally points) is written through
+ * by the worker thread, so dm_write() only returns once it is stored.
+ * Both are protected by g_store_lock.
+ */
+#if defined(__PX4_POSIX) && !defined(__PX4_QURT)
+#include <sys/mman.h>
+#define DM_USE_MMAP
+#endif
+
+#ifndef DM_CACHE_SECTORS
+#define DM_CACHE_SECTORS 16	/* number of sectors held in the RAM cache, 0 to disable */
+#endif
+
+#if !defined(DM_USE_MMAP) && (DM_CACHE_SECTORS > 0)
+#define DM_USE_CACHE
+#endif
+
+static px4_sem_t g_store_lock;
+
+#ifdef DM_USE_MMAP
+static unsigned char *g_store = NULL;	/* the mapped data manager file, NULL if not mapped */
+static size_t g_store_size = 0;
+#endif
+
+#ifdef DM_USE_CACHE
+typedef struct {
+	int offset;		/* file offset of the cached sector, -1 if the entry is unused */
+	bool dirty;		/* modified and not yet written back */
+	unsigned char data[DM_SECTOR_SIZE];
+} dm_cache_entry_t;
+
+static dm_cache_entry_t g_cache[DM_CACHE_SECTORS];
+#endif
+
+static unsigned g_caller_context_hits;	/* requests served without the worker thread */
+
+#ifndef DM_RANGE_CHUNK_SECTORS
+#define DM_RANGE_CHUNK_SECTORS 8	/* sectors moved per file read/write by range requests */
+#endif
+
 
 static void init_q(work_q_t *q)
 {
@@ -324,6 +396,317 @@ calculate_offset(dm_item_t item, unsigned char index)
  * The total size must not exceed k_sector_size
  */
 
+/* Encode a data item into its sector representation */
+static void
+sector_encode(unsigned char *sector, dm_persitence_t persistence, const void *buf, size_t count)
+{
+	sector[0] = count;
+	sector[1] = persistence;
+	sector[2] = 0;
+	sector[3] = 0;
+
+	if (count > 0) {
+		memcpy(sector + DM_SECTOR_HDR_SIZE, buf, count);
+	}
+}
+
+/* Decode a sector into the caller's buffer, returns the item length or -1 */
+static ssize_t
+sector_decode(const unsigned char *sector, void *buf, size_t count)
+{
+	/* See if we got data */
+	if (sector[0] > 0) {
+		/* We got more than requested!!! */
+		if (sector[0] > count) {
+			return -1;
+		}
+
+		/* Looks good, copy it to the caller's buffer */
+		memcpy(buf, sector + DM_SECTOR_HDR_SIZE, sector[0]);
+	}
+
+	/* Return the number of bytes of caller data read */
+	return sector[0];
+}
+
+#ifdef DM_USE_CACHE
+
+static inline dm_cache_entry_t *
+cache_entry(int offset)
+{
+	return &g_cache[(offset / k_sector_size) % DM_CACHE_SECTORS];
+}
+
+/* Look up a sector in the cache, returns true on a hit with the read result in *result */
+static bool
+cache_read(int offset, void *buf, size_t count, ssize_t *result)
+{
+	bool hit = false;
+
+	px4_sem_wait(&g_store_lock);
+
+	dm_cache_entry_t *entry = cache_entry(offset);
+
+	if (entry->offset == offset) {
+		*result = sector_decode(entry->data, buf, count);
+		hit = true;
+	}
+
+	px4_sem_post(&g_store_lock);
+
+	return hit;
+}
+
+/* Store a sector in the cache for write-back, returns false if its entry holds another unwritten sector */
+static bool
+cache_write(int offset, dm_persitence_t persistence, const void *buf, size_t count)
+{
+	bool cached = false;
+
+	px4_sem_wait(&g_store_lock);
+
+	dm_cache_entry_t *entry = cache_entry(offset);
+
+	if (entry->offset == offset || !entry->dirty) {
+		entry->offset = offset;
+		entry->dirty = true;
+		sector_encode(entry->data, persistence, buf, count);
+		cached = true;
+	}
+
+	px4_sem_post(&g_store_lock);
+
+	return cached;
+}
+
+/* Keep a sector read from the file, unless its entry holds unwritten data */
+static void
+cache_fill(int offset, const unsigned char *sector)
+{
+	px4_sem_wait(&g_store_lock);
+
+	dm_cache_entry_t *entry = cache_entry(offset);
+
+	if (!entry->dirty) {
+		entry->offset = offset;
+		memcpy(entry->data, sector, DM_SECTOR_HDR_SIZE + sector[0]);
+	}
+
+	px4_sem_post(&g_store_lock);
+}
+
+/* Drop a cached sector unless it holds unwritten (newer) data */
+static void
+cache_drop_clean(int offset)
+{
+	px4_sem_wait(&g_store_lock);
+
+	dm_cache_entry_t *entry = cache_entry(offset);
+
+	if (entry->offset == offset && !entry->dirty) {
+		entry->offset = -1;
+	}
+
+	px4_sem_post(&g_store_lock);
+}
+
+/* Drop cached sectors in [start, end), including unwritten ones */
+static void
+cache_invalidate(int start, int end)
+{
+	px4_sem_wait(&g_store_lock);
+
+	for (unsigned i = 0; i < DM_CACHE_SECTORS; i++) {
+		if (g_cache[i].offset >= start && g_cache[i].offset < end) {
+			g_cache[i].offset = -1;
+			g_cache[i].dirty = false;
+		}
+	}
+
+	px4_sem_post(&g_store_lock);
+}
+
+/* Write back all dirty sectors, called by the worker thread only */
+static void
+cache_flush(void)
+{
+	unsigned char buffer[DM_SECTOR_SIZE];
+	bool written = false;
+
+	for (unsigned i = 0; i < DM_CACHE_SECTORS; i++) {
+		int offset = -1;
+
+		/* copy the sector out so that the file I/O does not block callers */
+		px4_sem_wait(&g_store_lock);
+
+		if (g_cache[i].dirty) {
+			offset = g_cache[i].offset;
+			memcpy(buffer, g_cache[i].data, DM_SECTOR_HDR_SIZE + g_cache[i].data[0]);
+			g_cache[i].dirty = false;
+		}
+
+		px4_sem_post(&g_store_lock);
+
+		if (offset < 0) {
+			continue;
+		}
+
+		ssize_t count = DM_SECTOR_HDR_SIZE + buffer[0];
+
+		if (lseek(g_task_fd, offset, SEEK_SET) != offset || write(g_task_fd, buffer, count) != count) {
+			PX4_WARN("write back of sector at %d failed", offset);
+		}
+
+		written = true;
+	}
+
+	if (written) {
+		fsync(g_task_fd);        /* Make sure data is written to physical media */
+	}
+}
+
+#endif /* DM_USE_CACHE */
+
+#ifdef DM_USE_MMAP
+
+/* Write a modified range of the mapped file to storage, called with g_store_lock held */
+static int
+store_sync(size_t offset, size_t count)
+{
+	/* msync needs a page aligned address */
+	const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+	const size_t start = offset - (offset % page_size);
+
+	return msync(g_store + start, offset + count - start, MS_SYNC);
+}
+
+/* Read from the mapped file in the caller's context */
+static ssize_t
+store_read(int offset, void *buf, size_t count)
+{
+	ssize_t result = -1;
+
+	px4_sem_wait(&g_store_lock);
+
+	if (g_store != NULL) {
+		result = sector_decode(g_store + offset, buf, count);
+	}
+
+	px4_sem_post(&g_store_lock);
+
+	return result;
+}
+
+/* Write to the mapped file in the caller's context */
+static ssize_t
+store_write(int offset, dm_persitence_t persistence, const void *buf, size_t count)
+{
+	ssize_t result = -1;
+
+	px4_sem_wait(&g_store_lock);
+
+	if (g_store != NULL) {
+		sector_encode(g_store + offset, persistence, buf, count);
+
+		/* Make sure data is written to physical media */
+		if (store_sync(offset, DM_SECTOR_HDR_SIZE + count) == 0) {
+			result = count;
+		}
+	}
+
+	px4_sem_post(&g_store_lock);
+
+	return result;
+}
+
+/* Read consecutive items from the mapped file, returns the number of items read */
+static ssize_t
+store_read_range(int offset, unsigned num_items, void *buf, size_t item_size)
+{
+	unsigned char *dst = (unsigned char *)buf;
+	unsigned i;
+
+	px4_sem_wait(&g_store_lock);
+
+	for (i = 0; (g_store != NULL) && (i < num_items); i++) {
+		if (sector_decode(g_store + offset + i * k_sector_size, dst + i * item_size, item_size) != (ssize_t)item_size) {
+			break;
+		}
+	}
+
+	px4_sem_post(&g_store_lock);
+
+	return i;
+}
+
+/* Write consecutive items to the mapped file, returns the number of items written */
+static ssize_t
+store_write_range(int offset, unsigned num_items, dm_persitence_t persistence, const void *buf, size_t item_size)
+{
+	const unsigned char *src = (const unsigned char *)buf;
+	unsigned i;
+
+	px4_sem_wait(&g_store_lock);
+
+	for (i = 0; (g_store != NULL) && (i < num_items); i++) {
+		sector_encode(g_store + offset + i * k_sector_size, persistence, src + i * item_size, item_size);
+	}
+
+	if (i > 0 && store_sync(offset, i * k_sector_size) != 0) {
+		i = 0;
+	}
+
+	px4_sem_post(&g_store_lock);
+
+	return i;
+}
+
+/* Mark count sectors starting at offset unused in the mapped file */
+static int
+store_clear(int offset, unsigned count)
+{
+	int result = -1;
+
+	px4_sem_wait(&g_store_lock);
+
+	if (g_store != NULL) {
+		for (unsigned i = 0; i < count; i++) {
+			g_store[offset + i * k_sector_size] = 0;
+		}
+
+		result = (count > 0) ? store_sync(offset, count * k_sector_size) : 0;
+	}
+
+	px4_sem_post(&g_store_lock);
+
+	return result;
+}
+
+/* Mark all sectors above the persistence level unused in the mapped file */
+static int
+store_restart(unsigned max_persistence)
+{
+	int result = -1;
+
+	px4_sem_wait(&g_store_lock);
+
+	if (g_store != NULL) {
+		for (size_t offset = 0; offset < g_store_size; offset += k_sector_size) {
+			if (g_store[offset] && g_store[offset + 1] > max_persistence) {
+				g_store[offset] = 0;
+			}
+		}
+
+		result = store_sync(0, g_store_size);
+	}
+
+	px4_sem_post(&g_store_lock);
+
+	return result;
+}
+
+#endif /* DM_USE_MMAP */
+
 /* write to the data manager file */
 static ssize_t
 _write(dm_item_t item, unsigned char index, dm_persitence_t persistence, const void *buf, size_t count)
@@ -346,14 +729,7 @@ _write(dm_item_t item, unsigned char index, dm_persitence_t persistence, const v
 	}
 
 	/* Write out the data, prefixed with length and persistence level */
-	buffer[0] = count;
-	buffer[1] = persistence;
-	buffer[2] = 0;
-	buffer[3] = 0;
-
-	if (count > 0) {
-		memcpy(buffer + DM_SECTOR_HDR_SIZE, buf, count);
-	}
+	sector_encode(buffer, persistence, buf, count);
 
 	count += DM_SECTOR_HDR_SIZE;
 
@@ -365,6 +741,11 @@ _write(dm_item_t item, unsigned char index, dm_persitence_t persistence, const v
 			fsync(g_task_fd);        /* Make sure data is written to physical media */
 		}
 
+#ifdef DM_USE_CACHE
+	/* a copy of the old sector may have been cached in the meantime */
+	cache_drop_clean(offset);
+#endif
+
 	/* Make sure the write succeeded */
 	if (len != count) {
 		return -1;
@@ -394,6 +775,16 @@ _read(dm_item_t item, unsigned char index, void *buf, size_t count)
 		return -1;
 	}
 
+#ifdef DM_USE_CACHE
+	/* the sector may have been written to the cache since the caller missed it */
+	ssize_t result;
+
+	if (cache_read(offset, buf, count, &result)) {
+		return result;
+	}
+
+#endif
+
 	/* Read the prefix and data */
 	len = -1;
 
@@ -411,19 +802,147 @@ _read(dm_item_t item, unsigned char index, void *buf, size_t count)
 		buffer[0] = 0;
 	}
 
-	/* See if we got data */
-	if (buffer[0] > 0) {
-		/* We got more than requested!!! */
-		if (buffer[0] > count) {
-			return -1;
+#ifdef DM_USE_CACHE
+
+	/* only keep complete items */
+	if (buffer[0] <= count && (len == 0 || len >= DM_SECTOR_HDR_SIZE + buffer[0])) {
+		cache_fill(offset, buffer);
+	}
+
+#endif
+
+	return sector_decode(buffer, buf, count);
+}
+
+/* Read consecutive items with a single seek, returns the number of items read */
+static ssize_t
+_read_range(dm_item_t item, unsigned char index, unsigned num_items, void *buf, size_t item_size)
+{
+	unsigned char *dst = (unsigned char *)buf;
+	unsigned done = 0;
+	int offset;
+
+	/* Get the offset of the first item, the caller made sure that the range fits */
+	offset = calculate_offset(item, index);
+
+	if (offset < 0) {
+		return -1;
+	}
+
+#ifdef DM_USE_CACHE
+	/* Sectors are read around the cache, so write back what it holds first */
+	cache_flush();
+#endif
+
+	if (lseek(g_task_fd, offset, SEEK_SET) != offset) {
+		return -1;
+	}
+
+	/* too large for the worker thread's stack */
+	unsigned char *range_buffer = malloc(DM_RANGE_CHUNK_SECTORS * k_sector_size);
+
+	if (range_buffer == NULL) {
+		return -1;
+	}
+
+	while (done < num_items) {
+		unsigned chunk = num_items - done;
+
+		if (chunk > DM_RANGE_CHUNK_SECTORS) {
+			chunk = DM_RANGE_CHUNK_SECTORS;
 		}
 
-		/* Looks good, copy it to the caller's buffer */
-		memcpy(buf, buffer + DM_SECTOR_HDR_SIZE, buffer[0]);
+		ssize_t len = read(g_task_fd, range_buffer, chunk * k_sector_size);
+
+		if (len < 0) {
+			break;
+		}
+
+		for (unsigned i = 0; i < chunk; i++) {
+			unsigned char *sector = range_buffer + i * k_sector_size;
+			ssize_t avail = len - (ssize_t)(i * k_sector_size);
+
+			/* Sectors beyond the end of the file are empty */
+			if ((avail < DM_SECTOR_HDR_SIZE) || (avail < DM_SECTOR_HDR_SIZE + sector[0])) {
+				goto out;
+			}
+
+			if (sector_decode(sector, dst + done * item_size, item_size) != (ssize_t)item_size) {
+				goto out;
+			}
+
+			done++;
+		}
 	}
 
-	/* Return the number of bytes of caller data read */
-	return buffer[0];
+out:
+	free(range_buffer);
+	return done;
+}
+
+/* Write consecutive items with a single seek, returns the number of items written */
+static ssize_t
+_write_range(dm_item_t item, unsigned char index, unsigned num_items, dm_persitence_t persistence, const void *buf,
+	     size_t item_size)
+{
+	const unsigned char *src = (const unsigned char *)buf;
+	unsigned done = 0;
+	int offset;
+
+	/* Get the offset of the first item, the caller made sure that the range fits */
+	offset = calculate_offset(item, index);
+
+	if (offset < 0) {
+		return -1;
+	}
+
+#ifdef DM_USE_CACHE
+	/* Older cached copies must not be written back over the new data */
+	cache_flush();
+#endif
+
+	if (lseek(g_task_fd, offset, SEEK_SET) != offset) {
+		return -1;
+	}
+
+	/* too large for the worker thread's stack. Unused sector bytes are written as well, keep them deterministic */
+	unsigned char *range_buffer = calloc(DM_RANGE_CHUNK_SECTORS, k_sector_size);
+
+	if (range_buffer == NULL) {
+		return -1;
+	}
+
+	while (done < num_items) {
+		unsigned chunk = num_items - done;
+
+		if (chunk > DM_RANGE_CHUNK_SECTORS) {
+			chunk = DM_RANGE_CHUNK_SECTORS;
+		}
+
+		for (unsigned i = 0; i < chunk; i++) {
+			sector_encode(range_buffer + i * k_sector_size, persistence, src + (done + i) * item_size, item_size);
+		}
+
+		ssize_t len = chunk * k_sector_size;
+
+		if (write(g_task_fd, range_buffer, len) != len) {
+			break;
+		}
+
+		done += chunk;
+	}
+
+	free(range_buffer);
+
+	if (done > 0) {
+		fsync(g_task_fd);        /* Make sure data is written to physical media */
+	}
+
+#ifdef DM_USE_CACHE
+	cache_invalidate(offset, offset + num_items * k_sector_size);
+#endif
+
+	return done;
 }
 
 static int
@@ -439,6 +958,18 @@ _clear(dm_item_t item)
 		return -1;
 	}
 
+#ifdef DM_USE_MMAP
+
+	if (g_store != NULL) {
+		return store_clear(offset, g_per_item_max_index[item]);
+	}
+
+#endif
+
+#ifdef DM_USE_CACHE
+	cache_invalidate(offset, offset + g_per_item_max_index[item] * k_sector_size);
+#endif
+
 	/* Clear all items of this type */
 	for (i = 0; (unsigned)i < g_per_item_max_index[item]; i++) {
 		char buf[1];
@@ -485,6 +1016,23 @@ _restart(dm_reset_reason reason)
 
 	/* We need to scan the entire file and invalidate and data that should not persist after the last reset */
 
+	/* Whether data gets deleted depends on reset type and data segment's persistence setting */
+	unsigned max_persistence = (reason == DM_INIT_REASON_POWER_ON) ? DM_PERSIST_POWER_ON_RESET : DM_PERSIST_IN_FLIGHT_RESET;
+
+#ifdef DM_USE_MMAP
+
+	if (g_store != NULL) {
+		return store_restart(max_persistence);
+	}
+
+#endif
+
+#ifdef DM_USE_CACHE
+	/* write back pending data before scanning the file, then start over with an empty cache */
+	cache_flush();
+	cache_invalidate(0, INT32_MAX);
+#endif
+
 	/* Loop through all of the data segments and delete those that are not persistent */
 	while (1) {
 		size_t len;
@@ -504,22 +1052,8 @@ _restart(dm_reset_reason reason)
 
 		/* check if segment contains data */
 		if (buffer[0]) {
-			int clear_entry = 0;
-
-			/* Whether data gets deleted depends on reset type and data segment's persistence setting */
-			if (reason == DM_INIT_REASON_POWER_ON) {
-				if (buffer[1] > DM_PERSIST_POWER_ON_RESET) {
-					clear_entry = 1;
-				}
-
-			} else {
-				if (buffer[1] > DM_PERSIST_IN_FLIGHT_RESET) {
-					clear_entry = 1;
-				}
-			}
-
 			/* Set segment to unused if data does not persist */
-			if (clear_entry) {
+			if (buffer[1] > max_persistence) {
 				if (lseek(g_task_fd, offset, SEEK_SET) != offset) {
 					result = -1;
 					break;
@@ -556,6 +1090,39 @@ dm_write(dm_item_t item, unsigned char index, dm_persitence_t persistence, const
 		return -1;
 	}
 
+#if defined(DM_USE_MMAP) || defined(DM_USE_CACHE)
+	int offset = calculate_offset(item, index);
+
+	if ((offset < 0) || (count > DM_MAX_DATA_SIZE)) {
+		return -1;
+	}
+
+#endif
+
+#ifdef DM_USE_MMAP
+
+	if (g_store != NULL) {
+		__sync_fetch_and_add(&g_caller_context_hits, 1);
+		return store_write(offset, persistence, buf, count);
+	}
+
+#endif
+
+#ifdef DM_USE_CACHE
+
+	if (persistence == DM_PERSIST_POWER_ON_RESET) {
+		/* written through by the worker thread, an older unwritten copy must not be written back over it */
+		cache_invalidate(offset, offset + k_sector_size);
+
+	} else if (cache_write(offset, persistence, buf, count)) {
+		__sync_fetch_and_add(&g_caller_context_hits, 1);
+		/* wake up the worker thread to write it back */
+		px4_sem_post(&g_work_queued_sema);
+		return count;
+	}
+
+#endif
+
 	/* get a work item and queue up a write request */
 	if ((work = create_work_item()) == NULL) {
 		return -1;
@@ -583,6 +1150,34 @@ dm_read(dm_item_t item, unsigned char index, void *buf, size_t count)
 		return -1;
 	}
 
+#if defined(DM_USE_MMAP) || defined(DM_USE_CACHE)
+	int offset = calculate_offset(item, index);
+
+	if ((offset < 0) || (count > DM_MAX_DATA_SIZE)) {
+		return -1;
+	}
+
+#endif
+
+#ifdef DM_USE_MMAP
+
+	if (g_store != NULL) {
+		__sync_fetch_and_add(&g_caller_context_hits, 1);
+		return store_read(offset, buf, count);
+	}
+
+#endif
+
+#ifdef DM_USE_CACHE
+	ssize_t result;
+
+	if (cache_read(offset, buf, count, &result)) {
+		__sync_fetch_and_add(&g_caller_context_hits, 1);
+		return result;
+	}
+
+#endif
+
 	/* get a work item and queue up a read request */
 	if ((work = create_work_item()) == NULL) {
 		return -1;
@@ -608,6 +1203,15 @@ dm_clear(dm_item_t item)
 		return -1;
 	}
 
+#ifdef DM_USE_MMAP
+
+	if (g_store != NULL) {
+		__sync_fetch_and_add(&g_caller_context_hits, 1);
+		return _clear(item);
+	}
+
+#endif
+
 	/* get a work item and queue up a clear request */
 	if ((work = create_work_item()) == NULL) {
 		return -1;
@@ -620,6 +1224,108 @@ dm_clear(dm_item_t item)
 	return enqueue_work_item_and_wait_for_result(work);
 }
 
+/* Clip a range request to the items available for this item type, returns the number of items or -1 */
+static int
+clip_range(dm_item_t item, unsigned char index, unsigned num_items, size_t item_size)
+{
+	/* Make sure the item type and first index are valid and the items fit */
+	if ((calculate_offset(item, index) < 0) || (item_size > DM_MAX_DATA_SIZE)) {
+		return -1;
+	}
+
+	if (num_items > g_per_item_max_index[item] - index) {
+		num_items = g_per_item_max_index[item] - index;
+	}
+
+	return num_items;
+}
+
+/** Retrieve consecutive items from the data manager file */
+__EXPORT ssize_t
+dm_read_range(dm_item_t item, unsigned char index, unsigned num_items, void *buffer, size_t item_size)
+{
+	work_q_item_t *work;
+
+	/* Make sure data manager has been started and is not shutting down */
+	if ((g_fd < 0) || g_task_should_exit) {
+		return -1;
+	}
+
+	int count = clip_range(item, index, num_items, item_size);
+
+	if (count <= 0) {
+		return count;
+	}
+
+#ifdef DM_USE_MMAP
+
+	if (g_store != NULL) {
+		__sync_fetch_and_add(&g_caller_context_hits, 1);
+		return store_read_range(calculate_offset(item, index), count, buffer, item_size);
+	}
+
+#endif
+
+	/* get a work item and queue up a range read request */
+	if ((work = create_work_item()) == NULL) {
+		return -1;
+	}
+
+	work->func = dm_read_range_func;
+	work->read_range_params.item = item;
+	work->read_range_params.index = index;
+	work->read_range_params.num_items = count;
+	work->read_range_params.buf = buffer;
+	work->read_range_params.item_size = item_size;
+
+	/* Enqueue the item on the work queue and wait for the worker thread to complete processing it */
+	return (ssize_t)enqueue_work_item_and_wait_for_result(work);
+}
+
+/** Write consecutive items to the data manager file */
+__EXPORT ssize_t
+dm_write_range(dm_item_t item, unsigned char index, unsigned num_items, dm_persitence_t persistence,
+	       const void *buffer, size_t item_size)
+{
+	work_q_item_t *work;
+
+	/* Make sure data manager has been started and is not shutting down */
+	if ((g_fd < 0) || g_task_should_exit) {
+		return -1;
+	}
+
+	int count = clip_range(item, index, num_items, item_size);
+
+	if (count <= 0) {
+		return count;
+	}
+
+#ifdef DM_USE_MMAP
+
+	if (g_store != NULL) {
+		__sync_fetch_and_add(&g_caller_context_hits, 1);
+		return store_write_range(calculate_offset(item, index), count, persistence, buffer, item_size);
+	}
+
+#endif
+
+	/* get a work item and queue up a range write request */
+	if ((work = create_work_item()) == NULL) {
+		return -1;
+	}
+
+	work->func = dm_write_range_func;
+	work->write_range_params.item = item;
+	work->write_range_params.index = index;
+	work->write_range_params.num_items = count;
+	work->write_range_params.persistence = persistence;
+	work->write_range_params.buf = buffer;
+	work->write_range_params.item_size = item_size;
+
+	/* Enqueue the item on the work queue and wait for the worker thread to complete processing it */
+	return (ssize_t)enqueue_work_item_and_wait_for_result(work);
+}
+
 __EXPORT void
 dm_lock(dm_item_t item)
 {
@@ -665,6 +1371,15 @@ dm_restart(dm_reset_reason reason)
 		return -1;
 	}
 
+#ifdef DM_USE_MMAP
+
+	if (g_store != NULL) {
+		__sync_fetch_and_add(&g_caller_context_hits, 1);
+		return _restart(reason);
+	}
+
+#endif
+
 	/* get a work item and queue up a restart request */
 	if ((work = create_work_item()) == NULL) {
 		return -1;
@@ -704,6 +1419,18 @@ task_main(int argc, char *argv[])
 
 	g_item_locks[DM_KEY_MISSION_STATE] = &g_sys_state_mutex;
 
+	px4_sem_init(&g_store_lock, 1, 1);
+	g_caller_context_hits = 0;
+
+#ifdef DM_USE_CACHE
+
+	for (unsigned i = 0; i < DM_CACHE_SECTORS; i++) {
+		g_cache[i].offset = -1;
+		g_cache[i].dirty = false;
+	}
+
+#endif
+
 	g_task_should_exit = false;
 
 	init_q(&g_work_q);
@@ -770,6 +1497,24 @@ task_main(int argc, char *argv[])
 		}
 	}
 
+#ifdef DM_USE_MMAP
+	/* Map the file so that requests can be served in the caller's context, fall back to file I/O on failure */
+	struct stat st;
+
+	if ((fstat(g_task_fd, &st) == 0) && ((st.st_size >= (off_t)max_offset) || (ftruncate(g_task_fd, max_offset) == 0))) {
+		void *store = mmap(NULL, max_offset, PROT_READ | PROT_WRITE, MAP_SHARED, g_task_fd, 0);
+
+		if (store != MAP_FAILED) {
+			g_store_size = max_offset;
+			g_store = (unsigned char *)store;
+
+		} else {
+			PX4_WARN("Could not map data manager file %s, using file access", k_data_manager_device_path);
+		}
+	}
+
+#endif
+
 	/* We use two file descriptors, one for the caller context and one for the worker thread */
 	/* They are actually the same but we need to some way to reject caller request while the */
 	/* worker thread is shutting down but still processing requests */
@@ -823,6 +1568,20 @@ task_main(int argc, char *argv[])
 				work->result = _restart(work->restart_params.reason);
 				break;
 
+			case dm_read_range_func:
+				g_func_counts[dm_read_range_func]++;
+				work->result =
+					_read_range(work->read_range_params.item, work->read_range_params.index, work->read_range_params.num_items,
+						    work->read_range_params.buf, work->read_range_params.item_size);
+				break;
+
+			case dm_write_range_func:
+				g_func_counts[dm_write_range_func]++;
+				work->result =
+					_write_range(work->write_range_params.item, work->write_range_params.index, work->write_range_params.num_items,
+						     work->write_range_params.persistence, work->write_range_params.buf, work->write_range_params.item_size);
+				break;
+
 			default: /* should never happen */
 				work->result = -1;
 				break;
@@ -832,12 +1591,29 @@ task_main(int argc, char *argv[])
 			px4_sem_post(&work->wait_sem);
 		}
 
+#ifdef DM_USE_CACHE
+		/* write back what callers left in the cache */
+		cache_flush();
+#endif
+
 		/* time to go???? */
 		if ((g_task_should_exit) && (g_fd < 0)) {
 			break;
 		}
 	}
 
+#ifdef DM_USE_MMAP
+	px4_sem_wait(&g_store_lock);
+
+	if (g_store != NULL) {
+		msync(g_store, g_store_size, MS_SYNC);
+		munmap(g_store, g_store_size);
+		g_store = NULL;
+	}
+
+	px4_sem_post(&g_store_lock);
+#endif
+
 	close(g_task_fd);
 	g_task_fd = -1;
 
@@ -856,6 +1632,7 @@ task_main(int argc, char *argv[])
 	destroy_q(&g_free_q);
 	px4_sem_destroy(&g_work_queued_sema);
 	px4_sem_destroy(&g_sys_state_mutex);
+	px4_sem_destroy(&g_store_lock);
 
 	return 0;
 }
@@ -888,7 +1665,14 @@ status(void)
 	PX4_INFO("Reads    %d", g_func_counts[dm_read_func]);
 	PX4_INFO("Clears   %d", g_func_counts[dm_clear_func]);
 	PX4_INFO("Restarts %d", g_func_counts[dm_restart_func]);
+	PX4_INFO("Range reads %d, writes %d", g_func_counts[dm_read_range_func], g_func_counts[dm_write_range_func]);
 	PX4_INFO("Max Q lengths work %d, free %d", g_work_q.max_size, g_free_q.max_size);
+	PX4_INFO("Caller context %u", g_caller_context_hits);
+#ifdef DM_USE_MMAP
+	PX4_INFO("Backend: %s", (g_store != NULL) ? "mapped file" : "file");
+#elif defined(DM_USE_CACHE)
+	PX4_INFO("Backend: file, %d cached sectors", DM_CACHE_SECTORS);
+#endif
 }
 
 static void
@@ -110,6 +110,40 @@ dm_write(
 	size_t buflen			/* Length in bytes of data to retrieve */
 );
 
+/**
+ * Retrieve consecutive items from the data manager store
+ *
+ * Items are copied back to back into buffer, item_size bytes each, in a
+ * single request to the data manager. Returns the number of items read. The transfer stops at the first item
+ * whose stored length differs from item_size (e.g. an empty slot), at the
+ * last index of the item type or on error.
+ */
+__EXPORT ssize_t
+dm_read_range(
+	dm_item_t item,			/* The item type to retrieve */
+	unsigned char index,		/* The index of the first item */
+	unsigned num_items,		/* The number of items to retrieve */
+	void *buffer,			/* Pointer to caller data buffer, num_items * item_size bytes */
+	size_t item_size		/* Length in bytes of a single item */
+);
+
+/**
+ * Write consecutive items to the data manager store
+ *
+ * Items are taken back to back from buffer, item_size bytes each, in a
+ * single request to the data manager. Returns the number of items written,
+ * which is less than num_items on error or if the range exceeds the item type.
+ */
+__EXPORT ssize_t
+dm_write_range(
+	dm_item_t item,			/* The item type to store */
+	unsigned char index,		/* The index of the first item */
+	unsigned num_items,		/* The number of items to store */
+	dm_persitence_t persistence,	/* The persistence level of these items */
+	const void *buffer,		/* Pointer to caller data buffer, num_items * item_size bytes */
+	size_t item_size		/* Length in bytes of a single item */
+);
+
 /** Lock all items of this type */
 __EXPORT void
 dm_lock(
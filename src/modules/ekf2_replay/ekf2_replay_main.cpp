@@ -73,6 +73,7 @@
 #include <uORB/topics/vision_position_estimate.h>
 
 #include <sdlog2/sdlog2_messages.h>
+#include <ulog_reader/mapped_file.h>
 
 
 extern "C" __EXPORT int ekf2_replay_main(int argc, char *argv[]);
@@ -168,17 +169,25 @@ private:
 	int _write_fd = -1;
 	px4_pollfd_struct_t _fds[1];
 
+	ulog_reader::MappedFile _log_file;	// the log file is memory-mapped and read in place
+	size_t _log_offset = 0;			// read position in _log_file
+
+	// get the next bytes of the log file and advance the read position
+	// @size 	number of bytes
+	// @return 	pointer into the mapped log file, nullptr at the end of the file
+	const uint8_t *readLog(size_t size);
+
 	// parse replay message from buffer
 	// @source 			pointer to log message data (excluding header)
 	// @destination 	pointer to message struct of type @type
 	// @type 			message type
-	void parseMessage(uint8_t *source, uint8_t *destination, uint8_t type);
+	void parseMessage(const uint8_t *source, uint8_t *destination, uint8_t type);
 
 	// copy the replay data from the logs into the topic structs which
 	// will be puplished after
 	// @data 	pointer to the message struct of type @type
 	// @type 	message type
-	void setEstimatorInput(uint8_t *data, uint8_t type);
+	void setEstimatorInput(const uint8_t *data, uint8_t type);
 
 	// publish input data for estimator
 	void publishEstimatorInput();
@@ -187,7 +196,7 @@ private:
 	// @fd 		file descriptor
 	// @data 	pointer to log message
 	// @data 	size of data to be written
-	void writeMessage(int &fd, void *data, size_t size);
+	void writeMessage(int &fd, const void *data, size_t size);
 
 	// determins if we need so write a specific message to the replay log
 	// messages which are not regenerated by the estimator copied from the original log file
@@ -307,7 +316,7 @@ void Ekf2Replay::publishEstimatorInput()
 	_read_part6 = false;
 }
 
-void Ekf2Replay::parseMessage(uint8_t *source, uint8_t *destination, uint8_t type)
+void Ekf2Replay::parseMessage(const uint8_t *source, uint8_t *destination, uint8_t type)
 {
 	int i = 0;
 	int write_index = 0;
@@ -361,7 +370,7 @@ void Ekf2Replay::parseMessage(uint8_t *source, uint8_t *destination, uint8_t typ
 	}
 }
 
-void Ekf2Replay::setEstimatorInput(uint8_t *data, uint8_t type)
+void Ekf2Replay::setEstimatorInput(const uint8_t *data, uint8_t type)
 {
 	struct log_RPL1_s replay_part1 = {};
 	struct log_RPL2_s replay_part2 = {};
@@ -486,7 +495,18 @@ void Ekf2Replay::setEstimatorInput(uint8_t *data, uint8_t type)
 	}
 }
 
-void Ekf2Replay::writeMessage(int &fd, void *data, size_t size)
+const uint8_t *Ekf2Replay::readLog(size_t size)
+{
+	if (_log_offset + size > _log_file.size()) {
+		return nullptr;
+	}
+
+	const uint8_t *data = _log_file.data() + _log_offset;
+	_log_offset += size;
+	return data;
+}
+
+void Ekf2Replay::writeMessage(int &fd, const void *data, size_t size)
 {
 	if (size != ::write(fd, data, size)) {
 		PX4_WARN("error writing to file");
@@ -768,13 +788,16 @@ void Ekf2Replay::setUserParams(const char *filename)
 void Ekf2Replay::task_main()
 {
 	// formats
-	const int _k_max_data_size = 1024;	// 16x16 bytes
-	uint8_t data[_k_max_data_size] = {};
+	const uint8_t *data = nullptr;
 	const char param_file[] = "./rootfs/replay_params.txt";
 
 	// Open log file from which we read data
 	// TODO Check if file exists
-	int fd = ::open(_file_name, O_RDONLY);
+	if (_log_file.open(_file_name)) {
+		_log_file.adviseSequential();
+	}
+
+	_log_offset = 0;
 
 	// create path to write a replay file
 	char *replay_log_name;
@@ -833,9 +856,9 @@ void Ekf2Replay::task_main()
 
 	while (!_task_should_exit) {
 		_message_counter++;
-		uint8_t header[3] = {};
+		const uint8_t *header = readLog(3);
 
-		if (::read(fd, header, 3) != 3) {
+		if (header == nullptr) {
 			if (!read_first_header) {
 				PX4_WARN("error reading log file, is the path printed above correct?");
 
@@ -858,32 +881,34 @@ void Ekf2Replay::task_main()
 
 		// write header but only for messages which are not generated by the estimator
 		if (needToSaveMessage(header[2])) {
-			writeMessage(_write_fd, &header[0], 3);
+			writeMessage(_write_fd, header, 3);
 		}
 
 		if (header[2] == LOG_FORMAT_MSG) {
 			// format message
 			struct log_format_s f;
 
-			if (::read(fd, &f.type, sizeof(f)) != sizeof(f)) {
+			if ((data = readLog(sizeof(f))) == nullptr) {
 				PRINT_READ_ERROR;
 				_task_should_exit = true;
 				continue;
 			}
 
+			memcpy(&f, data, sizeof(f));
+
 			writeMessage(_write_fd, &f.type, sizeof(log_format_s));
 
 			memcpy(&_formats[f.type], &f, sizeof(f));
 
 		} else if (header[2] == LOG_PARM_MSG) {
 			// parameter message
-			if (::read(fd, &data[0], sizeof(log_PARM_s)) != sizeof(log_PARM_s)) {
+			if ((data = readLog(sizeof(log_PARM_s))) == nullptr) {
 				PRINT_READ_ERROR;
 				_task_should_exit = true;
 				continue;
 			}
 
-			writeMessage(_write_fd, &data[0], sizeof(log_PARM_s));
+			writeMessage(_write_fd, data, sizeof(log_PARM_s));
 
 			// apply the parameters
 			char param_name[16];
@@ -924,24 +949,24 @@ void Ekf2Replay::task_main()
 
 		} else if (header[2] == LOG_VER_MSG) {
 			// version message
-			if (::read(fd, &data[0], sizeof(log_VER_s)) != sizeof(log_VER_s)) {
+			if ((data = readLog(sizeof(log_VER_s))) == nullptr) {
 				PRINT_READ_ERROR;
 				_task_should_exit = true;
 				continue;
 			}
 
-			writeMessage(_write_fd, &data[0], sizeof(log_VER_s));
+			writeMessage(_write_fd, data, sizeof(log_VER_s));
 
 		} else if (header[2] == LOG_TIME_MSG) {
 			// time message
-			if (::read(fd, &data[0], sizeof(log_TIME_s)) != sizeof(log_TIME_s)) {
+			if ((data = readLog(sizeof(log_TIME_s))) == nullptr) {
 				// assume that this is because we have reached the end of the file
 				PX4_INFO("Done!");
 				_task_should_exit = true;
 				continue;
 			}
 
-			writeMessage(_write_fd, &data[0], sizeof(log_TIME_s));
+			writeMessage(_write_fd, data, sizeof(log_TIME_s));
 
 		} else {
 			// the first time we arrive here we should apply the parameters specified in the user file
@@ -953,7 +978,7 @@ void Ekf2Replay::task_main()
 			}
 
 			// data message
-			if (::read(fd, &data[0], _formats[header[2]].length - 3) != _formats[header[2]].length - 3) {
+			if ((data = readLog(_formats[header[2]].length - 3)) == nullptr) {
 				PX4_INFO("Done!");
 				_task_should_exit = true;
 				continue;
@@ -962,7 +987,7 @@ void Ekf2Replay::task_main()
 			// all messages which we are not getting from the estimator are written
 			// back into the replay log file
 			if (needToSaveMessage(header[2])) {
-				writeMessage(_write_fd, &data[0], _formats[header[2]].length - 3);
+				writeMessage(_write_fd, data, _formats[header[2]].length - 3);
 			}
 
 			if (header[2] == LOG_RPL1_MSG && _part1_counter_ref > 0) {
@@ -972,7 +997,7 @@ void Ekf2Replay::task_main()
 			}
 
 			// set estimator input data
-			setEstimatorInput(&data[0], header[2]);
+			setEstimatorInput(data, header[2]);
 
 			// we have read the imu replay message (part 1) and have waited 3 more cycles for other replay message parts
 			// e.g. flow, gps or range. we know that in case they were written to the log file they should come right after
@@ -984,7 +1009,7 @@ void Ekf2Replay::task_main()
 	}
 
 	::close(_write_fd);
-	::close(fd);
+	_log_file.close();
 	delete ekf2_replay::instance;
 	ekf2_replay::instance = nullptr;
 }
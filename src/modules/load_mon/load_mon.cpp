@@ -52,9 +52,12 @@
 #include <systemlib/systemlib.h>
 #include <systemlib/err.h>
 #include <systemlib/cpuload.h>
+#include <systemlib/perf_counter.h>
 
 #include <uORB/uORB.h>
 #include <uORB/topics/cpuload.h>
+#include <uORB/topics/perf_counters.h>
+#include <uORB/topics/task_load.h>
 
 extern struct system_load_s system_load;
 
@@ -84,6 +87,9 @@ public:
 	/* Trampoline for the work queue. */
 	static void cycle_trampoline(void *arg);
 
+	/* Trampoline for the snapshot on the low priority work queue. */
+	static void snapshot_trampoline(void *arg);
+
 	bool isRunning() { return _taskIsRunning; }
 
 private:
@@ -96,13 +102,37 @@ private:
 	/* Calculate the memory usage */
 	float _ram_used();
 
+	/* Publish the next page of the task load and perf counter topics. */
+	void _snapshot();
+
+	/* Fill the task_load topic with the next page of tasks. */
+	void _snapshot_tasks();
+
+	/* Fill the perf_counters topic with the next page of counters. */
+	void _snapshot_perf();
+
+	/* Add a perf counter to the current page, callback for perf_iterate_all(). */
+	static void _perf_counter_cb(perf_counter_t handle, void *user);
+
 	bool _taskShouldExit;
 	bool _taskIsRunning;
 	struct work_s _work;
+	struct work_s _snapshot_work;
 
 	struct cpuload_s _cpuload;
 	orb_advert_t _cpuload_pub;
 	hrt_abstime _last_idle_time;
+
+	struct task_load_s _task_load;
+	orb_advert_t _task_load_pub;
+	uint64_t _last_runtime[CONFIG_MAX_TASKS];	///< runtime of each task slot in the previous interval
+	uint32_t _last_wakeups[CONFIG_MAX_TASKS];	///< wakeups of each task slot in the previous interval
+	pid_t _last_pid[CONFIG_MAX_TASKS];		///< task of each slot in the previous interval, -1 if none
+	hrt_abstime _last_snapshot_time;
+
+	struct perf_counters_s _perf_counters;
+	orb_advert_t _perf_counters_pub;
+	unsigned _perf_index;				///< running index of the counter, while iterating
 };
 
 
@@ -110,14 +140,28 @@ LoadMon::LoadMon() :
 	_taskShouldExit(false),
 	_taskIsRunning(false),
 	_work{},
+	_snapshot_work{},
 	_cpuload{},
 	_cpuload_pub(nullptr),
-	_last_idle_time(0)
-{}
+	_last_idle_time(0),
+	_task_load{},
+	_task_load_pub(nullptr),
+	_last_runtime{},
+	_last_wakeups{},
+	_last_snapshot_time(0),
+	_perf_counters{},
+	_perf_counters_pub(nullptr),
+	_perf_index(0)
+{
+	for (unsigned i = 0; i < CONFIG_MAX_TASKS; i++) {
+		_last_pid[i] = -1;
+	}
+}
 
 LoadMon::~LoadMon()
 {
 	work_cancel(HPWORK, &_work);
+	work_cancel(LPWORK, &_snapshot_work);
 	_taskIsRunning = false;
 }
 
@@ -140,12 +184,26 @@ LoadMon::cycle_trampoline(void *arg)
 	dev->_cycle();
 }
 
+void
+LoadMon::snapshot_trampoline(void *arg)
+{
+	LoadMon *dev = reinterpret_cast<LoadMon *>(arg);
+
+	dev->_snapshot();
+}
+
 void LoadMon::_cycle()
 {
 	_taskIsRunning = true;
 
 	_compute();
 
+	/* The snapshot walks the task stacks, keep that off the high priority queue.
+	 * It takes much less than an interval, so the previous one has always completed. */
+	if (!_taskShouldExit) {
+		work_queue(LPWORK, &_snapshot_work, (worker_t)&LoadMon::snapshot_trampoline, this, 0);
+	}
+
 	if (!_taskShouldExit) {
 		work_queue(HPWORK, &_work, (worker_t)&LoadMon::cycle_trampoline, this,
 			   USEC2TICK(LOAD_MON_INTERVAL_US));
@@ -176,6 +234,153 @@ void LoadMon::_compute()
 	}
 }
 
+void LoadMon::_snapshot()
+{
+	_snapshot_tasks();
+	_snapshot_perf();
+}
+
+void LoadMon::_snapshot_tasks()
+{
+#ifdef __PX4_NUTTX
+	const unsigned name_len = task_load_s::NAME_LEN;
+	const unsigned max_tasks = task_load_s::MAX_TASKS;
+	uint8_t *stack_start[task_load_s::MAX_TASKS];
+	unsigned stack_size[task_load_s::MAX_TASKS];
+	unsigned slot[task_load_s::MAX_TASKS];
+	const uint8_t index = _task_load.index;
+	const hrt_abstime now = hrt_absolute_time();
+	const float interval = (_last_snapshot_time > 0) ? now - _last_snapshot_time : LOAD_MON_INTERVAL_US;
+	unsigned total = 0;
+	unsigned count = 0;
+
+	_last_snapshot_time = now;
+
+	memset(&_task_load, 0, sizeof(_task_load));
+	_task_load.index = index;
+
+	/* The tasks cannot exit while copying their state */
+	sched_lock();
+
+	for (unsigned i = 0; i < CONFIG_MAX_TASKS; i++) {
+		struct system_load_taskinfo_s *task = &system_load.tasks[i];
+
+		if (!task->valid || task->tcb == nullptr) {
+			_last_pid[i] = -1;
+			continue;
+		}
+
+		const bool known = (_last_pid[i] == task->tcb->pid);
+		const uint64_t runtime = known ? task->total_runtime - _last_runtime[i] : 0;
+		const uint32_t wakeups = known ? task->wakeups - _last_wakeups[i] : 0;
+
+		_last_pid[i] = task->tcb->pid;
+		_last_runtime[i] = task->total_runtime;
+		_last_wakeups[i] = task->wakeups;
+
+		if (total++ < index || count >= max_tasks) {
+			continue;
+		}
+
+		strncpy(&_task_load.name[count * name_len], task->tcb->name, name_len - 1);
+		_task_load.pid[count] = task->tcb->pid;
+		_task_load.load[count] = (float)runtime / interval;
+		_task_load.wakeups[count] = wakeups;
+		stack_start[count] = (uint8_t *)task->tcb->stack_alloc_ptr;
+		stack_size[count] = (uintptr_t)task->tcb->adj_stack_ptr - (uintptr_t)task->tcb->stack_alloc_ptr;
+		slot[count] = i;
+		count++;
+	}
+
+	sched_unlock();
+
+	/* The never used part of the stack still has the initial 0xff fill. The sweep runs with the
+	 * scheduler unlocked to not delay other tasks, so the task can exit and its stack be reused
+	 * meanwhile: the result is only kept if the task still owns the same stack afterwards. */
+	for (unsigned i = 0; i < count; i++) {
+		unsigned stack_free = 0;
+
+		while (stack_free < stack_size[i] && stack_start[i][stack_free] == 0xff) {
+			stack_free++;
+		}
+
+		sched_lock();
+
+		const struct system_load_taskinfo_s *task = &system_load.tasks[slot[i]];
+
+		if (!task->valid || task->tcb == nullptr || task->tcb->pid != _task_load.pid[i] ||
+		    (uint8_t *)task->tcb->stack_alloc_ptr != stack_start[i]) {
+			stack_free = 0;
+		}
+
+		sched_unlock();
+
+		_task_load.stack_free[i] = stack_free;
+	}
+
+	_task_load.timestamp = now;
+	_task_load.total = total;
+	_task_load.count = count;
+
+	if (_task_load_pub == nullptr) {
+		_task_load_pub = orb_advertise(ORB_ID(task_load), &_task_load);
+
+	} else {
+		orb_publish(ORB_ID(task_load), _task_load_pub, &_task_load);
+	}
+
+	/* next page, or start over */
+	_task_load.index = (index + count < total) ? index + count : 0;
+#endif
+}
+
+void LoadMon::_snapshot_perf()
+{
+	const uint16_t index = _perf_counters.index;
+
+	memset(&_perf_counters, 0, sizeof(_perf_counters));
+	_perf_counters.index = index;
+	_perf_index = 0;
+
+	perf_iterate_all(&LoadMon::_perf_counter_cb, this);
+
+	_perf_counters.timestamp = hrt_absolute_time();
+	_perf_counters.total = _perf_index;
+
+	if (_perf_counters_pub == nullptr) {
+		_perf_counters_pub = orb_advertise(ORB_ID(perf_counters), &_perf_counters);
+
+	} else {
+		orb_publish(ORB_ID(perf_counters), _perf_counters_pub, &_perf_counters);
+	}
+
+	/* next page, or start over */
+	_perf_counters.index = (index + _perf_counters.count < _perf_index) ? index + _perf_counters.count : 0;
+}
+
+void LoadMon::_perf_counter_cb(perf_counter_t handle, void *user)
+{
+	LoadMon *dev = reinterpret_cast<LoadMon *>(user);
+	struct perf_counters_s &msg = dev->_perf_counters;
+	const unsigned name_len = perf_counters_s::NAME_LEN;
+
+	if (dev->_perf_index++ < msg.index || msg.count >= perf_counters_s::MAX_COUNTERS) {
+		return;
+	}
+
+	struct perf_counter_summary summary;
+	perf_get_summary(handle, &summary);
+
+	const unsigned i = msg.count++;
+	strncpy(&msg.name[i * name_len], summary.name, name_len - 1);
+	msg.type[i] = summary.type;
+	msg.events[i] = summary.event_count;
+	msg.overruns[i] = summary.event_overruns;
+	msg.avg_us[i] = summary.time_avg;
+	msg.max_us[i] = summary.time_max;
+	msg.p99_us[i] = summary.time_p99;
+}
+
 float LoadMon::_ram_used()
 {
 #ifdef __PX4_NUTTX
@@ -0,0 +1,200 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#include "backfill_buffer.h"
+#include "messages.h"
+#include <string.h>
+
+namespace px4
+{
+namespace logger
+{
+
+BackfillBuffer::~BackfillBuffer()
+{
+	delete[] _buffer;
+}
+
+bool BackfillBuffer::init(size_t buffer_size, hrt_abstime window)
+{
+	if (_buffer) {
+		return true;
+	}
+
+	_buffer = new uint8_t[buffer_size];
+
+	if (!_buffer) {
+		return false;
+	}
+
+	_buffer_size = buffer_size;
+	_window = window;
+	/* the marks must span the window plus one slice, keep one spare */
+	_mark_interval = window / (MAX_MARKS - 2);
+	reset();
+	return true;
+}
+
+void BackfillBuffer::reset()
+{
+	_head = 0;
+	_tail = 0;
+	_marks_first = 0;
+	_marks_count = 0;
+}
+
+size_t BackfillBuffer::tail_message_size() const
+{
+	uint8_t header[ULOG_MSG_HEADER_LEN];
+	copy_out(_tail, header, sizeof(header));
+	return (header[0] | (header[1] << 8)) + ULOG_MSG_HEADER_LEN;
+}
+
+void BackfillBuffer::copy_out(size_t offset, uint8_t *dst, size_t size) const
+{
+	size_t n = _buffer_size - offset;
+
+	if (n > size) {
+		n = size;
+	}
+
+	memcpy(dst, _buffer + offset, n);
+	memcpy(dst + n, _buffer, size - n);
+}
+
+void BackfillBuffer::drop_oldest()
+{
+	_tail = (_tail + tail_message_size()) % _buffer_size;
+	drop_marks_before_tail();
+}
+
+void BackfillBuffer::drop_marks_before_tail()
+{
+	size_t fill = fill_count(_tail);
+
+	/* a mark is still valid as long as it lies between tail and head */
+	while (_marks_count > 0) {
+		size_t offset = _marks[_marks_first].offset;
+		size_t distance = (offset >= _tail) ? offset - _tail : _buffer_size - _tail + offset;
+
+		if (distance < fill) {
+			break;
+		}
+
+		_marks_first = (_marks_first + 1) % MAX_MARKS;
+		--_marks_count;
+	}
+}
+
+bool BackfillBuffer::write(const uint8_t *msg, size_t size)
+{
+	if (!_buffer || size >= _buffer_size) {
+		return false;
+	}
+
+	hrt_abstime now = hrt_absolute_time();
+
+	/* drop the slices that are completely older than the window */
+	while (_marks_count > 1) {
+		const Mark &next = _marks[(_marks_first + 1) % MAX_MARKS];
+
+		if (now - next.time <= _window) {
+			break;
+		}
+
+		_tail = next.offset;
+		_marks_first = (_marks_first + 1) % MAX_MARKS;
+		--_marks_count;
+	}
+
+	/* one byte always stays free to tell full from empty */
+	while (_buffer_size - 1 - fill_count(_tail) < size) {
+		drop_oldest();
+	}
+
+	if (_marks_count == 0 || now - _marks[(_marks_first + _marks_count - 1) % MAX_MARKS].time >= _mark_interval) {
+		if (_marks_count == MAX_MARKS) {
+			/* cannot happen with a steady clock, the window drops marks before */
+			_marks_first = (_marks_first + 1) % MAX_MARKS;
+			--_marks_count;
+		}
+
+		Mark &mark = _marks[(_marks_first + _marks_count) % MAX_MARKS];
+		mark.time = now;
+		mark.offset = _head;
+		++_marks_count;
+	}
+
+	size_t n = _buffer_size - _head;
+
+	if (n > size) {
+		n = size;
+	}
+
+	memcpy(_buffer + _head, msg, n);
+	memcpy(_buffer, msg + n, size - n);
+	_head = (_head + size) % _buffer_size;
+
+	return true;
+}
+
+size_t BackfillBuffer::read(uint8_t *msg, size_t max_size)
+{
+	if (!_buffer || _head == _tail) {
+		return 0;
+	}
+
+	size_t size = tail_message_size();
+
+	if (size > max_size) {
+		return 0;
+	}
+
+	copy_out(_tail, msg, size);
+	_tail = (_tail + size) % _buffer_size;
+	drop_marks_before_tail();
+
+	return size;
+}
+
+hrt_abstime BackfillBuffer::oldest_time() const
+{
+	if (_head == _tail || _marks_count == 0) {
+		return 0;
+	}
+
+	return _marks[_marks_first].time;
+}
+
+}
+}
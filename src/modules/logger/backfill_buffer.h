@@ -0,0 +1,140 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <drivers/drv_hrt.h>
+
+namespace px4
+{
+namespace logger
+{
+
+/**
+ * Ring of already serialized ULog messages, used to keep the most recent data
+ * while the logger is not writing a log (e.g. before arming), so that it can be
+ * written at the beginning of the next log.
+ *
+ * The buffer has the same layout as the LogWriter buffer: complete ULog messages
+ * back to back, wrapping around at the end. When the buffer is full or messages
+ * are older than the configured window, the oldest messages are dropped.
+ * Used from the logger thread only, no locking.
+ */
+class BackfillBuffer
+{
+public:
+	BackfillBuffer() = default;
+	~BackfillBuffer();
+
+	/**
+	 * Allocate the buffer
+	 * @param buffer_size size in bytes
+	 * @param window maximum age of the buffered data [us]
+	 * @return true on success
+	 */
+	bool init(size_t buffer_size, hrt_abstime window);
+
+	bool enabled() const { return _buffer != nullptr; }
+
+	/**
+	 * Add a complete ULog message, dropping the oldest ones if needed
+	 * @return false if the message is larger than the buffer
+	 */
+	bool write(const uint8_t *msg, size_t size);
+
+	/**
+	 * Remove the oldest message from the buffer
+	 * @param msg buffer for the message
+	 * @param max_size size of msg
+	 * @return size of the message, 0 if the buffer is empty (or the message does not fit into msg)
+	 */
+	size_t read(uint8_t *msg, size_t max_size);
+
+	/**
+	 * Time at which the oldest buffered message was added, 0 if empty
+	 */
+	hrt_abstime oldest_time() const;
+
+	void reset();
+
+	size_t get_buffer_size() const { return _buffer_size; }
+
+	size_t get_fill_count() const { return fill_count(_tail); }
+
+	hrt_abstime get_window() const { return _window; }
+
+private:
+
+	/**
+	 * The buffer is divided into time slices: a mark stores the position of the first
+	 * message added after the given time. Slices older than the window are dropped as a whole.
+	 */
+	struct Mark {
+		hrt_abstime time;
+		size_t offset;
+	};
+
+	static constexpr unsigned MAX_MARKS = 32;
+
+	size_t fill_count(size_t from) const
+	{
+		return (_head >= from) ? _head - from : _buffer_size - from + _head;
+	}
+
+	/**
+	 * Size of the message at the tail, including the header
+	 */
+	size_t tail_message_size() const;
+
+	void drop_oldest();
+
+	void drop_marks_before_tail();
+
+	void copy_out(size_t offset, uint8_t *dst, size_t size) const;
+
+	uint8_t		*_buffer = nullptr;
+	size_t		_buffer_size = 0;
+	size_t		_head = 0; ///< next position to write to
+	size_t		_tail = 0; ///< oldest message
+	hrt_abstime	_window = 0;
+	hrt_abstime	_mark_interval = 0;
+
+	Mark		_marks[MAX_MARKS];
+	unsigned	_marks_first = 0;
+	unsigned	_marks_count = 0;
+};
+
+}
+}
@@ -0,0 +1,164 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#include "log_index.h"
+
+namespace px4
+{
+namespace logger
+{
+
+LogIndex::~LogIndex()
+{
+	delete[] _entries;
+	delete[] _last_entry;
+	delete[] _events;
+}
+
+bool LogIndex::init(unsigned max_entries, unsigned max_events, unsigned max_msg_ids)
+{
+	if (_entries) {
+		return true;
+	}
+
+	/* sample indexes are stored as uint16_t */
+	if (max_entries >= NO_ENTRY) {
+		max_entries = NO_ENTRY - 1;
+	}
+
+	_entries = new ulog_index_data_entry_s[max_entries];
+	_last_entry = new uint16_t[max_msg_ids];
+	_events = new uint64_t[max_events];
+
+	if (!_entries || !_last_entry || !_events) {
+		delete[] _entries;
+		delete[] _last_entry;
+		delete[] _events;
+		_entries = nullptr;
+		_last_entry = nullptr;
+		_events = nullptr;
+		return false;
+	}
+
+	_max_entries = max_entries;
+	_max_events = max_events;
+	_max_msg_ids = max_msg_ids;
+	reset();
+	return true;
+}
+
+void LogIndex::reset()
+{
+	_num_entries = 0;
+	_num_events = 0;
+	_events_complete = true;
+	_interval = INITIAL_INTERVAL;
+
+	for (unsigned i = 0; i < _max_msg_ids; ++i) {
+		_last_entry[i] = NO_ENTRY;
+	}
+}
+
+void LogIndex::add_data(uint16_t msg_id, uint64_t timestamp, uint64_t offset)
+{
+	if (!_entries || msg_id >= _max_msg_ids || timestamp == 0) {
+		return;
+	}
+
+	uint16_t last = _last_entry[msg_id];
+
+	if (last != NO_ENTRY && timestamp < _entries[last].timestamp + _interval) {
+		return;
+	}
+
+	if (_num_entries == _max_entries) {
+		decimate();
+
+		/* the new sample might be too close to the remaining one now */
+		last = _last_entry[msg_id];
+
+		if (_num_entries == _max_entries ||
+		    (last != NO_ENTRY && timestamp < _entries[last].timestamp + _interval)) {
+			return;
+		}
+	}
+
+	ulog_index_data_entry_s &entry = _entries[_num_entries];
+	entry.timestamp = timestamp;
+	entry.offset = offset;
+	entry.msg_id = msg_id;
+	_last_entry[msg_id] = _num_entries;
+	++_num_entries;
+}
+
+void LogIndex::decimate()
+{
+	_interval *= 2;
+
+	for (unsigned i = 0; i < _max_msg_ids; ++i) {
+		_last_entry[i] = NO_ENTRY;
+	}
+
+	/* keep a sample if it is at least the new interval after the previous kept one */
+	unsigned num_kept = 0;
+
+	for (unsigned i = 0; i < _num_entries; ++i) {
+		const ulog_index_data_entry_s &entry = _entries[i];
+		uint16_t last = _last_entry[entry.msg_id];
+
+		if (last == NO_ENTRY || entry.timestamp >= _entries[last].timestamp + _interval) {
+			_entries[num_kept] = entry;
+			_last_entry[entry.msg_id] = num_kept;
+			++num_kept;
+		}
+	}
+
+	_num_entries = num_kept;
+}
+
+void LogIndex::add_event(uint64_t offset)
+{
+	if (!_events) {
+		return;
+	}
+
+	if (_num_events == _max_events) {
+		_events_complete = false;
+		return;
+	}
+
+	_events[_num_events++] = offset;
+}
+
+}
+}
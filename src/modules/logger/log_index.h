@@ -0,0 +1,128 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <drivers/drv_hrt.h>
+#include "messages.h"
+
+namespace px4
+{
+namespace logger
+{
+
+/**
+ * Index of the current log, written at the end of the log so that a reader can seek
+ * in the file without parsing it from the start (@see ulog_message_index_end_s).
+ *
+ * It contains timestamp -> offset samples for each logged topic instance, at most one
+ * per topic and sample interval, and the offsets of the messages that change the state
+ * of a reader (parameter changes and topics added while logging).
+ * The memory is fixed: when the samples are full, every other sample is dropped and the
+ * interval is doubled, so that a log of any length is covered.
+ * Used from the logger thread only, no locking.
+ */
+class LogIndex
+{
+public:
+	LogIndex() = default;
+	~LogIndex();
+
+	/**
+	 * Allocate the index
+	 * @param max_entries maximum number of data samples
+	 * @param max_events maximum number of event offsets
+	 * @param max_msg_ids message ids must be smaller than this
+	 * @return true on success
+	 */
+	bool init(unsigned max_entries, unsigned max_events, unsigned max_msg_ids);
+
+	bool enabled() const { return _entries != nullptr; }
+
+	/**
+	 * Clear the index, call at the start of a log
+	 */
+	void reset();
+
+	/**
+	 * Add a data message. It is only stored if the last stored sample of this
+	 * message id is older than the sample interval.
+	 * @param timestamp timestamp of the message
+	 * @param offset file offset of the message
+	 */
+	void add_data(uint16_t msg_id, uint64_t timestamp, uint64_t offset);
+
+	/**
+	 * Add the offset of a PARAMETER or ADD_LOGGED_MSG message
+	 */
+	void add_event(uint64_t offset);
+
+	const ulog_index_data_entry_s *entries() const { return _entries; }
+	unsigned num_entries() const { return _num_entries; }
+
+	const uint64_t *events() const { return _events; }
+	unsigned num_events() const { return _num_events; }
+
+	/**
+	 * @return false if events got dropped because the index is full
+	 */
+	bool events_complete() const { return _events_complete; }
+
+	hrt_abstime get_interval() const { return _interval; }
+
+private:
+	/**
+	 * Drop every other sample of each message id and double the interval
+	 */
+	void decimate();
+
+	static constexpr hrt_abstime INITIAL_INTERVAL = 1000 * 1000; ///< initial sample interval [us]
+	static constexpr uint16_t NO_ENTRY = 0xffff;
+
+	ulog_index_data_entry_s *_entries = nullptr;
+	unsigned	_max_entries = 0;
+	unsigned	_num_entries = 0;
+	uint16_t	*_last_entry = nullptr; ///< per message id: index of the last sample, NO_ENTRY if none
+	unsigned	_max_msg_ids = 0;
+	hrt_abstime	_interval = INITIAL_INTERVAL;
+
+	uint64_t	*_events = nullptr;
+	unsigned	_max_events = 0;
+	unsigned	_num_events = 0;
+	bool		_events_complete = true;
+};
+
+}
+}
@@ -37,24 +37,27 @@
 #include <string.h>
 
 #include <mathlib/mathlib.h>
+#include <ulog_compression/ulog_compression.h>
 
 namespace px4
 {
 namespace logger
 {
 constexpr size_t LogWriter::_min_write_chunk;
+constexpr size_t LogWriter::_cache_line_size;
 
 
-LogWriter::LogWriter(size_t buffer_size) :
+LogWriter::LogWriter(size_t buffer_size, bool compress) :
 	//We always write larger chunks (orb messages) to the buffer, so the buffer
 	//needs to be larger than the minimum write chunk (300 is somewhat arbitrary)
-	_buffer_size(math::max(buffer_size, _min_write_chunk + 300))
+	_buffer_size(math::max(buffer_size, _min_write_chunk + 300)),
+	_compress(compress)
 {
-	pthread_mutex_init(&_mtx, nullptr);
-	pthread_cond_init(&_cv, nullptr);
+	px4_sem_init(&_sem, 0, 0);
 	/* allocate write performance counters */
 	_perf_write = perf_alloc(PC_ELAPSED, "sd write");
 	_perf_fsync = perf_alloc(PC_ELAPSED, "sd fsync");
+	_perf_compress = compress ? perf_alloc(PC_ELAPSED, "log compress") : nullptr;
 }
 
 bool LogWriter::init()
@@ -63,6 +66,15 @@ bool LogWriter::init()
 		return true;
 	}
 
+	if (_compress) {
+		_compress_buffer = new uint8_t[ulog_compression::MAX_FRAMED_BLOCK_SIZE];
+		_compress_hash_table = new uint16_t[ulog_compression::HASH_TABLE_SIZE];
+
+		if (!_compress_buffer || !_compress_hash_table) {
+			return false;
+		}
+	}
+
 	_buffer = new uint8_t[_buffer_size];
 
 	return _buffer;
@@ -70,14 +82,20 @@ bool LogWriter::init()
 
 LogWriter::~LogWriter()
 {
-	pthread_mutex_destroy(&_mtx);
-	pthread_cond_destroy(&_cv);
+	px4_sem_destroy(&_sem);
 	perf_free(_perf_write);
 	perf_free(_perf_fsync);
 
+	if (_perf_compress) {
+		perf_free(_perf_compress);
+	}
+
 	if (_buffer) {
 		delete[] _buffer;
 	}
+
+	delete[] _compress_buffer;
+	delete[] _compress_hash_table;
 }
 
 void LogWriter::start_log(const char *filename)
@@ -88,17 +106,23 @@ void LogWriter::start_log(const char *filename)
 		PX4_ERR("Can't open log file %s", filename);
 		_should_run = false;
 		return;
-
-	} else {
-		PX4_INFO("Opened log file: %s", filename);
-		_should_run = true;
-		_running = true;
 	}
 
-	// Clear buffer and counters
+	PX4_INFO("Opened log file: %s", filename);
+
+	// Clear buffer and counters before the writer thread can see _should_run: a
+	// leftover semaphore post can wake it up before notify().
 	_head = 0;
-	_count = 0;
+	_tail = 0;
 	_total_written = 0;
+	_total_written_raw = 0;
+	_log_position = 0;
+	_max_fill = 0;
+	_dropouts = 0;
+	__sync_synchronize();
+
+	_should_run = true;
+	_running = true;
 	notify();
 }
 
@@ -147,13 +171,9 @@ void LogWriter::run()
 		// Outer endless loop
 		// Wait for _should_run flag
 		while (!_exit_thread) {
-			bool start = false;
-			pthread_mutex_lock(&_mtx);
-			pthread_cond_wait(&_cv, &_mtx);
-			start = _should_run;
-			pthread_mutex_unlock(&_mtx);
+			px4_sem_wait(&_sem);
 
-			if (start) {
+			if (_should_run) {
 				break;
 			}
 		}
@@ -166,11 +186,9 @@ void LogWriter::run()
 			void *read_ptr = nullptr;
 			bool is_part = false;
 
-			/* lock _buffer
-			 * wait for sufficient data, cycle on notify()
+			/* wait for sufficient data. The producer only wakes us up once the threshold
+			 * is reached, notify() wakes us up unconditionally (eg. to stop)
 			 */
-			pthread_mutex_lock(&_mtx);
-
 			while (true) {
 				available = get_read_ptr(&read_ptr, &is_part);
 
@@ -180,19 +198,23 @@ void LogWriter::run()
 					break;
 				}
 
-				/* wait for a call to notify()
-				 * this call unlocks the mutex while waiting, and returns with the mutex locked
-				 */
-				pthread_cond_wait(&_cv, &_mtx);
+				/* request a wakeup, then check again so that data written in between is not missed */
+				_need_wakeup = 1;
+				__sync_synchronize();
+				available = get_read_ptr(&read_ptr, &is_part);
+
+				if ((available >= _min_write_chunk) || is_part || !_should_run) {
+					_need_wakeup = 0;
+					break;
+				}
+
+				px4_sem_wait(&_sem);
 			}
 
-			pthread_mutex_unlock(&_mtx);
 			written = 0;
 
 			if (available > 0) {
-				perf_begin(_perf_write);
-				written = ::write(_fd, read_ptr, available);
-				perf_end(_perf_write);
+				written = write_file(read_ptr, available);
 
 				/* call fsync periodically to minimize potential loss of data */
 				if (++poll_count >= 100) {
@@ -209,19 +231,13 @@ void LogWriter::run()
 					break;
 				}
 
-				pthread_mutex_lock(&_mtx);
-				/* subtract bytes written from number in _buffer (_count -= written) */
+				/* hand the space back to the producer */
 				mark_read(written);
-				pthread_mutex_unlock(&_mtx);
-
-				_total_written += written;
 			}
 
 			if (!_should_run && written == static_cast<int>(available) && !is_part) {
 				// Stop only when all data written
 				_running = false;
-				_head = 0;
-				_count = 0;
 
 				if (_fd >= 0) {
 					int res = ::close(_fd);
@@ -241,19 +257,66 @@ void LogWriter::run()
 	}
 }
 
-bool LogWriter::write(void *ptr, size_t size, uint64_t dropout_start)
+int LogWriter::write_file(const void *data, size_t size)
 {
+	if (!_compress) {
+		perf_begin(_perf_write);
+		int written = ::write(_fd, data, size);
+		perf_end(_perf_write);
+
+		if (written > 0) {
+			_total_written += written;
+			_total_written_raw += written;
+		}
+
+		return written;
+	}
+
+	/* write one block at a time: the block must be written completely, otherwise the
+	 * data is lost (the reader resynchronizes on the next block) */
+	size_t raw_size = math::min(size, ulog_compression::MAX_BLOCK_SIZE);
+
+	perf_begin(_perf_compress);
+	size_t block_size = ulog_compression::write_block((const uint8_t *)data, raw_size, _compress_buffer,
+			    _compress_hash_table);
+	perf_end(_perf_compress);
+
+	size_t block_written = 0;
+
+	while (block_written < block_size) {
+		perf_begin(_perf_write);
+		int ret = ::write(_fd, _compress_buffer + block_written, block_size - block_written);
+		perf_end(_perf_write);
+
+		if (ret <= 0) {
+			return -1;
+		}
+
+		block_written += ret;
+	}
+
+	_total_written += block_size;
+	_total_written_raw += raw_size;
+
+	return raw_size;
+}
+
+bool LogWriter::write(const void *ptr, size_t size, const void *ptr2, size_t size2, uint64_t dropout_start)
+{
+	size_t head = _head;
+	size_t tail = _tail;
 
 	// Bytes available to write
-	size_t available = _buffer_size - _count;
+	size_t available = _buffer_size - 1 - fill_count(head, tail);
 	size_t dropout_size = 0;
 
 	if (dropout_start) {
 		dropout_size = sizeof(ulog_message_dropout_s);
 	}
 
-	if (size + dropout_size > available) {
+	if (size + size2 + dropout_size > available) {
 		// buffer overflow
+		++_dropouts;
 		return false;
 	}
 
@@ -261,23 +324,47 @@ bool LogWriter::write(void *ptr, size_t size, uint64_t dropout_start)
 		//write dropout msg
 		ulog_message_dropout_s dropout_msg;
 		dropout_msg.duration = (uint16_t)(hrt_elapsed_time(&dropout_start) / 1000);
-		write_no_check(&dropout_msg, sizeof(dropout_msg));
+		head = write_no_check(head, &dropout_msg, sizeof(dropout_msg));
+	}
+
+	head = write_no_check(head, ptr, size);
+
+	if (size2 > 0) {
+		head = write_no_check(head, ptr2, size2);
+	}
+
+	_log_position += size + size2 + dropout_size;
+
+	/* publish the data before the new head */
+	__sync_synchronize();
+	_head = head;
+
+	size_t fill = fill_count(head, tail);
+
+	if (fill > _max_fill) {
+		_max_fill = fill;
+	}
+
+	/* wake up the writer thread if it waits and has enough to write (same condition as in run()) */
+	if (_need_wakeup && (fill >= _min_write_chunk || head < tail)) {
+		if (__sync_fetch_and_and(&_need_wakeup, 0)) {
+			px4_sem_post(&_sem);
+		}
 	}
 
-	write_no_check(ptr, size);
 	return true;
 }
 
-void LogWriter::write_no_check(void *ptr, size_t size)
+size_t LogWriter::write_no_check(size_t head, const void *ptr, size_t size)
 {
-	size_t n = _buffer_size - _head;	// bytes to end of the buffer
+	size_t n = _buffer_size - head;	// bytes to end of the buffer
 
-	uint8_t *buffer_c = reinterpret_cast<uint8_t *>(ptr);
+	const uint8_t *buffer_c = reinterpret_cast<const uint8_t *>(ptr);
 
 	if (size > n) {
 		// Message goes over the end of the buffer
-		memcpy(&(_buffer[_head]), buffer_c, n);
-		_head = 0;
+		memcpy(&(_buffer[head]), buffer_c, n);
+		head = 0;
 
 	} else {
 		n = 0;
@@ -285,26 +372,28 @@ void LogWriter::write_no_check(void *ptr, size_t size)
 
 	// now: n = bytes already written
 	size_t p = size - n;	// number of bytes to write
-	memcpy(&(_buffer[_head]), &(buffer_c[n]), p);
-	_head = (_head + p) % _buffer_size;
-	_count += size;
+	memcpy(&(_buffer[head]), &(buffer_c[n]), p);
+	return (head + p) % _buffer_size;
 }
 
 size_t LogWriter::get_read_ptr(void **ptr, bool *is_part)
 {
-	// bytes available to read
-	int read_ptr = _head - _count;
+	size_t head = _head;
+
+	/* read the data only after the head that covers it */
+	__sync_synchronize();
+
+	size_t tail = _tail;
+	*ptr = &_buffer[tail];
 
-	if (read_ptr < 0) {
-		read_ptr += _buffer_size;
-		*ptr = &_buffer[read_ptr];
+	if (head < tail) {
+		// data wraps around the end of the buffer, return the part up to the end
 		*is_part = true;
-		return _buffer_size - read_ptr;
+		return _buffer_size - tail;
 
 	} else {
-		*ptr = &_buffer[read_ptr];
 		*is_part = false;
-		return _count;
+		return head - tail;
 	}
 }
 
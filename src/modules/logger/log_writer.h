@@ -34,6 +34,7 @@
 #pragma once
 
 #include <px4.h>
+#include <px4_posix.h>
 #include <stdint.h>
 #include <pthread.h>
 #include <drivers/drv_hrt.h>
@@ -47,11 +48,20 @@ namespace logger
 class LogWriter
 {
 public:
-	LogWriter(size_t buffer_size);
+	/**
+	 * @param buffer_size size of the write buffer
+	 * @param compress compress the log file (@see ulog_compression.h)
+	 */
+	LogWriter(size_t buffer_size, bool compress = false);
 	~LogWriter();
 
 	bool init();
 
+	bool is_compressed() const
+	{
+		return _compress;
+	}
+
 	/**
 	 * start the thread
 	 * @param thread will be set to the created thread on success
@@ -66,32 +76,57 @@ public:
 	void stop_log();
 
 	/**
-	 * Write data to be logged. The caller must call lock() before calling this.
+	 * Write data to be logged. The buffer is a single-producer, single-consumer ring:
+	 * only one thread (the logger) may call this, no locking is required.
+	 * The writer thread is woken up once enough data is buffered.
 	 * @param dropout_start timestamp when lastest dropout occured. 0 if no dropout at the moment.
 	 * @return true on success, false if not enough space in the buffer left
 	 */
-	bool write(void *ptr, size_t size, uint64_t dropout_start = 0);
-
-	void lock()
+	bool write(void *ptr, size_t size, uint64_t dropout_start = 0)
 	{
-		pthread_mutex_lock(&_mtx);
+		return write(ptr, size, nullptr, 0, dropout_start);
 	}
 
-	void unlock()
-	{
-		pthread_mutex_unlock(&_mtx);
-	}
+	/**
+	 * Write a message in two parts, e.g. a message header and topic data that is not
+	 * contiguous with it. Either both parts are written or none.
+	 * @return true on success, false if not enough space in the buffer left
+	 */
+	bool write(const void *ptr, size_t size, const void *ptr2, size_t size2, uint64_t dropout_start = 0);
 
+	/**
+	 * Wake up the writer thread, independent of the buffer fill level
+	 */
 	void notify()
 	{
-		pthread_cond_broadcast(&_cv);
+		px4_sem_post(&_sem);
 	}
 
+	/**
+	 * number of bytes written to the log file
+	 */
 	size_t get_total_written() const
 	{
 		return _total_written;
 	}
 
+	/**
+	 * number of uncompressed log bytes written. Equal to get_total_written() if not compressed
+	 */
+	size_t get_total_written_raw() const
+	{
+		return _total_written_raw;
+	}
+
+	/**
+	 * position in the (uncompressed) log data after the last written message,
+	 * i.e. the file offset of the next message. Called by the producer only.
+	 */
+	uint64_t get_log_position() const
+	{
+		return _log_position;
+	}
+
 	size_t get_buffer_size() const
 	{
 		return _buffer_size;
@@ -99,7 +134,23 @@ public:
 
 	size_t get_buffer_fill_count() const
 	{
-		return _count;
+		return fill_count(_head, _tail);
+	}
+
+	/**
+	 * maximum buffer fill level since the start of the log
+	 */
+	size_t get_max_fill() const
+	{
+		return _max_fill;
+	}
+
+	/**
+	 * number of writes rejected because the buffer was full, since the start of the log
+	 */
+	size_t get_dropouts() const
+	{
+		return _dropouts;
 	}
 
 private:
@@ -107,34 +158,74 @@ private:
 
 	void run();
 
+	/**
+	 * Get the next contiguous block of buffered data. Called by the writer thread only.
+	 */
 	size_t get_read_ptr(void **ptr, bool *is_part);
 
+	/**
+	 * Release n bytes returned by get_read_ptr(). Called by the writer thread only.
+	 */
 	void mark_read(size_t n)
 	{
-		_count -= n;
+		/* make sure the data is consumed before the space is handed back */
+		__sync_synchronize();
+		_tail = (_tail + n) % _buffer_size;
+	}
+
+	size_t fill_count(size_t head, size_t tail) const
+	{
+		return (head >= tail) ? head - tail : _buffer_size - tail + head;
 	}
 
 	/**
-	 * Write to the buffer but assuming there is enough space
+	 * Write to the buffer at head but assuming there is enough space
+	 * @return new head position
+	 */
+	inline size_t write_no_check(size_t head, const void *ptr, size_t size);
+
+	/**
+	 * Write data to the log file, compressing it if enabled. Called by the writer thread only.
+	 * @return number of bytes of data consumed, -1 on error
 	 */
-	inline void write_no_check(void *ptr, size_t size);
+	int write_file(const void *data, size_t size);
 
 	/* 512 didn't seem to work properly, 4096 should match the FAT cluster size */
 	static constexpr size_t	_min_write_chunk = 4096;
 
+	/* head and tail are written by different threads, keep them on separate cache lines */
+	static constexpr size_t _cache_line_size = 64;
+
 	int			_fd = -1;
 	uint8_t 	*_buffer = nullptr;
 	const size_t	_buffer_size;
-	size_t			_head = 0; ///< next position to write to
-	size_t			_count = 0; ///< number of bytes in _buffer to be written
+
+	/* producer (logger thread) side. One byte of the buffer always stays free to tell full from empty */
+	char		_pad_producer[_cache_line_size];
+	volatile size_t		_head = 0; ///< next position to write to, only modified by the producer
+	volatile unsigned	_need_wakeup = 0; ///< set by the writer thread before it waits for data
+	size_t		_max_fill = 0;
+	size_t		_dropouts = 0;
+	uint64_t	_log_position = 0; ///< bytes written to the buffer since the start of the log
+
+	/* consumer (writer thread) side */
+	char		_pad_consumer[_cache_line_size];
+	volatile size_t		_tail = 0; ///< next position to read from, only modified by the consumer
 	size_t		_total_written = 0;
-	bool		_should_run = false;
+	size_t		_total_written_raw = 0;
+	char		_pad_end[_cache_line_size];
+
+	const bool	_compress;
+	uint8_t		*_compress_buffer = nullptr; ///< one framed block
+	uint16_t	*_compress_hash_table = nullptr;
+
+	volatile bool	_should_run = false;
 	bool		_running = false;
-	bool 		_exit_thread = false;
-	pthread_mutex_t		_mtx;
-	pthread_cond_t		_cv;
+	volatile bool	_exit_thread = false;
+	px4_sem_t	_sem; ///< wakes up the writer thread
 	perf_counter_t _perf_write;
 	perf_counter_t _perf_fsync;
+	perf_counter_t _perf_compress;
 };
 
 }
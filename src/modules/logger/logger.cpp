@@ -185,12 +185,14 @@ void Logger::usage(const char *reason)
 		PX4_WARN("%s\n", reason);
 	}
 
-	PX4_INFO("usage: logger {start|stop|on|off|status} [-r <log rate>] [-b <buffer size>] -e -a -t -x\n"
+	PX4_INFO("usage: logger {start|stop|on|off|status} [-r <log rate>] [-b <buffer size>] [-p <backfill size>] -e -a -t -c -x\n"
 		 "\t-r\tLog rate in Hz, 0 means unlimited rate\n"
 		 "\t-b\tLog buffer size in KiB, default is 12\n"
+		 "\t-p\tPre-arm backfill buffer size in KiB (used if SDLOG_BACKFILL > 0), default is 16\n"
 		 "\t-e\tEnable logging right after start until disarm (otherwise only when armed)\n"
 		 "\t-f\tLog until shutdown (implies -e)\n"
-		 "\t-t\tUse date/time for naming log directories and files");
+		 "\t-t\tUse date/time for naming log directories and files\n"
+		 "\t-c\tCompress the log (.ulgz, can be read by replay)");
 }
 
 int Logger::start(char *const *argv)
@@ -219,6 +221,11 @@ void Logger::status()
 	if (!_enabled) {
 		PX4_INFO("Running, but not logging");
 
+		if (_backfill.enabled()) {
+			PX4_INFO("Backfill: %zu / %zu B buffered (window: %.1f s)", _backfill.get_fill_count(),
+				 _backfill.get_buffer_size(), (double)(_backfill.get_window() / 1e6));
+		}
+
 	} else {
 		PX4_INFO("Running");
 		print_statistics();
@@ -236,8 +243,23 @@ void Logger::print_statistics()
 
 	PX4_INFO("Log file: %s/%s", _log_dir, _log_file_name);
 	PX4_INFO("Wrote %4.2f MiB (avg %5.2f KiB/s)", (double)mebibytes, (double)(kibibytes / seconds));
+
+	if (_writer.is_compressed() && _writer.get_total_written() > 0) {
+		PX4_INFO("Compression ratio: %.2f (%4.2f MiB uncompressed)",
+			 (double)_writer.get_total_written_raw() / _writer.get_total_written(),
+			 (double)(_writer.get_total_written_raw() / 1024.0f / 1024.0f));
+	}
+
+	if (_index.enabled()) {
+		PX4_INFO("Index: %u samples (interval: %.1f s), %u events%s", _index.num_entries(),
+			 (double)(_index.get_interval() / 1e6), _index.num_events(),
+			 _index.events_complete() ? "" : " (incomplete)");
+	}
+
 	PX4_INFO("Since last status: dropouts: %zu (max len: %.3f s), max used buffer: %zu / %zu B",
 		 _write_dropouts, (double)_max_dropout_duration, _high_water, _writer.get_buffer_size());
+	PX4_INFO("Since log start: dropped writes: %zu, max used buffer: %zu / %zu B",
+		 _writer.get_dropouts(), _writer.get_max_fill(), _writer.get_buffer_size());
 	_high_water = 0;
 	_write_dropouts = 0;
 	_max_dropout_duration = 0.f;
@@ -247,16 +269,18 @@ void Logger::run_trampoline(int argc, char *argv[])
 {
 	uint32_t log_interval = 3500;
 	int log_buffer_size = 12 * 1024;
+	int backfill_buffer_size = 16 * 1024;
 	bool log_on_start = false;
 	bool log_until_shutdown = false;
 	bool error_flag = false;
 	bool log_name_timestamp = false;
+	bool log_compress = false;
 
 	int myoptind = 1;
 	int ch;
 	const char *myoptarg = NULL;
 
-	while ((ch = px4_getopt(argc, argv, "r:b:etf", &myoptind, &myoptarg)) != EOF) {
+	while ((ch = px4_getopt(argc, argv, "r:b:p:etfc", &myoptind, &myoptarg)) != EOF) {
 		switch (ch) {
 		case 'r': {
 				unsigned long r = strtoul(myoptarg, NULL, 10);
@@ -284,10 +308,25 @@ void Logger::run_trampoline(int argc, char *argv[])
 			}
 			break;
 
+		case 'p': {
+				unsigned long s = strtoul(myoptarg, NULL, 10);
+
+				if (s < 1) {
+					s = 1;
+				}
+
+				backfill_buffer_size = 1024 * s;
+			}
+			break;
+
 		case 't':
 			log_name_timestamp = true;
 			break;
 
+		case 'c':
+			log_compress = true;
+			break;
+
 		case 'f':
 			log_on_start = true;
 			log_until_shutdown = true;
@@ -309,8 +348,8 @@ void Logger::run_trampoline(int argc, char *argv[])
 		return;
 	}
 
-	logger_ptr = new Logger(log_buffer_size, log_interval, log_on_start,
-				log_until_shutdown, log_name_timestamp);
+	logger_ptr = new Logger(log_buffer_size, backfill_buffer_size, log_interval, log_on_start,
+				log_until_shutdown, log_name_timestamp, log_compress);
 
 #if defined(DBGPRINT) && defined(__PX4_NUTTX)
 	struct mallinfo alloc_info = mallinfo();
@@ -336,13 +375,14 @@ void Logger::run_trampoline(int argc, char *argv[])
 }
 
 
-Logger::Logger(size_t buffer_size, uint32_t log_interval, bool log_on_start,
-	       bool log_until_shutdown, bool log_name_timestamp) :
+Logger::Logger(size_t buffer_size, size_t backfill_buffer_size, uint32_t log_interval, bool log_on_start,
+	       bool log_until_shutdown, bool log_name_timestamp, bool log_compress) :
 	_arm_override(false),
 	_log_on_start(log_on_start),
 	_log_until_shutdown(log_until_shutdown),
 	_log_name_timestamp(log_name_timestamp),
-	_writer(buffer_size),
+	_writer(buffer_size, log_compress),
+	_backfill_buffer_size(backfill_buffer_size),
 	_log_interval(log_interval)
 {
 	_log_utc_offset = param_find("SDLOG_UTC_OFFSET");
@@ -445,7 +485,14 @@ bool Logger::copy_if_updated_multi(LoggerSubscription &sub, int multi_instance,
 
 			/* copy first data */
 			if (handle >= 0) {
-				write_add_logged_msg(sub, multi_instance);
+				/* while not logging, the message ids are assigned once logging starts */
+				if (_enabled) {
+					write_add_logged_msg(sub, multi_instance);
+				}
+
+				if (_update_queue) {
+					orb_update_queue_attach(_update_queue, handle, update_queue_tag(sub, multi_instance));
+				}
 
 				/* set to the same interval as the first instance */
 				unsigned int interval;
@@ -473,6 +520,122 @@ bool Logger::copy_if_updated_multi(LoggerSubscription &sub, int multi_instance,
 	return updated;
 }
 
+const void *Logger::get_if_updated_multi(LoggerSubscription &sub, int multi_instance)
+{
+	void *buffer = _msg_buffer + sizeof(ulog_message_data_header_s);
+	int handle = sub.fd[multi_instance];
+
+	/* the backfill buffer takes complete messages from _msg_buffer */
+	if (!_enabled || handle < 0 || sub.no_borrow) {
+		return copy_if_updated_multi(sub, multi_instance, buffer) ? buffer : nullptr;
+	}
+
+	bool updated = false;
+	orb_check(handle, &updated);
+
+	if (!updated) {
+		return nullptr;
+	}
+
+	const void *data;
+
+	if (orb_borrow(sub.metadata, handle, &data) == PX4_OK) {
+		return data;
+	}
+
+	/* topics with a queue cannot be borrowed, nor without memory for the spare buffer. EBUSY is only temporary */
+	if (errno == EINVAL || errno == ENOMEM) {
+		sub.no_borrow = true;
+	}
+
+	orb_copy(sub.metadata, handle, buffer);
+	return buffer;
+}
+
+void Logger::release_topic_data(LoggerSubscription &sub, int multi_instance, const void *data)
+{
+	if (data != _msg_buffer + sizeof(ulog_message_data_header_s)) {
+		orb_release(sub.metadata, sub.fd[multi_instance], data);
+	}
+}
+
+bool Logger::write_topic_data(LoggerSubscription &sub, int multi_instance)
+{
+	return write_topic_data(sub, multi_instance, _msg_buffer + sizeof(ulog_message_data_header_s));
+}
+
+bool Logger::write_topic_data(LoggerSubscription &sub, int multi_instance, const void *data)
+{
+	/* each message consists of a header followed by an orb data object */
+	size_t msg_size = sizeof(ulog_message_data_header_s) + sub.metadata->o_size_no_padding;
+
+	uint16_t write_msg_size = static_cast<uint16_t>(msg_size - ULOG_MSG_HEADER_LEN);
+	//write one byte after another (necessary because of alignment)
+	_msg_buffer[0] = (uint8_t)write_msg_size;
+	_msg_buffer[1] = (uint8_t)(write_msg_size >> 8);
+	_msg_buffer[2] = static_cast<uint8_t>(ULogMessageType::DATA);
+	/* backfill messages carry the update queue tag as id, which is translated once logging starts */
+	uint16_t write_msg_id = _enabled ? sub.msg_ids[multi_instance] : update_queue_tag(sub, multi_instance);
+	_msg_buffer[3] = (uint8_t)write_msg_id;
+	_msg_buffer[4] = (uint8_t)(write_msg_id >> 8);
+
+	//PX4_INFO("topic: %s, size = %zu, out_size = %zu", sub.metadata->o_name, sub.metadata->o_size, msg_size);
+
+	if (!_enabled) {
+		return _backfill.write(_msg_buffer, msg_size);
+	}
+
+	/* the topic data is written from where it is, borrowed data is not copied into _msg_buffer */
+	if (!write(_msg_buffer, sizeof(ulog_message_data_header_s), data, sub.metadata->o_size_no_padding)) {
+		return false;
+	}
+
+	index_data_message(msg_size, data);
+	return true;
+}
+
+void Logger::index_data_message(size_t msg_size, const void *data)
+{
+	/* the timestamp is the first field of each topic */
+	uint64_t timestamp;
+	memcpy(&timestamp, data, sizeof(timestamp));
+	uint16_t msg_id = _msg_buffer[3] | (_msg_buffer[4] << 8);
+	_index.add_data(msg_id, timestamp, _writer.get_log_position() - msg_size);
+}
+
+void Logger::write_backfill()
+{
+	size_t msg_size;
+	int num_msgs = 0;
+
+	while ((msg_size = _backfill.read(_msg_buffer, _msg_buffer_len)) > 0) {
+		if (_msg_buffer[2] == static_cast<uint8_t>(ULogMessageType::DATA)) {
+			unsigned tag = _msg_buffer[3] | (_msg_buffer[4] << 8);
+			LoggerSubscription &sub = _subscriptions[tag / ORB_MULTI_MAX_INSTANCES];
+			int instance = tag % ORB_MULTI_MAX_INSTANCES;
+
+			if (sub.fd[instance] < 0) {
+				continue;
+			}
+
+			uint16_t write_msg_id = sub.msg_ids[instance];
+			_msg_buffer[3] = (uint8_t)write_msg_id;
+			_msg_buffer[4] = (uint8_t)(write_msg_id >> 8);
+			write_wait(_msg_buffer, msg_size);
+			index_data_message(msg_size, _msg_buffer + sizeof(ulog_message_data_header_s));
+
+		} else {
+			write_wait(_msg_buffer, msg_size);
+		}
+
+		++num_msgs;
+	}
+
+	_backfill.reset();
+
+	PX4_DEBUG("wrote %i backfill messages", num_msgs);
+}
+
 void Logger::add_default_topics()
 {
 #ifdef CONFIG_ARCH_BOARD_SITL
@@ -514,6 +677,8 @@ void Logger::add_default_topics()
 	add_topic("control_state", 20);
 	add_topic("camera_trigger");
 	add_topic("cpuload");
+	add_topic("task_load"); //published page by page at 1 Hz
+	add_topic("perf_counters");
 	add_topic("gps_dump"); //this will only be published if GPS_DUMP_COMM is set
 
 	/* for estimator replay (need to be at full rate) */
@@ -590,6 +755,19 @@ void Logger::run()
 		return;
 	}
 
+	int32_t backfill_window = 0;
+	param_get(param_find("SDLOG_BACKFILL"), &backfill_window);
+
+	if (backfill_window > 0 && !_log_until_shutdown) {
+		if (!_backfill.init(_backfill_buffer_size, (hrt_abstime)backfill_window * 1000000)) {
+			PX4_WARN("backfill buffer alloc failed");
+		}
+	}
+
+	if (!_index.init(INDEX_MAX_ENTRIES, INDEX_MAX_EVENTS, UPDATE_QUEUE_CONTROL_TAG)) {
+		PX4_WARN("log index alloc failed");
+	}
+
 	uORB::Subscription<vehicle_status_s> vehicle_status_sub(ORB_ID(vehicle_status));
 	uORB::Subscription<parameter_update_s> parameter_update_sub(ORB_ID(parameter_update));
 	uORB::Subscription<log_message_s> log_message_sub(ORB_ID(log_message), 20);
@@ -659,12 +837,37 @@ void Logger::run()
 		start_log();
 	}
 
-	/* init the update timer */
+	/* get notified about topic updates, so that only the updated subscriptions need to be checked */
+	_update_queue = orb_update_queue_create(UPDATE_QUEUE_SIZE);
+	int num_update_tags = 0;
+	hrt_abstime last_subscribe_check = hrt_absolute_time();
+
+	if (_update_queue) {
+		for (LoggerSubscription &sub : _subscriptions) {
+			for (uint8_t instance = 0; instance < ORB_MULTI_MAX_INSTANCES; instance++) {
+				if (sub.fd[instance] >= 0) {
+					orb_update_queue_attach(_update_queue, sub.fd[instance], update_queue_tag(sub, instance));
+				}
+			}
+		}
+
+		orb_update_queue_attach(_update_queue, vehicle_status_sub.getHandle(), UPDATE_QUEUE_CONTROL_TAG);
+		orb_update_queue_attach(_update_queue, parameter_update_sub.getHandle(), UPDATE_QUEUE_CONTROL_TAG);
+		orb_update_queue_attach(_update_queue, log_message_sub.getHandle(), UPDATE_QUEUE_CONTROL_TAG);
+
+	} else {
+		PX4_WARN("update queue alloc failed, polling topics");
+	}
+
+	/* init the update timer, used if there is no update queue */
 	struct hrt_call timer_call;
 	memset(&timer_call, 0, sizeof(hrt_call));
 	px4_sem_t timer_semaphore;
 	px4_sem_init(&timer_semaphore, 0, 0);
-	hrt_call_every(&timer_call, _log_interval, _log_interval, timer_callback, &timer_semaphore);
+
+	if (!_update_queue) {
+		hrt_call_every(&timer_call, _log_interval, _log_interval, timer_callback, &timer_semaphore);
+	}
 
 
 	while (!_task_should_exit) {
@@ -693,59 +896,84 @@ void Logger::run()
 			}
 		}
 
-		if (_enabled) {
-
-			bool data_written = false;
+		/* while not logging, the data still goes into the backfill buffer (if enabled) */
+		if (_enabled || _backfill.enabled()) {
 
 			/* Check if parameters have changed */
 			// this needs to change to a timestamped record to record a history of parameter changes
-			if (parameter_update_sub.check_updated()) {
+			if (_enabled && parameter_update_sub.check_updated()) {
 				parameter_update_sub.update();
 				write_changed_parameters();
 			}
 
-			/* wait for lock on log buffer */
-			_writer.lock();
+			if (_update_queue) {
+				/* only the updated subscriptions, in the order they were published */
+				for (int i = 0; i < num_update_tags; i++) {
+					unsigned tag = _update_tags[i];
 
-			for (LoggerSubscription &sub : _subscriptions) {
-				/* each message consists of a header followed by an orb data object
-				 */
-				size_t msg_size = sizeof(ulog_message_data_header_s) + sub.metadata->o_size_no_padding;
-
-				/* if this topic has been updated, copy the new data into the message buffer
-				 * and write a message to the log
-				 */
-				for (uint8_t instance = 0; instance < ORB_MULTI_MAX_INSTANCES; instance++) {
-					if (copy_if_updated_multi(sub, instance, _msg_buffer + sizeof(ulog_message_data_header_s))) {
+					if (tag >= UPDATE_QUEUE_CONTROL_TAG) {
+						continue;
+					}
 
-						uint16_t write_msg_size = static_cast<uint16_t>(msg_size - ULOG_MSG_HEADER_LEN);
-						//write one byte after another (necessary because of alignment)
-						_msg_buffer[0] = (uint8_t)write_msg_size;
-						_msg_buffer[1] = (uint8_t)(write_msg_size >> 8);
-						_msg_buffer[2] = static_cast<uint8_t>(ULogMessageType::DATA);
-						uint16_t write_msg_id = sub.msg_ids[instance];
-						_msg_buffer[3] = (uint8_t)write_msg_id;
-						_msg_buffer[4] = (uint8_t)(write_msg_id >> 8);
+					LoggerSubscription &sub = _subscriptions[tag / ORB_MULTI_MAX_INSTANCES];
+					int instance = tag % ORB_MULTI_MAX_INSTANCES;
 
-						//PX4_INFO("topic: %s, size = %zu, out_size = %zu", sub.metadata->o_name, sub.metadata->o_size, msg_size);
+					const void *data = get_if_updated_multi(sub, instance);
 
-						if (write(_msg_buffer, msg_size)) {
+					if (data) {
+						if (write_topic_data(sub, instance, data)) {
 
 #ifdef DBGPRINT
-							total_bytes += msg_size;
+							total_bytes += sizeof(ulog_message_data_header_s) + sub.metadata->o_size_no_padding;
 #endif /* DBGPRINT */
+						}
 
-							data_written = true;
+						release_topic_data(sub, instance, data);
+					}
+				}
 
-						} else {
-							break;	// Write buffer overflow, skip this record
+				/* instances that are not subscribed yet are not in the queue: check them periodically */
+				if (hrt_elapsed_time(&last_subscribe_check) > TRY_SUBSCRIBE_INTERVAL) {
+					last_subscribe_check = hrt_absolute_time();
+
+					for (LoggerSubscription &sub : _subscriptions) {
+						for (uint8_t instance = 1; instance < ORB_MULTI_MAX_INSTANCES; instance++) {
+							if (sub.fd[instance] < 0 &&
+							    copy_if_updated_multi(sub, instance, _msg_buffer + sizeof(ulog_message_data_header_s))) {
+								write_topic_data(sub, instance);
+							}
+						}
+					}
+				}
+
+			} else {
+				for (LoggerSubscription &sub : _subscriptions) {
+					/* if this topic has been updated, copy the new data into the message buffer
+					 * and write a message to the log
+					 */
+					for (uint8_t instance = 0; instance < ORB_MULTI_MAX_INSTANCES; instance++) {
+						const void *data = get_if_updated_multi(sub, instance);
+
+						if (data) {
+							bool written = write_topic_data(sub, instance, data);
+							release_topic_data(sub, instance, data);
+
+							if (written) {
+
+#ifdef DBGPRINT
+								total_bytes += sizeof(ulog_message_data_header_s) + sub.metadata->o_size_no_padding;
+#endif /* DBGPRINT */
+
+							} else {
+								break;	// Write buffer overflow, skip this record
+							}
 						}
 					}
 				}
 			}
 
 			//check for new logging message(s)
-			if (log_message_sub.check_updated()) {
+			while (log_message_sub.check_updated()) {
 				log_message_sub.update();
 				const char *message = (const char *)log_message_sub.get().text;
 				int message_len = strlen(message);
@@ -760,7 +988,12 @@ void Logger::run()
 					memcpy(_msg_buffer + 4, &log_message_sub.get().timestamp, sizeof(ulog_message_logging_s::timestamp));
 					strncpy((char *)(_msg_buffer + 12), message, sizeof(ulog_message_logging_s::message));
 
-					write(_msg_buffer, write_msg_size + ULOG_MSG_HEADER_LEN);
+					if (_enabled) {
+						write(_msg_buffer, write_msg_size + ULOG_MSG_HEADER_LEN);
+
+					} else {
+						_backfill.write(_msg_buffer, write_msg_size + ULOG_MSG_HEADER_LEN);
+					}
 				}
 			}
 
@@ -768,13 +1001,7 @@ void Logger::run()
 				_high_water = _writer.get_buffer_fill_count();
 			}
 
-			/* release the log buffer */
-			_writer.unlock();
-
-			/* notify the writer thread if data is available */
-			if (data_written) {
-				_writer.notify();
-			}
+			/* no need to notify the writer thread, it wakes up by itself once enough data is buffered */
 
 #ifdef DBGPRINT
 			double deltat = (double)(hrt_absolute_time() - timer_start)  * 1e-6;
@@ -796,17 +1023,34 @@ void Logger::run()
 
 		}
 
-		/*
-		 * We wait on the semaphore, which periodically gets updated by a high-resolution timer.
-		 * The simpler alternative would be:
-		 *   usleep(max(300, _log_interval - elapsed_time_since_loop_start));
-		 * And on linux this is quite accurate as well, but under NuttX it is not accurate,
-		 * because usleep() has only a granularity of CONFIG_MSEC_PER_TICK (=1ms).
-		 */
-		while (px4_sem_wait(&timer_semaphore) != 0);
+		if (_update_queue) {
+			if (_enabled || _backfill.enabled()) {
+				/* wake up on each publication of a logged topic */
+				num_update_tags = orb_update_queue_wait(_update_queue, _update_tags, UPDATE_QUEUE_SIZE, UPDATE_QUEUE_TIMEOUT);
+
+			} else {
+				/* not recording: there is no need to wake up for every update, just check the status periodically */
+				usleep(_log_interval);
+				orb_update_queue_wait(_update_queue, _update_tags, UPDATE_QUEUE_SIZE, 0);
+				num_update_tags = 0;
+			}
+
+		} else {
+			/*
+			 * We wait on the semaphore, which periodically gets updated by a high-resolution timer.
+			 * The simpler alternative would be:
+			 *   usleep(max(300, _log_interval - elapsed_time_since_loop_start));
+			 * And on linux this is quite accurate as well, but under NuttX it is not accurate,
+			 * because usleep() has only a granularity of CONFIG_MSEC_PER_TICK (=1ms).
+			 */
+			while (px4_sem_wait(&timer_semaphore) != 0);
+		}
+	}
+
+	if (!_update_queue) {
+		hrt_cancel(&timer_call);
 	}
 
-	hrt_cancel(&timer_call);
 	px4_sem_destroy(&timer_semaphore);
 
 	// stop the writer thread
@@ -831,6 +1075,15 @@ void Logger::run()
 		}
 	}
 
+	if (_update_queue) {
+		/* the remaining subscriptions are still alive: detach them before destroying the queue */
+		orb_update_queue_attach(nullptr, vehicle_status_sub.getHandle(), 0);
+		orb_update_queue_attach(nullptr, parameter_update_sub.getHandle(), 0);
+		orb_update_queue_attach(nullptr, log_message_sub.getHandle(), 0);
+		orb_update_queue_destroy(_update_queue);
+		_update_queue = nullptr;
+	}
+
 	if (_mavlink_log_pub) {
 		orb_unadvertise(_mavlink_log_pub);
 		_mavlink_log_pub = nullptr;
@@ -839,7 +1092,12 @@ void Logger::run()
 
 bool Logger::write(void *ptr, size_t size)
 {
-	if (_writer.write(ptr, size, _dropout_start)) {
+	return write(ptr, size, nullptr, 0);
+}
+
+bool Logger::write(const void *ptr, size_t size, const void *ptr2, size_t size2)
+{
+	if (_writer.write(ptr, size, ptr2, size2, _dropout_start)) {
 
 		if (_dropout_start) {
 			float dropout_duration = (float)(hrt_elapsed_time(&_dropout_start) / 1000) / 1.e3f;
@@ -941,6 +1199,7 @@ int Logger::get_log_file_name(char *file_name, size_t file_name_size)
 	}
 
 	const char *replay_suffix = "";
+	const char *extension = _writer.is_compressed() ? "ulgz" : "ulg";
 
 	if (_replay_file_name) {
 		replay_suffix = "_replayed";
@@ -954,7 +1213,8 @@ int Logger::get_log_file_name(char *file_name, size_t file_name_size)
 
 		char log_file_name_time[16] = "";
 		strftime(log_file_name_time, sizeof(log_file_name_time), "%H_%M_%S", &tt);
-		snprintf(_log_file_name, sizeof(_log_file_name), "%s%s.ulg", log_file_name_time, replay_suffix);
+		snprintf(_log_file_name, sizeof(_log_file_name), "%s%s.%s", log_file_name_time, replay_suffix,
+			 extension);
 		snprintf(file_name, file_name_size, "%s/%s", _log_dir, _log_file_name);
 
 	} else {
@@ -967,7 +1227,8 @@ int Logger::get_log_file_name(char *file_name, size_t file_name_size)
 		/* look for the next file that does not exist */
 		while (file_number <= MAX_NO_LOGFILE) {
 			/* format log file path: e.g. /fs/microsd/sess001/log001.ulg */
-			snprintf(_log_file_name, sizeof(_log_file_name), "log%03u%s.ulg", file_number, replay_suffix);
+			snprintf(_log_file_name, sizeof(_log_file_name), "log%03u%s.%s", file_number, replay_suffix,
+				 extension);
 			snprintf(file_name, file_name_size, "%s/%s", _log_dir, _log_file_name);
 
 			if (!file_exist(file_name)) {
@@ -1064,6 +1325,7 @@ void Logger::start_log()
 	/* print logging path, important to find log file later */
 	mavlink_log_info(&_mavlink_log_pub, "[logger] file: %s", file_name);
 	_next_topic_id = 0;
+	_index.reset();
 
 	_writer.start_log(file_name);
 	write_header();
@@ -1071,6 +1333,11 @@ void Logger::start_log()
 	write_formats();
 	write_parameters();
 	write_all_add_logged_msg();
+
+	if (_backfill.enabled()) {
+		write_backfill();
+	}
+
 	_writer.notify();
 	_enabled = true;
 	_start_time = hrt_absolute_time();
@@ -1083,16 +1350,68 @@ void Logger::stop_log()
 	}
 
 	_enabled = false;
+
+	if (_index.enabled()) {
+		write_index();
+	}
+
 	_writer.stop_log();
 }
 
+void Logger::write_index()
+{
+	uint64_t index_offset = _writer.get_log_position();
+	uint8_t buffer[sizeof(ulog_message_index_header_s) + INDEX_ENTRIES_PER_MSG * sizeof(ulog_index_data_entry_s)];
+	ulog_message_index_header_s *msg = reinterpret_cast<ulog_message_index_header_s *>(buffer);
+	msg->msg_type = static_cast<uint8_t>(ULogMessageType::INDEX);
+
+	/* data samples */
+	msg->index_type = static_cast<uint8_t>(ULogIndexType::DATA);
+
+	for (unsigned i = 0; i < _index.num_entries(); i += INDEX_ENTRIES_PER_MSG) {
+		unsigned num = _index.num_entries() - i;
+
+		if (num > INDEX_ENTRIES_PER_MSG) {
+			num = INDEX_ENTRIES_PER_MSG;
+		}
+
+		size_t data_size = num * sizeof(ulog_index_data_entry_s);
+		memcpy(buffer + sizeof(*msg), _index.entries() + i, data_size);
+		msg->msg_size = sizeof(*msg) - ULOG_MSG_HEADER_LEN + data_size;
+		write_wait(buffer, sizeof(*msg) + data_size);
+	}
+
+	/* parameter changes and added topics */
+	msg->index_type = static_cast<uint8_t>(ULogIndexType::EVENTS);
+	const unsigned events_per_msg = (sizeof(buffer) - sizeof(*msg)) / sizeof(uint64_t);
+
+	for (unsigned i = 0; i < _index.num_events(); i += events_per_msg) {
+		unsigned num = _index.num_events() - i;
+
+		if (num > events_per_msg) {
+			num = events_per_msg;
+		}
+
+		size_t data_size = num * sizeof(uint64_t);
+		memcpy(buffer + sizeof(*msg), _index.events() + i, data_size);
+		msg->msg_size = sizeof(*msg) - ULOG_MSG_HEADER_LEN + data_size;
+		write_wait(buffer, sizeof(*msg) + data_size);
+	}
+
+	ulog_message_index_end_s end_msg;
+	end_msg.flags = _index.events_complete() ? 0 : ULOG_INDEX_FLAG_EVENTS_INCOMPLETE;
+	end_msg.index_offset = index_offset;
+	memcpy(end_msg.magic, ULOG_INDEX_END_MAGIC, sizeof(end_msg.magic));
+	write_wait(&end_msg, sizeof(end_msg));
+
+	PX4_DEBUG("wrote log index: %u samples, %u events", _index.num_entries(), _index.num_events());
+}
+
 bool Logger::write_wait(void *ptr, size_t size)
 {
 	while (!_writer.write(ptr, size)) {
-		_writer.unlock();
 		_writer.notify();
 		usleep(_log_interval);
-		_writer.lock();
 	}
 
 	return true;
@@ -1100,7 +1419,6 @@ bool Logger::write_wait(void *ptr, size_t size)
 
 void Logger::write_formats()
 {
-	_writer.lock();
 	ulog_message_format_s msg;
 	const orb_metadata **topics = orb_get_topics();
 
@@ -1113,12 +1431,10 @@ void Logger::write_formats()
 		write_wait(&msg, msg_size);
 	}
 
-	_writer.unlock();
 }
 
 void Logger::write_all_add_logged_msg()
 {
-	_writer.lock();
 
 	for (LoggerSubscription &sub : _subscriptions) {
 		for (int instance = 0; instance < ORB_MULTI_MAX_INSTANCES; ++instance) {
@@ -1128,7 +1444,6 @@ void Logger::write_all_add_logged_msg()
 		}
 	}
 
-	_writer.unlock();
 }
 
 void Logger::write_add_logged_msg(LoggerSubscription &subscription, int instance)
@@ -1148,13 +1463,17 @@ void Logger::write_add_logged_msg(LoggerSubscription &subscription, int instance
 
 	write_wait(&msg, msg_size);
 
+	/* topics added at the start of the log are found by reading the file from the start */
+	if (_enabled) {
+		_index.add_event(_writer.get_log_position() - msg_size);
+	}
+
 	++_next_topic_id;
 }
 
 /* write info message */
 void Logger::write_info(const char *name, const char *value)
 {
-	_writer.lock();
 	uint8_t buffer[sizeof(ulog_message_info_header_s)];
 	ulog_message_info_header_s *msg = reinterpret_cast<ulog_message_info_header_s *>(buffer);
 	msg->msg_type = static_cast<uint8_t>(ULogMessageType::INFO);
@@ -1174,11 +1493,9 @@ void Logger::write_info(const char *name, const char *value)
 		write_wait(buffer, msg_size);
 	}
 
-	_writer.unlock();
 }
 void Logger::write_info(const char *name, int32_t value)
 {
-	_writer.lock();
 	uint8_t buffer[sizeof(ulog_message_info_header_s)];
 	ulog_message_info_header_s *msg = reinterpret_cast<ulog_message_info_header_s *>(buffer);
 	msg->msg_type = static_cast<uint8_t>(ULogMessageType::INFO);
@@ -1195,7 +1512,6 @@ void Logger::write_info(const char *name, int32_t value)
 
 	write_wait(buffer, msg_size);
 
-	_writer.unlock();
 }
 
 void Logger::write_header()
@@ -1210,9 +1526,15 @@ void Logger::write_header()
 	header.magic[6] = 0x35;
 	header.magic[7] = 0x00; //file version 0
 	header.timestamp = hrt_absolute_time();
-	_writer.lock();
+
+	/* the log starts with the backfilled data */
+	hrt_abstime backfill_start = _backfill.oldest_time();
+
+	if (backfill_start != 0) {
+		header.timestamp = backfill_start;
+	}
+
 	write_wait(&header, sizeof(header));
-	_writer.unlock();
 }
 
 /* write version info messages */
@@ -1235,7 +1557,6 @@ void Logger::write_version()
 
 void Logger::write_parameters()
 {
-	_writer.lock();
 	uint8_t buffer[sizeof(ulog_message_parameter_header_s) + sizeof(param_value_u)];
 	ulog_message_parameter_header_s *msg = reinterpret_cast<ulog_message_parameter_header_s *>(buffer);
 
@@ -1286,13 +1607,11 @@ void Logger::write_parameters()
 		}
 	} while ((param != PARAM_INVALID) && (param_idx < (int) param_count()));
 
-	_writer.unlock();
 	_writer.notify();
 }
 
 void Logger::write_changed_parameters()
 {
-	_writer.lock();
 	uint8_t buffer[sizeof(ulog_message_parameter_header_s) + sizeof(param_value_u)];
 	ulog_message_parameter_header_s *msg = reinterpret_cast<ulog_message_parameter_header_s *>(buffer);
 
@@ -1342,10 +1661,10 @@ void Logger::write_changed_parameters()
 			msg->msg_size = msg_size - ULOG_MSG_HEADER_LEN;
 
 			write_wait(buffer, msg_size);
+			_index.add_event(_writer.get_log_position() - msg_size);
 		}
 	} while ((param != PARAM_INVALID) && (param_idx < (int) param_count()));
 
-	_writer.unlock();
 	_writer.notify();
 }
 
@@ -34,6 +34,8 @@
 #pragma once
 
 #include "log_writer.h"
+#include "backfill_buffer.h"
+#include "log_index.h"
 #include "array.h"
 #include <px4.h>
 #include <drivers/drv_hrt.h>
@@ -63,6 +65,7 @@ struct LoggerSubscription {
 	uint16_t msg_ids[ORB_MULTI_MAX_INSTANCES];
 	uint64_t time_tried_subscribe;	// captures the time at which we checked last time if this instance existed
 	const orb_metadata *metadata = nullptr;
+	bool no_borrow = false;	// the topic cannot be borrowed with orb_borrow() (it has a queue)
 
 	LoggerSubscription() {}
 
@@ -81,8 +84,8 @@ struct LoggerSubscription {
 class Logger
 {
 public:
-	Logger(size_t buffer_size, uint32_t log_interval, bool log_on_start,
-	       bool log_until_shutdown, bool log_name_timestamp);
+	Logger(size_t buffer_size, size_t backfill_buffer_size, uint32_t log_interval, bool log_on_start,
+	       bool log_until_shutdown, bool log_name_timestamp, bool log_compress);
 
 	~Logger();
 
@@ -128,7 +131,6 @@ private:
 
 	/**
 	 * Write an ADD_LOGGED_MSG to the log for a given subscription and instance.
-	 * _writer.lock() must be held when calling this.
 	 */
 	void write_add_logged_msg(LoggerSubscription &subscription, int instance);
 
@@ -174,19 +176,80 @@ private:
 
 	bool copy_if_updated_multi(LoggerSubscription &sub, int multi_instance, void *buffer);
 
+	/**
+	 * Get the data of a subscription instance if it was updated. While logging, the data is
+	 * borrowed from uORB (orb_borrow()) instead of copied, if the topic supports it. Otherwise,
+	 * and for instances that are not subscribed yet, it is copied into _msg_buffer with
+	 * copy_if_updated_multi().
+	 * @return the topic data, nullptr if not updated. Must be passed to release_topic_data()
+	 *         after writing it.
+	 */
+	const void *get_if_updated_multi(LoggerSubscription &sub, int multi_instance);
+
+	/**
+	 * Release data returned by get_if_updated_multi()
+	 */
+	void release_topic_data(LoggerSubscription &sub, int multi_instance, const void *data);
+
+	/**
+	 * Write a data message for a subscription instance, after the topic data has been
+	 * copied into _msg_buffer by copy_if_updated_multi(). While not logging, the message
+	 * goes to the backfill buffer.
+	 * @return true if data written, false otherwise (on overflow)
+	 */
+	bool write_topic_data(LoggerSubscription &sub, int multi_instance);
+
+	/**
+	 * Write a data message for a subscription instance with the topic data from
+	 * get_if_updated_multi(). While not logging, the data must be in _msg_buffer.
+	 * @return true if data written, false otherwise (on overflow)
+	 */
+	bool write_topic_data(LoggerSubscription &sub, int multi_instance, const void *data);
+
+	/**
+	 * Write the data buffered in _backfill while not logging. Called when logging starts,
+	 * after all ADD_LOGGED_MSG messages are written.
+	 */
+	void write_backfill();
+
+	/**
+	 * Add the data message, which was just written, to the index
+	 * @param data the topic data of the message
+	 */
+	void index_data_message(size_t msg_size, const void *data);
+
+	/**
+	 * Write the index at the end of the log
+	 */
+	void write_index();
+
+	/**
+	 * Update queue tag of a subscription instance
+	 */
+	unsigned update_queue_tag(const LoggerSubscription &sub, int multi_instance) const
+	{
+		return (&sub - _subscriptions.begin()) * ORB_MULTI_MAX_INSTANCES + multi_instance;
+	}
+
 	/**
 	 * Write data to the logger. Waits if buffer is full until all data is written.
-	 * Must be called with _writer.lock() held.
+	 * Must be called from the logger thread (the only producer of _writer).
 	 */
 	bool write_wait(void *ptr, size_t size);
 
 	/**
 	 * Write data to the logger and handle dropouts.
-	 * Must be called with _writer.lock() held.
+	 * Must be called from the logger thread (the only producer of _writer).
 	 * @return true if data written, false otherwise (on overflow)
 	 */
 	bool write(void *ptr, size_t size);
 
+	/**
+	 * Write a message given in two parts to the logger and handle dropouts.
+	 * @return true if data written, false otherwise (on overflow)
+	 */
+	bool write(const void *ptr, size_t size, const void *ptr2, size_t size2);
+
 	/**
 	 * Get the time for log file name
 	 * @param tt returned time
@@ -205,6 +268,17 @@ private:
 	void add_default_topics();
 
 	static constexpr size_t 	MAX_TOPICS_NUM = 64; /**< Maximum number of logged topics */
+	static constexpr unsigned	UPDATE_QUEUE_CONTROL_TAG = MAX_TOPICS_NUM * ORB_MULTI_MAX_INSTANCES; /**< tag of the non-logged subscriptions */
+	static constexpr unsigned	UPDATE_QUEUE_SIZE = UPDATE_QUEUE_CONTROL_TAG + 1;
+	static constexpr unsigned	UPDATE_QUEUE_TIMEOUT = 100 * 1000; /**< max wait for updates [us] */
+#ifdef __PX4_NUTTX
+	static constexpr unsigned	INDEX_MAX_ENTRIES = 256; /**< Maximum number of timestamp samples in the index */
+	static constexpr unsigned	INDEX_MAX_EVENTS = 64; /**< Maximum number of parameter changes and added topics in the index */
+#else
+	static constexpr unsigned	INDEX_MAX_ENTRIES = 8192;
+	static constexpr unsigned	INDEX_MAX_EVENTS = 1024;
+#endif
+	static constexpr unsigned	INDEX_ENTRIES_PER_MSG = 32; /**< index samples per INDEX message */
 	static constexpr unsigned	MAX_NO_LOGFOLDER = 999;	/**< Maximum number of log dirs */
 	static constexpr unsigned	MAX_NO_LOGFILE = 999;	/**< Maximum number of log files */
 #ifdef __PX4_POSIX_EAGLE
@@ -236,7 +310,12 @@ private:
 	const bool					_log_name_timestamp;
 	Array<LoggerSubscription, MAX_TOPICS_NUM>	_subscriptions;
 	LogWriter					_writer;
+	BackfillBuffer					_backfill; ///< data recorded while not logging
+	LogIndex					_index; ///< index of the current log
+	const size_t					_backfill_buffer_size;
 	uint32_t					_log_interval;
+	orb_update_queue_t				_update_queue = nullptr; ///< topic update notifications, if null topics are polled
+	uint16_t					_update_tags[UPDATE_QUEUE_SIZE];
 	param_t						_log_utc_offset;
 	orb_advert_t					_mavlink_log_pub = nullptr;
 	uint16_t					_next_topic_id; ///< id of next subscribed topic
@@ -43,8 +43,18 @@ enum class ULogMessageType : uint8_t {
 	SYNC = 'S',
 	DROPOUT = 'O',
 	LOGGING = 'L',
+	INDEX = 'X',
 };
 
+/** content of an INDEX message (first byte of the payload) */
+enum class ULogIndexType : uint8_t {
+	DATA = 0, ///< array of ulog_index_data_entry_s
+	EVENTS = 1, ///< array of uint64_t file offsets of PARAMETER and ADD_LOGGED_MSG messages
+	END = 2, ///< ulog_message_index_end_s, the last message in the file
+};
+
+#define ULOG_INDEX_FLAG_EVENTS_INCOMPLETE 0x01 ///< not all PARAMETER and ADD_LOGGED_MSG messages are in the index
+
 
 /* declare message data structs with byte alignment (no padding) */
 #pragma pack(push, 1)
@@ -129,4 +139,34 @@ struct ulog_message_parameter_header_s {
 	uint8_t key_len;
 	char key[255];
 };
+/**
+ * The index is written at the end of the log: a sequence of INDEX messages, followed by
+ * ulog_message_index_end_s, which makes it possible to find the index from the end of the file.
+ * All offsets are positions in the (uncompressed) ULog data, counted from the start of the file.
+ */
+struct ulog_message_index_header_s {
+	uint16_t msg_size;
+	uint8_t msg_type = static_cast<uint8_t>(ULogMessageType::INDEX);
+
+	uint8_t index_type;
+};
+
+/** timestamp -> offset sample of a data message */
+struct ulog_index_data_entry_s {
+	uint64_t timestamp; ///< timestamp of the message
+	uint64_t offset; ///< file offset of the DATA message
+	uint16_t msg_id;
+};
+
+struct ulog_message_index_end_s {
+	uint16_t msg_size = sizeof(ulog_message_index_end_s) - ULOG_MSG_HEADER_LEN;
+	uint8_t msg_type = static_cast<uint8_t>(ULogMessageType::INDEX);
+
+	uint8_t index_type = static_cast<uint8_t>(ULogIndexType::END);
+	uint8_t flags;
+	uint64_t index_offset; ///< file offset of the first INDEX message
+	uint8_t magic[8];
+};
+
+#define ULOG_INDEX_END_MAGIC "ULogIdx"
 #pragma pack(pop)
@@ -48,3 +48,20 @@
  * @group SD Logging
  */
 PARAM_DEFINE_INT32(SDLOG_UTC_OFFSET, 0);
+
+/**
+ * Pre-arm backfill window (unit: s)
+ *
+ * While not logging (e.g. before arming), the logger keeps the data of
+ * the last SDLOG_BACKFILL seconds in RAM and writes it at the beginning
+ * of the next log. The amount of data is additionally limited by the size
+ * of the backfill buffer (logger option -p).
+ * Set to 0 to disable.
+ *
+ * @unit s
+ * @min 0
+ * @max 60
+ * @reboot_required true
+ * @group SD Logging
+ */
+PARAM_DEFINE_INT32(SDLOG_BACKFILL, 0);
@@ -187,6 +187,10 @@ Mavlink::Mavlink() :
 	_main_loop_delay(1000),
 	_subscriptions(nullptr),
 	_streams(nullptr),
+	_update_queue(nullptr),
+	_update_subscriptions{},
+	_num_update_subscriptions(0),
+	_update_tags{},
 	_mission_manager(nullptr),
 	_parameters_manager(nullptr),
 	_mavlink_ftp(nullptr),
@@ -211,6 +215,7 @@ Mavlink::Mavlink() :
 	mavlink_link_termination_allowed(false),
 	_subscribe_to_stream(nullptr),
 	_subscribe_to_stream_rate(0.0f),
+	_subscribe_to_stream_on_update(false),
 	_udp_initialised(false),
 	_flow_control_enabled(false),
 	_last_write_success_time(0),
@@ -235,6 +240,17 @@ Mavlink::Mavlink() :
 	_broadcast_failed_warned(false),
 	_network_buf{},
 	_network_buf_len(0),
+	_network_tx_buf{},
+	_network_tx_len{},
+	_network_tx_count(0),
+	_network_tx_first(0),
+	_network_tx_window(0),
+	_network_tx_syscalls(0),
+	_network_tx_datagrams(0),
+	_network_tx_bytes(0),
+	_rate_tx_syscalls(0.0f),
+	_rate_tx_datagrams(0.0f),
+	_rate_tx_bytes(0.0f),
 #endif
 	_socket_fd(-1),
 	_protocol(SERIAL),
@@ -920,39 +936,37 @@ Mavlink::send_packet()
 	}
 
 	if (get_protocol() == UDP) {
+		pthread_mutex_lock(&_send_mutex);
 
+		/* append the message to the last datagram, or start a new one */
+		if (_network_tx_count == 0 ||
+		    _network_tx_len[_network_tx_count - 1] + _network_buf_len > NETWORK_TX_MTU) {
 
-		ret = sendto(_socket_fd, _network_buf, _network_buf_len, 0,
-			     (struct sockaddr *)&_src_addr, sizeof(_src_addr));
-
-		struct telemetry_status_s &tstatus = get_rx_status();
-
-		/* resend message via broadcast if no valid connection exists */
-		if ((_mode != MAVLINK_MODE_ONBOARD) && broadcast_enabled() &&
-		    (!get_client_source_initialized()
-		     || (hrt_elapsed_time(&tstatus.heartbeat_time) > 3 * 1000 * 1000))) {
-
-			if (!_broadcast_address_found) {
-				find_broadcast_address();
+			if (_network_tx_count == NETWORK_TX_DATAGRAMS) {
+				send_network_tx();
 			}
 
-			if (_broadcast_address_found && _network_buf_len > 0) {
+			_network_tx_len[_network_tx_count++] = 0;
+		}
 
-				int bret = sendto(_socket_fd, _network_buf, _network_buf_len, 0,
-						  (struct sockaddr *)&_bcast_addr, sizeof(_bcast_addr));
+		memcpy(&_network_tx_buf[_network_tx_count - 1][_network_tx_len[_network_tx_count - 1]],
+		       _network_buf, _network_buf_len);
+		_network_tx_len[_network_tx_count - 1] += _network_buf_len;
 
-				if (bret <= 0) {
-					if (!_broadcast_failed_warned) {
-						PX4_ERR("sending broadcast failed, errno: %d: %s", errno, strerror(errno));
-						_broadcast_failed_warned = true;
-					}
+		if (_network_tx_first == 0) {
+			_network_tx_first = hrt_absolute_time();
+		}
 
-				} else {
-					_broadcast_failed_warned = false;
-				}
-			}
+		if (_network_tx_window == 0) {
+			ret = send_network_tx();
+
+		} else {
+			/* sent by the main loop when the window expired */
+			ret = _network_buf_len;
 		}
 
+		pthread_mutex_unlock(&_send_mutex);
+
 	} else if (get_protocol() == TCP) {
 		/* not implemented, but possible to do so */
 		PX4_ERR("TCP transport pending implementation");
@@ -964,6 +978,134 @@ Mavlink::send_packet()
 	return ret;
 }
 
+#ifdef __PX4_POSIX
+void
+Mavlink::flush_network_tx(hrt_abstime t)
+{
+	pthread_mutex_lock(&_send_mutex);
+
+	if (_network_tx_first != 0 && t >= _network_tx_first + _network_tx_window) {
+		send_network_tx();
+	}
+
+	pthread_mutex_unlock(&_send_mutex);
+}
+
+int
+Mavlink::send_network_tx()
+{
+	if (_network_tx_count == 0) {
+		return 0;
+	}
+
+	struct telemetry_status_s &tstatus = get_rx_status();
+	bool broadcast = false;
+
+	/* resend message via broadcast if no valid connection exists */
+	if ((_mode != MAVLINK_MODE_ONBOARD) && broadcast_enabled() &&
+	    (!get_client_source_initialized()
+	     || (hrt_elapsed_time(&tstatus.heartbeat_time) > 3 * 1000 * 1000))) {
+
+		if (!_broadcast_address_found) {
+			find_broadcast_address();
+		}
+
+		broadcast = _broadcast_address_found;
+	}
+
+	/* one message per datagram and destination */
+	struct iovec iov[NETWORK_TX_DATAGRAMS];
+	struct msghdr hdr[2 * NETWORK_TX_DATAGRAMS];
+	unsigned num_hdr = 0;
+	memset(hdr, 0, sizeof(hdr));
+
+	for (unsigned i = 0; i < _network_tx_count; i++) {
+		iov[i].iov_base = _network_tx_buf[i];
+		iov[i].iov_len = _network_tx_len[i];
+
+		hdr[num_hdr].msg_name = &_src_addr;
+		hdr[num_hdr].msg_namelen = sizeof(_src_addr);
+		hdr[num_hdr].msg_iov = &iov[i];
+		hdr[num_hdr].msg_iovlen = 1;
+		num_hdr++;
+
+		if (broadcast) {
+			hdr[num_hdr] = hdr[num_hdr - 1];
+			hdr[num_hdr].msg_name = &_bcast_addr;
+			hdr[num_hdr].msg_namelen = sizeof(_bcast_addr);
+			num_hdr++;
+		}
+	}
+
+	int bytes = 0;
+	bool failed = false;
+	int broadcast_errno = 0;
+	unsigned next = 0;
+
+#if defined(__PX4_LINUX)
+	struct mmsghdr msgs[2 * NETWORK_TX_DATAGRAMS];
+	memset(msgs, 0, sizeof(msgs));
+
+	for (unsigned i = 0; i < num_hdr; i++) {
+		msgs[i].msg_hdr = hdr[i];
+	}
+#endif
+
+	while (next < num_hdr) {
+#if defined(__PX4_LINUX)
+		int sent = sendmmsg(_socket_fd, &msgs[next], num_hdr - next, 0);
+
+		for (int i = 0; i < sent; i++) {
+			bytes += msgs[next + i].msg_len;
+		}
+
+#else
+		int sent = sendmsg(_socket_fd, &hdr[next], 0) >= 0 ? 1 : -1;
+
+		if (sent > 0) {
+			bytes += hdr[next].msg_iov->iov_len;
+		}
+
+#endif
+		_network_tx_syscalls++;
+
+		if (sent > 0) {
+			next += sent;
+
+		} else {
+			/* skip the message that failed and continue with the next one */
+			if (hdr[next].msg_name == &_bcast_addr) {
+				broadcast_errno = errno;
+
+			} else {
+				failed = true;
+			}
+
+			next++;
+		}
+	}
+
+	if (broadcast) {
+		if (broadcast_errno != 0) {
+			if (!_broadcast_failed_warned) {
+				PX4_ERR("sending broadcast failed, errno: %d: %s", broadcast_errno, strerror(broadcast_errno));
+				_broadcast_failed_warned = true;
+			}
+
+		} else {
+			_broadcast_failed_warned = false;
+		}
+	}
+
+	_network_tx_bytes += bytes;
+	_network_tx_datagrams += num_hdr;
+	_network_tx_count = 0;
+	_network_tx_first = 0;
+
+	return failed ? -1 : bytes;
+}
+#endif
+
 void
 Mavlink::send_bytes(const uint8_t *buf, unsigned packet_len)
 {
@@ -1318,7 +1460,7 @@ Mavlink::interval_from_rate(float rate)
 }
 
 int
-Mavlink::configure_stream(const char *stream_name, const float rate)
+Mavlink::configure_stream(const char *stream_name, const float rate, bool on_update)
 {
 	/* calculate interval in us, 0 means disabled stream */
 	unsigned int interval = interval_from_rate(rate);
@@ -1330,9 +1472,13 @@ Mavlink::configure_stream(const char *stream_name, const float rate)
 			if (interval > 0) {
 				/* set new interval */
 				stream->set_interval(interval);
+				stream->set_on_update(on_update);
+				attach_update_subscription(stream);
+				_stream_scheduler.reschedule();
 
 			} else {
 				/* delete stream */
+				_stream_scheduler.remove(stream);
 				LL_DELETE(_streams, stream);
 				delete stream;
 			}
@@ -1353,7 +1499,14 @@ Mavlink::configure_stream(const char *stream_name, const float rate)
 			/* create new instance */
 			stream = streams_list[i]->new_instance(this);
 			stream->set_interval(interval);
+
+			if (on_update && !stream->set_on_update(true)) {
+				PX4_WARN("stream %s can't be sent on update, polling at %.1f Hz", stream_name, (double)rate);
+			}
+
+			attach_update_subscription(stream);
 			LL_APPEND(_streams, stream);
+			_stream_scheduler.add(stream);
 
 			return OK;
 		}
@@ -1388,10 +1541,66 @@ Mavlink::adjust_stream_rates(const float multiplier)
 		/* set new interval */
 		stream->set_interval(interval * multiplier);
 	}
+
+	_stream_scheduler.reschedule();
 }
 
 void
-Mavlink::configure_stream_threadsafe(const char *stream_name, const float rate)
+Mavlink::attach_update_subscription(MavlinkStream *stream)
+{
+	MavlinkOrbSubscription *sub = stream->get_update_subscription();
+
+	if (!stream->get_on_update() || sub == nullptr || _update_queue == nullptr) {
+		return;
+	}
+
+	/* subscriptions are shared between streams, so is the tag */
+	for (unsigned i = 0; i < _num_update_subscriptions; i++) {
+		if (_update_subscriptions[i] == sub) {
+			return;
+		}
+	}
+
+	if (_num_update_subscriptions >= UPDATE_QUEUE_SIZE) {
+		/* the stream keeps polling at its rate */
+		PX4_WARN("too many on-update streams, %s polls", stream->get_name());
+		return;
+	}
+
+	_update_subscriptions[_num_update_subscriptions] = sub;
+	sub->set_update_queue(_update_queue, _num_update_subscriptions);
+	_num_update_subscriptions++;
+}
+
+void
+Mavlink::wait_for_updates(unsigned timeout_us)
+{
+	int n = orb_update_queue_wait(_update_queue, _update_tags, UPDATE_QUEUE_SIZE, timeout_us);
+
+	if (n <= 0) {
+		return;
+	}
+
+	for (int i = 0; i < n; i++) {
+		if (_update_tags[i] >= _num_update_subscriptions) {
+			continue;
+		}
+
+		MavlinkOrbSubscription *sub = _update_subscriptions[_update_tags[i]];
+		MavlinkStream *stream;
+		LL_FOREACH(_streams, stream) {
+			if (stream->get_on_update() && stream->get_update_subscription() == sub) {
+				stream->notify_update();
+			}
+		}
+	}
+
+	/* the notified streams are due now, or when their maximum rate allows */
+	_stream_scheduler.reschedule();
+}
+
+void
+Mavlink::configure_stream_threadsafe(const char *stream_name, const float rate, bool on_update)
 {
 	/* orb subscription must be done from the main thread,
 	 * set _subscribe_to_stream and _subscribe_to_stream_rate fields
@@ -1409,6 +1618,7 @@ Mavlink::configure_stream_threadsafe(const char *stream_name, const float rate)
 
 		/* set subscription task */
 		_subscribe_to_stream_rate = rate;
+		_subscribe_to_stream_on_update = on_update;
 		_subscribe_to_stream = s;
 
 		/* wait for subscription */
@@ -1694,7 +1904,7 @@ Mavlink::task_main(int argc, char *argv[])
 	int temp_int_arg;
 #endif
 
-	while ((ch = px4_getopt(argc, argv, "b:r:d:u:o:m:t:fpvwx", &myoptind, &myoptarg)) != EOF) {
+	while ((ch = px4_getopt(argc, argv, "b:r:d:u:o:m:t:c:fpvwx", &myoptind, &myoptarg)) != EOF) {
 		switch (ch) {
 		case 'b':
 			_baudrate = strtoul(myoptarg, NULL, 10);
@@ -1762,12 +1972,26 @@ Mavlink::task_main(int argc, char *argv[])
 				err_flag = true;
 			}
 
+			break;
+
+		case 'c':
+			temp_int_arg = strtoul(myoptarg, &eptr, 10);
+
+			if (*eptr == '\0') {
+				_network_tx_window = temp_int_arg;
+
+			} else {
+				warnx("invalid coalescing window '%s'", myoptarg);
+				err_flag = true;
+			}
+
 			break;
 #else
 
 		case 'u':
 		case 'o':
 		case 't':
+		case 'c':
 			warnx("UDP options not supported on this platform");
 			err_flag = true;
 			break;
@@ -1907,6 +2131,13 @@ Mavlink::task_main(int argc, char *argv[])
 	struct vehicle_command_ack_s command_ack;
 	ack_sub->update(&ack_time, &command_ack);
 
+	/* publications wake up the main loop for on-update streams */
+	_update_queue = orb_update_queue_create(UPDATE_QUEUE_SIZE);
+
+	if (_update_queue == nullptr) {
+		PX4_WARN("no update queue, on-update streams poll");
+	}
+
 	/* add default streams depending on mode */
 
 	/* HEARTBEAT is constant rate stream, rate never adjusted */
@@ -1922,16 +2153,19 @@ Mavlink::task_main(int argc, char *argv[])
 	_parameters_manager = (MavlinkParametersManager *) MavlinkParametersManager::new_instance(this);
 	_parameters_manager->set_interval(interval_from_rate(120.0f));
 	LL_APPEND(_streams, _parameters_manager);
+	_stream_scheduler.add(_parameters_manager);
 
 	/* MAVLINK_FTP stream */
 	_mavlink_ftp = (MavlinkFTP *) MavlinkFTP::new_instance(this);
 	_mavlink_ftp->set_interval(interval_from_rate(80.0f));
 	LL_APPEND(_streams, _mavlink_ftp);
+	_stream_scheduler.add(_mavlink_ftp);
 
 	/* MAVLINK_Log_Handler */
 	_mavlink_log_handler = (MavlinkLogHandler *) MavlinkLogHandler::new_instance(this);
 	_mavlink_log_handler->set_interval(interval_from_rate(80.0f));
 	LL_APPEND(_streams, _mavlink_log_handler);
+	_stream_scheduler.add(_mavlink_log_handler);
 
 	/* MISSION_STREAM stream, actually sends all MISSION_XXX messages at some rate depending on
 	 * remote requests rate. Rate specified here controls how much bandwidth we will reserve for
@@ -1940,6 +2174,7 @@ Mavlink::task_main(int argc, char *argv[])
 	_mission_manager->set_interval(interval_from_rate(10.0f));
 	_mission_manager->set_verbose(_verbose);
 	LL_APPEND(_streams, _mission_manager);
+	_stream_scheduler.add(_mission_manager);
 
 	switch (_mode) {
 	case MAVLINK_MODE_NORMAL:
@@ -1968,10 +2203,11 @@ Mavlink::task_main(int argc, char *argv[])
 		break;
 
 	case MAVLINK_MODE_ONBOARD:
+		/* the state estimate is sent when it is published, the rates are the maximum rates */
 		configure_stream("SYS_STATUS", 1.0f);
 		configure_stream("EXTENDED_SYS_STATE", 2.0f);
-		configure_stream("HIGHRES_IMU", 50.0f);
-		configure_stream("ATTITUDE", 250.0f);
+		configure_stream("HIGHRES_IMU", 50.0f, true);
+		configure_stream("ATTITUDE", 250.0f, true);
 		configure_stream("RC_CHANNELS", 20.0f);
 		configure_stream("SERVO_OUTPUT_RAW_0", 10.0f);
 		configure_stream("ALTITUDE", 10.0f);
@@ -1982,8 +2218,8 @@ Mavlink::task_main(int argc, char *argv[])
 		configure_stream("VISION_POSITION_NED", 10.0f);
 		configure_stream("ESTIMATOR_STATUS", 1.0f);
 		configure_stream("NAV_CONTROLLER_OUTPUT", 10.0f);
-		configure_stream("GLOBAL_POSITION_INT", 50.0f);
-		configure_stream("LOCAL_POSITION_NED", 30.0f);
+		configure_stream("GLOBAL_POSITION_INT", 50.0f, true);
+		configure_stream("LOCAL_POSITION_NED", 30.0f, true);
 		configure_stream("POSITION_TARGET_GLOBAL_INT", 10.0f);
 		configure_stream("ATTITUDE_TARGET", 10.0f);
 		configure_stream("HOME_POSITION", 0.5f);
@@ -2080,16 +2316,59 @@ Mavlink::task_main(int argc, char *argv[])
 		send_autopilot_capabilites();
 	}
 
+	hrt_abstime next_main_loop_update = 0;
+	float scheduled_rate_mult = _rate_mult;
+
 	while (!_task_should_exit) {
-		/* main loop */
-		usleep(_main_loop_delay);
+		/* main loop: sleep until the next stream is due, but at most for the main loop delay */
+		hrt_abstime t = hrt_absolute_time();
+		hrt_abstime wakeup = next_main_loop_update;
+		hrt_abstime next_stream_due = _stream_scheduler.next_due();
+
+		if (next_stream_due != 0 && next_stream_due < wakeup) {
+			wakeup = next_stream_due;
+		}
+
+#ifdef __PX4_POSIX
+
+		if (_network_tx_first != 0 && _network_tx_first + _network_tx_window < wakeup) {
+			wakeup = _network_tx_first + _network_tx_window;
+		}
+
+#endif
+
+		if (_update_queue != nullptr) {
+			/* on-update streams: wake up early on publications */
+			wait_for_updates(wakeup > t ? wakeup - t : 0);
+
+		} else if (wakeup > t) {
+			usleep(wakeup - t);
+		}
 
 		perf_begin(_loop_perf);
 
-		hrt_abstime t = hrt_absolute_time();
+		t = hrt_absolute_time();
+
+		if (t < next_main_loop_update) {
+			/* only streams are due */
+			_stream_scheduler.update(t);
+#ifdef __PX4_POSIX
+			flush_network_tx(t);
+#endif
+			perf_end(_loop_perf);
+			continue;
+		}
+
+		next_main_loop_update = t + _main_loop_delay;
 
 		update_rate_mult();
 
+		if (_rate_mult != scheduled_rate_mult) {
+			/* the stream intervals changed */
+			_stream_scheduler.reschedule();
+			scheduled_rate_mult = _rate_mult;
+		}
+
 		_mission_manager->check_active_mission();
 
 		if (param_sub->update(&param_time, nullptr)) {
@@ -2178,7 +2457,8 @@ Mavlink::task_main(int argc, char *argv[])
 
 		/* check for requested subscriptions */
 		if (_subscribe_to_stream != nullptr) {
-			if (OK == configure_stream(_subscribe_to_stream, _subscribe_to_stream_rate)) {
+			if (OK == configure_stream(_subscribe_to_stream, _subscribe_to_stream_rate,
+						  _subscribe_to_stream_on_update)) {
 				if (_subscribe_to_stream_rate > 0.0f) {
 					if (get_protocol() == SERIAL) {
 						PX4_DEBUG("stream %s on device %s enabled with rate %.1f Hz", _subscribe_to_stream, _device_name,
@@ -2211,10 +2491,7 @@ Mavlink::task_main(int argc, char *argv[])
 		}
 
 		/* update streams */
-		MavlinkStream *stream;
-		LL_FOREACH(_streams, stream) {
-			stream->update(t);
-		}
+		_stream_scheduler.update(t);
 
 		/* pass messages from other UARTs or FTP worker */
 		if (_forwarding_on || _ftp_on) {
@@ -2274,11 +2551,23 @@ Mavlink::task_main(int argc, char *argv[])
 				_bytes_tx = 0;
 				_bytes_txerr = 0;
 				_bytes_rx = 0;
+#ifdef __PX4_POSIX
+				_rate_tx_syscalls = _network_tx_syscalls * 1000.0f / dt;
+				_rate_tx_datagrams = _network_tx_datagrams * 1000.0f / dt;
+				_rate_tx_bytes = _network_tx_bytes * 1000.0f / dt;
+				_network_tx_syscalls = 0;
+				_network_tx_datagrams = 0;
+				_network_tx_bytes = 0;
+#endif
 			}
 
 			_bytes_timestamp = t;
 		}
 
+#ifdef __PX4_POSIX
+		flush_network_tx(t);
+#endif
+
 		perf_end(_loop_perf);
 
 		/* confirm task running only once fully initialized */
@@ -2298,11 +2587,24 @@ Mavlink::task_main(int argc, char *argv[])
 	while (stream_next != nullptr) {
 		stream_to_del = stream_next;
 		stream_next = stream_to_del->next;
+		_stream_scheduler.remove(stream_to_del);
 		delete stream_to_del;
 	}
 
 	_streams = nullptr;
 
+	/* detach the on-update subscriptions before the queue is destroyed */
+	for (unsigned i = 0; i < _num_update_subscriptions; i++) {
+		_update_subscriptions[i]->set_update_queue(nullptr, 0);
+	}
+
+	_num_update_subscriptions = 0;
+
+	if (_update_queue != nullptr) {
+		orb_update_queue_destroy(_update_queue);
+		_update_queue = nullptr;
+	}
+
 	/* delete subscriptions */
 	MavlinkOrbSubscription *sub_to_del = nullptr;
 	MavlinkOrbSubscription *sub_next = _subscriptions;
@@ -2453,8 +2755,32 @@ Mavlink::display_status()
 	printf("\ttx: %.3f kB/s\n", (double)_rate_tx);
 	printf("\ttxerr: %.3f kB/s\n", (double)_rate_txerr);
 	printf("\trx: %.3f kB/s\n", (double)_rate_rx);
+#ifdef __PX4_POSIX
+
+	if (get_protocol() == UDP) {
+		printf("\tudp tx: %.3f kB/s, %.1f datagrams/s, %.1f syscalls/s (window %u us)\n",
+		       (double)_rate_tx_bytes / 1000.0, (double)_rate_tx_datagrams, (double)_rate_tx_syscalls,
+		       _network_tx_window);
+	}
+
+#endif
 	printf("\trate mult: %.3f\n", (double)_rate_mult);
 	printf("\taccepting commands: %s\n", (accepting_commands()) ? "YES" : "NO");
+	printf("\tstreams:\t\t rate (Hz)  achieved (Hz)  latency avg/max (us)\n");
+
+	MavlinkStream *stream;
+	LL_FOREACH(_streams, stream) {
+		unsigned interval = stream->get_interval();
+
+		if (!stream->const_rate()) {
+			interval /= _rate_mult;
+		}
+
+		printf("\t  %-24s %8.2f %14.2f %10u / %u%s\n", stream->get_name(),
+		       (interval > 0) ? 1e6 / interval : 0.0, (double)stream->get_achieved_rate(),
+		       stream->get_latency_avg(), stream->get_latency_max(),
+		       stream->get_on_update() ? " (on update)" : "");
+	}
 }
 
 int
@@ -2468,6 +2794,7 @@ Mavlink::stream_command(int argc, char *argv[])
 	int temp_int_arg;
 	bool provided_device = false;
 	bool provided_network_port = false;
+	bool on_update = false;
 
 	/*
 	 * Called via main with original argv
@@ -2504,6 +2831,10 @@ Mavlink::stream_command(int argc, char *argv[])
 			stream_name = argv[i + 1];
 			i++;
 
+		} else if (0 == strcmp(argv[i], "-p")) {
+			/* send on publication, the rate is the maximum rate */
+			on_update = true;
+
 		} else if (0 == strcmp(argv[i], "-u") && i < argc - 1) {
 			provided_network_port = true;
 			temp_int_arg = strtoul(argv[i + 1], &eptr, 10);
@@ -2540,7 +2871,7 @@ Mavlink::stream_command(int argc, char *argv[])
 		}
 
 		if (inst != nullptr) {
-			inst->configure_stream_threadsafe(stream_name, rate);
+			inst->configure_stream_threadsafe(stream_name, rate, on_update);
 
 		} else {
 
@@ -2557,7 +2888,7 @@ Mavlink::stream_command(int argc, char *argv[])
 		}
 
 	} else {
-		PX4_INFO("usage: mavlink stream [-d device] [-u network_port] -s stream -r rate");
+		PX4_INFO("usage: mavlink stream [-d device] [-u network_port] -s stream -r rate [-p]");
 		return 1;
 	}
 
@@ -2590,6 +2921,7 @@ static void usage()
 	PX4_INFO("    [-u network_port]");
 	PX4_INFO("    [-o remote_port]");
 	PX4_INFO("    [-t partner_ip]");
+	PX4_INFO("    [-c udp_coalescing_window_us]");
 #endif
 	PX4_INFO("    [-b baudrate]");
 	PX4_INFO("    [-r rate]");
@@ -64,6 +64,7 @@
 #include "mavlink_bridge_header.h"
 #include "mavlink_orb_subscription.h"
 #include "mavlink_stream.h"
+#include "mavlink_stream_scheduler.h"
 #include "mavlink_messages.h"
 #include "mavlink_mission.h"
 #include "mavlink_parameters.h"
@@ -308,7 +309,12 @@ public:
 
 	mavlink_channel_t	get_channel();
 
-	void			configure_stream_threadsafe(const char *stream_name, float rate);
+	/**
+	 * Configure a stream from another thread, waits until the main thread applied it.
+	 *
+	 * @param on_update	send on publications of the stream's topic, the rate is then the maximum rate
+	 */
+	void			configure_stream_threadsafe(const char *stream_name, float rate, bool on_update = false);
 
 	bool			_task_should_exit;	/**< if true, mavlink task should exit */
 
@@ -461,6 +467,13 @@ private:
 
 	MavlinkOrbSubscription	*_subscriptions;
 	MavlinkStream		*_streams;
+	MavlinkStreamScheduler	_stream_scheduler;	/**< the streams ordered by the time they are due */
+
+	static constexpr unsigned UPDATE_QUEUE_SIZE = 16;
+	orb_update_queue_t	_update_queue;		/**< wakes up the main loop on publications for on-update streams */
+	MavlinkOrbSubscription	*_update_subscriptions[UPDATE_QUEUE_SIZE]; /**< subscription per update queue tag */
+	unsigned		_num_update_subscriptions;
+	uint16_t		_update_tags[UPDATE_QUEUE_SIZE];
 
 	MavlinkMissionManager		*_mission_manager;
 	MavlinkParametersManager	*_parameters_manager;
@@ -501,6 +514,7 @@ private:
 
 	char 			*_subscribe_to_stream;
 	float			_subscribe_to_stream_rate;
+	bool			_subscribe_to_stream_on_update;
 	bool 			_udp_initialised;
 
 	bool			_flow_control_enabled;
@@ -526,8 +540,24 @@ private:
 	bool _broadcast_address_found;
 	bool _broadcast_address_not_found_warned;
 	bool _broadcast_failed_warned;
-	uint8_t _network_buf[MAVLINK_MAX_PACKET_LEN];
+	uint8_t _network_buf[MAVLINK_MAX_PACKET_LEN];	///< message being written
 	unsigned _network_buf_len;
+
+	static constexpr unsigned NETWORK_TX_MTU = 1472;	///< UDP payload of a 1500 byte ethernet frame
+	static constexpr unsigned NETWORK_TX_DATAGRAMS = 8;
+
+	/* complete messages, coalesced into datagrams and sent together */
+	uint8_t _network_tx_buf[NETWORK_TX_DATAGRAMS][NETWORK_TX_MTU];
+	unsigned _network_tx_len[NETWORK_TX_DATAGRAMS];
+	unsigned _network_tx_count;		///< number of datagrams in use, the last one is still filled
+	hrt_abstime _network_tx_first;		///< time the oldest queued message was written, 0 if empty
+	unsigned _network_tx_window;		///< maximum time messages are queued [us], 0 sends every message immediately
+	unsigned _network_tx_syscalls;
+	unsigned _network_tx_datagrams;
+	unsigned _network_tx_bytes;
+	float _rate_tx_syscalls;
+	float _rate_tx_datagrams;
+	float _rate_tx_bytes;
 #endif
 	int _socket_fd;
 	Protocol	_protocol;
@@ -579,7 +609,33 @@ private:
 	static constexpr unsigned RADIO_BUFFER_LOW_PERCENTAGE = 35;
 	static constexpr unsigned RADIO_BUFFER_HALF_PERCENTAGE = 50;
 
-	int configure_stream(const char *stream_name, const float rate);
+	int configure_stream(const char *stream_name, const float rate, bool on_update = false);
+
+	/**
+	 * Attach the subscription of an on-update stream to the update queue
+	 */
+	void attach_update_subscription(MavlinkStream *stream);
+
+	/**
+	 * Wait for publications of on-update stream topics or until the timeout expired,
+	 * and mark the streams that need to be sent.
+	 */
+	void wait_for_updates(unsigned timeout_us);
+
+#ifdef __PX4_POSIX
+	/**
+	 * Send the queued network messages if the coalescing window expired
+	 */
+	void flush_network_tx(hrt_abstime t);
+
+	/**
+	 * Send all queued network messages, with a single sendmmsg() call where available.
+	 * The caller must hold the send mutex.
+	 *
+	 * @return the number of bytes sent or -1 in case of error
+	 */
+	int send_network_tx();
+#endif
 
 	/**
 	 * Adjust the stream rates based on the current rate
@@ -53,6 +53,7 @@
 #include <px4_time.h>
 #include <systemlib/err.h>
 #include <systemlib/mavlink_log.h>
+#include <systemlib/perf_counter.h>
 
 #include <uORB/topics/actuator_armed.h>
 #include <uORB/topics/actuator_controls.h>
@@ -63,6 +64,8 @@
 #include <uORB/topics/camera_trigger.h>
 #include <uORB/topics/cpuload.h>
 #include <uORB/topics/debug_key_value.h>
+#include <uORB/topics/perf_counters.h>
+#include <uORB/topics/task_load.h>
 #include <uORB/topics/differential_pressure.h>
 #include <uORB/topics/distance_sensor.h>
 #include <uORB/topics/estimator_status.h>
@@ -701,6 +704,11 @@ public:
 		return MAVLINK_MSG_ID_HIGHRES_IMU_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES;
 	}
 
+	MavlinkOrbSubscription *get_update_subscription()
+	{
+		return _sensor_sub;
+	}
+
 private:
 	MavlinkOrbSubscription *_sensor_sub;
 	uint64_t _sensor_time;
@@ -820,6 +828,11 @@ public:
 		return MAVLINK_MSG_ID_ATTITUDE_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES;
 	}
 
+	MavlinkOrbSubscription *get_update_subscription()
+	{
+		return _att_sub;
+	}
+
 private:
 	MavlinkOrbSubscription *_att_sub;
 	uint64_t _att_time;
@@ -889,6 +902,11 @@ public:
 		return MAVLINK_MSG_ID_ATTITUDE_QUATERNION_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES;
 	}
 
+	MavlinkOrbSubscription *get_update_subscription()
+	{
+		return _att_sub;
+	}
+
 private:
 	MavlinkOrbSubscription *_att_sub;
 	uint64_t _att_time;
@@ -1389,6 +1407,11 @@ public:
 		return MAVLINK_MSG_ID_GLOBAL_POSITION_INT_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES;
 	}
 
+	MavlinkOrbSubscription *get_update_subscription()
+	{
+		return _pos_sub;
+	}
+
 private:
 	MavlinkOrbSubscription *_pos_sub;
 	uint64_t _pos_time;
@@ -1536,6 +1559,11 @@ public:
 		return MAVLINK_MSG_ID_LOCAL_POSITION_NED_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES;
 	}
 
+	MavlinkOrbSubscription *get_update_subscription()
+	{
+		return _pos_sub;
+	}
+
 private:
 	MavlinkOrbSubscription *_pos_sub;
 	uint64_t _pos_time;
@@ -2901,6 +2929,145 @@ protected:
 	}
 };
 
+class MavlinkStreamTaskLoad : public MavlinkStream
+{
+public:
+	const char *get_name() const
+	{
+		return MavlinkStreamTaskLoad::get_name_static();
+	}
+
+	static const char *get_name_static()
+	{
+		return "TASK_LOAD";
+	}
+
+	static uint8_t get_id_static()
+	{
+		return MAVLINK_MSG_ID_NAMED_VALUE_FLOAT;
+	}
+
+	uint8_t get_id()
+	{
+		return get_id_static();
+	}
+
+	static MavlinkStream *new_instance(Mavlink *mavlink)
+	{
+		return new MavlinkStreamTaskLoad(mavlink);
+	}
+
+	unsigned get_size()
+	{
+		return (_task_load_time > 0) ?
+		       task_load_s::MAX_TASKS * (MAVLINK_MSG_ID_NAMED_VALUE_FLOAT_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES) : 0;
+	}
+
+private:
+	MavlinkOrbSubscription *_task_load_sub;
+	uint64_t _task_load_time;
+
+	/* do not allow top copying this class */
+	MavlinkStreamTaskLoad(MavlinkStreamTaskLoad &);
+	MavlinkStreamTaskLoad &operator = (const MavlinkStreamTaskLoad &);
+
+protected:
+	explicit MavlinkStreamTaskLoad(Mavlink *mavlink) : MavlinkStream(mavlink),
+		_task_load_sub(_mavlink->add_orb_subscription(ORB_ID(task_load))),
+		_task_load_time(0)
+	{}
+
+	void send(const hrt_abstime t)
+	{
+		struct task_load_s task_load;
+
+		if (_task_load_sub->update(&_task_load_time, &task_load)) {
+			/* one message per task of the current page, with the CPU load in percent */
+			for (unsigned i = 0; i < task_load.count && i < task_load_s::MAX_TASKS; i++) {
+				mavlink_named_value_float_t msg;
+
+				msg.time_boot_ms = task_load.timestamp / 1000;
+				strncpy(msg.name, &task_load.name[i * task_load_s::NAME_LEN], sizeof(msg.name));
+				/* enforce null termination */
+				msg.name[sizeof(msg.name) - 1] = '\0';
+				msg.value = task_load.load[i] * 100.0f;
+
+				mavlink_msg_named_value_float_send_struct(_mavlink->get_channel(), &msg);
+			}
+		}
+	}
+};
+
+class MavlinkStreamPerfCounters : public MavlinkStream
+{
+public:
+	const char *get_name() const
+	{
+		return MavlinkStreamPerfCounters::get_name_static();
+	}
+
+	static const char *get_name_static()
+	{
+		return "PERF_COUNTERS";
+	}
+
+	static uint8_t get_id_static()
+	{
+		return MAVLINK_MSG_ID_NAMED_VALUE_INT;
+	}
+
+	uint8_t get_id()
+	{
+		return get_id_static();
+	}
+
+	static MavlinkStream *new_instance(Mavlink *mavlink)
+	{
+		return new MavlinkStreamPerfCounters(mavlink);
+	}
+
+	unsigned get_size()
+	{
+		return (_perf_counters_time > 0) ?
+		       perf_counters_s::MAX_COUNTERS * (MAVLINK_MSG_ID_NAMED_VALUE_INT_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES) : 0;
+	}
+
+private:
+	MavlinkOrbSubscription *_perf_counters_sub;
+	uint64_t _perf_counters_time;
+
+	/* do not allow top copying this class */
+	MavlinkStreamPerfCounters(MavlinkStreamPerfCounters &);
+	MavlinkStreamPerfCounters &operator = (const MavlinkStreamPerfCounters &);
+
+protected:
+	explicit MavlinkStreamPerfCounters(Mavlink *mavlink) : MavlinkStream(mavlink),
+		_perf_counters_sub(_mavlink->add_orb_subscription(ORB_ID(perf_counters))),
+		_perf_counters_time(0)
+	{}
+
+	void send(const hrt_abstime t)
+	{
+		struct perf_counters_s perf;
+
+		if (_perf_counters_sub->update(&_perf_counters_time, &perf)) {
+			/* one message per counter of the current page: the event count for PC_COUNT counters,
+			 * the average time in us otherwise */
+			for (unsigned i = 0; i < perf.count && i < perf_counters_s::MAX_COUNTERS; i++) {
+				mavlink_named_value_int_t msg;
+
+				msg.time_boot_ms = perf.timestamp / 1000;
+				strncpy(msg.name, &perf.name[i * perf_counters_s::NAME_LEN], sizeof(msg.name));
+				/* enforce null termination */
+				msg.name[sizeof(msg.name) - 1] = '\0';
+				msg.value = (perf.type[i] == PC_COUNT) ? perf.events[i] : perf.avg_us[i];
+
+				mavlink_msg_named_value_int_send_struct(_mavlink->get_channel(), &msg);
+			}
+		}
+	}
+};
+
 class MavlinkStreamNavControllerOutput : public MavlinkStream
 {
 public:
@@ -3480,6 +3647,8 @@ const StreamListItem *streams_list[] = {
 	new StreamListItem(&MavlinkStreamActuatorControlTarget<2>::new_instance, &MavlinkStreamActuatorControlTarget<2>::get_name_static, &MavlinkStreamActuatorControlTarget<2>::get_id_static),
 	new StreamListItem(&MavlinkStreamActuatorControlTarget<3>::new_instance, &MavlinkStreamActuatorControlTarget<3>::get_name_static, &MavlinkStreamActuatorControlTarget<3>::get_id_static),
 	new StreamListItem(&MavlinkStreamNamedValueFloat::new_instance, &MavlinkStreamNamedValueFloat::get_name_static, &MavlinkStreamNamedValueFloat::get_id_static),
+	new StreamListItem(&MavlinkStreamTaskLoad::new_instance, &MavlinkStreamTaskLoad::get_name_static, &MavlinkStreamTaskLoad::get_id_static),
+	new StreamListItem(&MavlinkStreamPerfCounters::new_instance, &MavlinkStreamPerfCounters::get_name_static, &MavlinkStreamPerfCounters::get_id_static),
 	new StreamListItem(&MavlinkStreamNavControllerOutput::new_instance, &MavlinkStreamNavControllerOutput::get_name_static, &MavlinkStreamNavControllerOutput::get_id_static),
 	new StreamListItem(&MavlinkStreamCameraCapture::new_instance, &MavlinkStreamCameraCapture::get_name_static, &MavlinkStreamCameraCapture::get_id_static),
 	new StreamListItem(&MavlinkStreamCameraTrigger::new_instance, &MavlinkStreamCameraTrigger::get_name_static, &MavlinkStreamCameraTrigger::get_id_static),
@@ -91,7 +91,12 @@ MavlinkMissionManager::MavlinkMissionManager(Mavlink *mavlink) : MavlinkStream(m
 	_mission_result_sub(-1),
 	_offboard_mission_pub(nullptr),
 	_slow_rate_limiter(_interval / 10.0f),
-	_verbose(false)
+	_verbose(false),
+	_transfer_items{},
+	_read_items{},
+	_read_items_dataman_id(0),
+	_read_items_seq(0),
+	_read_items_count(0)
 {
 	_offboard_mission_sub = orb_subscribe(ORB_ID(offboard_mission));
 	_mission_result_sub = orb_subscribe(ORB_ID(mission_result));
@@ -191,6 +196,50 @@ MavlinkMissionManager::update_active_mission(int dataman_id, unsigned count, int
 	}
 }
 
+int
+MavlinkMissionManager::read_mission_item(uint16_t seq, struct mission_item_s *mission_item)
+{
+	if (_read_items_count == 0 || _read_items_dataman_id != _dataman_id
+	    || seq < _read_items_seq || seq >= _read_items_seq + _read_items_count) {
+
+		unsigned num_items = (seq < _count) ? _count - seq : 1;
+
+		if (num_items > DATAMAN_BATCH_SIZE) {
+			num_items = DATAMAN_BATCH_SIZE;
+		}
+
+		ssize_t num_read = dm_read_range(DM_KEY_WAYPOINTS_OFFBOARD(_dataman_id), seq, num_items, _read_items,
+						 sizeof(struct mission_item_s));
+
+		if (num_read <= 0) {
+			_read_items_count = 0;
+			return ERROR;
+		}
+
+		_read_items_dataman_id = _dataman_id;
+		_read_items_seq = seq;
+		_read_items_count = num_read;
+	}
+
+	*mission_item = _read_items[seq - _read_items_seq];
+	return OK;
+}
+
+int
+MavlinkMissionManager::write_transfer_items(uint16_t seq)
+{
+	/* items arrive in order, the buffer holds the ones since the last full batch */
+	unsigned first = seq - (seq % DATAMAN_BATCH_SIZE);
+	unsigned num_items = seq - first + 1;
+
+	if (dm_write_range(DM_KEY_WAYPOINTS_OFFBOARD(_transfer_dataman_id), first, num_items, DM_PERSIST_POWER_ON_RESET,
+			   _transfer_items, sizeof(struct mission_item_s)) != (ssize_t)num_items) {
+		return ERROR;
+	}
+
+	return OK;
+}
+
 void
 MavlinkMissionManager::send_mission_ack(uint8_t sysid, uint8_t compid, uint8_t type)
 {
@@ -247,10 +296,9 @@ MavlinkMissionManager::send_mission_count(uint8_t sysid, uint8_t compid, uint16_
 void
 MavlinkMissionManager::send_mission_item(uint8_t sysid, uint8_t compid, uint16_t seq)
 {
-	dm_item_t dm_item = DM_KEY_WAYPOINTS_OFFBOARD(_dataman_id);
 	struct mission_item_s mission_item;
 
-	if (dm_read(dm_item, seq, &mission_item, sizeof(struct mission_item_s)) == sizeof(struct mission_item_s)) {
+	if (read_mission_item(seq, &mission_item) == OK) {
 		_time_last_sent = hrt_absolute_time();
 
 		if (_int_mode) {
@@ -544,6 +592,7 @@ MavlinkMissionManager::handle_mission_request_list(const mavlink_message_t *msg)
 			_state = MAVLINK_WPM_STATE_SENDLIST;
 			_transfer_seq = 0;
 			_transfer_count = _count;
+			_read_items_count = 0;	// the stored mission may have changed since the last transfer
 			_transfer_partner_sysid = msg->sysid;
 			_transfer_partner_compid = msg->compid;
 
@@ -803,10 +852,11 @@ MavlinkMissionManager::handle_mission_item_both(const mavlink_message_t *msg)
 			return;
 		}
 
-		dm_item_t dm_item = DM_KEY_WAYPOINTS_OFFBOARD(_transfer_dataman_id);
+		/* collect the items and write them in batches */
+		_transfer_items[wp.seq % DATAMAN_BATCH_SIZE] = mission_item;
 
-		if (dm_write(dm_item, wp.seq, DM_PERSIST_POWER_ON_RESET, &mission_item,
-			     sizeof(struct mission_item_s)) != sizeof(struct mission_item_s)) {
+		if ((((wp.seq + 1) % DATAMAN_BATCH_SIZE == 0) || (wp.seq + 1u == _transfer_count))
+		    && write_transfer_items(wp.seq) != OK) {
 			if (_verbose) { warnx("WPM: MISSION_ITEM ERROR: error writing seq %u to dataman ID %i", wp.seq, _transfer_dataman_id); }
 
 			send_mission_ack(_transfer_partner_sysid, _transfer_partner_compid, MAV_MISSION_ERROR);
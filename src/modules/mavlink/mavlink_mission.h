@@ -43,6 +43,7 @@
 #pragma once
 
 #include <uORB/uORB.h>
+#include <navigator/navigation.h>
 
 #include "mavlink_bridge_header.h"
 #include "mavlink_rate_limiter.h"
@@ -142,6 +143,15 @@ private:
 	static constexpr unsigned int	FILESYSTEM_ERRCOUNT_NOTIFY_LIMIT =
 		2;	///< Error count limit before stopping to report FS errors
 
+	static constexpr unsigned int	DATAMAN_BATCH_SIZE = 8;	///< Mission items moved per dataman request
+
+	struct mission_item_s	_transfer_items[DATAMAN_BATCH_SIZE];	///< Received items not yet written to dataman
+
+	struct mission_item_s	_read_items[DATAMAN_BATCH_SIZE];	///< Items read ahead for sending
+	int			_read_items_dataman_id;			///< Dataman storage ID of the read ahead items
+	unsigned		_read_items_seq;			///< Sequence of the first read ahead item
+	unsigned		_read_items_count;			///< Number of read ahead items, 0 if none
+
 	/* do not allow top copying this class */
 	MavlinkMissionManager(MavlinkMissionManager &);
 	MavlinkMissionManager &operator = (const MavlinkMissionManager &);
@@ -150,6 +160,20 @@ private:
 
 	int update_active_mission(int dataman_id, unsigned count, int seq);
 
+	/**
+	 * Get an item of the active mission, reading the following ones ahead in the same dataman request
+	 *
+	 * @return OK on success, ERROR if the item could not be read
+	 */
+	int read_mission_item(uint16_t seq, struct mission_item_s *mission_item);
+
+	/**
+	 * Write the received items up to and including seq to the transfer storage
+	 *
+	 * @return OK on success, ERROR if the items could not be written
+	 */
+	int write_transfer_items(uint16_t seq);
+
 	/**
 	 *  @brief Sends an waypoint ack message
 	 */
@@ -53,7 +53,10 @@ MavlinkOrbSubscription::MavlinkOrbSubscription(const orb_id_t topic, int instanc
 	_instance(instance),
 	_fd(-1),
 	_published(false),
-	_last_pub_check(0)
+	_last_pub_check(0),
+	_update_queue(nullptr),
+	_update_tag(0),
+	_update_queue_attached(false)
 {
 }
 
@@ -76,6 +79,31 @@ MavlinkOrbSubscription::get_instance() const
 	return _instance;
 }
 
+void
+MavlinkOrbSubscription::set_update_queue(orb_update_queue_t queue, unsigned tag)
+{
+	_update_queue = queue;
+	_update_tag = tag;
+	_update_queue_attached = false;
+
+	/* a nullptr queue detaches the subscription */
+	if (_fd >= 0 && orb_update_queue_attach(_update_queue, _fd, _update_tag) == 0) {
+		_update_queue_attached = (_update_queue != nullptr);
+	}
+}
+
+hrt_abstime
+MavlinkOrbSubscription::get_last_update()
+{
+	uint64_t time_topic;
+
+	if (_fd < 0 || orb_stat(_fd, &time_topic)) {
+		return 0;
+	}
+
+	return time_topic;
+}
+
 bool
 MavlinkOrbSubscription::update(uint64_t *time, void *data)
 {
@@ -186,6 +214,10 @@ MavlinkOrbSubscription::is_published()
 
 #endif
 
+	if (_update_queue && !_update_queue_attached && _fd >= 0) {
+		_update_queue_attached = orb_update_queue_attach(_update_queue, _fd, _update_tag) == 0;
+	}
+
 	bool updated;
 	orb_check(_fd, &updated);
 
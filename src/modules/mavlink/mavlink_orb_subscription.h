@@ -43,6 +43,7 @@
 
 #include <systemlib/uthash/utlist.h>
 #include <drivers/drv_hrt.h>
+#include <uORB/uORB.h>
 
 
 class MavlinkOrbSubscription
@@ -90,12 +91,31 @@ public:
 	orb_id_t get_topic() const;
 	int get_instance() const;
 
+	/**
+	 * Signal the updates of the topic through an update queue, see orb_update_queue_attach().
+	 * If the topic is not subscribed yet, the subscription is attached once the topic is published.
+	 */
+	void set_update_queue(orb_update_queue_t queue, unsigned tag);
+
+	/**
+	 * @return true if the updates are signalled through an update queue
+	 */
+	bool is_update_queue_attached() const { return _update_queue_attached; }
+
+	/**
+	 * @return time of the last publication of the topic, 0 if unknown
+	 */
+	hrt_abstime get_last_update();
+
 private:
 	const orb_id_t _topic;		///< topic metadata
 	const int _instance;		///< get topic instance
 	int _fd;			///< subscription handle
 	bool _published;		///< topic was ever published
 	hrt_abstime _last_pub_check;	///< when we checked last
+	orb_update_queue_t _update_queue;	///< update queue to attach to, nullptr if none
+	unsigned _update_tag;		///< tag in _update_queue
+	bool _update_queue_attached;	///< subscription is attached to _update_queue
 
 	/* do not allow copying this class */
 	MavlinkOrbSubscription(const MavlinkOrbSubscription &);
@@ -41,6 +41,8 @@
 
 #include <stdio.h>
 
+#include <px4_defines.h>
+
 #include <uORB/topics/uavcan_parameter_request.h>
 #include <uORB/topics/uavcan_parameter_value.h>
 
@@ -51,6 +53,11 @@
 
 MavlinkParametersManager::MavlinkParametersManager(Mavlink *mavlink) : MavlinkStream(mavlink),
 	_send_all_index(-1),
+	_send_all_used_index(0),
+	_send_all_used_count(0),
+	_send_all_start(0),
+	_send_all_last(0),
+	_send_all_bytes(0),
 	_rc_param_map_pub(nullptr),
 	_rc_param_map(),
 	_uavcan_parameter_request_pub(nullptr),
@@ -96,7 +103,7 @@ MavlinkParametersManager::handle_message(const mavlink_message_t *msg)
 
 				} else {
 					/* a restart should skip the hash check on the ground */
-					_send_all_index = 0;
+					begin_send_all(hrt_absolute_time());
 				}
 			}
 
@@ -133,9 +140,16 @@ MavlinkParametersManager::handle_message(const mavlink_message_t *msg)
 				/* enforce null termination */
 				name[MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN] = '\0';
 
-				/* Whatever the value is, we're being told to stop sending */
+				/* The ground station has the parameters cached, stop sending */
 				if (strncmp(name, "_HASH_CHECK", sizeof(name)) == 0) {
-					_send_all_index = -1;
+					uint32_t hash;
+					memcpy(&hash, &set.param_value, sizeof(hash));
+
+					/* an outdated cache continues the transfer */
+					if (_send_all_index >= 0 && hash == param_hash_check()) {
+						end_send_all(hrt_absolute_time(), true);
+					}
+
 					/* No other action taken, return */
 					return;
 				}
@@ -366,12 +380,71 @@ MavlinkParametersManager::send(const hrt_abstime t)
 			mavlink_msg_param_value_send_struct(_mavlink->get_channel(), &msg);
 
 			/* after this we should start sending all params */
-			_send_all_index = 0;
+			begin_send_all(t);
+			_send_all_bytes = get_size();
 
 			/* No further action, return now */
 			return;
 		}
 
+		send_all_params(t);
+
+	} else if (_send_all_index == PARAM_HASH && hrt_absolute_time() > 20 * 1000 * 1000) {
+		/* the boot did not seem to ever complete, warn user and set boot complete */
+		_mavlink->send_statustext_critical("WARNING: SYSTEM BOOT INCOMPLETE. CHECK CONFIG.");
+		_mavlink->set_boot_complete();
+	}
+}
+
+void
+MavlinkParametersManager::begin_send_all(hrt_abstime t)
+{
+	_send_all_index = 0;
+	_send_all_used_index = 0;
+	_send_all_used_count = param_count_used();
+	_send_all_start = t;
+	_send_all_last = t;
+	_send_all_bytes = 0;
+}
+
+void
+MavlinkParametersManager::end_send_all(hrt_abstime t, bool cached)
+{
+	if (_send_all_start != 0) {
+		PX4_DEBUG("param sync %s: %d params, %u bytes in %.3f s", cached ? "from GCS cache" : "done",
+			 _send_all_used_index, _send_all_bytes, (double)(t - _send_all_start) / 1e6);
+	}
+
+	_send_all_index = -1;
+	_send_all_start = 0;
+}
+
+void
+MavlinkParametersManager::send_all_params(hrt_abstime t)
+{
+	/*
+	 * Fill the TX buffer, but stay within the data rate of the link. At least one
+	 * parameter is sent per update, as before.
+	 */
+	unsigned budget = _mavlink->get_free_tx_buf();
+	uint64_t rate_budget = (t - _send_all_last) * (uint64_t)_mavlink->get_data_rate() / 1000000;
+
+	if (rate_budget < budget) {
+		budget = rate_budget > get_size() ? rate_budget : get_size();
+	}
+
+	_send_all_last = t;
+
+	/*
+	 * The used index of a parameter is counted locally. If a parameter became used
+	 * since the transfer started, the indices of the following ones shifted: start
+	 * over with the new count, so that the GCS gets a consistent list.
+	 */
+	if (param_count_used() != (unsigned)_send_all_used_count) {
+		restart_send_all();
+	}
+
+	while (budget >= get_size() && _send_all_index >= 0) {
 		/* look for the first parameter which is used */
 		param_t p;
 
@@ -381,23 +454,41 @@ MavlinkParametersManager::send(const hrt_abstime t)
 			_send_all_index++;
 		} while (p != PARAM_INVALID && !param_used(p));
 
+		if (p != PARAM_INVALID && _send_all_used_index >= _send_all_used_count) {
+			/* more used parameters than at the start */
+			restart_send_all();
+			continue;
+		}
+
 		if (p != PARAM_INVALID) {
-			send_param(p);
+			/* the used index and count are known, avoid looking them up for every parameter */
+			send_param(p, _send_all_used_index, _send_all_used_count);
+			_send_all_used_index++;
+			_send_all_bytes += get_size();
+			budget -= get_size();
 		}
 
 		if ((p == PARAM_INVALID) || (_send_all_index >= (int) param_count())) {
-			_send_all_index = -1;
-		}
+			if (param_count_used() != (unsigned)_send_all_used_count) {
+				restart_send_all();
 
-	} else if (_send_all_index == PARAM_HASH && hrt_absolute_time() > 20 * 1000 * 1000) {
-		/* the boot did not seem to ever complete, warn user and set boot complete */
-		_mavlink->send_statustext_critical("WARNING: SYSTEM BOOT INCOMPLETE. CHECK CONFIG.");
-		_mavlink->set_boot_complete();
+			} else {
+				end_send_all(t, false);
+			}
+		}
 	}
 }
 
+void
+MavlinkParametersManager::restart_send_all()
+{
+	_send_all_index = 0;
+	_send_all_used_index = 0;
+	_send_all_used_count = param_count_used();
+}
+
 int
-MavlinkParametersManager::send_param(param_t param)
+MavlinkParametersManager::send_param(param_t param, int used_index, int used_count)
 {
 	if (param == PARAM_INVALID) {
 		return 1;
@@ -413,8 +504,8 @@ MavlinkParametersManager::send_param(param_t param)
 		return 2;
 	}
 
-	msg.param_count = param_count_used();
-	msg.param_index = param_get_used_index(param);
+	msg.param_count = used_count >= 0 ? used_count : param_count_used();
+	msg.param_index = used_index >= 0 ? used_index : param_get_used_index(param);
 
 	/* copy parameter name */
 	strncpy(msg.param_id, param_name(param), MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN);
@@ -79,6 +79,33 @@ public:
 
 private:
 	int		_send_all_index;
+	int		_send_all_used_index;	///< used index of the next parameter to send in the list transfer
+	int		_send_all_used_count;	///< number of used parameters at the start of the list transfer
+	hrt_abstime	_send_all_start;	///< start of the list transfer, 0 if none
+	hrt_abstime	_send_all_last;		///< last time parameters of the list were sent
+	unsigned	_send_all_bytes;
+
+	/**
+	 * Start sending the list of all used parameters from the beginning
+	 */
+	void		begin_send_all(hrt_abstime t);
+
+	/**
+	 * Finish the list transfer and report the time it took
+	 *
+	 * @param cached	true if the ground station had the parameters cached already
+	 */
+	void		end_send_all(hrt_abstime t, bool cached);
+
+	/**
+	 * Start the list transfer over, with the current number of used parameters
+	 */
+	void		restart_send_all();
+
+	/**
+	 * Send as many parameters of the list as the link allows
+	 */
+	void		send_all_params(hrt_abstime t);
 
 	/* do not allow top copying this class */
 	MavlinkParametersManager(MavlinkParametersManager &);
@@ -90,7 +117,14 @@ protected:
 
 	void send(const hrt_abstime t);
 
-	int send_param(param_t param);
+	/**
+	 * Send a parameter value
+	 *
+	 * @param used_index	index of the parameter among the used ones, looked up if negative
+	 * @param used_count	number of used parameters, looked up if negative
+	 * @return 0 on success, 1 if the parameter is invalid, 2 if its value could not be read
+	 */
+	int send_param(param_t param, int used_index = -1, int used_count = -1);
 
 	orb_advert_t _rc_param_map_pub;
 	struct rc_parameter_map_s _rc_param_map;
@@ -38,6 +38,7 @@
  * @author Anton Babushkin <anton.babushkin@me.com>
  */
 
+#include <stdio.h>
 #include <stdlib.h>
 
 #include "mavlink_stream.h"
@@ -47,12 +48,26 @@ MavlinkStream::MavlinkStream(Mavlink *mavlink) :
 	next(nullptr),
 	_mavlink(mavlink),
 	_interval(1000000),
-	_last_sent(0)
+	_last_sent(0),
+	_on_update(false),
+	_updated(false),
+	_latency_perf(nullptr),
+	_latency_perf_name{},
+	_stats_start(0),
+	_stats_updates(0),
+	_stats_latency_sum(0),
+	_stats_latency_max(0),
+	_achieved_rate(0.0f),
+	_latency_avg(0),
+	_latency_max(0)
 {
 }
 
 MavlinkStream::~MavlinkStream()
 {
+	if (_latency_perf != nullptr) {
+		perf_free(_latency_perf);
+	}
 }
 
 /**
@@ -64,6 +79,58 @@ MavlinkStream::set_interval(const unsigned int interval)
 	_interval = interval;
 }
 
+unsigned
+MavlinkStream::get_effective_interval()
+{
+	unsigned int interval = _interval;
+
+	if (!const_rate()) {
+		interval /= _mavlink->get_rate_mult();
+	}
+
+	return interval;
+}
+
+bool
+MavlinkStream::set_on_update(bool on_update)
+{
+	if (on_update && get_update_subscription() == nullptr) {
+		return false;
+	}
+
+	_on_update = on_update;
+
+	if (_on_update && _latency_perf == nullptr) {
+		snprintf(_latency_perf_name, sizeof(_latency_perf_name), "mavlink: %s pub-send", get_name());
+		_latency_perf = perf_alloc(PC_ELAPSED, _latency_perf_name);
+	}
+
+	return true;
+}
+
+bool
+MavlinkStream::waits_for_update()
+{
+	if (!_on_update) {
+		return false;
+	}
+
+	/* until the subscription is attached to the update queue, poll it */
+	MavlinkOrbSubscription *sub = get_update_subscription();
+	return sub != nullptr && sub->is_update_queue_attached();
+}
+
+hrt_abstime
+MavlinkStream::get_next_update()
+{
+	if (!_updated && waits_for_update()) {
+		/* not due until notified */
+		return UINT64_MAX;
+	}
+
+	return _last_sent + get_effective_interval();
+}
+
 /**
  * Update subscriptions and send message if necessary
  */
@@ -71,18 +138,33 @@ int
 MavlinkStream::update(const hrt_abstime t)
 {
 	uint64_t dt = t - _last_sent;
-	unsigned int interval = _interval;
+	unsigned int interval = get_effective_interval();
 
-	if (!const_rate()) {
-		interval /= _mavlink->get_rate_mult();
+	const bool on_update = waits_for_update();
+
+	if (on_update && !_updated) {
+		return -1;
 	}
 
 	if (dt > 0 && dt >= interval) {
 		/* interval expired, send message */
+		hrt_abstime published = 0;
+
+		if (on_update) {
+			_updated = false;
+			published = get_update_subscription()->get_last_update();
+		}
+
 #ifndef __PX4_QURT
 		send(t);
 #endif
 
+		if (published != 0 && _latency_perf != nullptr) {
+			perf_set_elapsed(_latency_perf, hrt_absolute_time() - published);
+		}
+
+		update_stats(t, dt, interval);
+
 		if (const_rate()) {
 			_last_sent = (t / _interval) * _interval;
 
@@ -95,3 +177,42 @@ MavlinkStream::update(const hrt_abstime t)
 
 	return -1;
 }
+
+void
+MavlinkStream::update_stats(const hrt_abstime t, const uint64_t dt, const unsigned interval)
+{
+	if (_last_sent != 0) {
+		/* the update was due when the interval expired */
+		uint64_t latency = dt - interval;
+		_stats_latency_sum += latency;
+
+		if (latency > _stats_latency_max) {
+			_stats_latency_max = latency;
+		}
+	}
+
+	if (_stats_start == 0) {
+		_stats_start = t;
+		return;
+	}
+
+	_stats_updates++;
+
+	/* measure over a few updates for low rate streams */
+	hrt_abstime stats_interval = 2 * (hrt_abstime)interval;
+
+	if (stats_interval < STATS_INTERVAL) {
+		stats_interval = STATS_INTERVAL;
+	}
+
+	if (t - _stats_start >= stats_interval) {
+		_achieved_rate = _stats_updates * 1e6f / (t - _stats_start);
+		_latency_avg = _stats_latency_sum / _stats_updates;
+		_latency_max = _stats_latency_max;
+
+		_stats_start = t;
+		_stats_updates = 0;
+		_stats_latency_sum = 0;
+		_stats_latency_max = 0;
+	}
+}
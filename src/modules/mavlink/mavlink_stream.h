@@ -42,9 +42,11 @@
 #define MAVLINK_STREAM_H_
 
 #include <drivers/drv_hrt.h>
+#include <systemlib/perf_counter.h>
 
 class Mavlink;
 class MavlinkStream;
+class MavlinkOrbSubscription;
 
 class MavlinkStream
 {
@@ -73,6 +75,46 @@ public:
 	 * @return 0 if updated / sent, -1 if unchanged
 	 */
 	int update(const hrt_abstime t);
+
+	/**
+	 * Get the time of the next update, depending on the interval and the rate multiplier
+	 */
+	hrt_abstime get_next_update();
+
+	/**
+	 * Send on publications of the topic from get_update_subscription() instead of polling
+	 * at the interval. The interval is then the minimum interval between two messages.
+	 * The end-to-end latency from the publication to the sent message is measured with
+	 * a perf counter.
+	 * @return false if the stream does not support it
+	 */
+	bool set_on_update(bool on_update);
+
+	bool get_on_update() const { return _on_update; }
+
+	/**
+	 * Called when the topic from get_update_subscription() was published
+	 */
+	void notify_update() { _updated = true; }
+
+	/**
+	 * Get the subscription that triggers the stream in on-update mode
+	 *
+	 * @return nullptr if the stream does not support on-update mode
+	 */
+	virtual MavlinkOrbSubscription *get_update_subscription() { return nullptr; }
+
+	/**
+	 * Get the achieved update rate in Hz, measured over the last STATS_INTERVAL (or longer)
+	 */
+	float get_achieved_rate() const { return _achieved_rate; }
+
+	/**
+	 * Get the average and maximum latency of the updates in microseconds (us),
+	 * i.e. how late the updates were compared to when they were due
+	 */
+	uint32_t get_latency_avg() const { return _latency_avg; }
+	uint32_t get_latency_max() const { return _latency_max; }
 	virtual const char *get_name() const = 0;
 	virtual uint8_t get_id() = 0;
 
@@ -107,6 +149,33 @@ protected:
 private:
 	hrt_abstime _last_sent;
 
+	bool _on_update;			///< send on publications instead of polling
+	bool _updated;				///< on-update mode: the topic was published since the last message
+	perf_counter_t _latency_perf;		///< on-update mode: latency from the publication to the sent message
+	char _latency_perf_name[32];
+
+	static const hrt_abstime STATS_INTERVAL = 1000000; ///< minimum interval for the update statistics
+
+	hrt_abstime _stats_start;
+	unsigned _stats_updates;
+	uint64_t _stats_latency_sum;
+	uint32_t _stats_latency_max;
+	float _achieved_rate;
+	uint32_t _latency_avg;
+	uint32_t _latency_max;
+
+	/**
+	 * Get the interval adjusted with the rate multiplier
+	 */
+	unsigned get_effective_interval();
+
+	void update_stats(const hrt_abstime t, const uint64_t dt, const unsigned interval);
+
+	/**
+	 * @return true if the stream is in on-update mode and is notified about publications
+	 */
+	bool waits_for_update();
+
 	/* do not allow top copying this class */
 	MavlinkStream(const MavlinkStream &);
 	MavlinkStream &operator=(const MavlinkStream &);
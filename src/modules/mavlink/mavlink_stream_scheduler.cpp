@@ -0,0 +1,168 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file mavlink_stream_scheduler.cpp
+ * Deadline scheduler for the streams of a mavlink instance.
+ */
+
+#include <string.h>
+
+#include "mavlink_stream_scheduler.h"
+#include "mavlink_stream.h"
+
+MavlinkStreamScheduler::MavlinkStreamScheduler() :
+	_heap(nullptr),
+	_size(0),
+	_capacity(0)
+{
+}
+
+MavlinkStreamScheduler::~MavlinkStreamScheduler()
+{
+	delete[] _heap;
+}
+
+bool
+MavlinkStreamScheduler::add(MavlinkStream *stream)
+{
+	if (_size == _capacity) {
+		unsigned capacity = _capacity > 0 ? _capacity * 2 : 32;
+		Entry *heap = new Entry[capacity];
+
+		if (heap == nullptr) {
+			return false;
+		}
+
+		if (_heap != nullptr) {
+			memcpy(heap, _heap, _size * sizeof(Entry));
+			delete[] _heap;
+		}
+
+		_heap = heap;
+		_capacity = capacity;
+	}
+
+	_heap[_size].due = 0;
+	_heap[_size].stream = stream;
+	sift_up(_size++);
+	return true;
+}
+
+void
+MavlinkStreamScheduler::remove(MavlinkStream *stream)
+{
+	for (unsigned i = 0; i < _size; i++) {
+		if (_heap[i].stream == stream) {
+			_heap[i] = _heap[--_size];
+
+			if (i < _size) {
+				sift_down(i);
+				sift_up(i);
+			}
+
+			return;
+		}
+	}
+}
+
+void
+MavlinkStreamScheduler::reschedule()
+{
+	for (unsigned i = 0; i < _size; i++) {
+		_heap[i].due = _heap[i].stream->get_next_update();
+	}
+
+	/* heapify */
+	for (unsigned i = _size / 2; i > 0; i--) {
+		sift_down(i - 1);
+	}
+}
+
+void
+MavlinkStreamScheduler::update(const hrt_abstime t)
+{
+	while (_size > 0 && _heap[0].due <= t) {
+		MavlinkStream *stream = _heap[0].stream;
+		stream->update(t);
+
+		/* update() always moves the next update into the future */
+		hrt_abstime due = stream->get_next_update();
+		_heap[0].due = due > t ? due : t + 1;
+		sift_down(0);
+	}
+}
+
+void
+MavlinkStreamScheduler::sift_up(unsigned index)
+{
+	while (index > 0) {
+		unsigned parent = (index - 1) / 2;
+
+		if (_heap[parent].due <= _heap[index].due) {
+			break;
+		}
+
+		Entry tmp = _heap[parent];
+		_heap[parent] = _heap[index];
+		_heap[index] = tmp;
+		index = parent;
+	}
+}
+
+void
+MavlinkStreamScheduler::sift_down(unsigned index)
+{
+	while (true) {
+		unsigned smallest = index;
+		unsigned left = 2 * index + 1;
+		unsigned right = left + 1;
+
+		if (left < _size && _heap[left].due < _heap[smallest].due) {
+			smallest = left;
+		}
+
+		if (right < _size && _heap[right].due < _heap[smallest].due) {
+			smallest = right;
+		}
+
+		if (smallest == index) {
+			break;
+		}
+
+		Entry tmp = _heap[smallest];
+		_heap[smallest] = _heap[index];
+		_heap[index] = tmp;
+		index = smallest;
+	}
+}
@@ -0,0 +1,103 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file mavlink_stream_scheduler.h
+ * Deadline scheduler for the streams of a mavlink instance.
+ */
+
+#ifndef MAVLINK_STREAM_SCHEDULER_H_
+#define MAVLINK_STREAM_SCHEDULER_H_
+
+#include <drivers/drv_hrt.h>
+
+class MavlinkStream;
+
+/**
+ * Keeps the streams of a mavlink instance in a min-heap ordered by the time when they
+ * are due next, so that the main loop can sleep until the earliest stream is due and
+ * only update the streams that are due.
+ */
+class MavlinkStreamScheduler
+{
+public:
+	MavlinkStreamScheduler();
+	~MavlinkStreamScheduler();
+
+	/**
+	 * Add a stream. It is due immediately.
+	 * @return false if out of memory
+	 */
+	bool add(MavlinkStream *stream);
+
+	/**
+	 * Remove a stream, before it is deleted
+	 */
+	void remove(MavlinkStream *stream);
+
+	/**
+	 * Recompute the due times of all streams. Must be called after changing
+	 * the interval of a stream or the rate multiplier.
+	 */
+	void reschedule();
+
+	/**
+	 * Update all streams that are due
+	 */
+	void update(const hrt_abstime t);
+
+	/**
+	 * @return time when the next stream is due, 0 if there are no streams
+	 */
+	hrt_abstime next_due() const { return _size > 0 ? _heap[0].due : 0; }
+
+private:
+	struct Entry {
+		hrt_abstime due;
+		MavlinkStream *stream;
+	};
+
+	Entry *_heap;
+	unsigned _size;
+	unsigned _capacity;
+
+	void sift_up(unsigned index);
+	void sift_down(unsigned index);
+
+	/* do not allow top copying this class */
+	MavlinkStreamScheduler(const MavlinkStreamScheduler &);
+	MavlinkStreamScheduler &operator=(const MavlinkStreamScheduler &);
+};
+
+
+#endif /* MAVLINK_STREAM_SCHEDULER_H_ */
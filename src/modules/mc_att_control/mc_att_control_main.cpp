@@ -333,7 +333,7 @@ MulticopterAttitudeControl::MulticopterAttitudeControl() :
 	_actuators_0_circuit_breaker_enabled(false),
 
 	/* performance counters */
-	_loop_perf(perf_alloc(PC_ELAPSED, "mc_att_control")),
+	_loop_perf(perf_alloc(PC_HISTOGRAM, "mc_att_control")),
 	_controller_latency_perf(perf_alloc_once(PC_ELAPSED, "ctrl_latency")),
 	_ts_opt_recovery(nullptr)
 
@@ -844,10 +844,19 @@ MulticopterAttitudeControl::task_main()
 	fds[0].fd = _ctrl_state_sub;
 	fds[0].events = POLLIN;
 
+	/* the subscriptions stay the same, so register them for polling only once */
+	px4_pollset_t poll_set;
+
+	if (px4_pollset_init(&poll_set, &fds[0], (sizeof(fds) / sizeof(fds[0]))) != 0) {
+		warn("mc att ctrl: poll set init failed");
+		_control_task = -1;
+		return;
+	}
+
 	while (!_task_should_exit) {
 
 		/* wait for up to 100ms for data */
-		int pret = px4_poll(&fds[0], (sizeof(fds) / sizeof(fds[0])), 100);
+		int pret = px4_pollset_wait(&poll_set, 100);
 
 		/* timed out - periodic check for _task_should_exit */
 		if (pret == 0) {
@@ -1009,6 +1018,8 @@ MulticopterAttitudeControl::task_main()
 		perf_end(_loop_perf);
 	}
 
+	px4_pollset_deinit(&poll_set);
+
 	_control_task = -1;
 	return;
 }
@@ -41,6 +41,7 @@
 
 #include <uORB/topics/home_position.h>
 #include <uORB/topics/vehicle_global_position.h>
+#include <stddef.h>
 #include <string.h>
 #include <dataman/dataman.h>
 #include <systemlib/err.h>
@@ -51,6 +52,7 @@
 #include <px4_config.h>
 #include <unistd.h>
 #include <geo/geo.h>
+#include <mathlib/mathlib.h>
 #include <drivers/drv_hrt.h>
 #include "navigator.h"
 
@@ -74,6 +76,13 @@ Geofence::Geofence(Navigator *navigator) :
 	_altitude_min(0),
 	_altitude_max(0),
 	_vertices_count(0),
+	_edges{},
+	_polygons{},
+	_polygons_count(0),
+	_has_inclusion(false),
+	_fence_loaded(false),
+	_fence_valid(false),
+	_fence_sub(-1),
 	_param_action(this, "ACTION"),
 	_param_altitude_mode(this, "ALTMODE"),
 	_param_source(this, "SOURCE"),
@@ -88,7 +97,9 @@ Geofence::Geofence(Navigator *navigator) :
 
 Geofence::~Geofence()
 {
-
+	if (_fence_sub >= 0) {
+		orb_unsubscribe(_fence_sub);
+	}
 }
 
 
@@ -190,6 +201,8 @@ bool Geofence::inside(double lat, double lon, float altitude)
 
 bool Geofence::inside_polygon(double lat, double lon, float altitude)
 {
+	bool cache_valid = update_fence_cache();
+
 	if (valid()) {
 
 		if (!isEmpty()) {
@@ -198,36 +211,28 @@ bool Geofence::inside_polygon(double lat, double lon, float altitude)
 				return false;
 			}
 
-			/*Horizontal check */
-			/* Adaptation of algorithm originally presented as
-			 * PNPOLY - Point Inclusion in Polygon Test
-			 * W. Randolph Franklin (WRF) */
-
-			bool c = false;
+			if (!cache_valid) {
+				/* Unreadable or malformed fence --> report a violation */
+				return false;
+			}
 
-			struct fence_vertex_s temp_vertex_i;
-			struct fence_vertex_s temp_vertex_j;
+			/*Horizontal check */
+			bool inside_inclusion = !_has_inclusion;
 
-			/* Red until fence is finished */
-			for (unsigned i = 0, j = _vertices_count - 1; i < _vertices_count; j = i++) {
-				if (dm_read(DM_KEY_FENCE_POINTS, i, &temp_vertex_i, sizeof(struct fence_vertex_s)) != sizeof(struct fence_vertex_s)) {
-					break;
-				}
+			for (unsigned i = 0; i < _polygons_count; i++) {
+				const fence_polygon_s &polygon = _polygons[i];
 
-				if (dm_read(DM_KEY_FENCE_POINTS, j, &temp_vertex_j, sizeof(struct fence_vertex_s)) != sizeof(struct fence_vertex_s)) {
-					break;
-				}
+				if (polygon.exclusion) {
+					if (polygon_contains(polygon, lat, lon)) {
+						return false;
+					}
 
-				// skip vertex 0 (return point)
-				if (((double)temp_vertex_i.lon >= lon) != ((double)temp_vertex_j.lon >= lon) &&
-				    (lat <= (double)(temp_vertex_j.lat - temp_vertex_i.lat) * (lon - (double)temp_vertex_i.lon) /
-				     (double)(temp_vertex_j.lon - temp_vertex_i.lon) + (double)temp_vertex_i.lat)) {
-					c = !c;
+				} else if (!inside_inclusion) {
+					inside_inclusion = polygon_contains(polygon, lat, lon);
 				}
-
 			}
 
-			return c;
+			return inside_inclusion;
 
 		} else {
 			/* Empty fence --> accept all points */
@@ -240,6 +245,160 @@ bool Geofence::inside_polygon(double lat, double lon, float altitude)
 	}
 }
 
+bool
+Geofence::polygon_contains(const fence_polygon_s &polygon, double lat, double lon) const
+{
+	if (lat < polygon.lat_min || lat > polygon.lat_max ||
+	    lon < polygon.lon_min || lon > polygon.lon_max) {
+		return false;
+	}
+
+	/* Adaptation of algorithm originally presented as
+	 * PNPOLY - Point Inclusion in Polygon Test
+	 * W. Randolph Franklin (WRF) */
+
+	bool c = false;
+	const fence_edge_s *edge = &_edges[polygon.first_edge];
+
+	for (unsigned i = 0; i < polygon.num_edges; i++, edge++) {
+		bool crosses = (edge->lon_i >= lon) != (edge->lon_j >= lon);
+		bool below = lat <= edge->slope * (lon - edge->lon_i) + edge->lat_i;
+		c ^= crosses & below;
+	}
+
+	return c;
+}
+
+bool
+Geofence::update_fence_cache()
+{
+	if (_fence_sub < 0) {
+		_fence_sub = orb_subscribe(ORB_ID(fence));
+	}
+
+	bool updated = false;
+	orb_check(_fence_sub, &updated);
+
+	if (updated) {
+		struct fence_s fence;
+		orb_copy(ORB_ID(fence), _fence_sub, &fence);
+		_vertices_count = fence.count;
+		_fence_loaded = false;
+	}
+
+	if (_fence_loaded) {
+		return _fence_valid;
+	}
+
+	_polygons_count = 0;
+	_has_inclusion = false;
+
+	if (_vertices_count > fence_s::GEOFENCE_MAX_VERTICES) {
+		return false;
+	}
+
+	struct fence_vertex_s vertices[fence_s::GEOFENCE_MAX_VERTICES];
+
+	if (!read_vertices(vertices)) {
+		/* try again on the next check */
+		return false;
+	}
+
+	/* from here on the result is kept until the fence changes */
+	_fence_loaded = true;
+	_fence_valid = false;
+
+	/* consecutive vertices with the same polygon index form one polygon */
+	unsigned first = 0;
+
+	for (unsigned end = 1; end <= _vertices_count; end++) {
+		if (end < _vertices_count && vertices[end].polygon == vertices[first].polygon) {
+			continue;
+		}
+
+		if (end - first < 3) {
+			mavlink_and_console_log_critical(_navigator->get_mavlink_log_pub(),
+							 "Geofence polygon %d has less than 3 vertices, fence rejected", vertices[first].polygon);
+			_polygons_count = 0;
+			_has_inclusion = false;
+			return false;
+
+		} else if (_polygons_count < sizeof(_polygons) / sizeof(_polygons[0])) {
+			fence_polygon_s &polygon = _polygons[_polygons_count++];
+			polygon.first_edge = first;
+			polygon.num_edges = end - first;
+			polygon.exclusion = (vertices[first].type == fence_vertex_s::POLYGON_EXCLUSION);
+			polygon.lat_min = polygon.lat_max = (double)vertices[first].lat;
+			polygon.lon_min = polygon.lon_max = (double)vertices[first].lon;
+
+			for (unsigned i = first, j = end - 1; i < end; j = i++) {
+				fence_edge_s &edge = _edges[i];
+				edge.lat_i = (double)vertices[i].lat;
+				edge.lon_i = (double)vertices[i].lon;
+				edge.lon_j = (double)vertices[j].lon;
+
+				/* an edge parallel to the latitude axis is never crossed, the slope is unused */
+				double dlon = edge.lon_j - edge.lon_i;
+				edge.slope = (dlon != 0.0) ? ((double)vertices[j].lat - edge.lat_i) / dlon : 0.0;
+
+				polygon.lat_min = math::min(polygon.lat_min, edge.lat_i);
+				polygon.lat_max = math::max(polygon.lat_max, edge.lat_i);
+				polygon.lon_min = math::min(polygon.lon_min, edge.lon_i);
+				polygon.lon_max = math::max(polygon.lon_max, edge.lon_i);
+			}
+
+			_has_inclusion |= !polygon.exclusion;
+		}
+
+		first = end;
+	}
+
+	_fence_valid = true;
+	return true;
+}
+
+bool
+Geofence::read_vertices(struct fence_vertex_s *vertices)
+{
+	if (_vertices_count == 0) {
+		return true;
+	}
+
+	ssize_t count = dm_read_range(DM_KEY_FENCE_POINTS, 0, _vertices_count, vertices, sizeof(struct fence_vertex_s));
+
+	if (count == (ssize_t)_vertices_count) {
+		return true;
+	}
+
+	/*
+	 * The range read stops at the first vertex with a different size. Vertices
+	 * stored by older firmware have no polygon fields, which are at the end of
+	 * the struct: read them one by one into zeroed vertices, which puts them in
+	 * a single inclusion polygon, as they were used before.
+	 */
+	const ssize_t old_size = offsetof(struct fence_vertex_s, polygon);
+	unsigned old_vertices = 0;
+
+	for (unsigned i = (count > 0) ? count : 0; i < _vertices_count; i++) {
+		memset(&vertices[i], 0, sizeof(vertices[i]));
+		ssize_t len = dm_read(DM_KEY_FENCE_POINTS, i, &vertices[i], sizeof(vertices[i]));
+
+		if (len == old_size) {
+			old_vertices++;
+
+		} else if (len != sizeof(vertices[i])) {
+			return false;
+		}
+	}
+
+	if (old_vertices > 0) {
+		mavlink_log_info(_navigator->get_mavlink_log_pub(),
+				 "Geofence: %u vertices in old format, loaded as one inclusion polygon", old_vertices);
+	}
+
+	return true;
+}
+
 bool
 Geofence::valid()
 {
@@ -266,7 +425,7 @@ Geofence::addPoint(int argc, char *argv[])
 	char *end;
 
 	if ((argc == 1) && (strcmp("-clear", argv[0]) == 0)) {
-		dm_clear(DM_KEY_FENCE_POINTS);
+		clearDm();
 		publishFence(0);
 		return;
 	}
@@ -290,10 +449,13 @@ Geofence::addPoint(int argc, char *argv[])
 		last = 1;
 	}
 
+	memset(&vertex, 0, sizeof(vertex));
 	vertex.lat = (float)lat;
 	vertex.lon = (float)lon;
 
 	if (dm_write(DM_KEY_FENCE_POINTS, ix, DM_PERSIST_POWER_ON_RESET, &vertex, sizeof(vertex)) == sizeof(vertex)) {
+		_fence_loaded = false;
+
 		if (last) {
 			publishFence((unsigned)ix + 1);
 		}
@@ -307,11 +469,14 @@ Geofence::addPoint(int argc, char *argv[])
 void
 Geofence::publishFence(unsigned vertices)
 {
+	struct fence_s fence = {};
+	fence.count = vertices;
+
 	if (_fence_pub == nullptr) {
-		_fence_pub = orb_advertise(ORB_ID(fence), &vertices);
+		_fence_pub = orb_advertise(ORB_ID(fence), &fence);
 
 	} else {
-		orb_publish(ORB_ID(fence), _fence_pub, &vertices);
+		orb_publish(ORB_ID(fence), _fence_pub, &fence);
 	}
 }
 
@@ -322,6 +487,9 @@ Geofence::loadFromFile(const char *filename)
 	char		line[120];
 	int			pointCounter = 0;
 	bool		gotVertical = false;
+	uint8_t		polygon = 0;
+	uint8_t		polygonType = fence_vertex_s::POLYGON_INCLUSION;
+	bool		polygonHasVertices = false;
 	const char commentChar = '#';
 	int rc = ERROR;
 
@@ -357,9 +525,21 @@ Geofence::loadFromFile(const char *filename)
 			continue;
 		}
 
-		if (gotVertical) {
+		if (gotVertical && (strncmp(&line[textStart], "INCLUDE", 7) == 0 || strncmp(&line[textStart], "EXCLUDE", 7) == 0)) {
+			/* start a new polygon, the first one is an inclusion polygon unless stated otherwise */
+			if (polygonHasVertices) {
+				polygon++;
+				polygonHasVertices = false;
+			}
+
+			polygonType = (line[textStart] == 'E') ? fence_vertex_s::POLYGON_EXCLUSION : fence_vertex_s::POLYGON_INCLUSION;
+
+		} else if (gotVertical) {
 			/* Parse the line as a geofence point */
 			struct fence_vertex_s vertex;
+			memset(&vertex, 0, sizeof(vertex));
+			vertex.polygon = polygon;
+			vertex.type = polygonType;
 
 			/* if the line starts with DMS, this means that the coordinate is given as degree minute second instead of decimal degrees */
 			if (line[textStart] == 'D' && line[textStart + 1] == 'M' && line[textStart + 2] == 'S') {
@@ -388,9 +568,11 @@ Geofence::loadFromFile(const char *filename)
 				goto error;
 			}
 
-			warnx("Geofence: point: %d, lat %.5f: lon: %.5f", pointCounter, (double)vertex.lat, (double)vertex.lon);
+			warnx("Geofence: point: %d, polygon %d, lat %.5f: lon: %.5f", pointCounter, polygon, (double)vertex.lat,
+			      (double)vertex.lon);
 
 			pointCounter++;
+			polygonHasVertices = true;
 
 		} else {
 			/* Parse the line as the vertical limits */
@@ -406,6 +588,7 @@ Geofence::loadFromFile(const char *filename)
 	/* Check if import was successful */
 	if (gotVertical && pointCounter > 0) {
 		_vertices_count = pointCounter;
+		_fence_loaded = false;
 		warnx("Geofence: imported successfully");
 		mavlink_log_info(_navigator->get_mavlink_log_pub(), "Geofence imported");
 		rc = OK;
@@ -423,5 +606,6 @@ error:
 int Geofence::clearDm()
 {
 	dm_clear(DM_KEY_FENCE_POINTS);
+	_fence_loaded = false;
 	return OK;
 }
@@ -42,6 +42,7 @@
 #define GEOFENCE_H_
 
 #include <uORB/topics/fence.h>
+#include <uORB/topics/fence_vertex.h>
 #include <uORB/topics/vehicle_global_position.h>
 #include <uORB/topics/vehicle_gps_position.h>
 #include <uORB/topics/sensor_combined.h>
@@ -88,6 +89,12 @@ public:
 		    const struct vehicle_gps_position_s &gps_position, float baro_altitude_amsl,
 		    const struct home_position_s home_pos, bool home_position_set);
 
+	/**
+	 * Check a position against the vertical limits and all fence polygons.
+	 *
+	 * The position is inside if it lies within at least one inclusion polygon
+	 * (or there are none) and outside of every exclusion polygon.
+	 */
 	bool inside_polygon(double lat, double lon, float altitude);
 
 	int clearDm();
@@ -127,6 +134,53 @@ private:
 
 	unsigned _vertices_count;
 
+	/**
+	 * Fence edge for the PNPOLY test. The slope is precomputed so that the
+	 * crossing test for an edge is a single multiply-add.
+	 */
+	struct fence_edge_s {
+		double lat_i;
+		double lon_i;
+		double lon_j;
+		double slope;		/**< dlat / dlon, 0 for edges parallel to the latitude axis */
+	};
+
+	struct fence_polygon_s {
+		unsigned first_edge;
+		unsigned num_edges;
+		bool exclusion;
+		double lat_min;		/**< bounding box */
+		double lat_max;
+		double lon_min;
+		double lon_max;
+	};
+
+	/* in-memory copy of DM_KEY_FENCE_POINTS, rebuilt when the fence changes */
+	fence_edge_s _edges[fence_s::GEOFENCE_MAX_VERTICES];
+	fence_polygon_s _polygons[fence_s::GEOFENCE_MAX_VERTICES / 3];
+	unsigned _polygons_count;
+	bool _has_inclusion;
+	bool _fence_loaded;		/**< _edges and _polygons reflect the data manager */
+	bool _fence_valid;		/**< the loaded fence is usable, otherwise every position violates it */
+	int _fence_sub;
+
+	/**
+	 * Reload the polygons from the data manager if the fence changed.
+	 *
+	 * @return true if the cache is valid
+	 */
+	bool update_fence_cache();
+
+	/**
+	 * Read the fence vertices from the data manager, including vertices stored
+	 * in the format of older firmware (without polygon index and type).
+	 *
+	 * @return true if all _vertices_count vertices were read
+	 */
+	bool read_vertices(struct fence_vertex_s *vertices);
+
+	bool polygon_contains(const fence_polygon_s &polygon, double lat, double lon) const;
+
 	/* Params */
 	control::BlockParamInt _param_action;
 	control::BlockParamInt _param_altitude_mode;
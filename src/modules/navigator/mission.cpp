@@ -84,6 +84,10 @@ Mission::Mission(Navigator *navigator, const char *name) :
 	_inited(false),
 	_home_inited(false),
 	_need_mission_reset(false),
+	_item_cache{},
+	_item_cache_dm_item(DM_KEY_WAYPOINTS_OFFBOARD_0),
+	_item_cache_index(0),
+	_item_cache_count(0),
 	_missionFeasibilityChecker(),
 	_min_current_sp_distance_xy(FLT_MAX),
 	_distance_current_previous(0.0f),
@@ -252,6 +256,9 @@ Mission::on_active()
 void
 Mission::update_onboard_mission()
 {
+	/* the mission items may have changed */
+	_item_cache_count = 0;
+
 	if (orb_copy(ORB_ID(onboard_mission), _navigator->get_onboard_mission_sub(), &_onboard_mission) == OK) {
 		/* accept the current index set by the onboard mission if it is within bounds */
 		if (_onboard_mission.current_seq >= 0
@@ -295,6 +302,9 @@ Mission::update_offboard_mission()
 {
 	bool failed = true;
 
+	/* the mission items may have changed */
+	_item_cache_count = 0;
+
 	if (orb_copy(ORB_ID(offboard_mission), _navigator->get_offboard_mission_sub(), &_offboard_mission) == OK) {
 		warnx("offboard mission updated: dataman_id=%d, count=%d, current_seq=%d", _offboard_mission.dataman_id,
 		      _offboard_mission.count, _offboard_mission.current_seq);
@@ -1101,7 +1111,7 @@ Mission::read_mission_item(bool onboard, int offset, struct mission_item_s *miss
 		struct mission_item_s mission_item_tmp;
 
 		/* read mission item from datamanager */
-		if (dm_read(dm_item, *mission_index_ptr, &mission_item_tmp, len) != len) {
+		if (!read_mission_item_cached(dm_item, *mission_index_ptr, mission->count, &mission_item_tmp)) {
 			/* not supposed to happen unless the datamanager can't access the SD card, etc. */
 			mavlink_and_console_log_critical(_navigator->get_mavlink_log_pub(), "ERROR waypoint could not be read");
 			return false;
@@ -1127,6 +1137,13 @@ Mission::read_mission_item(bool onboard, int offset, struct mission_item_s *miss
 						return false;
 					}
 
+					/* keep the read-ahead copy in sync */
+					if (_item_cache_count > 0 && dm_item == _item_cache_dm_item
+					    && *mission_index_ptr >= _item_cache_index
+					    && *mission_index_ptr < _item_cache_index + (int)_item_cache_count) {
+						_item_cache[*mission_index_ptr - _item_cache_index] = mission_item_tmp;
+					}
+
 					report_do_jump_mission_changed(*mission_index_ptr, mission_item_tmp.do_jump_repeat_count);
 				}
 
@@ -1279,24 +1296,37 @@ Mission::reset_offboard_mission(struct mission_s &mission)
 			/* reset jump counters */
 			if (mission.count > 0) {
 				dm_item_t dm_current = DM_KEY_WAYPOINTS_OFFBOARD(mission.dataman_id);
+				const ssize_t len = sizeof(struct mission_item_s);
+
+				/* the read-ahead cache serves as batch buffer, it is stale afterwards anyway */
+				_item_cache_count = 0;
+
+				for (unsigned index = 0; index < mission.count; index += MISSION_ITEM_CACHE_SIZE) {
+					unsigned num_items = mission.count - index;
 
-				for (unsigned index = 0; index < mission.count; index++) {
-					struct mission_item_s item;
-					const ssize_t len = sizeof(struct mission_item_s);
+					if (num_items > MISSION_ITEM_CACHE_SIZE) {
+						num_items = MISSION_ITEM_CACHE_SIZE;
+					}
 
-					if (dm_read(dm_current, index, &item, len) != len) {
+					if (dm_read_range(dm_current, index, num_items, _item_cache, len) != (ssize_t)num_items) {
 						PX4_WARN("could not read mission item during reset");
 						break;
 					}
 
-					if (item.nav_cmd == NAV_CMD_DO_JUMP) {
-						item.do_jump_current_count = 0;
+					bool changed = false;
 
-						if (dm_write(dm_current, index, DM_PERSIST_POWER_ON_RESET, &item, len) != len) {
-							PX4_WARN("could not save mission item during reset");
-							break;
+					for (unsigned i = 0; i < num_items; i++) {
+						if (_item_cache[i].nav_cmd == NAV_CMD_DO_JUMP) {
+							_item_cache[i].do_jump_current_count = 0;
+							changed = true;
 						}
 					}
+
+					if (changed && dm_write_range(dm_current, index, num_items, DM_PERSIST_POWER_ON_RESET, _item_cache,
+								      len) != (ssize_t)num_items) {
+						PX4_WARN("could not save mission item during reset");
+						break;
+					}
 				}
 			}
 
@@ -1315,6 +1345,35 @@ Mission::reset_offboard_mission(struct mission_s &mission)
 	dm_unlock(DM_KEY_MISSION_STATE);
 }
 
+bool
+Mission::read_mission_item_cached(dm_item_t dm_item, int index, unsigned count, struct mission_item_s *mission_item)
+{
+	if (_item_cache_count == 0 || dm_item != _item_cache_dm_item
+	    || index < _item_cache_index || index >= _item_cache_index + (int)_item_cache_count) {
+
+		/* refill the cache starting at the requested item, the caller made sure it is within the mission */
+		unsigned num_items = count - index;
+
+		if (num_items > MISSION_ITEM_CACHE_SIZE) {
+			num_items = MISSION_ITEM_CACHE_SIZE;
+		}
+
+		ssize_t num_read = dm_read_range(dm_item, index, num_items, _item_cache, sizeof(struct mission_item_s));
+
+		if (num_read <= 0) {
+			_item_cache_count = 0;
+			return false;
+		}
+
+		_item_cache_dm_item = dm_item;
+		_item_cache_index = index;
+		_item_cache_count = num_read;
+	}
+
+	*mission_item = _item_cache[index - _item_cache_index];
+	return true;
+}
+
 bool
 Mission::need_to_reset_mission(bool active)
 {
@@ -188,6 +188,14 @@ private:
 	 */
 	bool read_mission_item(bool onboard, int offset, struct mission_item_s *mission_item);
 
+	/**
+	 * Read a mission item through the read-ahead cache, a miss refills it
+	 * with the following items in a single dataman request
+	 *
+	 * @return true if successful
+	 */
+	bool read_mission_item_cached(dm_item_t dm_item, int index, unsigned count, struct mission_item_s *mission_item);
+
 	/**
 	 * Save current offboard mission state to dataman
 	 */
@@ -254,6 +262,13 @@ private:
 	bool _home_inited;
 	bool _need_mission_reset;
 
+	static constexpr unsigned MISSION_ITEM_CACHE_SIZE = 8;	/**< number of mission items read from the dataman at once */
+
+	struct mission_item_s _item_cache[MISSION_ITEM_CACHE_SIZE];	/**< consecutive mission items read ahead */
+	dm_item_t _item_cache_dm_item;		/**< dataman item type of the cached items */
+	int _item_cache_index;			/**< mission index of the first cached item */
+	unsigned _item_cache_count;		/**< number of cached items, 0 if the cache is empty */
+
 	MissionFeasibilityChecker _missionFeasibilityChecker; /**< class that checks if a mission is feasible */
 
 	float _min_current_sp_distance_xy; /**< minimum distance which was achieved to the current waypoint  */
@@ -39,6 +39,8 @@ namespace replay
 {
 
 static const char *ENV_FILENAME = "replay"; ///< name for getenv()
+static const char *const ENV_START_TIME = "replay_start"; ///< optional start time [s], relative to the start of the log
+static const char *const ENV_MODE = "replay_mode"; ///< optional, "lockstep" to replay as fast as possible
 
 
 } //namespace replay
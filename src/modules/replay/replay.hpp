@@ -33,7 +33,6 @@
 
 #pragma once
 
-#include <fstream>
 #include <map>
 #include <vector>
 #include <set>
@@ -41,6 +40,8 @@
 
 #include "definitions.hpp"
 
+#include <ulog_reader/ulog_reader.h>
+#include <ulog_reader/merge_iterator.h>
 #include <uORB/uORBTopics.h>
 
 namespace px4
@@ -49,9 +50,13 @@ namespace px4
 /**
  * @class Replay
  * Parses an ULog file and replays it in 'real-time'. The timestamp of each replayed message is offset
- * to match the starting time of replay. It keeps a stream for each subscription to find the next message
- * to replay. This is necessary because data messages from different subscriptions don't need to be in
- * monotonic increasing order.
+ * to match the starting time of replay. Data messages from different subscriptions don't need to be in
+ * monotonic increasing order, so they are read through a ulog_reader::MergeIterator, which returns them
+ * in timestamp order. The file is memory-mapped and the messages are accessed in place.
+ *
+ * In lockstep mode, the replay drives the system time (hrt) from the log timestamps instead of waiting,
+ * and after each sensor update it waits for the estimator to publish its output. This replays a log as
+ * fast as the estimator can process it.
  */
 class Replay
 {
@@ -80,6 +85,14 @@ public:
 	static void setupReplayFile(const char *file_name);
 
 	static bool isSetup() { return _replay_file; }
+
+	/**
+	 * Skip forward in the replayed log. Can be called from another thread.
+	 * Seeking backwards is not supported.
+	 * @param seconds target time, relative to the start of the log
+	 * @return false if the target time is before the current replay position
+	 */
+	bool seek(float seconds);
 private:
 	bool _task_should_exit = false;
 	std::set<std::string> _overridden_params;
@@ -87,63 +100,98 @@ private:
 
 	uint64_t _file_start_time;
 	uint64_t _replay_start_time;
-	std::streampos _data_section_start; ///< first ADD_LOGGED_MSG message
+	uint64_t _data_section_start; ///< first ADD_LOGGED_MSG message
 	std::vector<uint8_t> _read_buffer;
 
+	ulog_reader::Reader _reader;
+	ulog_reader::MergeIterator _iterator; ///< data messages of all subscriptions in timestamp order
+
 	struct Subscription {
 
 		const orb_metadata *orb_meta = nullptr; ///< if nullptr, this subscription is invalid
 		orb_advert_t orb_advert = nullptr;
 		uint8_t multi_id;
 		int timestamp_offset; ///< marks the field of the timestamp
-
-		std::streampos next_read_pos;
-		uint64_t next_timestamp; ///< timestamp of the file
 	};
 	std::vector<Subscription> _subscriptions;
 
-	/** keep track of file position to avoid adding a subscription multiple times. */
-	std::streampos _subscription_file_pos = 0;
+	/**
+	 * File offsets of the messages in the data section that are not data: ADD_LOGGED_MSG,
+	 * PARAMETER and DROPOUT messages. They have no timestamp, so they are handled
+	 * based on their position in the file.
+	 */
+	std::vector<uint64_t> _events;
+
+	struct IndexSample {
+		uint64_t timestamp;
+		uint64_t offset;
+	};
+	std::vector<std::vector<IndexSample>> _index_samples; ///< index of the file, per msg_id, sorted by timestamp
+	std::vector<uint64_t> _index_events; ///< file positions of parameter changes and added topics
+	bool _index_valid = false; ///< true if the file has an index
+	bool _index_events_complete = false; ///< true if _index_events contains all events
+
+	volatile int32_t _seek_request_ms = -1; ///< requested seek time relative to the start of the log [ms], -1 if none
+	volatile int32_t _position_ms = 0; ///< file time of the last published message relative to the start of the log [ms]
 
-	bool readFileHeader(std::ifstream &file);
+	bool _lockstep = false; ///< drive the time from the log instead of replaying in real-time
+	int _estimator_output_sub = -1; ///< lockstep: estimator output we wait for, -1 if not waiting
+	unsigned _estimator_timeouts = 0; ///< lockstep: consecutive timeouts while waiting for the estimator
+	static constexpr int LOCKSTEP_TIMEOUT_MS = 200; ///< lockstep: maximum wait for the estimator (real-time)
+	static constexpr unsigned LOCKSTEP_MAX_TIMEOUTS = 10; ///< lockstep: stop waiting after this many consecutive timeouts
+
+	/**
+	 * Open the replay file. It can be an uncompressed or a compressed ULog file.
+	 * @return true on success
+	 */
+	bool openReplayFile();
 
 	/**
 	 * Read definitions section: check formats, apply parameters and store
 	 * the start of the data section.
 	 * @return true on success
 	 */
-	bool readFileDefinitions(std::ifstream &file);
+	bool readFileDefinitions();
 
 	///file parsing methods. They return false, when further parsing should be aborted.
-	bool readFormat(std::ifstream &file, uint16_t msg_size);
-	bool readAndAddSubscription(std::ifstream &file, uint16_t msg_size);
+	bool readFormat(const ulog_reader::MessageView &msg);
+	bool readAndAddSubscription(const ulog_reader::MessageView &msg);
 
 	/**
 	 * Read the file header and definitions sections. Apply the parameters from this section
 	 * and apply user-defined overridden parameters.
 	 * @return true on success
 	 */
-	bool readDefinitionsAndApplyParams(std::ifstream &file);
+	bool readDefinitionsAndApplyParams();
+
+	/**
+	 * Find the events in the data section (from the index, or by reading the whole data section)
+	 * and add the subscriptions.
+	 */
+	void readEventsAndAddSubscriptions();
+
+	/**
+	 * Handle the events before a given file offset, starting with _events[next_event].
+	 * This applies parameter updates and reports dropouts.
+	 */
+	void handleEvents(uint64_t end_offset, size_t &next_event);
+	void readDropout(const ulog_reader::MessageView &msg);
+	bool readAndApplyParameter(const ulog_reader::MessageView &msg);
 
 	/**
-	 * Read and handle additional messages starting at current file position, while position < end_position.
-	 * This handles dropout and parameter update messages.
-	 * We need to handle these separately, because they have no timestamp. We look at the file position instead.
-	 * @return false on file error
+	 * Read the index at the end of the file (written by the logger when the log was stopped).
+	 * Files without index (e.g. truncated logs) can still be replayed, but seeking
+	 * requires reading the file up to the target time.
+	 * @return true if the file has a valid index
 	 */
-	bool readAndHandleAdditionalMessages(std::ifstream &file, std::streampos end_position);
-	bool readDropout(std::ifstream &file, uint16_t msg_size);
-	bool readAndApplyParameter(std::ifstream &file, uint16_t msg_size);
+	bool readIndex();
 
 	/**
-	 * Find next data message for this subscription, starting with the stored file offset.
-	 * Skip the first message, and if found, read the timestamp and store the new file offset.
-	 * This also takes care of new subscriptions and parameter updates. When reaching EOF,
-	 * the subscription is set to invalid.
-	 * File seek position is arbitrary after this call.
-	 * @return false on file error
+	 * Skip forward: move all subscriptions to their first data message with timestamp >= file_time
+	 * and handle the events in between.
+	 * @param next_event index of the next event to handle, updated
 	 */
-	bool nextDataMessage(std::ifstream &file, Subscription &subscription, int msg_id);
+	void seekToTime(uint64_t file_time, size_t &next_event);
 
 	static const orb_metadata *findTopic(const std::string &name);
 	/** get the array size from a type. eg. float[3] -> return float */
@@ -155,6 +203,17 @@ private:
 
 	void setUserParams(const char *filename);
 
+	/**
+	 * Lockstep: wait until the estimator has processed the published sensor data.
+	 */
+	void waitForEstimator();
+
+	/**
+	 * Publish a data message, with the timestamp replaced
+	 * @return true if published
+	 */
+	bool publish(Subscription &sub, const ulog_reader::DataMessageView &msg, uint64_t publish_timestamp);
+
 	static char *_replay_file;
 };
 
@@ -45,6 +45,7 @@
 #include <px4_tasks.h>
 #include <px4_time.h>
 
+#include <algorithm>
 #include <cstring>
 #include <float.h>
 #include <fstream>
@@ -58,6 +59,8 @@
 
 #include <logger/logger.h>
 #include <logger/messages.h>
+#include <uORB/topics/estimator_status.h>
+#include <uORB/topics/sensor_combined.h>
 
 #include "replay.hpp"
 
@@ -82,7 +85,8 @@ static int	control_task = -1;			//task handle for task
 
 char *Replay::_replay_file = nullptr;
 
-Replay::Replay()
+Replay::Replay() :
+	_iterator(_reader)
 {
 }
 
@@ -159,89 +163,69 @@ void Replay::setUserParams(const char *filename)
 	}
 }
 
-bool Replay::readFileHeader(std::ifstream &file)
+bool Replay::openReplayFile()
 {
-	file.seekg(0);
-	ulog_file_header_s msg_header;
-	file.read((char *)&msg_header, sizeof(msg_header));
-
-	if (!file) {
+	if (!_reader.open(_replay_file)) {
+		PX4_ERR("Failed to open replay file");
 		return false;
 	}
 
-	_file_start_time = msg_header.timestamp;
-	//verify it's an ULog file
-	char magic[8];
-	magic[0] = 'U';
-	magic[1] = 'L';
-	magic[2] = 'o';
-	magic[3] = 'g';
-	magic[4] = 0x01;
-	magic[5] = 0x12;
-	magic[6] = 0x35;
-	return memcmp(magic, msg_header.magic, 7) == 0;
+	if (_reader.isCompressed()) {
+		PX4_INFO("Reading compressed log file");
+
+		if (_reader.skippedBytes() > 0) {
+			PX4_WARN("Skipped %zu bytes of corrupt or incomplete data", _reader.skippedBytes());
+		}
+	}
+
+	return true;
 }
 
-bool Replay::readFileDefinitions(std::ifstream &file)
+bool Replay::readFileDefinitions()
 {
 	PX4_INFO("Applying params from ULog file...");
 
-	ulog_message_header_s message_header;
-	file.seekg(sizeof(ulog_file_header_s));
-
-	while (true) {
-		file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
-
-		if (!file) {
-			return false;
-		}
+	ulog_reader::MessageView msg;
+	uint64_t offset = ulog_reader::Reader::FIRST_MESSAGE_OFFSET;
 
-		switch (message_header.msg_type) {
+	while (_reader.messageAt(offset, msg)) {
+		switch (msg.type) {
 		case (int)ULogMessageType::FORMAT:
-			if (!readFormat(file, message_header.msg_size)) {
+			if (!readFormat(msg)) {
 				return false;
 			}
 
 			break;
 
 		case (int)ULogMessageType::PARAMETER:
-			if (!readAndApplyParameter(file, message_header.msg_size)) {
+			if (!readAndApplyParameter(msg)) {
 				return false;
 			}
 
 			break;
 
 		case (int)ULogMessageType::ADD_LOGGED_MSG:
-			_data_section_start = file.tellg() - (streamoff)ULOG_MSG_HEADER_LEN;
+			_data_section_start = offset;
 			return true;
 
 		case (int)ULogMessageType::INFO: //skip
-			file.seekg(message_header.msg_size, ios::cur);
 			break;
 
 		default:
 			PX4_ERR("unknown log definition type %i, size %i (offset %i)",
-				(int)message_header.msg_type, (int)message_header.msg_size, (int)file.tellg());
-			file.seekg(message_header.msg_size, ios::cur);
+				(int)msg.type, (int)msg.size, (int)offset);
 			break;
 		}
+
+		offset += msg.totalSize();
 	}
 
-	return true;
+	return false;
 }
 
-bool Replay::readFormat(std::ifstream &file, uint16_t msg_size)
+bool Replay::readFormat(const ulog_reader::MessageView &msg)
 {
-	_read_buffer.reserve(msg_size + 1);
-	char *format = (char *)_read_buffer.data();
-	file.read(format, msg_size);
-	format[msg_size] = 0;
-
-	if (!file) {
-		return false;
-	}
-
-	string str_format(format);
+	string str_format((const char *)msg.payload, msg.size);
 	size_t pos = str_format.find(':');
 
 	if (pos == string::npos) {
@@ -255,27 +239,20 @@ bool Replay::readFormat(std::ifstream &file, uint16_t msg_size)
 	return true;
 }
 
-bool Replay::readAndAddSubscription(std::ifstream &file, uint16_t msg_size)
+bool Replay::readAndAddSubscription(const ulog_reader::MessageView &msg)
 {
-	_read_buffer.reserve(msg_size + 1);
-	char *message = (char *)_read_buffer.data();
-	streampos this_message_pos = file.tellg() - (streamoff)ULOG_MSG_HEADER_LEN;
-	file.read(message, msg_size);
-	message[msg_size] = 0;
-
-	if (!file) {
+	if (msg.size < 3) {
 		return false;
 	}
 
-	if (file.tellg() <= _subscription_file_pos) { //already read this subscription
+	uint8_t multi_id = msg.payload[0];
+	uint16_t msg_id = ((uint16_t) msg.payload[1]) | (((uint16_t) msg.payload[2]) << 8);
+
+	if (msg_id < _subscriptions.size() && _subscriptions[msg_id].orb_meta) { //already added this subscription
 		return true;
 	}
 
-	_subscription_file_pos = file.tellg();
-
-	uint8_t multi_id = *(uint8_t *)message;
-	uint16_t msg_id = ((uint16_t) message[1]) | (((uint16_t) message[2]) << 8);
-	string topic_name(message + 3);
+	string topic_name((const char *)msg.payload + 3, msg.size - 3);
 	const orb_metadata *orb_meta = findTopic(topic_name);
 
 	if (!orb_meta) {
@@ -334,22 +311,6 @@ bool Replay::readAndAddSubscription(std::ifstream &file, uint16_t msg_size)
 		return true;
 	}
 
-
-	//find first data message (and the timestamp)
-	streampos cur_pos = file.tellg();
-	subscription.next_read_pos = this_message_pos; //this will be skipped
-
-	if (!nextDataMessage(file, subscription, msg_id)) {
-		return false;
-	}
-
-	file.seekg(cur_pos);
-
-	if (!subscription.orb_meta) {
-		//no message found. This is not a fatal error
-		return true;
-	}
-
 	PX4_DEBUG("adding subscription for %s (msg_id %i)", subscription.orb_meta->o_name, msg_id);
 
 	//add subscription
@@ -359,53 +320,103 @@ bool Replay::readAndAddSubscription(std::ifstream &file, uint16_t msg_size)
 
 	_subscriptions[msg_id] = subscription;
 
+	//the data messages follow the ADD_LOGGED_MSG message
+	_iterator.addTopic(msg_id, msg.offset, orb_meta->o_size_no_padding, subscription.timestamp_offset);
+
 	return true;
 }
 
-bool Replay::readAndHandleAdditionalMessages(std::ifstream &file, std::streampos end_position)
+void Replay::readEventsAndAddSubscriptions()
 {
-	ulog_message_header_s message_header;
+	ulog_reader::MessageView msg;
+	_events.clear();
 
-	while (file.tellg() < end_position) {
-		file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
+	if (_index_valid && _index_events_complete) {
+		//the index contains the events after the start of logging, the topics added
+		//at the start directly follow the definitions section
+		uint64_t offset = _data_section_start;
 
-		if (!file) {
-			return false;
+		while (_reader.messageAt(offset, msg) && msg.type == (uint8_t)ULogMessageType::ADD_LOGGED_MSG) {
+			readAndAddSubscription(msg);
+			offset += msg.totalSize();
 		}
 
-		switch (message_header.msg_type) {
-		case (int)ULogMessageType::PARAMETER:
-			if (!readAndApplyParameter(file, message_header.msg_size)) {
-				return false;
+		for (uint64_t event_offset : _index_events) {
+			if (!_reader.messageAt(event_offset, msg)) {
+				continue;
+			}
+
+			if (msg.type == (uint8_t)ULogMessageType::ADD_LOGGED_MSG) {
+				readAndAddSubscription(msg);
 			}
 
+			_events.push_back(event_offset);
+		}
+
+		sort(_events.begin(), _events.end());
+		return;
+	}
+
+	//no (complete) index: read the message headers of the whole data section
+	uint64_t offset = _data_section_start;
+
+	while (_reader.messageAt(offset, msg)) {
+		switch (msg.type) {
+		case (int)ULogMessageType::ADD_LOGGED_MSG:
+			readAndAddSubscription(msg);
+			_events.push_back(offset);
 			break;
 
+		case (int)ULogMessageType::PARAMETER:
 		case (int)ULogMessageType::DROPOUT:
-			readDropout(file, message_header.msg_size);
+			_events.push_back(offset);
 			break;
 
-		default: //skip all others
-			file.seekg(message_header.msg_size, ios::cur);
+		default: //data and all others are handled by the iterator or ignored
 			break;
 		}
+
+		offset += msg.totalSize();
 	}
+}
 
-	return true;
+void Replay::handleEvents(uint64_t end_offset, size_t &next_event)
+{
+	ulog_reader::MessageView msg;
+
+	for (; next_event < _events.size() && _events[next_event] < end_offset; ++next_event) {
+		if (!_reader.messageAt(_events[next_event], msg)) {
+			continue;
+		}
+
+		switch (msg.type) {
+		case (int)ULogMessageType::PARAMETER:
+			readAndApplyParameter(msg);
+			break;
+
+		case (int)ULogMessageType::DROPOUT:
+			readDropout(msg);
+			break;
+
+		default: //subscriptions are already added
+			break;
+		}
+	}
 }
 
-bool Replay::readAndApplyParameter(std::ifstream &file, uint16_t msg_size)
+bool Replay::readAndApplyParameter(const ulog_reader::MessageView &msg)
 {
-	_read_buffer.reserve(msg_size);
-	uint8_t *message = (uint8_t *)_read_buffer.data();
-	file.read((char *)message, msg_size);
+	if (msg.size < 1) {
+		return false;
+	}
+
+	uint8_t key_len = msg.payload[0];
 
-	if (!file) {
+	if (1 + key_len + sizeof(int32_t) > msg.size) {
 		return false;
 	}
 
-	uint8_t key_len = message[0];
-	string key((char *)message + 1, key_len);
+	string key((const char *)msg.payload + 1, key_len);
 
 	size_t pos = key.find(' ');
 
@@ -429,96 +440,167 @@ bool Replay::readAndApplyParameter(std::ifstream &file, uint16_t msg_size)
 	param_t handle = param_find(param_name.c_str());
 
 	if (handle != PARAM_INVALID) {
-		param_set(handle, (const void *)(message + 1 + key_len));
+		//int32_t and float have the same size
+		uint8_t value[sizeof(int32_t)];
+		memcpy(value, msg.payload + 1 + key_len, sizeof(value));
+		param_set(handle, (const void *)value);
 	}
 
 	return true;
 }
 
-bool Replay::readDropout(std::ifstream &file, uint16_t msg_size)
+void Replay::readDropout(const ulog_reader::MessageView &msg)
 {
-	uint16_t duration;
-	file.read((char *)&duration, sizeof(duration));
+	uint16_t duration = 0;
+
+	if (msg.size >= sizeof(duration)) {
+		memcpy(&duration, msg.payload, sizeof(duration));
+	}
 
 	PX4_INFO("Dropout in replayed log, %i ms", (int)duration);
-	return file.good();
 }
 
-bool Replay::nextDataMessage(std::ifstream &file, Subscription &subscription, int msg_id)
+bool Replay::readIndex()
 {
-	ulog_message_header_s message_header;
-	file.seekg(subscription.next_read_pos);
-	//ignore the first message (it's data we already read)
-	file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
+	_index_valid = false;
+	_index_samples.clear();
+	_index_events.clear();
 
-	if (file) {
-		file.seekg(message_header.msg_size, ios::cur);
+	// offsets refer to the complete file, they are wrong if parts of a compressed file are missing
+	if (_reader.skippedBytes() > 0) {
+		return false;
 	}
 
-	uint16_t file_msg_id;
-	bool done = false;
+	ulog_message_index_end_s end_msg;
+
+	if (_reader.size() < sizeof(end_msg)) {
+		return false;
+	}
+
+	const uint64_t index_end = _reader.size() - sizeof(end_msg);
+	memcpy(&end_msg, _reader.data() + index_end, sizeof(end_msg));
+
+	if (end_msg.msg_type != (uint8_t)ULogMessageType::INDEX ||
+	    end_msg.index_type != (uint8_t)ULogIndexType::END ||
+	    end_msg.msg_size != sizeof(end_msg) - ULOG_MSG_HEADER_LEN ||
+	    memcmp(end_msg.magic, ULOG_INDEX_END_MAGIC, sizeof(end_msg.magic)) != 0 ||
+	    end_msg.index_offset > index_end) {
+		return false; // no index: the log was not properly closed
+	}
 
-	while (file && !done) {
-		streampos cur_pos = file.tellg();
-		file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
+	const uint64_t index_start = end_msg.index_offset;
+	ulog_reader::MessageView msg;
+	uint64_t offset = index_start;
 
-		if (!file) {
+	while (offset < index_end && _reader.messageAt(offset, msg)) {
+		if (msg.type != (uint8_t)ULogMessageType::INDEX || msg.size < 1) {
 			break;
 		}
 
-		switch (message_header.msg_type) {
-		case (int)ULogMessageType::ADD_LOGGED_MSG:
-			readAndAddSubscription(file, message_header.msg_size);
-			break;
+		const uint8_t index_type = msg.payload[0];
+		const uint8_t *entries = msg.payload + 1;
+		const size_t data_size = msg.size - 1;
+
+		if (index_type == (uint8_t)ULogIndexType::DATA) {
+			ulog_index_data_entry_s entry;
 
-		case (int)ULogMessageType::DATA:
-			file.read((char *)&file_msg_id, sizeof(file_msg_id));
-
-			if (file) {
-				if (msg_id == file_msg_id) {
-					if (message_header.msg_size == subscription.orb_meta->o_size_no_padding + 2) {
-						subscription.next_read_pos = cur_pos;
-						file.seekg(subscription.timestamp_offset, ios::cur);
-						file.read((char *)&subscription.next_timestamp, sizeof(subscription.next_timestamp));
-						done = true;
-
-					} else { //sanity check failed!
-						PX4_ERR("data message %s has wrong size %i (expected %i). Skipping",
-							subscription.orb_meta->o_name, message_header.msg_size,
-							subscription.orb_meta->o_size_no_padding + 2);
-						file.seekg(message_header.msg_size - sizeof(file_msg_id), ios::cur);
+			for (size_t i = 0; i < data_size / sizeof(entry); ++i) {
+				memcpy(&entry, entries + i * sizeof(entry), sizeof(entry));
+
+				if (entry.offset < index_start) {
+					if (_index_samples.size() <= entry.msg_id) {
+						_index_samples.resize(entry.msg_id + 1);
 					}
 
-				} else { //not the one we are looking for
-					file.seekg(message_header.msg_size - sizeof(file_msg_id), ios::cur);
+					_index_samples[entry.msg_id].push_back({entry.timestamp, entry.offset});
 				}
 			}
 
-			break;
+		} else if (index_type == (uint8_t)ULogIndexType::EVENTS) {
+			uint64_t event_offset;
 
-		case (int)ULogMessageType::REMOVE_LOGGED_MSG: //skip these
-		case (int)ULogMessageType::PARAMETER:
-		case (int)ULogMessageType::DROPOUT:
-		case (int)ULogMessageType::SYNC:
-		case (int)ULogMessageType::LOGGING:
-			file.seekg(message_header.msg_size, ios::cur);
-			break;
+			for (size_t i = 0; i < data_size / sizeof(event_offset); ++i) {
+				memcpy(&event_offset, entries + i * sizeof(event_offset), sizeof(event_offset));
 
-		default:
-			//this really should not happen
-			PX4_ERR("unknown log message type %i, size %i (offset %i)",
-				(int)message_header.msg_type, (int)message_header.msg_size, (int)file.tellg());
-			file.seekg(message_header.msg_size, ios::cur);
-			break;
+				if (event_offset < index_start) {
+					_index_events.push_back(event_offset);
+				}
+			}
+		}
+
+		offset += msg.totalSize();
+	}
+
+	if (offset != index_end) {
+		PX4_WARN("Invalid log index, ignoring it");
+		_index_samples.clear();
+		_index_events.clear();
+		return false;
+	}
+
+	_index_valid = true;
+	_index_events_complete = (end_msg.flags & ULOG_INDEX_FLAG_EVENTS_INCOMPLETE) == 0;
+	return true;
+}
+
+void Replay::seekToTime(uint64_t file_time, size_t &next_event)
+{
+	// move each topic to the last index sample before file_time, the iterator then skips the rest
+	if (_index_valid) {
+		for (size_t i = 0; i < _index_samples.size() && i < _subscriptions.size(); ++i) {
+			if (!_subscriptions[i].orb_meta) {
+				continue;
+			}
+
+			const vector<IndexSample> &samples = _index_samples[i];
+			auto it = upper_bound(samples.begin(), samples.end(), file_time,
+			[](uint64_t t, const IndexSample & sample) { return t < sample.timestamp; });
+
+			if (it != samples.begin()) {
+				--it;
+				_iterator.seekTopic(i, it->offset);
+			}
 		}
 	}
 
-	if (file.eof()) { //no more data messages for this subscription
-		subscription.orb_meta = nullptr;
-		file.clear();
+	_iterator.skipUntil(file_time);
+
+	// handle the parameter changes up to the new position
+	handleEvents(_iterator.minOffset(), next_event);
+}
+
+void Replay::waitForEstimator()
+{
+	if (_estimator_output_sub < 0) {
+		return;
+	}
+
+	px4_pollfd_struct_t fds[1];
+	fds[0].fd = _estimator_output_sub;
+	fds[0].events = POLLIN;
+
+	if (px4_poll(fds, 1, LOCKSTEP_TIMEOUT_MS) > 0) {
+		estimator_status_s estimator_status;
+		orb_copy(ORB_ID(estimator_status), _estimator_output_sub, &estimator_status);
+		_estimator_timeouts = 0;
+
+	} else if (++_estimator_timeouts >= LOCKSTEP_MAX_TIMEOUTS) {
+		PX4_WARN("no estimator output, continuing without waiting");
+		orb_unsubscribe(_estimator_output_sub);
+		_estimator_output_sub = -1;
+	}
+}
+
+bool Replay::seek(float seconds)
+{
+	const int32_t seek_ms = (int32_t)(seconds * 1000.f);
+
+	if (seek_ms < _position_ms) {
+		return false;
 	}
 
-	return file.good();
+	_seek_request_ms = seek_ms;
+	return true;
 }
 
 const orb_metadata *Replay::findTopic(const std::string &name)
@@ -588,7 +670,7 @@ size_t Replay::sizeOfFullType(const std::string &type_name_full)
 	return sizeOfType(type_name) * array_size;
 }
 
-bool Replay::readDefinitionsAndApplyParams(std::ifstream &file)
+bool Replay::readDefinitionsAndApplyParams()
 {
 	// log reader currently assumes little endian
 	int num = 1;
@@ -598,18 +680,13 @@ bool Replay::readDefinitionsAndApplyParams(std::ifstream &file)
 		return false;
 	}
 
-	if (!file.is_open()) {
-		PX4_ERR("Failed to open replay file");
-		return false;
-	}
-
-	if (!readFileHeader(file)) {
+	if (!_reader.readHeader(_file_start_time)) {
 		PX4_ERR("Failed to read file header. Not a valid ULog file");
 		return false;
 	}
 
 	//initialize the formats and apply the parameters from the log file
-	if (!readFileDefinitions(file)) {
+	if (!readFileDefinitions()) {
 		PX4_ERR("Failed to read ULog definitions section. Broken file?");
 		return false;
 	}
@@ -618,123 +695,146 @@ bool Replay::readDefinitionsAndApplyParams(std::ifstream &file)
 	return true;
 }
 
-void Replay::task_main()
+bool Replay::publish(Subscription &sub, const ulog_reader::DataMessageView &msg, uint64_t publish_timestamp)
 {
-	ifstream replay_file(_replay_file, ios::in | ios::binary);
+	const size_t msg_read_size = sub.orb_meta->o_size_no_padding;
+	const size_t msg_write_size = sub.orb_meta->o_size;
 
-	if (!readDefinitionsAndApplyParams(replay_file)) {
-		return;
+	if (_read_buffer.size() < msg_write_size) {
+		_read_buffer.resize(msg_write_size);
 	}
 
-	_replay_start_time = hrt_absolute_time();
+	memcpy(_read_buffer.data(), msg.data, msg_read_size);
+	memcpy(_read_buffer.data() + sub.timestamp_offset, &publish_timestamp, sizeof(publish_timestamp));
+
+	if (sub.orb_advert) {
+		orb_publish(sub.orb_meta, sub.orb_advert, _read_buffer.data());
+		return true;
+	}
 
-	PX4_INFO("Replay in progress...");
+	if (sub.multi_id == 0) {
+		sub.orb_advert = orb_advertise(sub.orb_meta, _read_buffer.data());
+		return true;
+	}
 
-	ulog_message_header_s message_header;
-	replay_file.seekg(_data_section_start);
+	// make sure the other instances are advertised already so that we get the correct instance
+	for (const auto &subscription : _subscriptions) {
+		if (subscription.orb_meta) {
+			if (strcmp(sub.orb_meta->o_name, subscription.orb_meta->o_name) == 0 &&
+			    subscription.orb_advert && subscription.multi_id == sub.multi_id - 1) {
+				int instance;
+				sub.orb_advert = orb_advertise_multi(sub.orb_meta, _read_buffer.data(),
+								     &instance, ORB_PRIO_DEFAULT);
+				return true;
+			}
+		}
+	}
 
-	//we know the next message must be an ADD_LOGGED_MSG
-	replay_file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
+	return false;
+}
 
-	if (!readAndAddSubscription(replay_file, message_header.msg_size)) {
-		PX4_ERR("Failed to read subscription");
+void Replay::task_main()
+{
+	if (!openReplayFile() || !readDefinitionsAndApplyParams()) {
 		return;
 	}
 
+	if (readIndex()) {
+		PX4_INFO("Log index: %zu topics, %zu events", _index_samples.size(), _index_events.size());
+	}
+
+	readEventsAndAddSubscriptions();
+
+	const char *mode = getenv(replay::ENV_MODE);
+	_lockstep = mode && strcmp(mode, "lockstep") == 0;
+	const uint64_t wall_start_time = hrt_system_time();
+
+	_replay_start_time = hrt_absolute_time();
+
+	if (_lockstep) {
+		// from now on the time only advances with the replayed messages
+		hrt_set_absolute_time(_replay_start_time);
+		_estimator_output_sub = orb_subscribe(ORB_ID(estimator_status));
+		PX4_INFO("Replay in progress (lockstep)...");
+
+	} else {
+		PX4_INFO("Replay in progress...");
+	}
+
+	const char *start_time = getenv(replay::ENV_START_TIME);
+
+	if (start_time && !seek(atof(start_time))) {
+		PX4_ERR("invalid start time %s", start_time);
+	}
 
 	//we update the timestamps from the file by a constant offset to match
 	//the current replay time
-	const uint64_t timestamp_offset = _replay_start_time - _file_start_time;
+	uint64_t timestamp_offset = _replay_start_time - _file_start_time;
 	uint32_t nr_published_messages = 0;
-	streampos last_additional_message_pos = _data_section_start;
+	size_t next_event = 0;
+	ulog_reader::DataMessageView msg;
 
-	while (!_task_should_exit && replay_file) {
+	while (!_task_should_exit) {
 
-		//Find the next message to publish. Messages from different subscriptions don't need
-		//to be in chronological order, so we need to check all subscriptions
-		uint64_t next_file_time = 0;
-		int next_msg_id = -1;
-
-		for (size_t i = 0; i < _subscriptions.size(); ++i) {
-			const Subscription &subscription = _subscriptions[i];
+		const int32_t seek_request_ms = __sync_lock_test_and_set(&_seek_request_ms, -1);
 
-			if (subscription.orb_meta) {
-				if (next_file_time == 0 || subscription.next_timestamp < next_file_time) {
-					next_msg_id = (int)i;
-					next_file_time = subscription.next_timestamp;
-				}
+		if (seek_request_ms >= 0) {
+			// the iterator can only move forward, a request can be stale by the time it is handled
+			if (seek_request_ms < _position_ms) {
+				PX4_ERR("cannot seek back to %.3f s (at %.3f s)", (double)seek_request_ms / 1.e3, (double)_position_ms / 1.e3);
+				continue;
 			}
-		}
 
-		if (next_msg_id == -1) {
-			break; //no active subscription anymore. We're done.
+			const uint64_t seek_file_time = _file_start_time + (uint64_t)seek_request_ms * 1000;
+			PX4_INFO("Seeking to %.3f s", (double)seek_request_ms / 1.e3);
+			seekToTime(seek_file_time, next_event);
+			timestamp_offset = hrt_absolute_time() - seek_file_time;
+			continue;
 		}
 
-		Subscription &sub = _subscriptions[next_msg_id];
+		//Find the next message to publish. Messages from different subscriptions don't need
+		//to be in chronological order, the iterator returns them in timestamp order
+		if (!_iterator.next(msg)) {
+			break; //no more data messages. We're done.
+		}
 
-		if (next_file_time == 0) {
+		if (msg.timestamp == 0) {
 			//someone didn't set the timestamp properly. Consider the message invalid
-			nextDataMessage(replay_file, sub, next_msg_id);
 			continue;
 		}
 
 
 		//handle additional messages between last and next published data
-		replay_file.seekg(last_additional_message_pos);
-		streampos next_additional_message_pos = sub.next_read_pos;
-		readAndHandleAdditionalMessages(replay_file, next_additional_message_pos);
-		last_additional_message_pos = next_additional_message_pos;
+		handleEvents(msg.offset, next_event);
 
 
 		//wait if necessary
-		const uint64_t publish_timestamp = next_file_time + timestamp_offset;
+		const uint64_t publish_timestamp = msg.timestamp + timestamp_offset;
 		uint64_t cur_time = hrt_absolute_time();
 
 		if (cur_time < publish_timestamp) {
-			usleep(publish_timestamp - cur_time);
+			if (_lockstep) {
+				hrt_set_absolute_time(publish_timestamp);
+
+			} else {
+				usleep(publish_timestamp - cur_time);
+			}
 		}
 
 		//It's time to publish
-		const size_t msg_read_size = sub.orb_meta->o_size_no_padding;
-		const size_t msg_write_size = sub.orb_meta->o_size;
-		_read_buffer.reserve(msg_write_size);
-		replay_file.seekg(sub.next_read_pos + (streamoff)(ULOG_MSG_HEADER_LEN + 2)); //skip header & msg id
-		replay_file.read((char *)_read_buffer.data(), msg_read_size);
-		*(uint64_t *)(_read_buffer.data() + sub.timestamp_offset) = publish_timestamp;
-
-		if (sub.orb_advert) {
-			orb_publish(sub.orb_meta, sub.orb_advert, _read_buffer.data());
-			++nr_published_messages;
-
-		} else {
-			if (sub.multi_id == 0) {
-				sub.orb_advert = orb_advertise(sub.orb_meta, _read_buffer.data());
-				++nr_published_messages;
+		Subscription &sub = _subscriptions[msg.msg_id];
 
-			} else {
-				// make sure the other instances are advertised already so that we get the correct instance
-				bool advertised = false;
-
-				for (const auto &subscription : _subscriptions) {
-					if (subscription.orb_meta) {
-						if (strcmp(sub.orb_meta->o_name, subscription.orb_meta->o_name) == 0 &&
-						    subscription.orb_advert && subscription.multi_id == sub.multi_id - 1) {
-							advertised = true;
-						}
-					}
-				}
-
-				if (advertised) {
-					int instance;
-					sub.orb_advert = orb_advertise_multi(sub.orb_meta, _read_buffer.data(),
-									     &instance, ORB_PRIO_DEFAULT);
-					++nr_published_messages;
-				}
-			}
+		if (publish(sub, msg, publish_timestamp)) {
+			++nr_published_messages;
 		}
 
+		if (msg.timestamp > _file_start_time) {
+			_position_ms = (int32_t)((msg.timestamp - _file_start_time) / 1000);
+		}
 
-		nextDataMessage(replay_file, _subscriptions[next_msg_id], next_msg_id);
+		if (_lockstep && sub.orb_meta == ORB_ID(sensor_combined)) {
+			waitForEstimator();
+		}
 
 		//TODO: output status (eg. every sec), including total duration...
 	}
@@ -746,9 +846,24 @@ void Replay::task_main()
 		}
 	}
 
+	if (_lockstep) {
+		if (_estimator_output_sub >= 0) {
+			orb_unsubscribe(_estimator_output_sub);
+			_estimator_output_sub = -1;
+		}
+
+		// continue in real-time
+		hrt_stop_delay();
+	}
+
+	if (_iterator.sizeMismatches() > 0) {
+		PX4_WARN("Skipped %u data messages with wrong size", _iterator.sizeMismatches());
+	}
+
 	if (!_task_should_exit) {
-		PX4_INFO("Replay done (published %u msgs, %.3lf s)", nr_published_messages,
-			 (double)hrt_elapsed_time(&_replay_start_time) / 1.e6);
+		PX4_INFO("Replay done (published %u msgs, %.3lf s, took %.3lf s)", nr_published_messages,
+			 (double)hrt_elapsed_time(&_replay_start_time) / 1.e6,
+			 (double)(hrt_system_time() - wall_start_time) / 1.e6);
 
 		//TODO: should we close the log file & exit (optionally, by adding a parameter -q) ?
 	}
@@ -799,9 +914,7 @@ int Replay::start(bool quiet, bool apply_params_only)
 			return -ENOMEM;
 		}
 
-		ifstream replay_file(_replay_file, ios::in | ios::binary);
-
-		if (!r->readDefinitionsAndApplyParams(replay_file)) {
+		if (!r->openReplayFile() || !r->readDefinitionsAndApplyParams()) {
 			ret = -1;
 		}
 
@@ -834,7 +947,7 @@ using namespace px4;
 int replay_main(int argc, char *argv[])
 {
 	if (argc < 1) {
-		PX4_WARN("usage: replay {tryapplyparams|trystart|start|stop|status}");
+		PX4_WARN("usage: replay {tryapplyparams|trystart|start|stop|status|seek <seconds>}");
 		return 1;
 	}
 
@@ -881,6 +994,25 @@ int replay_main(int argc, char *argv[])
 		return 0;
 	}
 
+	if (!strcmp(argv[1], "seek")) {
+		if (replay::instance == nullptr) {
+			PX4_WARN("not running");
+			return 1;
+		}
+
+		if (argc < 3) {
+			PX4_WARN("usage: replay seek <seconds from log start>");
+			return 1;
+		}
+
+		if (!replay::instance->seek(atof(argv[2]))) {
+			PX4_ERR("seeking backwards is not supported");
+			return 1;
+		}
+
+		return 0;
+	}
+
 	if (!strcmp(argv[1], "status")) {
 		if (replay::instance) {
 			PX4_WARN("running");
@@ -586,7 +586,7 @@ Sensors::Sensors() :
 	_mavlink_log_pub(nullptr),
 
 	/* performance counters */
-	_loop_perf(perf_alloc(PC_ELAPSED, "sensors")),
+	_loop_perf(perf_alloc(PC_HISTOGRAM, "sensors")),
 	_airspeed_validator(),
 
 	_param_rc_values{},
@@ -58,12 +58,49 @@
 #define BSON_WRITE write
 #define BSON_FSYNC px4_fsync
 
+static int
+read_buffered(bson_decoder_t decoder, void *p, size_t s)
+{
+	uint8_t *dst = (uint8_t *)p;
+
+	while (s > 0) {
+		/* refill the readahead buffer with the next block */
+		if (decoder->bufpos >= decoder->buflen) {
+			int ret = BSON_READ(decoder->fd, decoder->buf, decoder->bufsize);
+
+			if (ret <= 0) {
+				return -1;
+			}
+
+			decoder->buflen = ret;
+			decoder->bufpos = 0;
+		}
+
+		size_t n = decoder->buflen - decoder->bufpos;
+
+		if (n > s) {
+			n = s;
+		}
+
+		memcpy(dst, decoder->buf + decoder->bufpos, n);
+		decoder->bufpos += n;
+		dst += n;
+		s -= n;
+	}
+
+	return 0;
+}
+
 static int
 read_x(bson_decoder_t decoder, void *p, size_t s)
 {
 	CODER_CHECK(decoder);
 
 	if (decoder->fd > -1) {
+		if (decoder->buf != NULL) {
+			return read_buffered(decoder, p, s);
+		}
+
 		return (BSON_READ(decoder->fd, p, s) == (int)s) ? 0 : -1;
 	}
 
@@ -133,6 +170,38 @@ bson_decoder_init_file(bson_decoder_t decoder, int fd, bson_decoder_callback cal
 	return 0;
 }
 
+int
+bson_decoder_init_buf_file(bson_decoder_t decoder, int fd, void *buf, unsigned bufsize,
+			   bson_decoder_callback callback, void *private)
+{
+	int32_t	junk;
+
+	/* argument sanity */
+	if ((buf == NULL) || (bufsize == 0)) {
+		return -1;
+	}
+
+	decoder->fd = fd;
+	decoder->buf = (uint8_t *)buf;
+	decoder->bufsize = bufsize;
+	decoder->bufpos = 0;
+	decoder->buflen = 0;
+	decoder->dead = false;
+	decoder->callback = callback;
+	decoder->private = private;
+	decoder->nesting = 1;
+	decoder->pending = 0;
+	decoder->node.type = BSON_UNDEFINED;
+
+	/* read and discard document size */
+	if (read_int32(decoder, &junk)) {
+		CODER_KILL(decoder, "failed discarding length");
+	}
+
+	/* ready for decoding */
+	return 0;
+}
+
 int
 bson_decoder_init_buf(bson_decoder_t decoder, void *buf, unsigned bufsize, bson_decoder_callback callback,
 		      void *private)
@@ -195,6 +264,12 @@ bson_decoder_next(bson_decoder_t decoder)
 		if (decoder->nesting == 0) {
 			/* like kill but not an error */
 			debug("nesting is zero, document is done");
+
+			/* the readahead buffer of a file decoder is not a source on its own */
+			if (decoder->fd > -1) {
+				decoder->buf = NULL;
+			}
+
 			decoder->fd = -1;
 
 			/* return end-of-file to the caller */
@@ -333,13 +408,48 @@ bson_decoder_data_pending(bson_decoder_t decoder)
 	return decoder->pending;
 }
 
+static int
+flush_buffered(bson_encoder_t encoder)
+{
+	if (encoder->bufpos == 0) {
+		return 0;
+	}
+
+	int ret = BSON_WRITE(encoder->fd, encoder->buf, encoder->bufpos);
+
+	if (ret != (int)encoder->bufpos) {
+		return -1;
+	}
+
+	encoder->bufpos = 0;
+	return 0;
+}
+
 static int
 write_x(bson_encoder_t encoder, const void *p, size_t s)
 {
 	CODER_CHECK(encoder);
 
 	if (encoder->fd > -1) {
-		return (BSON_WRITE(encoder->fd, p, s) == (int)s) ? 0 : -1;
+		if (encoder->buf == NULL) {
+			return (BSON_WRITE(encoder->fd, p, s) == (int)s) ? 0 : -1;
+		}
+
+		/* stage writes in the buffer, flushing it as full blocks */
+		if ((encoder->bufpos + s) > encoder->bufsize) {
+			if (flush_buffered(encoder)) {
+				CODER_KILL(encoder, "write error flushing buffer");
+			}
+
+			/* too large to stage, write through */
+			if (s > encoder->bufsize) {
+				return (BSON_WRITE(encoder->fd, p, s) == (int)s) ? 0 : -1;
+			}
+		}
+
+		memcpy(encoder->buf + encoder->bufpos, p, s);
+		encoder->bufpos += s;
+		return 0;
 	}
 
 	/* do we need to extend the buffer? */
@@ -416,6 +526,28 @@ bson_encoder_init_file(bson_encoder_t encoder, int fd)
 	return 0;
 }
 
+int
+bson_encoder_init_buf_file(bson_encoder_t encoder, int fd, void *buf, unsigned bufsize)
+{
+	/* argument sanity */
+	if ((buf == NULL) || (bufsize == 0)) {
+		return -1;
+	}
+
+	encoder->fd = fd;
+	encoder->buf = (uint8_t *)buf;
+	encoder->bufsize = bufsize;
+	encoder->bufpos = 0;
+	encoder->realloc_ok = false;
+	encoder->dead = false;
+
+	if (write_int32(encoder, 0)) {
+		CODER_KILL(encoder, "write error on document length");
+	}
+
+	return 0;
+}
+
 int
 bson_encoder_init_buf(bson_encoder_t encoder, void *buf, unsigned bufsize)
 {
@@ -450,13 +582,17 @@ bson_encoder_fini(bson_encoder_t encoder)
 	}
 
 	/* hack to fix up length for in-buffer documents */
-	if (encoder->buf != NULL) {
+	if ((encoder->fd < 0) && (encoder->buf != NULL)) {
 		int32_t len = bson_encoder_buf_size(encoder);
 		memcpy(encoder->buf, &len, sizeof(len));
 	}
 
-	/* sync file */
+	/* flush the staged data and sync file */
 	if (encoder->fd > -1) {
+		if ((encoder->buf != NULL) && flush_buffered(encoder)) {
+			CODER_KILL(encoder, "write error flushing buffer");
+		}
+
 		BSON_FSYNC(encoder->fd);
 	}
 
@@ -105,10 +105,11 @@ struct bson_decoder_s {
 	/* file reader state */
 	int			fd;
 
-	/* buffer reader state */
+	/* buffer reader state, also the readahead buffer for buffered files */
 	uint8_t			*buf;
 	size_t			bufsize;
 	unsigned		bufpos;
+	unsigned		buflen;		/**< buffered file: valid bytes in buf */
 
 	bool			dead;
 	bson_decoder_callback	callback;
@@ -129,6 +130,23 @@ struct bson_decoder_s {
  */
 __EXPORT int bson_decoder_init_file(bson_decoder_t decoder, int fd, bson_decoder_callback callback, void *private);
 
+/**
+ * Initialise the decoder to read from a file through a readahead buffer.
+ *
+ * The file is read in blocks of bufsize bytes instead of one read per field,
+ * so the file position may be past the end of the document when decoding is done.
+ *
+ * @param decoder		Decoder state structure to be initialised.
+ * @param fd			File to read BSON data from.
+ * @param buf			Readahead buffer, must stay valid while decoding.
+ * @param bufsize		Size of the readahead buffer.
+ * @param callback		Callback to be invoked by bson_decoder_next
+ * @param private		Callback private data, stored in node.
+ * @return			Zero on success.
+ */
+__EXPORT int bson_decoder_init_buf_file(bson_decoder_t decoder, int fd, void *buf, unsigned bufsize,
+					bson_decoder_callback callback, void *private);
+
 /**
  * Initialise the decoder to read from a buffer in memory.
  *
@@ -174,7 +192,7 @@ typedef struct bson_encoder_s {
 	/* file writer state */
 	int		fd;
 
-	/* buffer writer state */
+	/* buffer writer state, also the staging buffer for buffered files */
 	uint8_t		*buf;
 	unsigned	bufsize;
 	unsigned	bufpos;
@@ -193,6 +211,21 @@ typedef struct bson_encoder_s {
  */
 __EXPORT int bson_encoder_init_file(bson_encoder_t encoder, int fd);
 
+/**
+ * Initialze the encoder for writing to a file through a staging buffer.
+ *
+ * The encoded data is collected in the buffer and written whenever it is full,
+ * so a document costs a few block-sized writes instead of one write per field.
+ * The data written is identical to bson_encoder_init_file.
+ *
+ * @param encoder		Encoder state structure to be initialised.
+ * @param fd			File to write to.
+ * @param buf			Staging buffer, must stay valid until bson_encoder_fini.
+ * @param bufsize		Size of the staging buffer.
+ * @return			Zero on success.
+ */
+__EXPORT int bson_encoder_init_buf_file(bson_encoder_t encoder, int fd, void *buf, unsigned bufsize);
+
 /**
  * Initialze the encoder for writing to a buffer.
  *
@@ -93,6 +93,7 @@ void cpuload_initialize_once()
 	for (system_load.total_count = 0; system_load.total_count < static_tasks_count; system_load.total_count++) {
 		system_load.tasks[system_load.total_count].total_runtime = 0;
 		system_load.tasks[system_load.total_count].curr_start_time = 0;
+		system_load.tasks[system_load.total_count].wakeups = 0;
 		system_load.tasks[system_load.total_count].tcb = sched_gettcb(
 					system_load.total_count);	// it is assumed that these static threads have consecutive PIDs
 		system_load.tasks[system_load.total_count].valid = true;
@@ -109,6 +110,7 @@ void sched_note_start(FAR struct tcb_s *tcb)
 			/* slot is available */
 			system_load.tasks[i].total_runtime = 0;
 			system_load.tasks[i].curr_start_time = 0;
+			system_load.tasks[i].wakeups = 0;
 			system_load.tasks[i].tcb = tcb;
 			system_load.tasks[i].valid = true;
 			system_load.total_count++;
@@ -127,6 +129,7 @@ void sched_note_stop(FAR struct tcb_s *tcb)
 			system_load.tasks[i].valid = false;
 			system_load.tasks[i].total_runtime = 0;
 			system_load.tasks[i].curr_start_time = 0;
+			system_load.tasks[i].wakeups = 0;
 			system_load.tasks[i].tcb = NULL;
 			system_load.total_count--;
 			break;
@@ -152,6 +155,7 @@ void sched_note_switch(FAR struct tcb_s *pFromTcb, FAR struct tcb_s *pToTcb)
 
 		} else if (system_load.tasks[i].tcb->pid == pToTcb->pid) {
 			system_load.tasks[i].curr_start_time = new_time;
+			system_load.tasks[i].wakeups++;
 			both_found++;
 		}
 
@@ -43,6 +43,7 @@ __BEGIN_DECLS
 struct system_load_taskinfo_s {
 	uint64_t total_runtime;			///< Runtime since start (start_time - total_runtime)/(start_time - current_time) = load
 	uint64_t curr_start_time;		///< Start time of the current scheduling slot
+	uint32_t wakeups;				///< Number of times the task was scheduled in since start
 #ifdef __PX4_NUTTX
 	FAR struct tcb_s *tcb;			///<
 #endif
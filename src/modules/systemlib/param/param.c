@@ -54,10 +54,13 @@
 #include <systemlib/err.h>
 #include <errno.h>
 #include <semaphore.h>
+#include <pthread.h>
+#include <stddef.h>
 
 #include <sys/stat.h>
 
 #include <drivers/drv_hrt.h>
+#include <px4_workqueue.h>
 
 #include "systemlib/param/param.h"
 #include "systemlib/uthash/utarray.h"
@@ -92,6 +95,24 @@
 #define PARAM_CLOSE	close
 #endif
 
+/**
+ * Size of the staging and readahead buffer used for parameter files, one storage block.
+ * On FMUv4 the bus lock around each encoder and decoder call is a critical section, and flushing
+ * a whole block inside it would keep interrupts off for too long, so every field is
+ * read and written directly there.
+ */
+#if defined (CONFIG_ARCH_BOARD_PX4FMU_V4)
+#define PARAM_BSON_BUFFER_SIZE	0
+#else
+#define PARAM_BSON_BUFFER_SIZE	512
+#endif
+
+/**
+ * Name of the node holding the generation of a snapshot in the parameter file,
+ * ignored by the import like any unknown parameter.
+ */
+#define PARAM_JOURNAL_GENERATION	"_JOURNAL_GEN"
+
 /**
  * Array of static parameter info.
  */
@@ -142,6 +163,12 @@ get_param_info_count(void)
 /** flexible array holding modified parameter values */
 FLASH_PARAMS_EXPOSE UT_array        *param_values;
 
+/**
+ * Index from param_t to the position of its modified value in param_values (+1).
+ * 0 means the parameter has not been modified.
+ */
+static uint16_t *param_values_index = NULL;
+
 /** array info for the modified parameters array */
 FLASH_PARAMS_EXPOSE const UT_icd    param_icd = {sizeof(struct param_wbuf_s), NULL, NULL, NULL};
 
@@ -155,6 +182,29 @@ static void param_set_used_internal(param_t param);
 
 static param_t param_find_internal(const char *name, bool notification);
 
+static int param_export_internal(int fd, bool only_unsaved, int32_t journal_generation);
+
+static int param_import_internal(int fd, bool mark_saved, int32_t *journal_generation);
+
+#if !defined(FLASH_BASED_PARAMS)
+static void param_journal_mark_pending(param_t param);
+
+static void param_journal_invalidate(void);
+
+static bool param_journal_paths(void);
+
+static bool param_journal_supported(void);
+
+static int param_journal_save(void);
+
+static void param_journal_load(int32_t snapshot_generation);
+
+static pthread_mutex_t param_journal_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** parameter file path with PARAM_SNAPSHOT_SUFFIX, only valid while holding param_journal_mutex */
+static char param_snapshot_path[128];
+#endif
+
 /** lock the parameter store */
 static void
 param_lock(void)
@@ -189,28 +239,6 @@ handle_in_range(param_t param)
 	return (count && param < count);
 }
 
-/**
- * Compare two modifid parameter structures to determine ordering.
- *
- * This function is suitable for passing to qsort or bsearch.
- */
-static int
-param_compare_values(const void *a, const void *b)
-{
-	struct param_wbuf_s *pa = (struct param_wbuf_s *)a;
-	struct param_wbuf_s *pb = (struct param_wbuf_s *)b;
-
-	if (pa->param < pb->param) {
-		return -1;
-	}
-
-	if (pa->param > pb->param) {
-		return 1;
-	}
-
-	return 0;
-}
-
 /**
  * Locate the modified parameter structure for a parameter, if it exists.
  *
@@ -225,25 +253,34 @@ param_find_changed(param_t param)
 
 	param_assert_locked();
 
-	if (param_values != NULL) {
-#if 0	/* utarray_find requires bsearch, not available */
-		struct param_wbuf_s key;
-		key.param = param;
-		s = utarray_find(param_values, &key, param_compare_values);
-#else
+	if (param_values != NULL && param_values_index != NULL && handle_in_range(param)) {
+		unsigned index = param_values_index[param];
 
-		while ((s = (struct param_wbuf_s *)utarray_next(param_values, s)) != NULL) {
-			if (s->param == param) {
-				break;
-			}
+		if (index > 0) {
+			s = (struct param_wbuf_s *)utarray_eltptr(param_values, index - 1);
 		}
-
-#endif
 	}
 
 	return s;
 }
 
+/**
+ * Rebuild param_values_index for all entries of param_values starting at position first.
+ * Needed after entries got removed from param_values.
+ */
+static void
+param_values_reindex(unsigned first)
+{
+	struct param_wbuf_s *s;
+
+	param_assert_locked();
+
+	for (unsigned i = first; i < utarray_len(param_values); i++) {
+		s = (struct param_wbuf_s *)utarray_eltptr(param_values, i);
+		param_values_index[s->param] = i + 1;
+	}
+}
+
 static void
 param_notify_changes(bool is_saved)
 {
@@ -267,11 +304,60 @@ param_notify_changes(bool is_saved)
 #endif
 }
 
+#if !defined(_UNIT_TEST)
+/**
+ * 32 bit FNV-1a hash of a parameter name. Must match param_name_hash() in
+ * Tools/px_generate_params.py, which generates the perfect hash tables.
+ */
+static uint32_t
+param_name_hash(const char *name, uint32_t seed)
+{
+	uint32_t hash = 0x811c9dc5u ^ seed;
+
+	while (*name) {
+		hash ^= (uint8_t) * name++;
+		hash *= 0x01000193u;
+	}
+
+	return hash;
+}
+#endif /* _UNIT_TEST */
+
 param_t
 param_find_internal(const char *name, bool notification)
 {
 	param_t param;
 
+#if !defined(_UNIT_TEST)
+	/*
+	 * Constant time lookup in the perfect hash generated at build time: the
+	 * first hash selects a bucket, which either stores the slot directly
+	 * (negative value) or the seed for a second hash resolving its collisions.
+	 */
+	uint32_t bucket = param_name_hash(name, 0) % PX4_PARAMETERS_HASH_SIZE;
+	int32_t displacement = px4_parameters_hash_displacement[bucket];
+	uint32_t slot;
+
+	if (displacement < 0) {
+		slot = -displacement - 1;
+
+	} else {
+		slot = param_name_hash(name, displacement) % PX4_PARAMETERS_HASH_SIZE;
+	}
+
+	param = px4_parameters_hash_index[slot];
+
+	/* names not in the table hash to an arbitrary slot */
+	if (handle_in_range(param) && !strcmp(param_info_base[param].name, name)) {
+		if (notification) {
+			param_set_used_internal(param);
+		}
+
+		return param;
+	}
+
+#else
+
 	/* perform a linear search of the known parameters */
 
 	for (param = 0; handle_in_range(param); param++) {
@@ -284,6 +370,8 @@ param_find_internal(const char *name, bool notification)
 		}
 	}
 
+#endif /* _UNIT_TEST */
+
 	/* not found */
 	return PARAM_INVALID;
 }
@@ -525,7 +613,11 @@ param_set_internal(param_t param, const void *val, bool mark_saved, bool notify_
 		utarray_new(param_values, &param_icd);
 	}
 
-	if (param_values == NULL) {
+	if (param_values_index == NULL) {
+		param_values_index = calloc(get_param_info_count(), sizeof(*param_values_index));
+	}
+
+	if (param_values == NULL || param_values_index == NULL) {
 		debug("failed to allocate modified values array");
 		goto out;
 	}
@@ -543,11 +635,10 @@ param_set_internal(param_t param, const void *val, bool mark_saved, bool notify_
 				.unsaved = false
 			};
 
-			/* add it to the array and sort */
+			/* append it to the array, the index keeps lookups constant time without sorting */
 			utarray_push_back(param_values, &buf);
-			utarray_sort(param_values, param_compare_values);
+			param_values_index[param] = utarray_len(param_values);
 
-			/* find it after sorting */
 			s = param_find_changed(param);
 		}
 
@@ -584,6 +675,14 @@ param_set_internal(param_t param, const void *val, bool mark_saved, bool notify_
 
 		s->unsaved = !mark_saved;
 		result = 0;
+
+#if !defined(FLASH_BASED_PARAMS)
+
+		if (!mark_saved) {
+			param_journal_mark_pending(param);
+		}
+
+#endif
 	}
 
 out:
@@ -673,6 +772,11 @@ param_reset(param_t param)
 		if (s != NULL) {
 			int pos = utarray_eltidx(param_values, s);
 			utarray_erase(param_values, pos, 1);
+			param_values_index[param] = 0;
+			param_values_reindex(pos);
+#if !defined(FLASH_BASED_PARAMS)
+			param_journal_invalidate();
+#endif
 		}
 
 		param_found = true;
@@ -696,9 +800,17 @@ param_reset_all(void)
 		utarray_free(param_values);
 	}
 
+	if (param_values_index != NULL) {
+		memset(param_values_index, 0, get_param_info_count() * sizeof(*param_values_index));
+	}
+
 	/* mark as reset / deleted */
 	param_values = NULL;
 
+#if !defined(FLASH_BASED_PARAMS)
+	param_journal_invalidate();
+#endif
+
 	param_unlock();
 
 	param_notify_changes(false);
@@ -751,6 +863,13 @@ param_set_default_file(const char *filename)
 		param_user_file = strdup(filename);
 	}
 
+#if !defined(FLASH_BASED_PARAMS)
+	/* the journal state belongs to the previous file */
+	pthread_mutex_lock(&param_journal_mutex);
+	param_journal_load(0);
+	pthread_mutex_unlock(&param_journal_mutex);
+#endif
+
 	return 0;
 }
 
@@ -769,6 +888,17 @@ param_save_default(void)
 
 	const char *filename = param_get_default_file();
 
+	pthread_mutex_lock(&param_journal_mutex);
+
+	/* append the changes to the journal, or write a new snapshot */
+	if (param_journal_supported()) {
+		res = param_journal_save();
+		pthread_mutex_unlock(&param_journal_mutex);
+		return res;
+	}
+
+	pthread_mutex_unlock(&param_journal_mutex);
+
 	/* write parameters to temp file */
 	fd = PARAM_OPEN(filename, O_WRONLY | O_CREAT, PX4_O_MODE_666);
 
@@ -806,7 +936,25 @@ param_load_default(void)
 	warnx("param_load_default\n");
 	int fd_load = PARAM_OPEN(param_get_default_file(), O_RDONLY);
 
+#if !defined(FLASH_BASED_PARAMS)
+	pthread_mutex_lock(&param_journal_mutex);
+
+	if (fd_load < 0 && errno == ENOENT && param_journal_paths()) {
+		/* a compaction was interrupted after removing the old file, the new snapshot is complete */
+		fd_load = PARAM_OPEN(param_snapshot_path, O_RDONLY);
+
+		if (fd_load < 0) {
+			errno = ENOENT;
+		}
+	}
+
+#endif
+
 	if (fd_load < 0) {
+#if !defined(FLASH_BASED_PARAMS)
+		pthread_mutex_unlock(&param_journal_mutex);
+#endif
+
 		/* no parameter file is OK, otherwise this is an error */
 		if (errno != ENOENT) {
 			warn("open '%s' for reading failed", param_get_default_file());
@@ -816,9 +964,21 @@ param_load_default(void)
 		return 1;
 	}
 
-	int result = param_load(fd_load);
+	int32_t journal_generation = 0;
+	param_reset_all();
+	int result = param_import_internal(fd_load, true, &journal_generation);
 	PARAM_CLOSE(fd_load);
 
+#if !defined(FLASH_BASED_PARAMS)
+
+	/* apply the changes saved since the snapshot */
+	if (result == 0) {
+		param_journal_load(journal_generation);
+	}
+
+	pthread_mutex_unlock(&param_journal_mutex);
+#endif
+
 	if (result != 0) {
 		warn("error reading parameters from '%s'", param_get_default_file());
 		return -2;
@@ -861,17 +1021,44 @@ param_bus_lock(bool lock)
 
 int
 param_export(int fd, bool only_unsaved)
+{
+	return param_export_internal(fd, only_unsaved, 0);
+}
+
+/**
+ * Export parameters to a file.
+ *
+ * @param journal_generation	If not zero, written as PARAM_JOURNAL_GENERATION node before the parameters.
+ */
+static int
+param_export_internal(int fd, bool only_unsaved, int32_t journal_generation)
 {
 	struct param_wbuf_s *s = NULL;
 	struct bson_encoder_s encoder;
 	int	result = -1;
 
+	/* stage the document in blocks, fall back to writing every field if there is no memory */
+	uint8_t *bson_buf = (PARAM_BSON_BUFFER_SIZE > 0) ? malloc(PARAM_BSON_BUFFER_SIZE) : NULL;
+
 	param_lock();
 
 	param_bus_lock(true);
-	bson_encoder_init_file(&encoder, fd);
+
+	if (bson_buf != NULL) {
+		bson_encoder_init_buf_file(&encoder, fd, bson_buf, PARAM_BSON_BUFFER_SIZE);
+
+	} else {
+		bson_encoder_init_file(&encoder, fd);
+	}
+
 	param_bus_lock(false);
 
+	if (journal_generation != 0 &&
+	    bson_encoder_append_int(&encoder, PARAM_JOURNAL_GENERATION, journal_generation)) {
+		debug("BSON append failed for journal generation");
+		goto out;
+	}
+
 	/* no modified parameters -> we are done */
 	if (param_values == NULL) {
 		result = 0;
@@ -970,11 +1157,14 @@ out:
 		result = bson_encoder_fini(&encoder);
 	}
 
+	free(bson_buf);
+
 	return result;
 }
 
 struct param_import_state {
 	bool mark_saved;
+	int32_t *journal_generation;	/**< receives the snapshot generation, may be NULL */
 };
 
 static int
@@ -995,6 +1185,14 @@ param_import_callback(bson_decoder_t decoder, void *private, bson_node_t node)
 		return 0;
 	}
 
+	if (strcmp(node->name, PARAM_JOURNAL_GENERATION) == 0) {
+		if (node->type == BSON_INT32 && state->journal_generation != NULL) {
+			*state->journal_generation = node->i;
+		}
+
+		return 1;
+	}
+
 	/*
 	 * Find the parameter this node represents.  If we don't know it,
 	 * ignore the node.
@@ -1086,15 +1284,27 @@ out:
 }
 
 static int
-param_import_internal(int fd, bool mark_saved)
+param_import_internal(int fd, bool mark_saved, int32_t *journal_generation)
 {
 	struct bson_decoder_s decoder;
 	int result = -1;
 	struct param_import_state state;
+	int init_result;
+
+	/* read the file in blocks, fall back to reading every field if there is no memory */
+	uint8_t *bson_buf = (PARAM_BSON_BUFFER_SIZE > 0) ? malloc(PARAM_BSON_BUFFER_SIZE) : NULL;
 
 	param_bus_lock(true);
 
-	if (bson_decoder_init_file(&decoder, fd, param_import_callback, &state)) {
+	if (bson_buf != NULL) {
+		init_result = bson_decoder_init_buf_file(&decoder, fd, bson_buf, PARAM_BSON_BUFFER_SIZE,
+				param_import_callback, &state);
+
+	} else {
+		init_result = bson_decoder_init_file(&decoder, fd, param_import_callback, &state);
+	}
+
+	if (init_result) {
 		debug("decoder init failed");
 		param_bus_lock(false);
 		goto out;
@@ -1103,6 +1313,7 @@ param_import_internal(int fd, bool mark_saved)
 	param_bus_lock(false);
 
 	state.mark_saved = mark_saved;
+	state.journal_generation = journal_generation;
 
 	do {
 		param_bus_lock(true);
@@ -1118,21 +1329,461 @@ out:
 		debug("BSON error decoding parameters");
 	}
 
+	free(bson_buf);
+
 	return result;
 }
 
 int
 param_import(int fd)
 {
-	return param_import_internal(fd, false);
+	return param_import_internal(fd, false, NULL);
 }
 
 int
 param_load(int fd)
 {
 	param_reset_all();
-	return param_import_internal(fd, true);
+	return param_import_internal(fd, true, NULL);
+}
+
+#if !defined(FLASH_BASED_PARAMS)
+/*
+ * Parameter journal
+ *
+ * To avoid rewriting the whole parameter file on every save, the file holds a
+ * snapshot of all changed parameters, and the changes since that snapshot are
+ * appended to a journal next to it (<file>.journal). Once the journal has grown
+ * beyond PARAM_JOURNAL_COMPACT_SIZE, it is compacted into a new snapshot on the
+ * low priority work queue.
+ *
+ * The journal starts with a header, followed by records. A record is a complete
+ * BSON document with the parameters saved together, followed by the CRC32 of the
+ * document, so that a record torn by a power loss is detected on load.
+ *
+ * The snapshot is a regular BSON parameter file with an additional
+ * PARAM_JOURNAL_GENERATION node. The journal header holds the generation of the
+ * snapshot it belongs to, so a journal left behind by an interrupted compaction
+ * is never applied to the newer snapshot. A new snapshot is written to
+ * <file>.tmp first and then renamed over the parameter file.
+ *
+ * Journaling needs regular files. A parameter file on a raw device (e.g. the
+ * FRAM partition) is rewritten completely on every save, as before.
+ */
+
+#define PARAM_JOURNAL_SUFFIX		".journal"
+#define PARAM_SNAPSHOT_SUFFIX		".tmp"
+#define PARAM_JOURNAL_MAGIC		0x4c4e4a50	/* "PJNL" */
+#define PARAM_JOURNAL_RECORD_MAX	1024		/**< larger sets of changes are saved as a snapshot */
+#define PARAM_JOURNAL_COMPACT_SIZE	4096		/**< journal size [bytes] that triggers a compaction */
+
+struct param_journal_header_s {
+	uint32_t	magic;
+	int32_t		generation;	/**< generation of the snapshot the journal belongs to */
+	uint32_t	crc;		/**< CRC32 of the fields above */
+};
+
+/** parameter file path with PARAM_JOURNAL_SUFFIX, only valid while holding param_journal_mutex */
+static char param_journal_path[sizeof(param_snapshot_path)];
+
+/** bitmap of the parameters changed since they were last saved */
+static uint8_t *param_journal_pending = NULL;
+
+/** generation of the snapshot in the parameter file, 0 if it has none */
+static int32_t param_journal_generation = 0;
+
+/** size of the journal file [bytes], 0 if it does not exist yet */
+static unsigned param_journal_size = 0;
+
+/** the journal cannot record removed values, so the next save has to write a snapshot */
+static bool param_journal_snapshot_needed = true;
+
+static bool param_journal_compact_scheduled = false;
+static struct work_s param_journal_work;
+
+static void
+param_journal_mark_pending(param_t param)
+{
+	if (param_journal_pending == NULL) {
+		param_journal_pending = calloc(get_param_info_count() / 8 + 1, 1);
+
+		if (param_journal_pending == NULL) {
+			param_journal_snapshot_needed = true;
+			return;
+		}
+	}
+
+	param_journal_pending[param / 8] |= (1 << (param % 8));
+}
+
+static void
+param_journal_invalidate(void)
+{
+	param_journal_snapshot_needed = true;
+}
+
+/**
+ * Update the journal and snapshot paths for the current parameter file.
+ * @return false if the path is too long for journaling
+ */
+static bool
+param_journal_paths(void)
+{
+	const char *filename = param_get_default_file();
+
+	return snprintf(param_journal_path, sizeof(param_journal_path), "%s%s", filename,
+			PARAM_JOURNAL_SUFFIX) < (int)sizeof(param_journal_path) &&
+	       snprintf(param_snapshot_path, sizeof(param_snapshot_path), "%s%s", filename,
+			PARAM_SNAPSHOT_SUFFIX) < (int)sizeof(param_snapshot_path);
+}
+
+/**
+ * @return true if the parameter file is a regular file (or does not exist yet), so files
+ * can be created next to it.
+ */
+static bool
+param_journal_supported(void)
+{
+	struct stat st;
+
+	if (stat(param_get_default_file(), &st) != 0) {
+		return (errno == ENOENT) && param_journal_paths();
+	}
+
+	return S_ISREG(st.st_mode) && param_journal_paths();
+}
+
+static int
+param_journal_encode(bson_encoder_t encoder, param_t param)
+{
+	const char *name = param_name(param);
+	const void *v = param_get_value_ptr(param);
+
+	switch (param_type(param)) {
+	case PARAM_TYPE_INT32:
+		return bson_encoder_append_int(encoder, name, *(const int32_t *)v);
+
+	case PARAM_TYPE_FLOAT:
+		return bson_encoder_append_double(encoder, name, *(const float *)v);
+
+	case PARAM_TYPE_STRUCT ... PARAM_TYPE_STRUCT_MAX:
+		return bson_encoder_append_binary(encoder, name, BSON_BIN_BINARY, param_size(param), v);
+
+	default:
+		return -1;
+	}
+}
+
+/**
+ * Append the pending changes to the journal as one record.
+ * @return 0 on success, -1 if the changes have to be saved in a snapshot instead
+ */
+static int
+param_journal_append(void)
+{
+	struct bson_encoder_s encoder;
+	unsigned count = 0;
+	bool encoded = true;
+	int result = -1;
+
+	/* the record and its CRC */
+	uint8_t *buf = malloc(PARAM_JOURNAL_RECORD_MAX + sizeof(uint32_t));
+
+	if (buf == NULL) {
+		return -1;
+	}
+
+	bson_encoder_init_buf(&encoder, buf, PARAM_JOURNAL_RECORD_MAX);
+
+	/* the pending bits are set and the values changed with the store locked */
+	param_lock();
+
+	for (param_t param = 0; param_journal_pending != NULL && handle_in_range(param); param++) {
+		uint8_t mask = (1 << (param % 8));
+
+		if (!(param_journal_pending[param / 8] & mask)) {
+			continue;
+		}
+
+		param_journal_pending[param / 8] &= ~mask;
+
+		if (param_journal_encode(&encoder, param)) {
+			/* too many changes for a record */
+			encoded = false;
+			break;
+		}
+
+		count++;
+	}
+
+	param_unlock();
+
+	if (!encoded) {
+		goto out;
+	}
+
+	if (count == 0) {
+		result = 0;
+		goto out;
+	}
+
+	if (bson_encoder_fini(&encoder)) {
+		goto out;
+	}
+
+	int len = bson_encoder_buf_size(&encoder);
+	uint32_t crc = crc32part(buf, len, 0);
+	memcpy(buf + len, &crc, sizeof(crc));
+	len += sizeof(crc);
+
+	int fd;
+
+	if (param_journal_size == 0) {
+		struct param_journal_header_s header = {
+			.magic = PARAM_JOURNAL_MAGIC,
+			.generation = param_journal_generation
+		};
+		header.crc = crc32part((const uint8_t *)&header, offsetof(struct param_journal_header_s, crc), 0);
+
+		fd = PARAM_OPEN(param_journal_path, O_WRONLY | O_CREAT | O_TRUNC, PX4_O_MODE_666);
+
+		if (fd < 0 || write(fd, &header, sizeof(header)) != sizeof(header)) {
+			goto out_close;
+		}
+
+		param_journal_size = sizeof(header);
+
+	} else {
+		fd = PARAM_OPEN(param_journal_path, O_WRONLY | O_APPEND);
+	}
+
+	if (fd >= 0 && write(fd, buf, len) == len && fsync(fd) == 0) {
+		param_journal_size += len;
+		result = 0;
+	}
+
+out_close:
+
+	if (fd >= 0) {
+		PARAM_CLOSE(fd);
+	}
+
+out:
+	free(buf);
+	return result;
+}
+
+/**
+ * Write all changed parameters to a new snapshot and start a new journal.
+ */
+static int
+param_journal_snapshot(void)
+{
+	const char *filename = param_get_default_file();
+
+	/* any new generation will do, as long as it differs from the previous one */
+	hrt_abstime now = hrt_absolute_time();
+	int32_t generation = crc32part((const uint8_t *)&now, sizeof(now), param_journal_generation) & 0x7fffffff;
+
+	if (generation == 0 || generation == param_journal_generation) {
+		generation = (param_journal_generation % 0x7fffffff) + 1;
+	}
+
+	int fd = PARAM_OPEN(param_snapshot_path, O_WRONLY | O_CREAT | O_TRUNC, PX4_O_MODE_666);
+
+	if (fd < 0) {
+		warn("failed to open param file: %s", param_snapshot_path);
+		param_journal_snapshot_needed = true;
+		return ERROR;
+	}
+
+	/* the snapshot contains everything changed so far, later changes go into the journal */
+	param_lock();
+
+	if (param_journal_pending != NULL) {
+		memset(param_journal_pending, 0, get_param_info_count() / 8 + 1);
+	}
+
+	param_unlock();
+
+	param_journal_snapshot_needed = false;
+
+	int res = param_export_internal(fd, false, generation);
+	PARAM_CLOSE(fd);
+
+	/* not all file systems replace an existing file on rename */
+	if (res == OK && rename(param_snapshot_path, filename) != 0) {
+		unlink(filename);
+
+		if (rename(param_snapshot_path, filename) != 0) {
+			res = ERROR;
+		}
+	}
+
+	if (res != OK) {
+		warnx("failed to write parameters to file: %s", filename);
+		param_journal_snapshot_needed = true;
+		return ERROR;
+	}
+
+	/* the old journal belongs to the previous snapshot */
+	unlink(param_journal_path);
+	param_journal_generation = generation;
+	param_journal_size = 0;
+
+	return OK;
+}
+
+static void
+param_journal_compact(void *arg)
+{
+	pthread_mutex_lock(&param_journal_mutex);
+
+	param_journal_compact_scheduled = false;
+
+	/* a save might have written a snapshot in the meantime */
+	if (param_journal_size > PARAM_JOURNAL_COMPACT_SIZE && param_journal_supported()) {
+		param_journal_snapshot();
+	}
+
+	pthread_mutex_unlock(&param_journal_mutex);
+}
+
+/**
+ * Save the changed parameters, called with param_journal_mutex held.
+ */
+static int
+param_journal_save(void)
+{
+	if (!param_journal_snapshot_needed && param_journal_generation != 0 &&
+	    param_journal_append() == 0) {
+
+		/* compact on the work queue, so the caller does not wait for it */
+		if (param_journal_size > PARAM_JOURNAL_COMPACT_SIZE && !param_journal_compact_scheduled) {
+			param_journal_compact_scheduled = true;
+			work_queue(LPWORK, &param_journal_work, param_journal_compact, NULL, 0);
+		}
+
+		return OK;
+	}
+
+	return param_journal_snapshot();
+}
+
+/**
+ * Apply the journal of the loaded snapshot, called with param_journal_mutex held.
+ *
+ * @param snapshot_generation	Generation of the loaded snapshot, 0 if it has none
+ *				or no snapshot was loaded.
+ */
+static void
+param_journal_load(int32_t snapshot_generation)
+{
+	struct param_journal_header_s header;
+	struct param_import_state state = {
+		.mark_saved = true,
+		.journal_generation = NULL
+	};
+	unsigned records = 0;
+	uint8_t *buf = NULL;
+	int fd = -1;
+
+	param_lock();
+
+	if (param_journal_pending != NULL) {
+		memset(param_journal_pending, 0, get_param_info_count() / 8 + 1);
+	}
+
+	param_unlock();
+
+	param_journal_generation = snapshot_generation;
+	param_journal_size = 0;
+
+	/* snapshots without generation, e.g. written by an older version, are replaced on the next save */
+	param_journal_snapshot_needed = (snapshot_generation == 0);
+
+	if (snapshot_generation == 0 || !param_journal_supported()) {
+		return;
+	}
+
+	fd = PARAM_OPEN(param_journal_path, O_RDONLY);
+
+	if (fd < 0) {
+		/* no changes since the snapshot */
+		return;
+	}
+
+	if (read(fd, &header, sizeof(header)) != sizeof(header) ||
+	    header.magic != PARAM_JOURNAL_MAGIC ||
+	    header.crc != crc32part((const uint8_t *)&header, offsetof(struct param_journal_header_s, crc), 0) ||
+	    header.generation != snapshot_generation) {
+		/* left behind by an interrupted compaction or save */
+		param_journal_snapshot_needed = true;
+		goto out;
+	}
+
+	param_journal_size = sizeof(header);
+	buf = malloc(PARAM_JOURNAL_RECORD_MAX + sizeof(uint32_t));
+
+	if (buf == NULL) {
+		param_journal_snapshot_needed = true;
+		goto out;
+	}
+
+	for (;;) {
+		struct bson_decoder_s decoder;
+		int32_t len;
+		uint32_t crc;
+		int ret = read(fd, buf, sizeof(len));
+
+		if (ret == 0) {
+			/* end of the journal */
+			break;
+		}
+
+		/* a record consists of the BSON document, starting with its length, and the CRC */
+		memcpy(&len, buf, sizeof(len));
+
+		if (ret != sizeof(len) || len <= (int32_t)sizeof(len) || len > PARAM_JOURNAL_RECORD_MAX ||
+		    read(fd, buf + sizeof(len), len) != len) {
+			warnx("parameter journal: ignoring incomplete record");
+			param_journal_snapshot_needed = true;
+			break;
+		}
+
+		memcpy(&crc, buf + len, sizeof(crc));
+
+		if (crc != crc32part(buf, len, 0)) {
+			warnx("parameter journal: ignoring corrupt record");
+			param_journal_snapshot_needed = true;
+			break;
+		}
+
+		if (bson_decoder_init_buf(&decoder, buf, len, param_import_callback, &state)) {
+			param_journal_snapshot_needed = true;
+			break;
+		}
+
+		do {
+			ret = bson_decoder_next(&decoder);
+		} while (ret > 0);
+
+		if (ret < 0) {
+			param_journal_snapshot_needed = true;
+			break;
+		}
+
+		param_journal_size += len + sizeof(crc);
+		records++;
+	}
+
+	debug("applied %u journal records", records);
+
+out:
+	free(buf);
+	PARAM_CLOSE(fd);
 }
+#endif /* FLASH_BASED_PARAMS */
 
 void
 param_foreach(void (*func)(void *arg, param_t param), void *arg, bool only_changed, bool only_used)
@@ -335,14 +335,16 @@ __EXPORT const char	*param_get_default_file(void);
 /**
  * Save parameters to the default file.
  *
- * This function saves all parameters with non-default values.
+ * This function saves all parameters with non-default values. If the default file
+ * is a regular file, only the parameters changed since the last save are appended
+ * to a journal next to it, which is compacted into the file in the background.
  *
  * @return		Zero on success.
  */
 __EXPORT int 		param_save_default(void);
 
 /**
- * Load parameters from the default parameter file.
+ * Load parameters from the default parameter file, including its journal.
  *
  * @return		Zero on success.
  */
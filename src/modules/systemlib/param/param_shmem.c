@@ -79,6 +79,11 @@
 #endif
 #define PARAM_CLOSE	close
 
+/**
+ * Size of the staging and readahead buffer used for parameter files, one storage block.
+ */
+#define PARAM_BSON_BUFFER_SIZE	512
+
 /**
  * Array of static parameter info.
  */
@@ -944,9 +949,17 @@ param_export(int fd, bool only_unsaved)
 	struct bson_encoder_s encoder;
 	int	result = -1;
 
+	/* stage the document in blocks, fall back to writing every field if there is no memory */
+	uint8_t *bson_buf = malloc(PARAM_BSON_BUFFER_SIZE);
+
 	param_lock();
 
-	bson_encoder_init_file(&encoder, fd);
+	if (bson_buf != NULL) {
+		bson_encoder_init_buf_file(&encoder, fd, bson_buf, PARAM_BSON_BUFFER_SIZE);
+
+	} else {
+		bson_encoder_init_file(&encoder, fd);
+	}
 
 	/* no modified parameters -> we are done */
 	if (param_values == NULL) {
@@ -1027,6 +1040,8 @@ out:
 		result = bson_encoder_fini(&encoder);
 	}
 
+	free(bson_buf);
+
 	return result;
 }
 
@@ -1150,8 +1165,20 @@ param_import_internal(int fd, bool mark_saved)
 	struct bson_decoder_s decoder;
 	int result = -1;
 	struct param_import_state state;
+	int init_result;
+
+	/* read the file in blocks, fall back to reading every field if there is no memory */
+	uint8_t *bson_buf = malloc(PARAM_BSON_BUFFER_SIZE);
 
-	if (bson_decoder_init_file(&decoder, fd, param_import_callback, &state)) {
+	if (bson_buf != NULL) {
+		init_result = bson_decoder_init_buf_file(&decoder, fd, bson_buf, PARAM_BSON_BUFFER_SIZE,
+				param_import_callback, &state);
+
+	} else {
+		init_result = bson_decoder_init_file(&decoder, fd, param_import_callback, &state);
+	}
+
+	if (init_result) {
 		PX4_DEBUG("decoder init failed");
 		goto out;
 	}
@@ -1169,6 +1196,8 @@ out:
 		PX4_DEBUG("BSON error decoding parameters");
 	}
 
+	free(bson_buf);
+
 	return result;
 }
 
@@ -40,6 +40,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
 #include <sys/queue.h>
 #include <drivers/drv_hrt.h>
 #include <math.h>
@@ -97,14 +98,62 @@ struct perf_ctr_interval {
 	float			M2;
 };
 
+/**
+ * PC_HISTOGRAM buckets: values below PERF_HISTOGRAM_SUB_BUCKETS have a bucket each,
+ * every power of two above is split into PERF_HISTOGRAM_SUB_BUCKETS linear buckets
+ * (log-linear, at most 12.5% wide). Values from 2^PERF_HISTOGRAM_MAX_BITS us (~1s)
+ * on go into the last bucket.
+ */
+#define PERF_HISTOGRAM_SUB_BITS		3
+#define PERF_HISTOGRAM_SUB_BUCKETS	(1 << PERF_HISTOGRAM_SUB_BITS)
+#define PERF_HISTOGRAM_MAX_BITS		20
+#define PERF_HISTOGRAM_BUCKETS		((PERF_HISTOGRAM_MAX_BITS - PERF_HISTOGRAM_SUB_BITS + 1) * PERF_HISTOGRAM_SUB_BUCKETS + 1)
+
+/**
+ * Number of threads that can update a PC_HISTOGRAM counter. Each one gets its own
+ * shard, so updates need no locking; the shards are merged when reading. Events of
+ * further threads are counted as dropped (a lock would not be usable from interrupts).
+ */
+#define PERF_HISTOGRAM_SHARDS		2
+
+/**
+ * PC_HISTOGRAM shard, only updated by the thread owning it.
+ */
+struct perf_histogram_shard {
+	uintptr_t		owner;		/**< owning thread, 0 if unused */
+	uint64_t		event_count;
+	uint64_t		event_overruns;
+	uint64_t		time_start;
+	uint64_t		time_total;
+	uint64_t		time_least;
+	uint64_t		time_most;
+	uint32_t		buckets[PERF_HISTOGRAM_BUCKETS];
+};
+
+/**
+ * PC_HISTOGRAM counter.
+ */
+struct perf_ctr_histogram {
+	struct perf_ctr_header	hdr;
+	uint32_t		event_dropped;	/**< completed events from threads without a shard */
+	struct perf_histogram_shard shards[PERF_HISTOGRAM_SHARDS];
+};
+
 /**
  * List of all known counters.
  */
 static sq_queue_t	perf_counters;
 
+/**
+ * Protects perf_counters, counters are allocated and freed by any thread.
+ */
+static pthread_mutex_t	perf_counters_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-perf_counter_t
-perf_alloc(enum perf_counter_type type, const char *name)
+/**
+ * Allocate a counter without adding it to the list.
+ */
+static perf_counter_t
+perf_counter_create(enum perf_counter_type type, const char *name)
 {
 	perf_counter_t ctr = NULL;
 
@@ -122,6 +171,10 @@ perf_alloc(enum perf_counter_type type, const char *name)
 
 		break;
 
+	case PC_HISTOGRAM:
+		ctr = (perf_counter_t)calloc(sizeof(struct perf_ctr_histogram), 1);
+		break;
+
 	default:
 		break;
 	}
@@ -129,7 +182,20 @@ perf_alloc(enum perf_counter_type type, const char *name)
 	if (ctr != NULL) {
 		ctr->type = type;
 		ctr->name = name;
+	}
+
+	return ctr;
+}
+
+perf_counter_t
+perf_alloc(enum perf_counter_type type, const char *name)
+{
+	perf_counter_t ctr = perf_counter_create(type, name);
+
+	if (ctr != NULL) {
+		pthread_mutex_lock(&perf_counters_mutex);
 		sq_addfirst(&ctr->link, &perf_counters);
+		pthread_mutex_unlock(&perf_counters_mutex);
 	}
 
 	return ctr;
@@ -138,25 +204,35 @@ perf_alloc(enum perf_counter_type type, const char *name)
 perf_counter_t
 perf_alloc_once(enum perf_counter_type type, const char *name)
 {
+	pthread_mutex_lock(&perf_counters_mutex);
+
 	perf_counter_t handle = (perf_counter_t)sq_peek(&perf_counters);
 
 	while (handle != NULL) {
 		if (!strcmp(handle->name, name)) {
-			if (type == handle->type) {
-				/* they are the same counter */
-				return handle;
-
-			} else {
+			if (type != handle->type) {
 				/* same name but different type, assuming this is an error and not intended */
-				return NULL;
+				handle = NULL;
 			}
+
+			/* otherwise they are the same counter */
+			pthread_mutex_unlock(&perf_counters_mutex);
+			return handle;
 		}
 
 		handle = (perf_counter_t)sq_next(&handle->link);
 	}
 
 	/* if the execution reaches here, no existing counter of that name was found */
-	return perf_alloc(type, name);
+	handle = perf_counter_create(type, name);
+
+	if (handle != NULL) {
+		sq_addfirst(&handle->link, &perf_counters);
+	}
+
+	pthread_mutex_unlock(&perf_counters_mutex);
+
+	return handle;
 }
 
 void
@@ -166,10 +242,128 @@ perf_free(perf_counter_t handle)
 		return;
 	}
 
+	pthread_mutex_lock(&perf_counters_mutex);
 	sq_rem(&handle->link, &perf_counters);
+	pthread_mutex_unlock(&perf_counters_mutex);
+
 	free(handle);
 }
 
+/**
+ * Get the shard of the calling thread, claiming a free one on first use.
+ * @return shard, or NULL if all shards are owned by other threads
+ */
+static struct perf_histogram_shard *
+perf_histogram_shard(struct perf_ctr_histogram *pch)
+{
+	/* +1: 0 marks an unused shard */
+	uintptr_t self = (uintptr_t)pthread_self() + 1;
+
+	for (int i = 0; i < PERF_HISTOGRAM_SHARDS; i++) {
+		if (pch->shards[i].owner == self) {
+			return &pch->shards[i];
+		}
+	}
+
+	for (int i = 0; i < PERF_HISTOGRAM_SHARDS; i++) {
+		if (pch->shards[i].owner == 0 && __sync_bool_compare_and_swap(&pch->shards[i].owner, 0, self)) {
+			return &pch->shards[i];
+		}
+	}
+
+	return NULL;
+}
+
+static unsigned
+perf_histogram_bucket(uint64_t value)
+{
+	if (value < PERF_HISTOGRAM_SUB_BUCKETS) {
+		return value;
+	}
+
+	if (value >= (1 << PERF_HISTOGRAM_MAX_BITS)) {
+		return PERF_HISTOGRAM_BUCKETS - 1;
+	}
+
+	/* index of the highest bit, then the next PERF_HISTOGRAM_SUB_BITS bits select the sub-bucket */
+	unsigned msb = 31 - __builtin_clz((uint32_t)value);
+
+	return (msb - PERF_HISTOGRAM_SUB_BITS + 1) * PERF_HISTOGRAM_SUB_BUCKETS +
+	       ((value >> (msb - PERF_HISTOGRAM_SUB_BITS)) & (PERF_HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+/**
+ * Largest value of a bucket (except for the last one, which is unbounded).
+ */
+static uint64_t
+perf_histogram_bucket_max(unsigned bucket)
+{
+	if (bucket < PERF_HISTOGRAM_SUB_BUCKETS) {
+		return bucket;
+	}
+
+	unsigned octave = bucket / PERF_HISTOGRAM_SUB_BUCKETS;
+	unsigned sub = bucket % PERF_HISTOGRAM_SUB_BUCKETS;
+
+	return ((uint64_t)(PERF_HISTOGRAM_SUB_BUCKETS + sub + 1) << (octave - 1)) - 1;
+}
+
+static void
+perf_histogram_record(struct perf_histogram_shard *shard, int64_t elapsed)
+{
+	if (elapsed < 0) {
+		shard->event_overruns++;
+		return;
+	}
+
+	shard->event_count++;
+	shard->time_total += elapsed;
+
+	if ((shard->time_least > (uint64_t)elapsed) || (shard->time_least == 0)) {
+		shard->time_least = elapsed;
+	}
+
+	if (shard->time_most < (uint64_t)elapsed) {
+		shard->time_most = elapsed;
+	}
+
+	shard->buckets[perf_histogram_bucket(elapsed)]++;
+}
+
+/**
+ * Merge the statistics of all shards of a PC_HISTOGRAM counter.
+ */
+static void
+perf_histogram_merge(const struct perf_ctr_histogram *pch, uint64_t *event_count, uint64_t *event_overruns,
+		     uint64_t *time_total, uint64_t *time_least, uint64_t *time_most)
+{
+	*event_count = 0;
+	*event_overruns = 0;
+	*time_total = 0;
+	*time_least = 0;
+	*time_most = 0;
+
+	for (int i = 0; i < PERF_HISTOGRAM_SHARDS; i++) {
+		const struct perf_histogram_shard *shard = &pch->shards[i];
+		*event_overruns += shard->event_overruns;
+
+		if (shard->event_count == 0) {
+			continue;
+		}
+
+		*event_count += shard->event_count;
+		*time_total += shard->time_total;
+
+		if ((*time_least > shard->time_least) || (*time_least == 0)) {
+			*time_least = shard->time_least;
+		}
+
+		if (*time_most < shard->time_most) {
+			*time_most = shard->time_most;
+		}
+	}
+}
+
 void
 perf_count(perf_counter_t handle)
 {
@@ -241,6 +435,16 @@ perf_begin(perf_counter_t handle)
 		((struct perf_ctr_elapsed *)handle)->time_start = hrt_absolute_time();
 		break;
 
+	case PC_HISTOGRAM: {
+			struct perf_histogram_shard *shard = perf_histogram_shard((struct perf_ctr_histogram *)handle);
+
+			if (shard != NULL) {
+				shard->time_start = hrt_absolute_time();
+			}
+
+			break;
+		}
+
 	default:
 		break;
 	}
@@ -289,6 +493,20 @@ perf_end(perf_counter_t handle)
 		}
 		break;
 
+	case PC_HISTOGRAM: {
+			struct perf_ctr_histogram *pch = (struct perf_ctr_histogram *)handle;
+			struct perf_histogram_shard *shard = perf_histogram_shard(pch);
+
+			if (shard == NULL) {
+				__sync_fetch_and_add(&pch->event_dropped, 1);
+
+			} else if (shard->time_start != 0) {
+				perf_histogram_record(shard, hrt_absolute_time() - shard->time_start);
+				shard->time_start = 0;
+			}
+		}
+		break;
+
 	default:
 		break;
 	}
@@ -335,6 +553,20 @@ perf_set_elapsed(perf_counter_t handle, int64_t elapsed)
 		}
 		break;
 
+	case PC_HISTOGRAM: {
+			struct perf_ctr_histogram *pch = (struct perf_ctr_histogram *)handle;
+			struct perf_histogram_shard *shard = perf_histogram_shard(pch);
+
+			if (shard == NULL) {
+				__sync_fetch_and_add(&pch->event_dropped, 1);
+
+			} else {
+				perf_histogram_record(shard, elapsed);
+				shard->time_start = 0;
+			}
+		}
+		break;
+
 	default:
 		break;
 	}
@@ -374,6 +606,15 @@ perf_cancel(perf_counter_t handle)
 		}
 		break;
 
+	case PC_HISTOGRAM: {
+			struct perf_histogram_shard *shard = perf_histogram_shard((struct perf_ctr_histogram *)handle);
+
+			if (shard != NULL) {
+				shard->time_start = 0;
+			}
+		}
+		break;
+
 	default:
 		break;
 	}
@@ -413,6 +654,20 @@ perf_reset(perf_counter_t handle)
 			pci->time_most = 0;
 			break;
 		}
+
+	case PC_HISTOGRAM: {
+			struct perf_ctr_histogram *pch = (struct perf_ctr_histogram *)handle;
+			pch->event_dropped = 0;
+
+			/* keep the shards assigned to their threads */
+			for (int i = 0; i < PERF_HISTOGRAM_SHARDS; i++) {
+				uintptr_t owner = pch->shards[i].owner;
+				memset(&pch->shards[i], 0, sizeof(pch->shards[i]));
+				pch->shards[i].owner = owner;
+			}
+
+			break;
+		}
 	}
 }
 
@@ -469,11 +724,91 @@ perf_print_counter_fd(int fd, perf_counter_t handle)
 			break;
 		}
 
+	case PC_HISTOGRAM: {
+			struct perf_ctr_histogram *pch = (struct perf_ctr_histogram *)handle;
+			uint64_t event_count;
+			uint64_t event_overruns;
+			uint64_t time_total;
+			uint64_t time_least;
+			uint64_t time_most;
+
+			perf_histogram_merge(pch, &event_count, &event_overruns, &time_total, &time_least, &time_most);
+
+			dprintf(fd, "%s: %llu events, %llu overruns, %lluus avg, min %lluus max %lluus, "
+				"p50 %lluus p90 %lluus p99 %lluus p99.9 %lluus\n",
+				handle->name,
+				(unsigned long long)event_count,
+				(unsigned long long)event_overruns,
+				(event_count == 0) ? 0 : (unsigned long long)time_total / event_count,
+				(unsigned long long)time_least,
+				(unsigned long long)time_most,
+				(unsigned long long)perf_percentile(handle, 0.5f),
+				(unsigned long long)perf_percentile(handle, 0.9f),
+				(unsigned long long)perf_percentile(handle, 0.99f),
+				(unsigned long long)perf_percentile(handle, 0.999f));
+
+			if (pch->event_dropped > 0) {
+				dprintf(fd, "%s: %u events dropped (more than %i threads)\n",
+					handle->name, (unsigned)pch->event_dropped, PERF_HISTOGRAM_SHARDS);
+			}
+
+			break;
+		}
+
 	default:
 		break;
 	}
 }
 
+uint64_t
+perf_percentile(perf_counter_t handle, float percentile)
+{
+	if (handle == NULL || handle->type != PC_HISTOGRAM) {
+		return 0;
+	}
+
+	struct perf_ctr_histogram *pch = (struct perf_ctr_histogram *)handle;
+	uint64_t total = 0;
+	uint64_t time_most = 0;
+
+	for (int i = 0; i < PERF_HISTOGRAM_SHARDS; i++) {
+		for (int b = 0; b < PERF_HISTOGRAM_BUCKETS; b++) {
+			total += pch->shards[i].buckets[b];
+		}
+
+		if (time_most < pch->shards[i].time_most) {
+			time_most = pch->shards[i].time_most;
+		}
+	}
+
+	if (total == 0) {
+		return 0;
+	}
+
+	/* rank of the event at the percentile, starting at 1 */
+	uint64_t rank = (uint64_t)ceilf(percentile * total);
+
+	if (rank < 1) {
+		rank = 1;
+	}
+
+	uint64_t count = 0;
+
+	for (int b = 0; b < PERF_HISTOGRAM_BUCKETS - 1; b++) {
+		for (int i = 0; i < PERF_HISTOGRAM_SHARDS; i++) {
+			count += pch->shards[i].buckets[b];
+		}
+
+		if (count >= rank) {
+			uint64_t value = perf_histogram_bucket_max(b);
+			return (value < time_most) ? value : time_most;
+		}
+	}
+
+	/* the last bucket is unbounded */
+	return time_most;
+}
+
 uint64_t
 perf_event_count(perf_counter_t handle)
 {
@@ -495,6 +830,17 @@ perf_event_count(perf_counter_t handle)
 			return pci->event_count;
 		}
 
+	case PC_HISTOGRAM: {
+			struct perf_ctr_histogram *pch = (struct perf_ctr_histogram *)handle;
+			uint64_t event_count = 0;
+
+			for (int i = 0; i < PERF_HISTOGRAM_SHARDS; i++) {
+				event_count += pch->shards[i].event_count;
+			}
+
+			return event_count;
+		}
+
 	default:
 		break;
 	}
@@ -502,15 +848,85 @@ perf_event_count(perf_counter_t handle)
 	return 0;
 }
 
+void
+perf_get_summary(perf_counter_t handle, struct perf_counter_summary *summary)
+{
+	memset(summary, 0, sizeof(*summary));
+
+	if (handle == NULL) {
+		return;
+	}
+
+	summary->name = handle->name;
+	summary->type = handle->type;
+
+	switch (handle->type) {
+	case PC_COUNT:
+		summary->event_count = ((struct perf_ctr_count *)handle)->event_count;
+		break;
+
+	case PC_ELAPSED: {
+			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
+			summary->event_count = pce->event_count;
+			summary->event_overruns = pce->event_overruns;
+			summary->time_avg = (pce->event_count == 0) ? 0 : pce->time_total / pce->event_count;
+			summary->time_max = pce->time_most;
+			break;
+		}
+
+	case PC_INTERVAL: {
+			struct perf_ctr_interval *pci = (struct perf_ctr_interval *)handle;
+			summary->event_count = pci->event_count;
+			summary->time_avg = (pci->event_count == 0) ? 0 : (pci->time_last - pci->time_first) / pci->event_count;
+			summary->time_max = pci->time_most;
+			break;
+		}
+
+	case PC_HISTOGRAM: {
+			struct perf_ctr_histogram *pch = (struct perf_ctr_histogram *)handle;
+			uint64_t time_total;
+			uint64_t time_least;
+
+			perf_histogram_merge(pch, &summary->event_count, &summary->event_overruns, &time_total, &time_least,
+					     &summary->time_max);
+			summary->time_avg = (summary->event_count == 0) ? 0 : time_total / summary->event_count;
+			summary->time_p99 = perf_percentile(handle, 0.99f);
+			break;
+		}
+
+	default:
+		break;
+	}
+}
+
+void
+perf_iterate_all(perf_callback cb, void *user)
+{
+	pthread_mutex_lock(&perf_counters_mutex);
+
+	perf_counter_t handle = (perf_counter_t)sq_peek(&perf_counters);
+
+	while (handle != NULL) {
+		cb(handle, user);
+		handle = (perf_counter_t)sq_next(&handle->link);
+	}
+
+	pthread_mutex_unlock(&perf_counters_mutex);
+}
+
 void
 perf_print_all(int fd)
 {
+	pthread_mutex_lock(&perf_counters_mutex);
+
 	perf_counter_t handle = (perf_counter_t)sq_peek(&perf_counters);
 
 	while (handle != NULL) {
 		perf_print_counter_fd(fd, handle);
 		handle = (perf_counter_t)sq_next(&handle->link);
 	}
+
+	pthread_mutex_unlock(&perf_counters_mutex);
 }
 
 extern const uint16_t latency_bucket_count;
@@ -533,6 +949,8 @@ perf_print_latency(int fd)
 void
 perf_reset_all(void)
 {
+	pthread_mutex_lock(&perf_counters_mutex);
+
 	perf_counter_t handle = (perf_counter_t)sq_peek(&perf_counters);
 
 	while (handle != NULL) {
@@ -540,6 +958,8 @@ perf_reset_all(void)
 		handle = (perf_counter_t)sq_next(&handle->link);
 	}
 
+	pthread_mutex_unlock(&perf_counters_mutex);
+
 	for (int i = 0; i <= latency_bucket_count; i++) {
 		latency_counters[i] = 0;
 	}
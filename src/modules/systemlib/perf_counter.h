@@ -44,16 +44,44 @@
 
 /**
  * Counter types.
+ *
+ * Counters other than PC_HISTOGRAM are not synchronized: a PC_ELAPSED or PC_INTERVAL
+ * counter updated from several threads can mix up their start times and statistics,
+ * each thread should use its own counter.
+ * PC_HISTOGRAM counters can be updated by up to two threads at the same time, each
+ * gets its own copy of the statistics. Events of further threads are counted as
+ * dropped and reported by perf_print_counter().
  */
 enum perf_counter_type {
 	PC_COUNT,		/**< count the number of times an event occurs */
 	PC_ELAPSED,		/**< measure the time elapsed performing an event */
-	PC_INTERVAL		/**< measure the interval between instances of an event */
+	PC_INTERVAL,		/**< measure the interval between instances of an event */
+	PC_HISTOGRAM		/**< measure the time elapsed performing an event, with a latency histogram */
 };
 
 struct perf_ctr_header;
 typedef struct perf_ctr_header	*perf_counter_t;
 
+/**
+ * Statistics of a counter, see perf_get_summary().
+ */
+struct perf_counter_summary {
+	const char		*name;		/**< counter name */
+	enum perf_counter_type	type;		/**< counter type */
+	uint64_t		event_count;	/**< number of events */
+	uint64_t		event_overruns;	/**< number of overruns (PC_ELAPSED and PC_HISTOGRAM) */
+	uint64_t		time_avg;	/**< average elapsed time or interval in microseconds */
+	uint64_t		time_max;	/**< maximum elapsed time or interval in microseconds */
+	uint64_t		time_p99;	/**< 99th percentile of the elapsed time in microseconds (PC_HISTOGRAM) */
+};
+
+/**
+ * Callback for perf_iterate_all().
+ * @param handle		The counter.
+ * @param user			The user pointer passed to perf_iterate_all().
+ */
+typedef void (*perf_callback)(perf_counter_t handle, void *user);
+
 __BEGIN_DECLS
 
 /**
@@ -175,6 +203,23 @@ __EXPORT extern void		perf_print_counter_fd(int fd, perf_counter_t handle);
  */
 __EXPORT extern void		perf_print_all(int fd);
 
+/**
+ * Call a function for each of the performance counters, in the order they are printed
+ * by perf_print_all(). The counter list is locked during the iteration, so the function
+ * must not allocate or free counters.
+ * @param cb			The function to call.
+ * @param user			Pointer passed to the function.
+ */
+__EXPORT extern void		perf_iterate_all(perf_callback cb, void *user);
+
+/**
+ * Get the statistics of a counter, e.g. for publishing them.
+ * The values that do not apply to the counter type are set to 0.
+ * @param handle		The counter returned from perf_alloc.
+ * @param summary		Filled with the statistics.
+ */
+__EXPORT extern void		perf_get_summary(perf_counter_t handle, struct perf_counter_summary *summary);
+
 /**
  * Print hrt latency counters.
  *
@@ -187,6 +232,19 @@ __EXPORT extern void		perf_print_latency(int fd);
  */
 __EXPORT extern void		perf_reset_all(void);
 
+/**
+ * Return a percentile of the measured times.
+ *
+ * This call applies to counters of type PC_HISTOGRAM. The result is the upper bound
+ * of the histogram bucket containing the percentile, which is at most 12.5% larger
+ * than the exact value.
+ *
+ * @param handle		The counter returned from perf_alloc.
+ * @param percentile		Percentile in the range 0..1, e.g. 0.99.
+ * @return			Time in microseconds, 0 if there are no events.
+ */
+__EXPORT extern uint64_t	perf_percentile(perf_counter_t handle, float percentile);
+
 /**
  * Return current event_count
  *
@@ -102,13 +102,14 @@ bool SubscriptionBase::updated()
 	return isUpdated;
 }
 
-void SubscriptionBase::update(void *data)
+bool SubscriptionBase::update(void *data)
 {
-	if (updated()) {
-		int ret = orb_copy(_meta, _handle, data);
+	bool isUpdated = false;
+	int ret = orb_copy_if_updated(_meta, _handle, data, &isUpdated);
 
-		if (ret != PX4_OK) { PX4_ERR("orb copy failed"); }
-	}
+	if (ret != PX4_OK) { PX4_ERR("orb copy failed"); }
+
+	return isUpdated;
 }
 
 SubscriptionBase::~SubscriptionBase()
@@ -141,9 +142,9 @@ Subscription<T>::~Subscription()
 }
 
 template <class T>
-void Subscription<T>::update()
+bool Subscription<T>::update()
 {
-	SubscriptionBase::update((void *)(&_data));
+	return SubscriptionBase::update((void *)(&_data));
 }
 
 template <class T>
@@ -76,8 +76,9 @@ public:
 	/**
 	 * Update the struct
 	 * @param data The uORB message struct we are updating.
+	 * @return true if there was an update and data was copied
 	 */
-	void update(void *data);
+	bool update(void *data);
 
 	/**
 	 * Deconstructor
@@ -145,8 +146,9 @@ public:
 	/**
 	 * This function is the callback for list traversal
 	 * updates, a child class must implement it.
+	 * @return true if there was an update
 	 */
-	virtual void update() = 0;
+	virtual bool update() = 0;
 
 };
 
@@ -183,8 +185,9 @@ public:
 
 	/**
 	 * Create an update function that uses the embedded struct.
+	 * @return true if there was an update
 	 */
-	void update();
+	bool update();
 
 	/**
 	 * Create an update function that uses the embedded struct.
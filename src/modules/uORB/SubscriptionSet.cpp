@@ -0,0 +1,167 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file SubscriptionSet.cpp
+ *
+ */
+
+#include "SubscriptionSet.hpp"
+
+#include <px4_defines.h>
+
+namespace uORB
+{
+
+SubscriptionSet::SubscriptionSet() :
+	_entries{},
+	_count(0),
+	_polled(0),
+	_queue(orb_update_queue_create(MAX_SUBSCRIPTIONS)),
+	_tags{}
+{
+}
+
+SubscriptionSet::~SubscriptionSet()
+{
+	if (_queue != nullptr) {
+		for (unsigned i = 0; i < _count; i++) {
+			if (!(_polled & (1u << i))) {
+				orb_update_queue_attach(nullptr, _entries[i].handle, 0);
+			}
+		}
+
+		orb_update_queue_destroy(_queue);
+	}
+}
+
+int SubscriptionSet::add(SubscriptionBase &sub, void *data)
+{
+	return add(&sub, nullptr, sub.getMeta(), sub.getHandle(), data);
+}
+
+int SubscriptionSet::add(SubscriptionNode &sub)
+{
+	return add(&sub, &sub, sub.getMeta(), sub.getHandle(), nullptr);
+}
+
+int SubscriptionSet::add(const struct orb_metadata *meta, int handle, void *data)
+{
+	return add(nullptr, nullptr, meta, handle, data);
+}
+
+int SubscriptionSet::add(List<SubscriptionNode *> &list)
+{
+	int added = 0;
+
+	for (SubscriptionNode *sub = list.getHead(); sub != nullptr; sub = sub->getSibling()) {
+		if (add(sub, sub, sub->getMeta(), sub->getHandle(), nullptr) < 0) {
+			break;
+		}
+
+		added++;
+	}
+
+	return added;
+}
+
+int SubscriptionSet::add(SubscriptionBase *sub, SubscriptionNode *node, const struct orb_metadata *meta, int handle,
+			 void *data)
+{
+	if (_count >= MAX_SUBSCRIPTIONS) {
+		PX4_ERR("subscription set full");
+		return -1;
+	}
+
+	const unsigned i = _count++;
+	_entries[i].sub = sub;
+	_entries[i].node = node;
+	_entries[i].meta = meta;
+	_entries[i].handle = handle;
+	_entries[i].data = data;
+
+	/* if the topic already has data, the tag is queued right away */
+	if (_queue == nullptr || handle < 0 ||
+	    orb_update_queue_attach(_queue, handle, i) != PX4_OK) {
+		_polled |= 1u << i;
+	}
+
+	return i;
+}
+
+bool SubscriptionSet::update_entry(unsigned i)
+{
+	Entry &entry = _entries[i];
+
+	if (entry.node != nullptr) {
+		return entry.node->update();
+	}
+
+	if (entry.sub != nullptr) {
+		return entry.sub->update(entry.data);
+	}
+
+	bool updated = false;
+	orb_copy_if_updated(entry.meta, entry.handle, entry.data, &updated);
+	return updated;
+}
+
+uint32_t SubscriptionSet::update()
+{
+	uint32_t updated = 0;
+
+	if (_queue != nullptr) {
+		int n = orb_update_queue_wait(_queue, _tags, MAX_SUBSCRIPTIONS, 0);
+
+		/*
+		 * A tag can still be queued for data that was already copied (published
+		 * again between popping the tag and the copy), so the entry is checked
+		 * before it is reported.
+		 */
+		for (int j = 0; j < n; j++) {
+			if (_tags[j] < _count && update_entry(_tags[j])) {
+				updated |= 1u << _tags[j];
+			}
+		}
+	}
+
+	for (unsigned i = 0; _polled != 0 && i < _count; i++) {
+		if ((_polled & (1u << i)) && update_entry(i)) {
+			updated |= 1u << i;
+		}
+	}
+
+	return updated;
+}
+
+} // namespace uORB
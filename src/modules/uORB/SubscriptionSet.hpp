@@ -0,0 +1,147 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file SubscriptionSet.hpp
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "Subscription.hpp"
+
+namespace uORB
+{
+
+/**
+ * Set of subscriptions that are updated together.
+ *
+ * Modules that check many subscriptions per loop pay one orb_check()
+ * per subscription, even though only a few of them are updated. The set
+ * attaches all its subscriptions to an update queue instead: a single
+ * call pops the tags of the updated subscriptions and only those are
+ * copied, each with a single orb_copy_if_updated() (one node lock).
+ *
+ * Subscriptions that cannot be attached to the queue (e.g. if the
+ * subscription failed) are checked on every update, as before.
+ * The set does not own the subscriptions, they must outlive it.
+ */
+class __EXPORT SubscriptionSet
+{
+public:
+	static constexpr unsigned MAX_SUBSCRIPTIONS = 32;
+
+	SubscriptionSet();
+	~SubscriptionSet();
+
+	/**
+	 * Add a subscription.
+	 *
+	 * @param sub The subscription.
+	 * @param data The uORB message struct updated with the subscription.
+	 * @return the bit of the subscription in the mask returned by update(),
+	 * 	-1 if the set is full
+	 */
+	int add(SubscriptionBase &sub, void *data);
+
+	/**
+	 * Add a subscription that updates its embedded struct (Subscription<T>).
+	 *
+	 * @return the bit of the subscription in the mask returned by update(),
+	 * 	-1 if the set is full
+	 */
+	int add(SubscriptionNode &sub);
+
+	/**
+	 * Add all subscriptions of a list, e.g. the subscriptions of a controllib block.
+	 *
+	 * @return the number of subscriptions added
+	 */
+	int add(List<SubscriptionNode *> &list);
+
+	/**
+	 * Add a subscription handle returned by orb_subscribe().
+	 *
+	 * @param meta The uORB metadata of the topic.
+	 * @param handle The subscription handle.
+	 * @param data The uORB message struct updated with the subscription.
+	 * @return the bit of the subscription in the mask returned by update(),
+	 * 	-1 if the set is full
+	 */
+	int add(const struct orb_metadata *meta, int handle, void *data);
+
+	/**
+	 * Copy the data of all updated subscriptions.
+	 *
+	 * @return bitmask of the updated subscriptions
+	 */
+	uint32_t update();
+
+	/**
+	 * Check a mask returned by update().
+	 *
+	 * @param mask The mask returned by update().
+	 * @param bit The bit returned by add().
+	 * @return true if the subscription was updated
+	 */
+	static bool updated(uint32_t mask, int bit) { return bit >= 0 && (mask & (1u << bit)) != 0; }
+
+	unsigned size() const { return _count; }
+
+private:
+	struct Entry {
+		SubscriptionBase *sub;	///< null for a raw subscription handle
+		SubscriptionNode *node;	///< if not null, updates its own struct
+		const struct orb_metadata *meta;
+		int handle;
+		void *data;
+	};
+
+	Entry _entries[MAX_SUBSCRIPTIONS];
+	unsigned _count;
+	uint32_t _polled;		///< subscriptions not attached to the queue, checked on every update
+	orb_update_queue_t _queue;
+	uint16_t _tags[MAX_SUBSCRIPTIONS];
+
+	int add(SubscriptionBase *sub, SubscriptionNode *node, const struct orb_metadata *meta, int handle, void *data);
+
+	bool update_entry(unsigned i);
+
+	/* do not allow copying this class */
+	SubscriptionSet(const SubscriptionSet &);
+	SubscriptionSet &operator=(const SubscriptionSet &);
+};
+
+} // namespace uORB
@@ -109,11 +109,46 @@ int  orb_copy(const struct orb_metadata *meta, int handle, void *buffer)
 	return uORB::Manager::get_instance()->orb_copy(meta, handle, buffer);
 }
 
+int  orb_copy_if_updated(const struct orb_metadata *meta, int handle, void *buffer, bool *updated)
+{
+	return uORB::Manager::get_instance()->orb_copy_if_updated(meta, handle, buffer, updated);
+}
+
+int  orb_borrow(const struct orb_metadata *meta, int handle, const void **buffer)
+{
+	return uORB::Manager::get_instance()->orb_borrow(meta, handle, buffer);
+}
+
+int  orb_release(const struct orb_metadata *meta, int handle, const void *buffer)
+{
+	return uORB::Manager::get_instance()->orb_release(meta, handle, buffer);
+}
+
 int  orb_check(int handle, bool *updated)
 {
 	return uORB::Manager::get_instance()->orb_check(handle, updated);
 }
 
+orb_update_queue_t orb_update_queue_create(unsigned size)
+{
+	return uORB::Manager::get_instance()->orb_update_queue_create(size);
+}
+
+void orb_update_queue_destroy(orb_update_queue_t queue)
+{
+	uORB::Manager::get_instance()->orb_update_queue_destroy(queue);
+}
+
+int  orb_update_queue_attach(orb_update_queue_t queue, int handle, unsigned tag)
+{
+	return uORB::Manager::get_instance()->orb_update_queue_attach(queue, handle, tag);
+}
+
+int  orb_update_queue_wait(orb_update_queue_t queue, uint16_t *tags, unsigned max_tags, unsigned timeout_us)
+{
+	return uORB::Manager::get_instance()->orb_update_queue_wait(queue, tags, max_tags, timeout_us);
+}
+
 int  orb_stat(int handle, uint64_t *time)
 {
 	return uORB::Manager::get_instance()->orb_stat(handle, time);
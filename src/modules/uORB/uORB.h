@@ -199,11 +199,52 @@ extern int	orb_unsubscribe(int handle) __EXPORT;
  */
 extern int	orb_copy(const struct orb_metadata *meta, int handle, void *buffer) __EXPORT;
 
+/**
+ * @see uORB::Manager::orb_copy_if_updated()
+ */
+extern int	orb_copy_if_updated(const struct orb_metadata *meta, int handle, void *buffer, bool *updated) __EXPORT;
+
+/**
+ * @see uORB::Manager::orb_borrow()
+ */
+extern int	orb_borrow(const struct orb_metadata *meta, int handle, const void **buffer) __EXPORT;
+
+/**
+ * @see uORB::Manager::orb_release()
+ */
+extern int	orb_release(const struct orb_metadata *meta, int handle, const void *buffer) __EXPORT;
+
 /**
  * @see uORB::Manager::orb_check()
  */
 extern int	orb_check(int handle, bool *updated) __EXPORT;
 
+/**
+ * ORB update queue handle.
+ */
+typedef void 	*orb_update_queue_t;
+
+/**
+ * @see uORB::Manager::orb_update_queue_create()
+ */
+extern orb_update_queue_t orb_update_queue_create(unsigned size) __EXPORT;
+
+/**
+ * @see uORB::Manager::orb_update_queue_destroy()
+ */
+extern void	orb_update_queue_destroy(orb_update_queue_t queue) __EXPORT;
+
+/**
+ * @see uORB::Manager::orb_update_queue_attach()
+ */
+extern int	orb_update_queue_attach(orb_update_queue_t queue, int handle, unsigned tag) __EXPORT;
+
+/**
+ * @see uORB::Manager::orb_update_queue_wait()
+ */
+extern int	orb_update_queue_wait(orb_update_queue_t queue, uint16_t *tags, unsigned max_tags,
+				      unsigned timeout_us) __EXPORT;
+
 /**
  * @see uORB::Manager::orb_stat()
  */
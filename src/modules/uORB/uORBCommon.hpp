@@ -63,5 +63,23 @@ struct orb_advertdata {
 	int *instance;
 	int priority;
 };
+
+struct orb_borrowdata {
+	const struct orb_metadata *meta;
+	const void *data;
+};
+
+struct orb_copydata {
+	const struct orb_metadata *meta;
+	void *data;
+	bool updated;
+};
+
+class UpdateQueue;
+
+struct orb_updatequeuedata {
+	UpdateQueue *queue;
+	unsigned tag;
+};
 }
 #endif // _uORBCommon_hpp_
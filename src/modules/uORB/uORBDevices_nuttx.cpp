@@ -56,6 +56,8 @@ uORB::DeviceNode::DeviceNode
 	_data(nullptr),
 	_last_update(0),
 	_generation(0),
+	_borrow_buffers{nullptr, nullptr},
+	_borrow_count{0, 0},
 	_publisher(0),
 	_priority(priority),
 	_published(false),
@@ -69,7 +71,12 @@ uORB::DeviceNode::DeviceNode
 
 uORB::DeviceNode::~DeviceNode()
 {
-	if (_data != nullptr) {
+	if (_borrow_buffers[1] != nullptr) {
+		/* _data points to one of the two */
+		delete[] _borrow_buffers[0];
+		delete[] _borrow_buffers[1];
+
+	} else if (_data != nullptr) {
 		delete[] _data;
 	}
 
@@ -159,6 +166,12 @@ uORB::DeviceNode::close(struct file *filp)
 				hrt_cancel(&sd->update_interval->update_call);
 			}
 
+			if (sd->update_queue != nullptr) {
+				irqstate_t flags = px4_enter_critical_section();
+				remove_listener(sd);
+				px4_leave_critical_section(flags);
+			}
+
 			remove_internal_subscriber();
 			delete sd;
 			sd = nullptr;
@@ -224,6 +237,103 @@ uORB::DeviceNode::read(struct file *filp, char *buffer, size_t buflen)
 	return _meta->o_size;
 }
 
+bool
+uORB::DeviceNode::copy_if_updated(struct file *filp, void *buffer)
+{
+	/* critical sections nest, the check and the copy are atomic */
+	irqstate_t flags = px4_enter_critical_section();
+
+	const bool updated = appears_updated((SubscriberData *)filp_to_sd(filp));
+
+	if (updated) {
+		read(filp, (char *)buffer, _meta->o_size);
+	}
+
+	px4_leave_critical_section(flags);
+
+	return updated;
+}
+
+int
+uORB::DeviceNode::borrow(SubscriberData *sd, const void **data)
+{
+	/* nothing published yet */
+	if (_data == nullptr) {
+		return -ENODATA;
+	}
+
+	/* with a queue, publishers write to a different slot each time, use orb_copy instead */
+	if (_queue_size != 1) {
+		return -EINVAL;
+	}
+
+	if (_borrow_buffers[1] == nullptr) {
+		lock();
+
+		if (_borrow_buffers[1] == nullptr) {
+			uint8_t *spare = new uint8_t[_meta->o_size];
+
+			if (spare != nullptr) {
+				irqstate_t flags = px4_enter_critical_section();
+				_borrow_buffers[0] = _data;
+				_borrow_buffers[1] = spare;
+				px4_leave_critical_section(flags);
+			}
+		}
+
+		unlock();
+
+		if (_borrow_buffers[1] == nullptr) {
+			return -ENOMEM;
+		}
+	}
+
+	irqstate_t flags = px4_enter_critical_section();
+
+	int cur = current_borrow_index();
+
+	/* bounded staleness: refuse while an older generation is still borrowed, otherwise
+	 * the publisher would be left without a free buffer */
+	if (_borrow_count[cur ^ 1] > 0) {
+		px4_leave_critical_section(flags);
+		return -EBUSY;
+	}
+
+	++_borrow_count[cur];
+
+	/* same subscriber state update as in read(), for a queue size of 1 */
+	if (_generation > sd->generation + 1) {
+		_lost_messages += _generation - (sd->generation + 1);
+	}
+
+	sd->generation = _generation;
+	sd->set_priority(_priority);
+	sd->set_update_reported(false);
+
+	px4_leave_critical_section(flags);
+
+	*data = _borrow_buffers[cur];
+	return OK;
+}
+
+int
+uORB::DeviceNode::release(const void *data)
+{
+	int ret = -EINVAL;
+	irqstate_t flags = px4_enter_critical_section();
+
+	for (int i = 0; i < 2; ++i) {
+		if (data != nullptr && data == _borrow_buffers[i] && _borrow_count[i] > 0) {
+			--_borrow_count[i];
+			ret = OK;
+			break;
+		}
+	}
+
+	px4_leave_critical_section(flags);
+	return ret;
+}
+
 ssize_t
 uORB::DeviceNode::write(struct file *filp, const char *buffer, size_t buflen)
 {
@@ -262,6 +372,16 @@ uORB::DeviceNode::write(struct file *filp, const char *buffer, size_t buflen)
 
 	/* Perform an atomic copy. */
 	irqstate_t flags = px4_enter_critical_section();
+
+	if (_borrow_buffers[1] != nullptr) {
+		/* never overwrite a borrowed buffer, switch to the spare one instead */
+		int cur = current_borrow_index();
+
+		if (_borrow_count[cur] > 0) {
+			_data = _borrow_buffers[cur ^ 1];
+		}
+	}
+
 	memcpy(_data + (_meta->o_size * (_generation % _queue_size)), buffer, _meta->o_size);
 
 	/* update the timestamp and generation count */
@@ -276,6 +396,12 @@ uORB::DeviceNode::write(struct file *filp, const char *buffer, size_t buflen)
 	/* notify any poll waiters */
 	poll_notify(POLLIN);
 
+	if (_listeners != nullptr) {
+		flags = px4_enter_critical_section();
+		notify_listeners();
+		px4_leave_critical_section(flags);
+	}
+
 	return _meta->o_size;
 }
 
@@ -327,6 +453,42 @@ uORB::DeviceNode::ioctl(struct file *filp, int cmd, unsigned long arg)
 			return ret;
 		}
 
+	case ORBIOCBORROW: {
+			struct orb_borrowdata *borrow_data = (struct orb_borrowdata *)arg;
+
+			if (borrow_data->meta != _meta) {
+				return -EINVAL;
+			}
+
+			return borrow(sd, &borrow_data->data);
+		}
+
+	case ORBIOCCOPYUPDATED: {
+			struct orb_copydata *copy_data = (struct orb_copydata *)arg;
+
+			if (copy_data->meta != _meta) {
+				return -EINVAL;
+			}
+
+			copy_data->updated = copy_if_updated(filp, copy_data->data);
+			return OK;
+		}
+
+	case ORBIOCSETUPDATEQUEUE: {
+			struct orb_updatequeuedata *data = (struct orb_updatequeuedata *)arg;
+			return set_update_queue(sd, data->queue, data->tag);
+		}
+
+	case ORBIOCRELEASE: {
+			struct orb_borrowdata *borrow_data = (struct orb_borrowdata *)arg;
+
+			if (borrow_data->meta != _meta) {
+				return -EINVAL;
+			}
+
+			return release(borrow_data->data);
+		}
+
 	case ORBIOCGADVERTISER:
 		*(uintptr_t *)arg = (uintptr_t)this;
 		return OK;
@@ -540,6 +702,64 @@ uORB::DeviceNode::update_deferred()
 	 * expired will be woken.
 	 */
 	poll_notify(POLLIN);
+
+	if (_listeners != nullptr) {
+		irqstate_t flags = px4_enter_critical_section();
+		notify_listeners();
+		px4_leave_critical_section(flags);
+	}
+}
+
+int
+uORB::DeviceNode::set_update_queue(SubscriberData *sd, UpdateQueue *queue, unsigned tag)
+{
+	if (sd == nullptr) {
+		return -EINVAL;
+	}
+
+	irqstate_t flags = px4_enter_critical_section();
+
+	remove_listener(sd);
+
+	if (queue != nullptr) {
+		sd->update_queue = queue;
+		sd->update_tag = tag;
+		sd->next_listener = _listeners;
+		_listeners = sd;
+
+		/* data published before attaching must not be missed */
+		if (appears_updated(sd)) {
+			queue->push(tag);
+		}
+	}
+
+	px4_leave_critical_section(flags);
+
+	return OK;
+}
+
+void
+uORB::DeviceNode::remove_listener(SubscriberData *sd)
+{
+	for (SubscriberData **l = &_listeners; *l != nullptr; l = &(*l)->next_listener) {
+		if (*l == sd) {
+			*l = sd->next_listener;
+			break;
+		}
+	}
+
+	sd->update_queue = nullptr;
+	sd->next_listener = nullptr;
+}
+
+void
+uORB::DeviceNode::notify_listeners()
+{
+	for (SubscriberData *sd = _listeners; sd != nullptr; sd = sd->next_listener) {
+		if (appears_updated(sd)) {
+			sd->update_queue->push(sd->update_tag);
+		}
+	}
 }
 
 void
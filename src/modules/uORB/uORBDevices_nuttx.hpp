@@ -39,6 +39,7 @@
 #include <stdlib.h>
 #include "ORBMap.hpp"
 #include "uORBCommon.hpp"
+#include "uORBUpdateQueue.hpp"
 
 
 namespace uORB
@@ -207,12 +208,18 @@ private:
 
 		bool update_reported() const { return flags & (1 << 8); }
 		void set_update_reported(bool update_reported_flag) { flags = (flags & ~(1 << 8)) | (((int)update_reported_flag) << 8); }
+
+		UpdateQueue *update_queue; /**< if not null, queue that gets update_tag pushed on each visible update */
+		unsigned update_tag;
+		SubscriberData *next_listener; /**< next subscriber in _listeners */
 	};
 
 	const struct orb_metadata *_meta; /**< object metadata information */
 	uint8_t     *_data;   /**< allocated object buffer */
 	hrt_abstime   _last_update; /**< time the object was last updated */
 	volatile unsigned   _generation;  /**< object generation count */
+	uint8_t     *_borrow_buffers[2]; /**< _data and a spare buffer, allocated on the first borrow (queue size 1 only) */
+	unsigned    _borrow_count[2]; /**< number of active borrows of each buffer in _borrow_buffers */
 	pid_t     _publisher; /**< if nonzero, current publisher. Only used inside the advertise call.
 					We allow one publisher to have an open file descriptor at the same time. */
 	const int   _priority;  /**< priority of topic */
@@ -232,11 +239,32 @@ private:
 	uint32_t _lost_messages = 0; ///< nr of lost messages for all subscribers. If two subscribers lose the same
 	///message, it is counted as two.
 
+	SubscriberData *_listeners = nullptr; ///< subscribers with an update queue attached
+
 	/**
 	 * Perform a deferred update for a rate-limited subscriber.
 	 */
 	void      update_deferred();
 
+	/**
+	 * Attach an update queue to a subscriber, replacing any previous one (ORBIOCSETUPDATEQUEUE).
+	 * @param queue    The queue, or null to detach.
+	 * @return    PX4_OK on success, -errno otherwise.
+	 */
+	int       set_update_queue(SubscriberData *sd, UpdateQueue *queue, unsigned tag);
+
+	/**
+	 * Remove a subscriber from _listeners.
+	 * Lock must already be held when calling this.
+	 */
+	void      remove_listener(SubscriberData *sd);
+
+	/**
+	 * Push the tags of all listeners to which the topic appears updated.
+	 * Lock must already be held when calling this.
+	 */
+	void      notify_listeners();
+
 	/**
 	 * Bridge from hrt_call to update_deferred
 	 *
@@ -244,6 +272,33 @@ private:
 	 */
 	static void   update_deferred_trampoline(void *arg);
 
+	/**
+	 * Copy the data if the topic appears updated to a subscriber (ORBIOCCOPYUPDATED).
+	 * @param filp    The file of the subscriber for whom to read.
+	 * @param buffer    Receives the data, unchanged if there is no update.
+	 * @return    true if the topic was updated and copied.
+	 */
+	bool      copy_if_updated(struct file *filp, void *buffer);
+
+	/**
+	 * Borrow the latest data for in-place reading (ORBIOCBORROW).
+	 * @param sd    The subscriber for whom to read.
+	 * @param data    Returns a pointer to the borrowed buffer.
+	 * @return    OK on success, -errno otherwise.
+	 */
+	int       borrow(SubscriberData *sd, const void **data);
+
+	/**
+	 * Release a buffer returned by borrow() (ORBIOCRELEASE).
+	 * @return    OK on success, -errno otherwise.
+	 */
+	int       release(const void *data);
+
+	/**
+	 * Get the index into _borrow_buffers of the current _data buffer.
+	 */
+	int       current_borrow_index() const { return (_data == _borrow_buffers[0]) ? 0 : 1; }
+
 	/**
 	 * Check whether a topic appears updated to a subscriber.
 	 *
@@ -66,6 +66,9 @@ uORB::DeviceNode::DeviceNode(const struct orb_metadata *meta, const char *name,
 	_data(nullptr),
 	_last_update(0),
 	_generation(0),
+	_seq(0),
+	_borrow_buffers{nullptr, nullptr},
+	_borrow_count{0, 0},
 	_publisher(0),
 	_priority(priority),
 	_published(false),
@@ -78,7 +81,12 @@ uORB::DeviceNode::DeviceNode(const struct orb_metadata *meta, const char *name,
 
 uORB::DeviceNode::~DeviceNode()
 {
-	if (_data != nullptr) {
+	if (_borrow_buffers[1] != nullptr) {
+		/* _data points to one of the two */
+		delete[] _borrow_buffers[0];
+		delete[] _borrow_buffers[1];
+
+	} else if (_data != nullptr) {
 		delete[] _data;
 	}
 
@@ -171,6 +179,12 @@ uORB::DeviceNode::close(device::file_t *filp)
 				hrt_cancel(&sd->update_interval->update_call);
 			}
 
+			if (sd->update_queue != nullptr) {
+				lock();
+				remove_listener(sd);
+				unlock();
+			}
+
 			remove_internal_subscriber();
 			delete sd;
 			sd = nullptr;
@@ -197,44 +211,202 @@ uORB::DeviceNode::read(device::file_t *filp, char *buffer, size_t buflen)
 	}
 
 	/*
-	 * Perform an atomic copy & state update
+	 * Optimistically copy without the lock and validate against the sequence
+	 * counter. If a publisher was active during the copy, redo it under the lock,
+	 * which also guarantees progress if the publisher got preempted in the middle
+	 * of an update.
 	 */
-	lock();
+	unsigned seq;
+	unsigned sd_generation = 0;
+	unsigned lost_messages = 0;
+	bool consistent = false;
 
-	if (_generation > sd->generation + _queue_size) {
+	/*
+	 * Clear the flag that indicates that an update has been reported, as we are
+	 * about to collect it. Publishers set it concurrently, so it is cleared before
+	 * the copy: an update reported in between is reported again instead of lost.
+	 */
+	sd->set_update_reported(false);
+
+	if (seq_read_begin(seq)) {
+		lost_messages = copy_for_subscriber(sd, buffer, sd_generation);
+		consistent = seq_read_valid(seq);
+	}
+
+	if (!consistent) {
+		lock();
+		lost_messages = copy_for_subscriber(sd, buffer, sd_generation);
+		unlock();
+	}
+
+	update_subscriber(sd, sd_generation, lost_messages);
+
+	return _meta->o_size;
+}
+
+void
+uORB::DeviceNode::update_subscriber(SubscriberData *sd, unsigned sd_generation, unsigned lost_messages)
+{
+	if (lost_messages > 0) {
+		__sync_fetch_and_add(&_lost_messages, lost_messages);
+	}
+
+	/* publishers compare it in appears_updated(), an aligned store is atomic */
+	sd->generation = sd_generation;
+}
+
+unsigned
+uORB::DeviceNode::copy_for_subscriber(const SubscriberData *sd, char *buffer, unsigned &sd_generation)
+{
+	const unsigned generation = _generation;
+	unsigned lost_messages = 0;
+
+	sd_generation = sd->generation;
+
+	if (generation > sd_generation + _queue_size) {
 		/* Reader is too far behind: some messages are lost */
-		_lost_messages += _generation - (sd->generation + _queue_size);
-		sd->generation = _generation - _queue_size;
+		lost_messages = generation - (sd_generation + _queue_size);
+		sd_generation = generation - _queue_size;
 	}
 
-	if (_generation == sd->generation && sd->generation > 0) {
+	if (generation == sd_generation && sd_generation > 0) {
 		/* The subscriber already read the latest message, but nothing new was published yet.
 		 * Return the previous message
 		 */
-		--sd->generation;
+		--sd_generation;
 	}
 
 	/* if the caller doesn't want the data, don't give it to them */
 	if (nullptr != buffer) {
-		memcpy(buffer, _data + (_meta->o_size * (sd->generation % _queue_size)), _meta->o_size);
+		memcpy(buffer, _data + (_meta->o_size * (sd_generation % _queue_size)), _meta->o_size);
+	}
+
+	if (sd_generation < generation) {
+		++sd_generation;
 	}
 
-	if (sd->generation < _generation) {
-		++sd->generation;
+	return lost_messages;
+}
+
+bool
+uORB::DeviceNode::copy_if_updated(SubscriberData *sd, void *buffer)
+{
+	/* a single lock for the check and the copy */
+	lock();
+
+	const bool updated = appears_updated(sd);
+
+	if (updated) {
+		unsigned sd_generation = 0;
+		sd->set_update_reported(false);
+		unsigned lost_messages = copy_for_subscriber(sd, (char *)buffer, sd_generation);
+		update_subscriber(sd, sd_generation, lost_messages);
 	}
 
-	/* set priority */
-	sd->set_priority(_priority);
+	unlock();
+
+	return updated;
+}
+
+int
+uORB::DeviceNode::borrow(SubscriberData *sd, const void **data)
+{
+	/* nothing published yet */
+	if (_data == nullptr) {
+		return -ENODATA;
+	}
+
+	/* with a queue, publishers write to a different slot each time, use orb_copy instead */
+	if (_queue_size != 1) {
+		return -EINVAL;
+	}
+
+	if (_borrow_buffers[1] == nullptr) {
+		lock();
+
+		if (_borrow_buffers[1] == nullptr) {
+			uint8_t *spare = new uint8_t[_meta->o_size];
+
+			if (spare != nullptr) {
+				_borrow_buffers[0] = _data;
+				_borrow_buffers[1] = spare;
+			}
+		}
+
+		unlock();
+
+		if (_borrow_buffers[1] == nullptr) {
+			return -ENOMEM;
+		}
+	}
 
 	/*
-	 * Clear the flag that indicates that an update has been reported, as
-	 * we have just collected it.
+	 * Take a reference on the current buffer and validate with the seqlock that no
+	 * publisher started an update in between (the publisher checks the reference
+	 * count after starting its update, so either it sees our reference or we see
+	 * its sequence change). On a race, take the reference under the lock instead.
 	 */
-	sd->set_update_reported(false);
+	unsigned seq;
+	unsigned sd_generation = 0;
+	unsigned lost_messages = 0;
+	int cur = -1;
+
+	if (seq_read_begin(seq)) {
+		cur = current_borrow_index();
+
+		/* bounded staleness: refuse while an older generation is still borrowed, otherwise
+		 * the publisher would be left without a free buffer */
+		if (_borrow_count[cur ^ 1] > 0) {
+			return -EBUSY;
+		}
 
-	unlock();
+		/* cleared before taking the reference, as in read() */
+		sd->set_update_reported(false);
+		__sync_fetch_and_add(&_borrow_count[cur], 1);
+		lost_messages = copy_for_subscriber(sd, nullptr, sd_generation);
 
-	return _meta->o_size;
+		if (!seq_read_valid(seq)) {
+			__sync_fetch_and_sub(&_borrow_count[cur], 1);
+			cur = -1;
+		}
+	}
+
+	if (cur < 0) {
+		lock();
+		cur = current_borrow_index();
+
+		if (_borrow_count[cur ^ 1] > 0) {
+			unlock();
+			return -EBUSY;
+		}
+
+		sd->set_update_reported(false);
+		__sync_fetch_and_add(&_borrow_count[cur], 1);
+		lost_messages = copy_for_subscriber(sd, nullptr, sd_generation);
+		unlock();
+	}
+
+	update_subscriber(sd, sd_generation, lost_messages);
+
+	*data = _borrow_buffers[cur];
+	return PX4_OK;
+}
+
+int
+uORB::DeviceNode::release(const void *data)
+{
+	for (int i = 0; i < 2; ++i) {
+		if (data != nullptr && data == _borrow_buffers[i]) {
+			if (_borrow_count[i] == 0) {
+				return -EINVAL;
+			}
+
+			__sync_fetch_and_sub(&_borrow_count[i], 1);
+			return PX4_OK;
+		}
+	}
+
+	return -EINVAL;
 }
 
 ssize_t
@@ -271,20 +443,39 @@ uORB::DeviceNode::write(device::file_t *filp, const char *buffer, size_t buflen)
 		return -EIO;
 	}
 
+	/* the lock serializes publishers and poll (de)registration, readers only take it after racing with a publisher */
 	lock();
+	const hrt_abstime now = hrt_absolute_time();
+
+	seq_write_begin();
+
+	if (_borrow_buffers[1] != nullptr) {
+		/* never overwrite a borrowed buffer, switch to the spare one instead */
+		int cur = current_borrow_index();
+
+		if (_borrow_count[cur] > 0) {
+			_data = _borrow_buffers[cur ^ 1];
+		}
+	}
+
 	memcpy(_data + (_meta->o_size * (_generation % _queue_size)), buffer, _meta->o_size);
 
 	/* update the timestamp and generation count */
-	_last_update = hrt_absolute_time();
+	_last_update = now;
 	/* wrap-around happens after ~49 days, assuming a publisher rate of 1 kHz */
 	_generation++;
+	seq_write_end();
 
 	_published = true;
 
-	unlock();
+	/* notify any poll waiters and update queues while we still hold the lock */
+	poll_notify_locked(POLLIN);
 
-	/* notify any poll waiters */
-	poll_notify(POLLIN);
+	if (_listeners != nullptr) {
+		notify_listeners();
+	}
+
+	unlock();
 
 	return _meta->o_size;
 }
@@ -296,11 +487,25 @@ uORB::DeviceNode::ioctl(device::file_t *filp, int cmd, unsigned long arg)
 	SubscriberData *sd = filp_to_sd(filp);
 
 	switch (cmd) {
-	case ORBIOCLASTUPDATE:
-		lock();
-		*(hrt_abstime *)arg = _last_update;
-		unlock();
-		return PX4_OK;
+	case ORBIOCLASTUPDATE: {
+			unsigned seq;
+			hrt_abstime last_update = 0;
+			bool consistent = false;
+
+			if (seq_read_begin(seq)) {
+				last_update = _last_update;
+				consistent = seq_read_valid(seq);
+			}
+
+			if (!consistent) {
+				lock();
+				last_update = _last_update;
+				unlock();
+			}
+
+			*(hrt_abstime *)arg = last_update;
+			return PX4_OK;
+		}
 
 	case ORBIOCUPDATED:
 		lock();
@@ -341,6 +546,42 @@ uORB::DeviceNode::ioctl(device::file_t *filp, int cmd, unsigned long arg)
 			return ret;
 		}
 
+	case ORBIOCBORROW: {
+			struct orb_borrowdata *borrow_data = (struct orb_borrowdata *)arg;
+
+			if (borrow_data->meta != _meta) {
+				return -EINVAL;
+			}
+
+			return borrow(sd, &borrow_data->data);
+		}
+
+	case ORBIOCCOPYUPDATED: {
+			struct orb_copydata *copy_data = (struct orb_copydata *)arg;
+
+			if (copy_data->meta != _meta) {
+				return -EINVAL;
+			}
+
+			copy_data->updated = copy_if_updated(sd, copy_data->data);
+			return PX4_OK;
+		}
+
+	case ORBIOCSETUPDATEQUEUE: {
+			struct orb_updatequeuedata *data = (struct orb_updatequeuedata *)arg;
+			return set_update_queue(sd, data->queue, data->tag);
+		}
+
+	case ORBIOCRELEASE: {
+			struct orb_borrowdata *borrow_data = (struct orb_borrowdata *)arg;
+
+			if (borrow_data->meta != _meta) {
+				return -EINVAL;
+			}
+
+			return release(borrow_data->data);
+		}
+
 	case ORBIOCGADVERTISER:
 		*(uintptr_t *)arg = (uintptr_t)this;
 		return PX4_OK;
@@ -544,6 +785,64 @@ uORB::DeviceNode::update_deferred()
 	 * expired will be woken.
 	 */
 	poll_notify(POLLIN);
+
+	if (_listeners != nullptr) {
+		lock();
+		notify_listeners();
+		unlock();
+	}
+}
+
+int
+uORB::DeviceNode::set_update_queue(SubscriberData *sd, UpdateQueue *queue, unsigned tag)
+{
+	if (sd == nullptr) {
+		return -EINVAL;
+	}
+
+	lock();
+
+	remove_listener(sd);
+
+	if (queue != nullptr) {
+		sd->update_queue = queue;
+		sd->update_tag = tag;
+		sd->next_listener = _listeners;
+		_listeners = sd;
+
+		/* data published before attaching must not be missed */
+		if (appears_updated(sd)) {
+			queue->push(tag);
+		}
+	}
+
+	unlock();
+
+	return PX4_OK;
+}
+
+void
+uORB::DeviceNode::remove_listener(SubscriberData *sd)
+{
+	for (SubscriberData **l = &_listeners; *l != nullptr; l = &(*l)->next_listener) {
+		if (*l == sd) {
+			*l = sd->next_listener;
+			break;
+		}
+	}
+
+	sd->update_queue = nullptr;
+	sd->next_listener = nullptr;
+}
+
+void
+uORB::DeviceNode::notify_listeners()
+{
+	for (SubscriberData *sd = _listeners; sd != nullptr; sd = sd->next_listener) {
+		if (appears_updated(sd)) {
+			sd->update_queue->push(sd->update_tag);
+		}
+	}
 }
 
 void
@@ -561,15 +860,15 @@ uORB::DeviceNode::print_statistics(bool reset)
 		return false;
 	}
 
-	lock();
 	//This can be wrong: if a reader never reads, _lost_messages will not be increased either
-	uint32_t lost_messages = _lost_messages;
+	uint32_t lost_messages;
 
 	if (reset) {
-		_lost_messages = 0;
-	}
+		lost_messages = __sync_fetch_and_and(&_lost_messages, 0);
 
-	unlock();
+	} else {
+		lost_messages = _lost_messages;
+	}
 
 	PX4_INFO("%s: %i", _meta->o_name, lost_messages);
 	return true;
@@ -38,6 +38,7 @@
 #include <string>
 #include <map>
 #include "uORBCommon.hpp"
+#include "uORBUpdateQueue.hpp"
 
 namespace uORB
 {
@@ -136,21 +137,38 @@ private:
 	struct SubscriberData {
 		~SubscriberData() { if (update_interval) { delete(update_interval); } }
 
-		unsigned  generation; /**< last generation the subscriber has seen */
-		int   flags; /**< lowest 8 bits: priority of publisher, 9. bit: update_reported bit */
+		volatile unsigned  generation; /**< last generation the subscriber has seen, only written by the subscriber */
+		volatile int   flags; /**< lowest 8 bits: priority of publisher, 9. bit: update_reported bit */
 		UpdateIntervalData *update_interval; /**< if null, no update interval */
 
 		int priority() const { return flags & 0xff; }
+		/* only set on open, before the subscriber is visible to publishers */
 		void set_priority(uint8_t prio) { flags = (flags & ~0xff) | prio; }
 
 		bool update_reported() const { return flags & (1 << 8); }
-		void set_update_reported(bool update_reported_flag) { flags = (flags & ~(1 << 8)) | (((int)update_reported_flag) << 8); }
+		/* set by publishers and cleared by the subscriber without a common lock */
+		void set_update_reported(bool update_reported_flag)
+		{
+			if (update_reported_flag) {
+				__sync_fetch_and_or(&flags, 1 << 8);
+
+			} else {
+				__sync_fetch_and_and(&flags, ~(1 << 8));
+			}
+		}
+
+		UpdateQueue *update_queue; /**< if not null, queue that gets update_tag pushed on each visible update */
+		unsigned update_tag;
+		SubscriberData *next_listener; /**< next subscriber in _listeners */
 	};
 
 	const struct orb_metadata *_meta; /**< object metadata information */
 	uint8_t     *_data;   /**< allocated object buffer */
 	hrt_abstime   _last_update; /**< time the object was last updated */
 	volatile unsigned   _generation;  /**< object generation count */
+	volatile unsigned   _seq; /**< seqlock sequence: odd while a publisher updates _data, _generation and _last_update */
+	uint8_t     *_borrow_buffers[2]; /**< _data and a spare buffer, allocated on the first borrow (queue size 1 only) */
+	volatile unsigned   _borrow_count[2]; /**< number of active borrows of each buffer in _borrow_buffers */
 	unsigned long     _publisher; /**< if nonzero, current publisher. Only used inside the advertise call.
 					We allow one publisher to have an open file descriptor at the same time. */
 	const int   _priority;  /**< priority of topic */
@@ -165,11 +183,32 @@ private:
 	uint32_t _lost_messages = 0; ///< nr of lost messages for all subscribers. If two subscribers lose the same
 	///message, it is counted as two.
 
+	SubscriberData *_listeners = nullptr; ///< subscribers with an update queue attached
+
 	/**
 	 * Perform a deferred update for a rate-limited subscriber.
 	 */
 	void      update_deferred();
 
+	/**
+	 * Attach an update queue to a subscriber, replacing any previous one (ORBIOCSETUPDATEQUEUE).
+	 * @param queue    The queue, or null to detach.
+	 * @return    PX4_OK on success, -errno otherwise.
+	 */
+	int       set_update_queue(SubscriberData *sd, UpdateQueue *queue, unsigned tag);
+
+	/**
+	 * Remove a subscriber from _listeners.
+	 * Lock must already be held when calling this.
+	 */
+	void      remove_listener(SubscriberData *sd);
+
+	/**
+	 * Push the tags of all listeners to which the topic appears updated.
+	 * Lock must already be held when calling this.
+	 */
+	void      notify_listeners();
+
 	/**
 	 * Bridge from hrt_call to update_deferred
 	 *
@@ -177,6 +216,92 @@ private:
 	 */
 	static void   update_deferred_trampoline(void *arg);
 
+	/**
+	 * Seqlock write side. Marks the start of an update of _data, _generation
+	 * and _last_update. Publishers are serialized by the driver lock, so this
+	 * must be called with the lock held. Readers never take the lock on the
+	 * fast path, thus a publisher never waits for a reader.
+	 */
+	void      seq_write_begin() { __sync_fetch_and_add(&_seq, 1); }
+
+	/**
+	 * Seqlock write side. Marks the end of an update started with seq_write_begin().
+	 */
+	void      seq_write_end() { __sync_fetch_and_add(&_seq, 1); }
+
+	/**
+	 * Seqlock read side. Start an optimistic read.
+	 * @param seq    set to the sequence number to validate against in seq_read_valid()
+	 * @return    false if a publisher is currently updating the data (the read must
+	 *            then be done under the lock)
+	 */
+	bool      seq_read_begin(unsigned &seq) const
+	{
+		seq = _seq;
+		__sync_synchronize();
+		return (seq & 1) == 0;
+	}
+
+	/**
+	 * Seqlock read side. Check that no publisher modified the data since seq_read_begin().
+	 * @return    true if the data read in between is consistent
+	 */
+	bool      seq_read_valid(unsigned seq) const
+	{
+		__sync_synchronize();
+		return seq == _seq;
+	}
+
+	/**
+	 * Copy the next message for a subscriber into buffer and compute its new generation.
+	 * Does not modify any shared state, so it can be called without the lock held, as
+	 * long as the result is validated with the seqlock afterwards.
+	 *
+	 * @param sd    The subscriber for whom to read.
+	 * @param buffer    Destination buffer (may be null).
+	 * @param sd_generation    Set to the generation the subscriber has seen after the read.
+	 * @return    Number of messages the subscriber lost.
+	 */
+	unsigned      copy_for_subscriber(const SubscriberData *sd, char *buffer, unsigned &sd_generation);
+
+	/**
+	 * Store the state of a subscriber after a read. Only the subscriber writes its
+	 * generation and the lost message counter is updated atomically, so this does not
+	 * need the lock.
+	 *
+	 * @param sd    The subscriber.
+	 * @param sd_generation    Generation the subscriber has seen, from copy_for_subscriber().
+	 * @param lost_messages    Number of messages the subscriber lost.
+	 */
+	void      update_subscriber(SubscriberData *sd, unsigned sd_generation, unsigned lost_messages);
+
+	/**
+	 * Copy the data if the topic appears updated to a subscriber (ORBIOCCOPYUPDATED).
+	 * @param sd    The subscriber for whom to read.
+	 * @param buffer    Receives the data, unchanged if there is no update.
+	 * @return    true if the topic was updated and copied.
+	 */
+	bool      copy_if_updated(SubscriberData *sd, void *buffer);
+
+	/**
+	 * Borrow the latest data for in-place reading (ORBIOCBORROW).
+	 * @param sd    The subscriber for whom to read.
+	 * @param data    Returns a pointer to the borrowed buffer.
+	 * @return    PX4_OK on success, -errno otherwise.
+	 */
+	int       borrow(SubscriberData *sd, const void **data);
+
+	/**
+	 * Release a buffer returned by borrow() (ORBIOCRELEASE).
+	 * @return    PX4_OK on success, -errno otherwise.
+	 */
+	int       release(const void *data);
+
+	/**
+	 * Get the index into _borrow_buffers of the current _data buffer.
+	 */
+	int       current_borrow_index() const { return (_data == _borrow_buffers[0]) ? 0 : 1; }
+
 	/**
 	 * Check whether a topic appears updated to a subscriber.
 	 *
@@ -274,6 +274,56 @@ int uORB::Manager::orb_copy(const struct orb_metadata *meta, int handle, void *b
 	return PX4_OK;
 }
 
+int uORB::Manager::orb_copy_if_updated(const struct orb_metadata *meta, int handle, void *buffer, bool *updated)
+{
+	struct orb_copydata copy = { meta, buffer, false };
+	int ret = px4_ioctl(handle, ORBIOCCOPYUPDATED, (unsigned long)(uintptr_t)&copy);
+
+	*updated = copy.updated;
+
+	if (ret < 0) {
+#ifndef __PX4_NUTTX
+		errno = -ret;
+#endif
+		*updated = false;
+		return ERROR;
+	}
+
+	return PX4_OK;
+}
+
+int uORB::Manager::orb_borrow(const struct orb_metadata *meta, int handle, const void **buffer)
+{
+	struct orb_borrowdata borrow = { meta, nullptr };
+	int ret = px4_ioctl(handle, ORBIOCBORROW, (unsigned long)(uintptr_t)&borrow);
+
+	if (ret < 0) {
+#ifndef __PX4_NUTTX
+		/* on NuttX errno is already set by the ioctl syscall */
+		errno = -ret;
+#endif
+		return ERROR;
+	}
+
+	*buffer = borrow.data;
+	return PX4_OK;
+}
+
+int uORB::Manager::orb_release(const struct orb_metadata *meta, int handle, const void *buffer)
+{
+	struct orb_borrowdata borrow = { meta, buffer };
+	int ret = px4_ioctl(handle, ORBIOCRELEASE, (unsigned long)(uintptr_t)&borrow);
+
+	if (ret < 0) {
+#ifndef __PX4_NUTTX
+		errno = -ret;
+#endif
+		return ERROR;
+	}
+
+	return PX4_OK;
+}
+
 int uORB::Manager::orb_check(int handle, bool *updated)
 {
 	/* Set to false here so that if `px4_ioctl` fails to false. */
@@ -281,6 +331,51 @@ int uORB::Manager::orb_check(int handle, bool *updated)
 	return px4_ioctl(handle, ORBIOCUPDATED, (unsigned long)(uintptr_t)updated);
 }
 
+orb_update_queue_t uORB::Manager::orb_update_queue_create(unsigned size)
+{
+	uORB::UpdateQueue *queue = new uORB::UpdateQueue(size);
+
+	if (queue && !queue->init()) {
+		delete queue;
+		queue = nullptr;
+	}
+
+	return (orb_update_queue_t)queue;
+}
+
+void uORB::Manager::orb_update_queue_destroy(orb_update_queue_t queue)
+{
+	delete (uORB::UpdateQueue *)queue;
+}
+
+int uORB::Manager::orb_update_queue_attach(orb_update_queue_t queue, int handle, unsigned tag)
+{
+	uORB::UpdateQueue *update_queue = (uORB::UpdateQueue *)queue;
+
+	if (update_queue && tag >= update_queue->size()) {
+		errno = EINVAL;
+		return ERROR;
+	}
+
+	struct orb_updatequeuedata data = { update_queue, tag };
+	int ret = px4_ioctl(handle, ORBIOCSETUPDATEQUEUE, (unsigned long)(uintptr_t)&data);
+
+	if (ret < 0) {
+#ifndef __PX4_NUTTX
+		errno = -ret;
+#endif
+		return ERROR;
+	}
+
+	return PX4_OK;
+}
+
+int uORB::Manager::orb_update_queue_wait(orb_update_queue_t queue, uint16_t *tags, unsigned max_tags,
+		unsigned timeout_us)
+{
+	return ((uORB::UpdateQueue *)queue)->pop(tags, max_tags, timeout_us);
+}
+
 int uORB::Manager::orb_stat(int handle, uint64_t *time)
 {
 	return px4_ioctl(handle, ORBIOCLASTUPDATE, (unsigned long)(uintptr_t)time);
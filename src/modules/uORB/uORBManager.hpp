@@ -263,6 +263,55 @@ public:
 	 */
 	int  orb_copy(const struct orb_metadata *meta, int handle, void *buffer) ;
 
+	/**
+	 * Fetch data from a topic if it has been updated.
+	 *
+	 * This combines orb_check() and orb_copy() in a single call on the topic,
+	 * without the race window between them.
+	 *
+	 * @param meta    The uORB metadata (usually from the ORB_ID() macro)
+	 *      for the topic.
+	 * @param handle  A handle returned from orb_subscribe.
+	 * @param buffer  Pointer to the buffer receiving the data, left unchanged
+	 *      if the topic has not been updated.
+	 * @param updated Set to true if the topic has been updated and was copied.
+	 * @return    OK on success, ERROR otherwise with errno set accordingly.
+	 */
+	int  orb_copy_if_updated(const struct orb_metadata *meta, int handle, void *buffer, bool *updated) ;
+
+	/**
+	 * Borrow the latest data of a topic for in-place (zero-copy) read access.
+	 *
+	 * This behaves like orb_copy() with respect to the updated flag, but instead
+	 * of copying the data, returns a pointer to the topic buffer itself. The data
+	 * stays valid and unmodified until orb_release() is called: a publisher never
+	 * overwrites a borrowed buffer, it switches to a spare one instead.
+	 * To bound the staleness of borrowed data, a new borrow is refused while data
+	 * of an older generation is still borrowed (errno is set to EBUSY), in which
+	 * case the caller should fall back to orb_copy().
+	 *
+	 * Borrowing is only supported for topics with a queue size of 1.
+	 * Borrows must be short-lived (within one loop iteration) and always released.
+	 *
+	 * @param meta    The uORB metadata (usually from the ORB_ID() macro)
+	 *      for the topic.
+	 * @param handle  A handle returned from orb_subscribe.
+	 * @param buffer  Returns a pointer to the topic data (meta->o_size bytes).
+	 * @return    OK on success, ERROR otherwise with errno set accordingly.
+	 */
+	int  orb_borrow(const struct orb_metadata *meta, int handle, const void **buffer) ;
+
+	/**
+	 * Release data previously borrowed with orb_borrow().
+	 *
+	 * @param meta    The uORB metadata (usually from the ORB_ID() macro)
+	 *      for the topic.
+	 * @param handle  A handle returned from orb_subscribe.
+	 * @param buffer  The pointer returned by orb_borrow().
+	 * @return    OK on success, ERROR otherwise with errno set accordingly.
+	 */
+	int  orb_release(const struct orb_metadata *meta, int handle, const void *buffer) ;
+
 	/**
 	 * Check whether a topic has been published to since the last orb_copy.
 	 *
@@ -283,6 +332,58 @@ public:
 	 */
 	int  orb_check(int handle, bool *updated) ;
 
+	/**
+	 * Create an update queue, used to wait for updates of a set of subscriptions.
+	 *
+	 * This is an alternative to poll() for a consumer with many subscriptions:
+	 * instead of returning all handles that need to be checked, the queue returns
+	 * the tags of exactly those subscriptions that were updated, in the order of
+	 * the updates. The cost of waiting therefore does not grow with the number of
+	 * subscriptions.
+	 *
+	 * @param size    Number of tags: tags passed to orb_update_queue_attach() must
+	 *      be smaller than this.
+	 * @return    A queue handle on success, nullptr otherwise.
+	 */
+	orb_update_queue_t orb_update_queue_create(unsigned size);
+
+	/**
+	 * Destroy an update queue. All subscriptions attached to it must be
+	 * unsubscribed (or attached to another queue) before.
+	 *
+	 * @param queue   A queue returned from orb_update_queue_create.
+	 */
+	void orb_update_queue_destroy(orb_update_queue_t queue);
+
+	/**
+	 * Attach a subscription to an update queue.
+	 *
+	 * Whenever the topic is updated (respecting the interval set with
+	 * orb_set_interval), the tag is pushed into the queue. A tag is only queued
+	 * once until it is popped, so a consumer that falls behind sees one
+	 * notification per subscription, not one per update. If the topic already
+	 * has unread data, the tag is pushed immediately.
+	 * A subscription can be attached to at most one queue, attaching it again
+	 * replaces the previous queue, attaching it to nullptr detaches it.
+	 *
+	 * @param queue   A queue returned from orb_update_queue_create.
+	 * @param handle  A handle returned from orb_subscribe.
+	 * @param tag     Value to identify the subscription, smaller than the queue size.
+	 * @return    OK on success, ERROR otherwise with errno set accordingly.
+	 */
+	int  orb_update_queue_attach(orb_update_queue_t queue, int handle, unsigned tag);
+
+	/**
+	 * Wait for updates on an update queue.
+	 *
+	 * @param queue   A queue returned from orb_update_queue_create.
+	 * @param tags    Returns the tags of the updated subscriptions.
+	 * @param max_tags Size of the tags buffer.
+	 * @param timeout_us Maximum time to wait in microseconds, 0 to only check.
+	 * @return    The number of tags returned, 0 on timeout.
+	 */
+	int  orb_update_queue_wait(orb_update_queue_t queue, uint16_t *tags, unsigned max_tags, unsigned timeout_us);
+
 	/**
 	 * Return the last time that the topic was updated. If a queue is used, it returns
 	 * the timestamp of the latest element in the queue.
@@ -0,0 +1,161 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#include "uORBUpdateQueue.hpp"
+#include <px4_time.h>
+#include <errno.h>
+#include <string.h>
+
+#ifdef __PX4_NUTTX
+#define UPDATE_QUEUE_LOCK()	irqstate_t flags = px4_enter_critical_section()
+#define UPDATE_QUEUE_UNLOCK()	px4_leave_critical_section(flags)
+#else
+#define UPDATE_QUEUE_LOCK()	pthread_mutex_lock(&_mutex)
+#define UPDATE_QUEUE_UNLOCK()	pthread_mutex_unlock(&_mutex)
+#endif
+
+uORB::UpdateQueue::UpdateQueue(unsigned size) :
+	_size(size)
+{
+	px4_sem_init(&_sem, 0, 0);
+#ifndef __PX4_NUTTX
+	pthread_mutex_init(&_mutex, nullptr);
+#endif
+}
+
+uORB::UpdateQueue::~UpdateQueue()
+{
+	delete[] _ring;
+	delete[] _queued;
+	px4_sem_destroy(&_sem);
+#ifndef __PX4_NUTTX
+	pthread_mutex_destroy(&_mutex);
+#endif
+}
+
+bool
+uORB::UpdateQueue::init()
+{
+	if (_size == 0 || _size > UINT16_MAX + 1u) {
+		return false;
+	}
+
+	_ring = new uint16_t[_size];
+	_queued = new uint8_t[_size];
+
+	if (_ring == nullptr || _queued == nullptr) {
+		return false;
+	}
+
+	memset(_queued, 0, _size);
+	return true;
+}
+
+void
+uORB::UpdateQueue::push(unsigned tag)
+{
+	if (tag >= _size) {
+		return;
+	}
+
+	bool wakeup = false;
+
+	UPDATE_QUEUE_LOCK();
+
+	if (!_queued[tag]) {
+		_queued[tag] = 1;
+		_ring[(_head + _count) % _size] = tag;
+		++_count;
+
+		/* the consumer drains the whole queue, so it only needs a wakeup if it is blocked */
+		wakeup = _waiting;
+		_waiting = false;
+	}
+
+	UPDATE_QUEUE_UNLOCK();
+
+	if (wakeup) {
+		px4_sem_post(&_sem);
+	}
+}
+
+int
+uORB::UpdateQueue::pop(uint16_t *tags, unsigned max_tags, unsigned timeout_us)
+{
+	struct timespec deadline;
+	bool have_deadline = false;
+
+	while (true) {
+		unsigned n = 0;
+
+		UPDATE_QUEUE_LOCK();
+
+		while (n < max_tags && _count > 0) {
+			uint16_t tag = _ring[_head];
+			_queued[tag] = 0;
+			_head = (_head + 1) % _size;
+			--_count;
+			tags[n++] = tag;
+		}
+
+		_waiting = (n == 0 && timeout_us > 0);
+
+		UPDATE_QUEUE_UNLOCK();
+
+		if (n > 0 || timeout_us == 0) {
+			return n;
+		}
+
+		/* after a timeout a push can still post, so there may be a stale post: wait in a loop */
+		if (!have_deadline) {
+			px4_clock_gettime(CLOCK_REALTIME, &deadline);
+			uint64_t nsecs = deadline.tv_nsec + (uint64_t)timeout_us * 1000;
+			deadline.tv_sec += nsecs / 1000000000;
+			deadline.tv_nsec = nsecs % 1000000000;
+			have_deadline = true;
+		}
+
+		if (px4_sem_timedwait(&_sem, &deadline) != 0 && errno == ETIMEDOUT) {
+			clear_waiting();
+			return 0;
+		}
+	}
+}
+
+void
+uORB::UpdateQueue::clear_waiting()
+{
+	UPDATE_QUEUE_LOCK();
+	_waiting = false;
+	UPDATE_QUEUE_UNLOCK();
+}
@@ -0,0 +1,108 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2016 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+#ifndef _uORBUpdateQueue_hpp_
+#define _uORBUpdateQueue_hpp_
+
+#include <stdint.h>
+#include <px4_posix.h>
+#ifndef __PX4_NUTTX
+#include <pthread.h>
+#endif
+
+namespace uORB
+{
+class UpdateQueue;
+}
+
+/**
+ * Queue of update notifications for a set of subscriptions.
+ *
+ * Each subscription attached to the queue has a tag. When a publisher updates
+ * the topic (and the update is visible to the subscription, i.e. its update
+ * interval has elapsed), the tag is pushed into the queue, so that a single
+ * consumer can process exactly the updated subscriptions instead of checking
+ * all of them.
+ *
+ * A tag is queued at most once until it is popped, which bounds the queue
+ * to one entry per tag: tags must be smaller than the size of the queue.
+ * Pushing is allowed from any thread (and from interrupt context on NuttX),
+ * there must be a single consumer.
+ */
+class uORB::UpdateQueue
+{
+public:
+	UpdateQueue(unsigned size);
+	~UpdateQueue();
+
+	/**
+	 * Allocate the queue storage.
+	 * @return true on success
+	 */
+	bool init();
+
+	/**
+	 * Queue a tag if it is not already queued. Called by publishers.
+	 */
+	void push(unsigned tag);
+
+	/**
+	 * Pop queued tags, waiting for at least one.
+	 * @param tags    buffer for the popped tags, in the order they were pushed
+	 * @param max_tags size of tags
+	 * @param timeout_us maximum time to wait, 0 to return immediately
+	 * @return number of tags popped, 0 on timeout
+	 */
+	int pop(uint16_t *tags, unsigned max_tags, unsigned timeout_us);
+
+	unsigned size() const { return _size; }
+
+private:
+	const unsigned _size;
+	uint16_t *_ring = nullptr;	///< queued tags
+	uint8_t *_queued = nullptr;	///< per tag: 1 if it is in _ring
+	unsigned _head = 0;		///< next position to pop from
+	unsigned _count = 0;		///< number of tags in _ring
+	bool _waiting = false;		///< set while the consumer is (about to be) blocked on _sem
+	px4_sem_t _sem;			///< posted on push if the consumer is waiting
+#ifndef __PX4_NUTTX
+	pthread_mutex_t _mutex;		///< protects the queue, on NuttX a critical section is used instead
+#endif
+
+	void clear_waiting();
+
+	/* do not allow copying this class */
+	UpdateQueue(const UpdateQueue &);
+	UpdateQueue &operator=(const UpdateQueue &);
+};
+
+#endif /* _uORBUpdateQueue_hpp_ */
@@ -33,9 +33,11 @@
 
 #include "uORBTest_UnitTest.hpp"
 #include "../uORBCommon.hpp"
+#include "../SubscriptionSet.hpp"
 #include <px4_config.h>
 #include <px4_time.h>
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
 #include <poll.h>
 
@@ -178,6 +180,24 @@ int uORBTest::UnitTest::test()
 		return ret;
 	}
 
+	ret = test_borrow();
+
+	if (ret != OK) {
+		return ret;
+	}
+
+	ret = test_update_queue();
+
+	if (ret != OK) {
+		return ret;
+	}
+
+	ret = test_subscription_set();
+
+	if (ret != OK) {
+		return ret;
+	}
+
 	return test_queue_poll_notify();
 }
 
@@ -690,6 +710,178 @@ int uORBTest::UnitTest::test_queue()
 }
 
 
+int uORBTest::UnitTest::test_borrow()
+{
+	test_note("Testing orb borrow/release");
+
+	struct orb_test_large t;
+	const struct orb_test_large *b0, *b1;
+	orb_advert_t ptopic;
+	bool updated;
+
+	t.val = 1;
+	ptopic = orb_advertise(ORB_ID(orb_test_large_borrow), &t);
+
+	if (ptopic == nullptr) {
+		return test_fail("advertise failed: %d", errno);
+	}
+
+	int sfd = orb_subscribe(ORB_ID(orb_test_large_borrow));
+
+	if (sfd < 0) {
+		return test_fail("subscribe failed: %d", errno);
+	}
+
+	if (PX4_OK != orb_borrow(ORB_ID(orb_test_large_borrow), sfd, (const void **)&b0)) {
+		return test_fail("borrow(1) failed: %d", errno);
+	}
+
+	if (b0->val != 1) {
+		return test_fail("borrow(1) mismatch: %d expected %d", b0->val, 1);
+	}
+
+	orb_check(sfd, &updated);
+
+	if (updated) {
+		return test_fail("spurious updated flag after borrow");
+	}
+
+	/* publishing must not touch the borrowed buffer */
+	t.val = 2;
+	orb_publish(ORB_ID(orb_test_large_borrow), ptopic, &t);
+	t.val = 3;
+	orb_publish(ORB_ID(orb_test_large_borrow), ptopic, &t);
+
+	if (b0->val != 1) {
+		return test_fail("borrowed data overwritten: %d", b0->val);
+	}
+
+	orb_check(sfd, &updated);
+
+	if (!updated) {
+		return test_fail("missing updated flag");
+	}
+
+	/* an older generation is still borrowed, so this must be refused */
+	if (PX4_OK == orb_borrow(ORB_ID(orb_test_large_borrow), sfd, (const void **)&b1)) {
+		return test_fail("borrow(2) succeeded while older data is borrowed");
+	}
+
+	if (PX4_OK != orb_release(ORB_ID(orb_test_large_borrow), sfd, b0)) {
+		return test_fail("release(1) failed: %d", errno);
+	}
+
+	if (PX4_OK != orb_borrow(ORB_ID(orb_test_large_borrow), sfd, (const void **)&b1)) {
+		return test_fail("borrow(3) failed: %d", errno);
+	}
+
+	if (b1->val != 3) {
+		return test_fail("borrow(3) mismatch: %d expected %d", b1->val, 3);
+	}
+
+	if (PX4_OK != orb_release(ORB_ID(orb_test_large_borrow), sfd, b1)) {
+		return test_fail("release(3) failed: %d", errno);
+	}
+
+	if (PX4_OK == orb_release(ORB_ID(orb_test_large_borrow), sfd, b1)) {
+		return test_fail("double release succeeded");
+	}
+
+	orb_unsubscribe(sfd);
+	orb_unadvertise(ptopic);
+
+	return test_note("PASS orb borrow/release");
+}
+
+int uORBTest::UnitTest::test_update_queue()
+{
+	test_note("Testing orb update queue");
+
+	struct orb_test_medium t;
+	orb_advert_t ptopic_a, ptopic_b;
+	uint16_t tags[4];
+	int n;
+
+	t.val = 1;
+	ptopic_a = orb_advertise(ORB_ID(orb_test_medium_update_queue_a), &t);
+
+	if (ptopic_a == nullptr) {
+		return test_fail("advertise failed: %d", errno);
+	}
+
+	int sfd_a = orb_subscribe(ORB_ID(orb_test_medium_update_queue_a));
+	int sfd_b = orb_subscribe(ORB_ID(orb_test_medium_update_queue_b));
+
+	if (sfd_a < 0 || sfd_b < 0) {
+		return test_fail("subscribe failed: %d", errno);
+	}
+
+	orb_update_queue_t queue = orb_update_queue_create(4);
+
+	if (queue == nullptr) {
+		return test_fail("queue create failed");
+	}
+
+	if (PX4_OK == orb_update_queue_attach(queue, sfd_a, 4)) {
+		return test_fail("attach with out-of-range tag succeeded");
+	}
+
+	if (PX4_OK != orb_update_queue_attach(queue, sfd_a, 0) ||
+	    PX4_OK != orb_update_queue_attach(queue, sfd_b, 1)) {
+		return test_fail("attach failed: %d", errno);
+	}
+
+	/* data published before attaching is reported right away */
+	n = orb_update_queue_wait(queue, tags, 4, 0);
+
+	if (n != 1 || tags[0] != 0) {
+		return test_fail("initial data not reported (%i tags)", n);
+	}
+
+	n = orb_update_queue_wait(queue, tags, 4, 1000);
+
+	if (n != 0) {
+		return test_fail("spurious update (%i tags)", n);
+	}
+
+	/* tags in publication order, each at most once */
+	t.val = 2;
+	ptopic_b = orb_advertise(ORB_ID(orb_test_medium_update_queue_b), &t);
+
+	if (ptopic_b == nullptr) {
+		return test_fail("advertise failed: %d", errno);
+	}
+
+	orb_publish(ORB_ID(orb_test_medium_update_queue_a), ptopic_a, &t);
+	orb_publish(ORB_ID(orb_test_medium_update_queue_a), ptopic_a, &t);
+
+	n = orb_update_queue_wait(queue, tags, 4, 1000);
+
+	if (n != 2 || tags[0] != 1 || tags[1] != 0) {
+		return test_fail("wrong tags after publish (%i tags)", n);
+	}
+
+	/* a detached subscription is not reported anymore */
+	orb_copy(ORB_ID(orb_test_medium_update_queue_a), sfd_a, &t);
+	orb_update_queue_attach(nullptr, sfd_a, 0);
+	orb_publish(ORB_ID(orb_test_medium_update_queue_a), ptopic_a, &t);
+	orb_publish(ORB_ID(orb_test_medium_update_queue_b), ptopic_b, &t);
+
+	n = orb_update_queue_wait(queue, tags, 4, 1000);
+
+	if (n != 1 || tags[0] != 1) {
+		return test_fail("wrong tags after detach (%i tags)", n);
+	}
+
+	orb_unsubscribe(sfd_a);
+	orb_unsubscribe(sfd_b);
+	orb_update_queue_destroy(queue);
+	orb_unadvertise(ptopic_a);
+	orb_unadvertise(ptopic_b);
+
+	return test_note("PASS orb update queue");
+}
+
 int uORBTest::UnitTest::pub_test_queue_entry(char *const argv[])
 {
 	uORBTest::UnitTest &t = uORBTest::UnitTest::instance();
@@ -733,6 +925,96 @@ int uORBTest::UnitTest::pub_test_queue_main()
 	return 0;
 }
 
+int uORBTest::UnitTest::test_subscription_set()
+{
+	test_note("Testing subscription set");
+
+	struct orb_test t, a, b;
+	memset(&t, 0, sizeof(t));
+	memset(&a, 0, sizeof(a));
+	memset(&b, 0, sizeof(b));
+
+	t.val = 1;
+	orb_advert_t ptopic_a = orb_advertise(ORB_ID(orb_test_subset), &t);
+	orb_advert_t ptopic_b = nullptr;
+
+	if (ptopic_a == nullptr) {
+		return test_fail("advertise failed: %d", errno);
+	}
+
+	int ret = OK;
+	uint32_t updated;
+
+	{
+		uORB::SubscriptionBase sub_a(ORB_ID(orb_test_subset));
+		uORB::SubscriptionBase sub_b(ORB_ID(orb_test_subset_idle));
+		uORB::SubscriptionSet set;
+
+		if (set.add(sub_a, &a) != 0 || set.add(sub_b, &b) != 1) {
+			ret = test_fail("add failed");
+			goto out;
+		}
+
+		/* data published before adding the subscription is reported */
+		updated = set.update();
+
+		if (updated != 1 || a.val != 1) {
+			ret = test_fail("initial update: mask 0x%x, val %d", updated, a.val);
+			goto out;
+		}
+
+		if ((updated = set.update()) != 0) {
+			ret = test_fail("spurious update: mask 0x%x", updated);
+			goto out;
+		}
+
+		/* several publications are one update with the latest data */
+		t.val = 2;
+		orb_publish(ORB_ID(orb_test_subset), ptopic_a, &t);
+		t.val = 3;
+		orb_publish(ORB_ID(orb_test_subset), ptopic_a, &t);
+
+		updated = set.update();
+
+		if (updated != 1 || a.val != 3) {
+			ret = test_fail("update a: mask 0x%x, val %d", updated, a.val);
+			goto out;
+		}
+
+		/* a topic advertised after adding the subscription */
+		t.val = 4;
+		ptopic_b = orb_advertise(ORB_ID(orb_test_subset_idle), &t);
+
+		updated = set.update();
+
+		if (updated != 2 || b.val != 4) {
+			ret = test_fail("update b: mask 0x%x, val %d", updated, b.val);
+			goto out;
+		}
+
+		/* data copied outside of the set after the notification must not be reported again */
+		t.val = 5;
+		orb_publish(ORB_ID(orb_test_subset), ptopic_a, &t);
+		orb_copy(ORB_ID(orb_test_subset), sub_a.getHandle(), &a);
+
+		if ((updated = set.update()) != 0) {
+			ret = test_fail("update after copy: mask 0x%x", updated);
+			goto out;
+		}
+	}
+
+	ret = test_note("PASS subscription set");
+
+out:
+	orb_unadvertise(ptopic_a);
+
+	if (ptopic_b != nullptr) {
+		orb_unadvertise(ptopic_b);
+	}
+
+	return ret;
+}
+
 int uORBTest::UnitTest::test_queue_poll_notify()
 {
 	test_note("Testing orb queuing (poll & notify)");
@@ -797,6 +1079,388 @@ int uORBTest::UnitTest::test_queue_poll_notify()
 	return test_note("PASS orb queuing (poll & notify), got %i messages", next_expected_val);
 }
 
+int uORBTest::UnitTest::pubcopy_bench_sub_entry(char *const argv[])
+{
+	uORBTest::UnitTest &t = uORBTest::UnitTest::instance();
+	return t.pubcopy_bench_sub_main();
+}
+
+int uORBTest::UnitTest::pubcopy_bench_sub_main()
+{
+	struct orb_test_medium t;
+	unsigned num_copies = 0;
+	unsigned copy_time_total = 0;
+	unsigned copy_time_max = 0;
+	unsigned torn_reads = 0;
+
+	int sfd = orb_subscribe(ORB_ID(orb_test_medium_pubcopy));
+
+	if (sfd < 0) {
+		return test_fail("subscribe failed: %d", errno);
+	}
+
+	px4_pollfd_struct_t fds[1];
+	fds[0].fd = sfd;
+	fds[0].events = POLLIN;
+
+	__sync_fetch_and_add(&_bench_subs_running, 1);
+
+	while (!_thread_should_exit) {
+		int poll_ret = px4_poll(fds, 1, 100);
+
+		if (poll_ret <= 0 || !(fds[0].revents & POLLIN)) {
+			continue;
+		}
+
+		hrt_abstime start = hrt_absolute_time();
+		orb_copy(ORB_ID(orb_test_medium_pubcopy), sfd, &t);
+		unsigned dt = hrt_elapsed_time(&start);
+
+		copy_time_total += dt;
+
+		if (dt > copy_time_max) {
+			copy_time_max = dt;
+		}
+
+		/* the publisher fills the whole payload with the same value, anything else is a torn read */
+		for (unsigned i = 0; i < sizeof(t.junk); ++i) {
+			if (t.junk[i] != (char)t.val) {
+				++torn_reads;
+				break;
+			}
+		}
+
+		++num_copies;
+	}
+
+	orb_unsubscribe(sfd);
+
+	__sync_fetch_and_add(&_bench_num_copies, num_copies);
+	__sync_fetch_and_add(&_bench_copy_time_total, copy_time_total);
+	__sync_fetch_and_add(&_bench_torn_reads, torn_reads);
+
+	unsigned cur_max;
+
+	do {
+		cur_max = _bench_copy_time_max;
+	} while (copy_time_max > cur_max && !__sync_bool_compare_and_swap(&_bench_copy_time_max, cur_max, copy_time_max));
+
+	__sync_fetch_and_sub(&_bench_subs_running, 1);
+
+	return 0;
+}
+
+int uORBTest::UnitTest::pubcopy_bench(unsigned num_subscribers)
+{
+	test_note("---------------- PUBLISH/COPY BENCHMARK (%u subscribers) ------------------", num_subscribers);
+
+	struct orb_test_medium t;
+	memset(&t, 0, sizeof(t));
+
+	orb_advert_t ptopic = orb_advertise(ORB_ID(orb_test_medium_pubcopy), &t);
+
+	if (ptopic == nullptr) {
+		return test_fail("advertise failed: %d", errno);
+	}
+
+	_thread_should_exit = false;
+	_bench_subs_running = 0;
+	_bench_num_copies = 0;
+	_bench_copy_time_total = 0;
+	_bench_copy_time_max = 0;
+	_bench_torn_reads = 0;
+
+	char *const args[1] = { NULL };
+
+	for (unsigned i = 0; i < num_subscribers; ++i) {
+		int sub_task = px4_task_spawn_cmd("uorb_bench_sub",
+						  SCHED_DEFAULT,
+						  SCHED_PRIORITY_MAX - 5,
+						  1500,
+						  (px4_main_t)&uORBTest::UnitTest::pubcopy_bench_sub_entry,
+						  args);
+
+		if (sub_task < 0) {
+			_thread_should_exit = true;
+			return test_fail("failed launching task");
+		}
+	}
+
+	/* wait for all subscribers to be ready */
+	for (int i = 0; i < 100 && _bench_subs_running < num_subscribers; ++i) {
+		usleep(10 * 1000);
+	}
+
+	const unsigned num_messages = 10000;
+	unsigned publish_time_total = 0;
+	unsigned publish_time_max = 0;
+
+	for (unsigned i = 0; i < num_messages; ++i) {
+		t.val = i;
+		t.time = hrt_absolute_time();
+		memset(t.junk, (char)t.val, sizeof(t.junk));
+
+		hrt_abstime start = hrt_absolute_time();
+
+		if (PX4_OK != orb_publish(ORB_ID(orb_test_medium_pubcopy), ptopic, &t)) {
+			_thread_should_exit = true;
+			return test_fail("publish failed");
+		}
+
+		unsigned dt = hrt_elapsed_time(&start);
+		publish_time_total += dt;
+
+		if (dt > publish_time_max) {
+			publish_time_max = dt;
+		}
+
+		/* publish at ~5 kHz, fast enough to race with the subscribers' copies */
+		usleep(200);
+	}
+
+	_thread_should_exit = true;
+
+	while (_bench_subs_running > 0) {
+		usleep(10 * 1000);
+	}
+
+	orb_unadvertise(ptopic);
+
+	test_note("publish: mean %8.4f us, max %u us (%u messages)",
+		  (double)publish_time_total / num_messages, publish_time_max, num_messages);
+
+	if (_bench_num_copies > 0) {
+		test_note("copy:    mean %8.4f us, max %u us (%u copies)",
+			  (double)_bench_copy_time_total / _bench_num_copies, _bench_copy_time_max, _bench_num_copies);
+	}
+
+	if (_bench_torn_reads > 0) {
+		return test_fail("%u torn reads", _bench_torn_reads);
+	}
+
+	return test_note("PASS publish/copy benchmark");
+}
+
+int uORBTest::UnitTest::pollset_bench(unsigned num_fds)
+{
+	test_note("---------------- POLL SET BENCHMARK (%u fds) ------------------", num_fds);
+
+	const unsigned max_fds = 8;
+	const unsigned iterations = 100000;
+
+	if (num_fds < 1 || num_fds > max_fds) {
+		return test_fail("number of fds must be 1..%u", max_fds);
+	}
+
+	/*
+	 * Sensors-style loop: the first fd receives data like a gyro would,
+	 * the others stay idle. The data is never consumed, so every wait
+	 * returns immediately and the time measured is the per-wakeup overhead.
+	 */
+	int subs[max_fds];
+	px4_pollfd_struct_t fds[max_fds];
+
+	for (unsigned i = 0; i < num_fds; ++i) {
+		subs[i] = orb_subscribe(i == 0 ? ORB_ID(orb_test_pollset) : ORB_ID(orb_test_pollset_idle));
+
+		if (subs[i] < 0) {
+			return test_fail("subscribe failed: %d", errno);
+		}
+
+		fds[i].fd = subs[i];
+		fds[i].events = POLLIN;
+	}
+
+	struct orb_test t;
+	memset(&t, 0, sizeof(t));
+
+	orb_advert_t ptopic = orb_advertise(ORB_ID(orb_test_pollset), &t);
+
+	if (ptopic == nullptr) {
+		return test_fail("advertise failed: %d", errno);
+	}
+
+	int ret = OK;
+	hrt_abstime poll_time = 0;
+	hrt_abstime pollset_time = 0;
+	px4_pollset_t set;
+
+	hrt_abstime start = hrt_absolute_time();
+
+	for (unsigned i = 0; i < iterations; ++i) {
+		if (px4_poll(fds, num_fds, 0) != 1) {
+			ret = test_fail("px4_poll: expected 1 ready fd");
+			goto out;
+		}
+	}
+
+	poll_time = hrt_elapsed_time(&start);
+
+	if (px4_pollset_init(&set, fds, num_fds) != PX4_OK) {
+		ret = test_fail("px4_pollset_init failed: %d", px4_errno);
+		goto out;
+	}
+
+	start = hrt_absolute_time();
+
+	for (unsigned i = 0; i < iterations; ++i) {
+		if (px4_pollset_wait(&set, 0) != 1) {
+			ret = test_fail("px4_pollset_wait: expected 1 ready fd");
+			break;
+		}
+	}
+
+	pollset_time = hrt_elapsed_time(&start);
+
+	/* consuming the update must clear the ready state, a new publication must set it again */
+	if (ret == OK) {
+		orb_copy(ORB_ID(orb_test_pollset), subs[0], &t);
+
+		if (px4_pollset_wait(&set, 0) != 0) {
+			ret = test_fail("px4_pollset_wait: fd still ready after orb_copy");
+
+		} else {
+			t.val = 1;
+			orb_publish(ORB_ID(orb_test_pollset), ptopic, &t);
+
+			if (px4_pollset_wait(&set, 100) != 1 || !(fds[0].revents & POLLIN)) {
+				ret = test_fail("px4_pollset_wait: publication not reported");
+			}
+		}
+	}
+
+	px4_pollset_deinit(&set);
+
+	if (ret == OK) {
+		test_note("px4_poll:          %8.1f ns per wakeup", (double)poll_time * 1000.0 / iterations);
+		test_note("px4_pollset_wait:  %8.1f ns per wakeup", (double)pollset_time * 1000.0 / iterations);
+		ret = test_note("PASS poll set benchmark");
+	}
+
+out:
+	orb_unadvertise(ptopic);
+
+	for (unsigned i = 0; i < num_fds; ++i) {
+		orb_unsubscribe(subs[i]);
+	}
+
+	return ret;
+}
+
+int uORBTest::UnitTest::subset_bench(unsigned num_subs, unsigned num_updated)
+{
+	test_note("---------------- SUBSCRIPTION SET BENCHMARK (%u subscriptions, %u updated) ------------------",
+		  num_subs, num_updated);
+
+	const unsigned max_subs = uORB::SubscriptionSet::MAX_SUBSCRIPTIONS;
+	const unsigned iterations = 20000;
+
+	if (num_subs < 1 || num_subs > max_subs || num_updated > num_subs) {
+		return test_fail("number of subscriptions must be 1..%u, at most all updated", max_subs);
+	}
+
+	/*
+	 * Commander-style loop: one topic is published every loop, num_updated
+	 * subscriptions see it, the others are subscribed to an idle topic.
+	 */
+	struct orb_test t, data[max_subs];
+	memset(&t, 0, sizeof(t));
+
+	orb_advert_t ptopic = orb_advertise(ORB_ID(orb_test_subset), &t);
+	orb_advert_t ptopic_idle = orb_advertise(ORB_ID(orb_test_subset_idle), &t);
+
+	if (ptopic == nullptr || ptopic_idle == nullptr) {
+		return test_fail("advertise failed: %d", errno);
+	}
+
+	uORB::SubscriptionBase *subs[max_subs];
+
+	for (unsigned i = 0; i < num_subs; ++i) {
+		subs[i] = new uORB::SubscriptionBase(i < num_updated ? ORB_ID(orb_test_subset) : ORB_ID(orb_test_subset_idle));
+		orb_copy(subs[i]->getMeta(), subs[i]->getHandle(), &data[i]);
+	}
+
+	int ret = OK;
+	unsigned copies = 0;
+
+	/* before: orb_check() on every subscription, orb_copy() on the updated ones */
+	hrt_abstime start = hrt_absolute_time();
+
+	for (unsigned i = 0; i < iterations; ++i) {
+		t.val = i;
+		orb_publish(ORB_ID(orb_test_subset), ptopic, &t);
+
+		for (unsigned j = 0; j < num_subs; ++j) {
+			bool updated;
+			orb_check(subs[j]->getHandle(), &updated);
+
+			if (updated) {
+				orb_copy(subs[j]->getMeta(), subs[j]->getHandle(), &data[j]);
+				copies++;
+			}
+		}
+	}
+
+	hrt_abstime check_time = hrt_elapsed_time(&start);
+	const unsigned check_calls = num_subs + copies / iterations;
+
+	if (copies != iterations * num_updated) {
+		ret = test_fail("orb_check: %u copies, expected %u", copies, iterations * num_updated);
+	}
+
+	hrt_abstime set_time = 0;
+	copies = 0;
+
+	{
+		uORB::SubscriptionSet set;
+
+		for (unsigned i = 0; i < num_subs; ++i) {
+			set.add(*subs[i], &data[i]);
+		}
+
+		start = hrt_absolute_time();
+
+		for (unsigned i = 0; i < iterations && ret == OK; ++i) {
+			t.val = i;
+			orb_publish(ORB_ID(orb_test_subset), ptopic, &t);
+
+			uint32_t updated = set.update();
+
+			for (unsigned j = 0; j < num_subs; ++j) {
+				if (updated & (1u << j)) {
+					copies++;
+				}
+			}
+		}
+
+		set_time = hrt_elapsed_time(&start);
+	}
+
+	if (ret == OK && copies != iterations * num_updated) {
+		ret = test_fail("subscription set: %u copies, expected %u", copies, iterations * num_updated);
+	}
+
+	if (ret == OK) {
+		/*
+		 * each orb_check()/orb_copy() is a device lookup (a syscall on NuttX), the set pops the queue once
+		 * and copies each updated subscription with one orb_copy_if_updated()
+		 */
+		test_note("orb_check + orb_copy: %8.1f ns per loop, %u device calls per loop",
+			  (double)check_time * 1000.0 / iterations, check_calls);
+		test_note("subscription set:     %8.1f ns per loop, %u device calls + 1 queue pop per loop",
+			  (double)set_time * 1000.0 / iterations, num_updated);
+		ret = test_note("PASS subscription set benchmark");
+	}
+
+	for (unsigned i = 0; i < num_subs; ++i) {
+		delete subs[i];
+	}
+
+	orb_unadvertise(ptopic);
+	orb_unadvertise(ptopic_idle);
+
+	return ret;
+}
 
 int uORBTest::UnitTest::test_fail(const char *fmt, ...)
 {
@@ -43,6 +43,10 @@ struct orb_test {
 };
 ORB_DEFINE(orb_test, struct orb_test, sizeof(orb_test), "ORB_TEST:int val;hrt_abstime time;");
 ORB_DEFINE(orb_multitest, struct orb_test, sizeof(orb_test), "ORB_MULTITEST:int val;hrt_abstime time;");
+ORB_DEFINE(orb_test_pollset, struct orb_test, sizeof(orb_test), "ORB_TEST_POLLSET:int val;hrt_abstime time;");
+ORB_DEFINE(orb_test_pollset_idle, struct orb_test, sizeof(orb_test), "ORB_TEST_POLLSET_IDLE:int val;hrt_abstime time;");
+ORB_DEFINE(orb_test_subset, struct orb_test, sizeof(orb_test), "ORB_TEST_SUBSET:int val;hrt_abstime time;");
+ORB_DEFINE(orb_test_subset_idle, struct orb_test, sizeof(orb_test), "ORB_TEST_SUBSET_IDLE:int val;hrt_abstime time;");
 
 
 struct orb_test_medium {
@@ -58,6 +62,12 @@ ORB_DEFINE(orb_test_medium_queue, struct orb_test_medium, sizeof(orb_test_medium
 	   "ORB_TEST_MEDIUM_MULTI:int val;hrt_abstime time;char[64] junk;");
 ORB_DEFINE(orb_test_medium_queue_poll, struct orb_test_medium, sizeof(orb_test_medium),
 	   "ORB_TEST_MEDIUM_MULTI:int val;hrt_abstime time;char[64] junk;");
+ORB_DEFINE(orb_test_medium_pubcopy, struct orb_test_medium, sizeof(orb_test_medium),
+	   "ORB_TEST_MEDIUM_PUBCOPY:int val;hrt_abstime time;char[64] junk;");
+ORB_DEFINE(orb_test_medium_update_queue_a, struct orb_test_medium, sizeof(orb_test_medium),
+	   "ORB_TEST_MEDIUM_UPDATE_QUEUE_A:int val;hrt_abstime time;char[64] junk;");
+ORB_DEFINE(orb_test_medium_update_queue_b, struct orb_test_medium, sizeof(orb_test_medium),
+	   "ORB_TEST_MEDIUM_UPDATE_QUEUE_B:int val;hrt_abstime time;char[64] junk;");
 
 struct orb_test_large {
 	int val;
@@ -66,6 +76,8 @@ struct orb_test_large {
 };
 ORB_DEFINE(orb_test_large, struct orb_test_large, sizeof(orb_test_large),
 	   "ORB_TEST_LARGE:int val;hrt_abstime time;char[512] junk;");
+ORB_DEFINE(orb_test_large_borrow, struct orb_test_large, sizeof(orb_test_large),
+	   "ORB_TEST_LARGE_BORROW:int val;hrt_abstime time;char[512] junk;");
 
 
 namespace uORBTest
@@ -82,6 +94,9 @@ public:
 	~UnitTest() {}
 	int test();
 	template<typename S> int latency_test(orb_id_t T, bool print);
+	int pubcopy_bench(unsigned num_subscribers);
+	int pollset_bench(unsigned num_fds);
+	int subset_bench(unsigned num_subs, unsigned num_updated);
 	int info();
 
 private:
@@ -112,6 +127,12 @@ private:
 
 	int test_multi2();
 
+	int test_borrow();
+
+	int test_update_queue();
+
+	int test_subscription_set();
+
 	/* queuing tests */
 	int test_queue();
 	static int pub_test_queue_entry(char *const argv[]);
@@ -119,6 +140,15 @@ private:
 	int test_queue_poll_notify();
 	volatile int _num_messages_sent = 0;
 
+	/* publish/copy benchmark with concurrent subscribers */
+	static int pubcopy_bench_sub_entry(char *const argv[]);
+	int pubcopy_bench_sub_main();
+	volatile unsigned _bench_subs_running = 0;
+	volatile unsigned _bench_num_copies = 0;
+	volatile unsigned _bench_copy_time_total = 0; ///< [us]
+	volatile unsigned _bench_copy_time_max = 0; ///< [us]
+	volatile unsigned _bench_torn_reads = 0;
+
 	int test_fail(const char *fmt, ...);
 	int test_note(const char *fmt, ...);
 };
@@ -32,6 +32,7 @@
  ****************************************************************************/
 
 #include <string.h>
+#include <stdlib.h>
 #include "../uORBDevices.hpp"
 #include "../uORB.h"
 #include "../uORBCommon.hpp"
@@ -44,7 +45,7 @@ extern "C" { __EXPORT int uorb_tests_main(int argc, char *argv[]); }
 
 static void usage()
 {
-	PX4_INFO("Usage: uorb_test 'latency_test'");
+	PX4_INFO("Usage: uorb_tests ['latency_test' [medium|large]|'pubcopy_bench' [<num subscribers>]|'pollset_bench' [<num fds>]|'subset_bench' [<num subscriptions> [<num updated>]]]");
 }
 
 int
@@ -90,6 +91,56 @@ uorb_tests_main(int argc, char *argv[])
 		}
 	}
 
+	/*
+	 * Benchmark publish/copy with concurrent subscribers.
+	 */
+	if (argc > 1 && !strcmp(argv[1], "pubcopy_bench")) {
+
+		uORBTest::UnitTest &t = uORBTest::UnitTest::instance();
+		unsigned num_subscribers = 4;
+
+		if (argc > 2) {
+			num_subscribers = strtoul(argv[2], nullptr, 10);
+		}
+
+		return t.pubcopy_bench(num_subscribers);
+	}
+
+	/*
+	 * Benchmark px4_poll() against a persistent poll set.
+	 */
+	if (argc > 1 && !strcmp(argv[1], "pollset_bench")) {
+
+		uORBTest::UnitTest &t = uORBTest::UnitTest::instance();
+		unsigned num_fds = 4;
+
+		if (argc > 2) {
+			num_fds = strtoul(argv[2], nullptr, 10);
+		}
+
+		return t.pollset_bench(num_fds);
+	}
+
+	/*
+	 * Benchmark orb_check() on every subscription against a subscription set.
+	 */
+	if (argc > 1 && !strcmp(argv[1], "subset_bench")) {
+
+		uORBTest::UnitTest &t = uORBTest::UnitTest::instance();
+		unsigned num_subs = 22;
+		unsigned num_updated = 3;
+
+		if (argc > 2) {
+			num_subs = strtoul(argv[2], nullptr, 10);
+		}
+
+		if (argc > 3) {
+			num_updated = strtoul(argv[3], nullptr, 10);
+		}
+
+		return t.subset_bench(num_subs, num_updated);
+	}
+
 #endif
 
 	usage();
@@ -65,21 +65,32 @@ static void		hrt_call_reschedule(void);
 
 static px4_sem_t 	_hrt_lock;
 static struct work_s	_hrt_work;
-#ifndef __PX4_QURT
-static hrt_abstime px4_timestart = 0;
-#else
-static int32_t dsp_offset = 0;
+#ifdef __PX4_QURT
+static volatile int32_t dsp_offset = 0;
 #endif
-static hrt_abstime _start_delay_time = 0;
-static hrt_abstime _delay_interval = 0;
-static hrt_abstime max_time = 0;
+
+/**
+ * Time base shared by all callers of hrt_absolute_time().
+ *
+ * Written only with _hrt_mutex held and published through _time_base_seq
+ * (odd while an update is in progress), so that readers can take a
+ * consistent snapshot without locking.
+ */
+struct hrt_time_base {
+	hrt_abstime timestart;		/**< CLOCK_MONOTONIC at time zero, 0 if not yet set */
+	hrt_abstime start_delay_time;	/**< time at which the simulator paused, 0 if running */
+	hrt_abstime delay_interval;	/**< accumulated simulator pause time */
+};
+
+static struct hrt_time_base _time_base = { 0, 0, 0 };
+static volatile unsigned _time_base_seq = 0;
 pthread_mutex_t _hrt_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static void
 hrt_call_invoke(void);
 
 static hrt_abstime
-_hrt_absolute_time_internal(void);
+_hrt_absolute_time_internal(const struct hrt_time_base *base);
 
 __EXPORT hrt_abstime hrt_reset(void);
 
@@ -150,13 +161,13 @@ uint64_t hrt_system_time(void)
 /*
  * Get absolute time.
  */
-hrt_abstime _hrt_absolute_time_internal(void)
+hrt_abstime _hrt_absolute_time_internal(const struct hrt_time_base *base)
 {
 	struct timespec ts;
 
 #if defined(__PX4_QURT)
 	// Don't use the timestart on the DSP on Snapdragon because we manually
-	// set the px4_timestart using the hrt_set_absolute_time_offset().
+	// set the offset using the hrt_set_absolute_time_offset().
 	px4_clock_gettime(CLOCK_MONOTONIC, &ts);
 	return ts_to_abstime(&ts) + dsp_offset;
 
@@ -166,14 +177,8 @@ hrt_abstime _hrt_absolute_time_internal(void)
 	return ts_to_abstime(&ts);
 
 #else
-
-	if (!px4_timestart) {
-		px4_clock_gettime(CLOCK_MONOTONIC, &ts);
-		px4_timestart = ts_to_abstime(&ts);
-	}
-
 	px4_clock_gettime(CLOCK_MONOTONIC, &ts);
-	return ts_to_abstime(&ts) - px4_timestart;
+	return ts_to_abstime(&ts) - base->timestart;
 #endif
 }
 
@@ -185,30 +190,111 @@ int hrt_set_absolute_time_offset(int32_t time_diff_us)
 }
 #endif
 
-/*
- * Get absolute time.
+static void hrt_time_base_write_begin(void)
+{
+	/* full barrier: the odd count is visible before any field changes */
+	__sync_fetch_and_add(&_time_base_seq, 1);
+}
+
+static void hrt_time_base_write_end(void)
+{
+	__sync_fetch_and_add(&_time_base_seq, 1);
+}
+
+/**
+ * Take a snapshot of the time base without locking.
+ *
+ * @param seq	set to the sequence count of the snapshot
+ * @return false if a writer was active, in which case the snapshot must be
+ *	   retaken under _hrt_mutex.
  */
-hrt_abstime hrt_absolute_time(void)
+static bool hrt_time_base_read(struct hrt_time_base *base, unsigned *seq)
 {
-	pthread_mutex_lock(&_hrt_mutex);
+	*seq = _time_base_seq;
+
+	if (*seq & 1) {
+		return false;
+	}
+
+	__sync_synchronize();
+	*base = _time_base;
+	__sync_synchronize();
+
+	return *seq == _time_base_seq;
+}
 
+/**
+ * Time seen by hrt_absolute_time() for a given time base.
+ */
+static hrt_abstime hrt_time_base_time(const struct hrt_time_base *base)
+{
 	hrt_abstime ret;
 
-	if (_start_delay_time > 0) {
-		ret = _start_delay_time;
+	if (base->start_delay_time > 0) {
+		ret = base->start_delay_time;
 
 	} else {
-		ret = _hrt_absolute_time_internal();
+		ret = _hrt_absolute_time_internal(base);
+	}
+
+	return ret - base->delay_interval;
+}
+
+/**
+ * Latch the time origin on first use. Must be called with _hrt_mutex held.
+ */
+static void hrt_time_base_start_locked(void)
+{
+#if !defined(__PX4_QURT) && !defined(__PX4_POSIX_EAGLE) && !defined(__PX4_POSIX_EXCELSIOR)
+
+	if (_time_base.timestart == 0) {
+		struct timespec ts;
+		px4_clock_gettime(CLOCK_MONOTONIC, &ts);
+
+		hrt_time_base_write_begin();
+		_time_base.timestart = ts_to_abstime(&ts);
+		hrt_time_base_write_end();
 	}
 
-	ret -= _delay_interval;
+#endif
+}
+
+/*
+ * Get absolute time.
+ *
+ * Lock-free in the common case: the time base only changes when the
+ * simulator pauses or resumes, so readers validate a snapshot against the
+ * sequence counter and only take _hrt_mutex if they raced with a writer
+ * (or the origin has not been latched yet). Falling back to the mutex
+ * rather than spinning keeps a high priority reader from starving a
+ * preempted writer.
+ *
+ * The sequence counter is checked again after reading the clock: writers
+ * read the clock only after starting their update, so if the count did not
+ * change, a pause that follows freezes the time at or after the value
+ * returned here and the time does not step backwards.
+ */
+hrt_abstime hrt_absolute_time(void)
+{
+	struct hrt_time_base base;
+	unsigned seq;
+
+	if (hrt_time_base_read(&base, &seq)
+#if !defined(__PX4_QURT) && !defined(__PX4_POSIX_EAGLE) && !defined(__PX4_POSIX_EXCELSIOR)
+	    && base.timestart != 0
+#endif
+	   ) {
+		hrt_abstime ret = hrt_time_base_time(&base);
+		__sync_synchronize();
 
-	if (ret < max_time) {
-		PX4_ERR("WARNING! TIME IS NEGATIVE! %d vs %d", (int)ret, (int)max_time);
-		ret = max_time;
+		if (seq == _time_base_seq) {
+			return ret;
+		}
 	}
 
-	max_time = ret;
+	pthread_mutex_lock(&_hrt_mutex);
+	hrt_time_base_start_locked();
+	hrt_abstime ret = hrt_time_base_time(&_time_base);
 	pthread_mutex_unlock(&_hrt_mutex);
 
 	return ret;
@@ -216,11 +302,17 @@ hrt_abstime hrt_absolute_time(void)
 
 __EXPORT hrt_abstime hrt_reset(void)
 {
-#ifndef __PX4_QURT
-	px4_timestart = 0;
+	pthread_mutex_lock(&_hrt_mutex);
+#if !defined(__PX4_QURT) && !defined(__PX4_POSIX_EAGLE) && !defined(__PX4_POSIX_EXCELSIOR)
+	hrt_time_base_write_begin();
+	_time_base.timestart = 0;
+	hrt_time_base_write_end();
 #endif
-	max_time = 0;
-	return _hrt_absolute_time_internal();
+	hrt_time_base_start_locked();
+	hrt_abstime now = _hrt_absolute_time_internal(&_time_base);
+	pthread_mutex_unlock(&_hrt_mutex);
+
+	return now;
 }
 
 /*
@@ -328,23 +420,54 @@ void	hrt_init(void)
 void	hrt_start_delay()
 {
 	pthread_mutex_lock(&_hrt_mutex);
-	_start_delay_time = _hrt_absolute_time_internal();
+	hrt_time_base_start_locked();
+
+	/* read the clock within the update, see hrt_absolute_time() */
+	hrt_time_base_write_begin();
+	_time_base.start_delay_time = _hrt_absolute_time_internal(&_time_base);
+	hrt_time_base_write_end();
+
 	pthread_mutex_unlock(&_hrt_mutex);
 }
 
 void	hrt_stop_delay()
 {
 	pthread_mutex_lock(&_hrt_mutex);
-	uint64_t delta = _hrt_absolute_time_internal() - _start_delay_time;
-	_delay_interval += delta;
-	_start_delay_time = 0;
+
+	/* both fields change together so readers never see a jump */
+	hrt_time_base_write_begin();
+	uint64_t delta = _hrt_absolute_time_internal(&_time_base) - _time_base.start_delay_time;
+	_time_base.delay_interval += delta;
+	_time_base.start_delay_time = 0;
+	hrt_time_base_write_end();
+
+	pthread_mutex_unlock(&_hrt_mutex);
 
 	if (delta > 10000) {
 		PX4_INFO("simulator is slow. Delay added: %" PRIu64 " us", delta);
 	}
+}
 
-	pthread_mutex_unlock(&_hrt_mutex);
+void	hrt_set_absolute_time(hrt_abstime time)
+{
+	pthread_mutex_lock(&_hrt_mutex);
+	hrt_time_base_start_locked();
+	hrt_abstime now = _hrt_absolute_time_internal(&_time_base);
 
+	/* a start_delay_time of 0 means not delayed */
+	if (now == 0) {
+		now = 1;
+	}
+
+	/* hold the time at start_delay_time - delay_interval == time. This wraps
+	 * around if time is ahead of real-time, which the unsigned arithmetic in
+	 * hrt_absolute_time() and hrt_stop_delay() undoes */
+	hrt_time_base_write_begin();
+	_time_base.start_delay_time = now;
+	_time_base.delay_interval = now - time;
+	hrt_time_base_write_end();
+
+	pthread_mutex_unlock(&_hrt_mutex);
 }
 
 static void
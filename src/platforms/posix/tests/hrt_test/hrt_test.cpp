@@ -40,10 +40,13 @@
  */
 
 #include <px4_time.h>
+#include <px4_log.h>
 #include <drivers/drv_hrt.h>
 #include "hrt_test.h"
 #include <unistd.h>
 #include <stdio.h>
+#include <string.h>
+#include <pthread.h>
 
 px4::AppState HRTTest::appState;
 
@@ -89,3 +92,101 @@ int HRTTest::main()
 
 	return 0;
 }
+
+#define BENCH_MAX_THREADS	32
+#define BENCH_ITERATIONS	1000000
+
+static pthread_mutex_t bench_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile bool bench_go = false;
+
+struct bench_thread {
+	pthread_t thread;
+	bool locked;
+	hrt_abstime elapsed_ns;
+	unsigned backwards;
+};
+
+/* the time read hrt_absolute_time() used to do: a global mutex around clock_gettime */
+static hrt_abstime bench_locked_time()
+{
+	struct timespec ts;
+	pthread_mutex_lock(&bench_mutex);
+	px4_clock_gettime(CLOCK_MONOTONIC, &ts);
+	pthread_mutex_unlock(&bench_mutex);
+	return ts_to_abstime(&ts);
+}
+
+static void *bench_thread_main(void *arg)
+{
+	struct bench_thread *t = (struct bench_thread *)arg;
+	struct timespec start, end;
+	hrt_abstime last = 0;
+
+	while (!bench_go) {
+		usleep(100);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+		hrt_abstime now = t->locked ? bench_locked_time() : hrt_absolute_time();
+
+		if (now < last) {
+			t->backwards++;
+		}
+
+		last = now;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	t->elapsed_ns = (end.tv_sec - start.tv_sec) * 1000000000ULL + end.tv_nsec - start.tv_nsec;
+	return nullptr;
+}
+
+static unsigned bench_run(struct bench_thread *threads, unsigned num_threads, bool locked)
+{
+	hrt_abstime total_ns = 0;
+	unsigned backwards = 0;
+
+	bench_go = false;
+
+	for (unsigned i = 0; i < num_threads; i++) {
+		memset(&threads[i], 0, sizeof(threads[i]));
+		threads[i].locked = locked;
+		pthread_create(&threads[i].thread, nullptr, bench_thread_main, &threads[i]);
+	}
+
+	bench_go = true;
+
+	for (unsigned i = 0; i < num_threads; i++) {
+		pthread_join(threads[i].thread, nullptr);
+		total_ns += threads[i].elapsed_ns;
+		backwards += threads[i].backwards;
+	}
+
+	PX4_INFO("%-22s %u threads: %.1f ns/call", locked ? "mutex + clock_gettime" : "hrt_absolute_time",
+		 num_threads, (double)total_ns / ((double)num_threads * BENCH_ITERATIONS));
+
+	return backwards;
+}
+
+int HRTTest::bench(unsigned num_threads)
+{
+	static struct bench_thread threads[BENCH_MAX_THREADS];
+
+	if (num_threads < 1 || num_threads > BENCH_MAX_THREADS) {
+		PX4_ERR("threads must be 1..%d", BENCH_MAX_THREADS);
+		return 1;
+	}
+
+	bench_run(threads, num_threads, true);
+	unsigned backwards = bench_run(threads, num_threads, false);
+
+	if (backwards > 0) {
+		PX4_ERR("hrt_absolute_time went backwards %u times", backwards);
+		return 1;
+	}
+
+	return 0;
+}
@@ -50,5 +50,14 @@ public:
 
 	int main();
 
+	/**
+	 * Measure the per-call cost of hrt_absolute_time() with several threads
+	 * calling it concurrently, against a mutex protected clock read.
+	 *
+	 * @param num_threads number of concurrent threads
+	 * @return 0 on success, 1 if time was seen going backwards
+	 */
+	static int bench(unsigned num_threads);
+
 	static px4::AppState appState; /* track requests to terminate app */
 };
@@ -41,6 +41,7 @@
 #include <px4_app.h>
 #include <px4_tasks.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sched.h>
 
@@ -50,7 +51,7 @@ extern "C" __EXPORT int hrttest_main(int argc, char *argv[]);
 int hrttest_main(int argc, char *argv[])
 {
 	if (argc < 2) {
-		PX4_WARN("usage: hrttest_main {start|stop|status}\n");
+		PX4_WARN("usage: hrttest_main {start|stop|status|bench [threads]}\n");
 		return 1;
 	}
 
@@ -77,6 +78,16 @@ int hrttest_main(int argc, char *argv[])
 		return 0;
 	}
 
+	if (!strcmp(argv[1], "bench")) {
+		unsigned num_threads = 8;
+
+		if (argc > 2) {
+			num_threads = strtoul(argv[2], nullptr, 10);
+		}
+
+		return HRTTest::bench(num_threads);
+	}
+
 	if (!strcmp(argv[1], "status")) {
 		if (HRTTest::appState.isRunning()) {
 			PX4_INFO("is running\n");
@@ -88,6 +99,6 @@ int hrttest_main(int argc, char *argv[])
 		return 0;
 	}
 
-	PX4_WARN("usage: hrttest_main {start|stop|status}\n");
+	PX4_WARN("usage: hrttest_main {start|stop|status|bench [threads]}\n");
 	return 1;
 }
@@ -44,8 +44,10 @@
 #include "vcdevtest_example.h"
 #include <drivers/drv_device.h>
 #include <drivers/device/device.h>
+#include <drivers/drv_hrt.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <pthread.h>
 
 px4::AppState VCDevExample::appState;
 
@@ -374,3 +376,103 @@ fail2:
 	sleep(3);
 	return ret;
 }
+
+#define CHURNDEV		"/dev/vdevchurn"
+#define CHURN_MAX_THREADS	16
+#define CHURN_MAX_FDS		64
+#define CHURN_MAX_TOTAL_FDS	256	/* half of the default PX4_MAX_FD, the rest is left to the running system */
+#define CHURN_ROUNDS		20000
+
+struct churn_thread {
+	pthread_t thread;
+	unsigned num_fds;
+	unsigned opens;
+	unsigned failures;
+};
+
+static void *churn_thread_main(void *arg)
+{
+	struct churn_thread *t = (struct churn_thread *)arg;
+	int fds[CHURN_MAX_FDS];
+
+	for (unsigned round = 0; round < CHURN_ROUNDS; round++) {
+		for (unsigned i = 0; i < t->num_fds; i++) {
+			fds[i] = px4_open(CHURNDEV, PX4_F_RDONLY);
+
+			if (fds[i] < 0) {
+				t->failures++;
+
+			} else {
+				t->opens++;
+			}
+		}
+
+		/* close every other descriptor first so that the free list gets shuffled */
+		for (unsigned i = 0; i < t->num_fds; i += 2) {
+			if (fds[i] >= 0) {
+				px4_close(fds[i]);
+			}
+		}
+
+		for (unsigned i = 1; i < t->num_fds; i += 2) {
+			if (fds[i] >= 0) {
+				px4_close(fds[i]);
+			}
+		}
+	}
+
+	return nullptr;
+}
+
+int VCDevExample::churn(unsigned num_threads, unsigned fds_per_thread)
+{
+	static struct churn_thread threads[CHURN_MAX_THREADS];
+
+	if (num_threads < 1 || num_threads > CHURN_MAX_THREADS ||
+	    fds_per_thread < 1 || fds_per_thread > CHURN_MAX_FDS) {
+		PX4_ERR("threads must be 1..%d, fds 1..%d", CHURN_MAX_THREADS, CHURN_MAX_FDS);
+		return 1;
+	}
+
+	if (num_threads * fds_per_thread > CHURN_MAX_TOTAL_FDS) {
+		PX4_ERR("threads x fds must be at most %d", CHURN_MAX_TOTAL_FDS);
+		return 1;
+	}
+
+	VDev node("vcdevchurn", CHURNDEV);
+
+	if (node.init() != PX4_OK) {
+		PX4_ERR("Failed to init churn device");
+		return 1;
+	}
+
+	hrt_abstime start = hrt_absolute_time();
+
+	for (unsigned i = 0; i < num_threads; i++) {
+		memset(&threads[i], 0, sizeof(threads[i]));
+		threads[i].num_fds = fds_per_thread;
+		pthread_create(&threads[i].thread, nullptr, churn_thread_main, &threads[i]);
+	}
+
+	unsigned opens = 0;
+	unsigned failures = 0;
+
+	for (unsigned i = 0; i < num_threads; i++) {
+		pthread_join(threads[i].thread, nullptr);
+		opens += threads[i].opens;
+		failures += threads[i].failures;
+	}
+
+	hrt_abstime elapsed = hrt_elapsed_time(&start);
+
+	PX4_INFO("%u threads x %u fds: %u open/close pairs in %llu us, %.0f ns per pair",
+		 num_threads, fds_per_thread, opens, (unsigned long long)elapsed,
+		 opens > 0 ? (double)elapsed * 1000.0 / (double)opens : 0.0);
+
+	if (failures > 0) {
+		PX4_ERR("%u opens failed", failures);
+		return 1;
+	}
+
+	return 0;
+}
@@ -52,6 +52,18 @@ public:
 
 	int main();
 
+	/**
+	 * Open/close churn benchmark for the POSIX descriptor table.
+	 *
+	 * Each thread repeatedly opens a batch of descriptors on a test device
+	 * and closes them again in a different order.
+	 *
+	 * @param num_threads number of concurrent threads
+	 * @param fds_per_thread descriptors held open by each thread per round
+	 * @return 0 on success, 1 on failure
+	 */
+	static int churn(unsigned num_threads, unsigned fds_per_thread);
+
 	static px4::AppState appState; /* track requests to terminate app */
 
 private:
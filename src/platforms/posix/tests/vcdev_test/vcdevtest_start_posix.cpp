@@ -41,6 +41,7 @@
 #include <px4_app.h>
 #include <px4_tasks.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 static int daemon_task;             /* Handle of deamon task / thread */
@@ -52,7 +53,7 @@ int vcdevtest_main(int argc, char *argv[])
 {
 
 	if (argc < 2) {
-		printf("usage: vcdevtest {start|stop|status}\n");
+		printf("usage: vcdevtest {start|stop|status|churn [threads] [fds]}\n");
 		return 1;
 	}
 
@@ -79,6 +80,13 @@ int vcdevtest_main(int argc, char *argv[])
 		return 0;
 	}
 
+	if (!strcmp(argv[1], "churn")) {
+		unsigned num_threads = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 8;
+		unsigned fds_per_thread = (argc > 3) ? strtoul(argv[3], nullptr, 10) : 32;
+
+		return VCDevExample::churn(num_threads, fds_per_thread);
+	}
+
 	if (!strcmp(argv[1], "status")) {
 		if (VCDevExample::appState.isRunning()) {
 			printf("is running\n");
@@ -90,6 +98,6 @@ int vcdevtest_main(int argc, char *argv[])
 		return 0;
 	}
 
-	printf("usage: vcdevtest_main {start|stop|status}\n");
+	printf("usage: vcdevtest_main {start|stop|status|churn [threads] [fds]}\n");
 	return 1;
 }
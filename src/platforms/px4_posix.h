@@ -79,6 +79,28 @@ typedef struct pollfd px4_pollfd_struct_t;
 
 #define  PX4_STACK_OVERHEAD	0
 
+typedef struct {
+	px4_pollfd_struct_t	*fds;
+	nfds_t			nfds;
+} px4_pollset_t;
+
+/* NuttX sets up its poll waiters in the kernel, a poll set is a plain poll() */
+static inline int px4_pollset_init(px4_pollset_t *set, px4_pollfd_struct_t *fds, nfds_t nfds)
+{
+	set->fds = fds;
+	set->nfds = nfds;
+	return 0;
+}
+
+static inline int px4_pollset_wait(px4_pollset_t *set, int timeout)
+{
+	return poll(set->fds, set->nfds, timeout);
+}
+
+static inline void px4_pollset_deinit(px4_pollset_t *set)
+{
+}
+
 #elif defined(__PX4_POSIX)
 
 #define  PX4_F_RDONLY O_RDONLY
@@ -99,6 +121,17 @@ typedef struct {
 	void   *priv;     	/* For use by drivers */
 } px4_pollfd_struct_t;
 
+/**
+ * Persistent poll set: the descriptors are registered with their devices
+ * once in px4_pollset_init() and stay registered across waits, so that a
+ * wait does not set up and tear down every descriptor.
+ */
+typedef struct {
+	px4_pollfd_struct_t	*fds;	/* caller owned, must stay valid until px4_pollset_deinit() */
+	nfds_t			nfds;
+	px4_sem_t		sem;	/* posted by the devices, shared by all descriptors */
+} px4_pollset_t;
+
 __BEGIN_DECLS
 
 __EXPORT int 		px4_open(const char *path, int flags, ...);
@@ -108,6 +141,30 @@ __EXPORT ssize_t	px4_write(int fd, const void *buffer, size_t buflen);
 __EXPORT int		px4_ioctl(int fd, int cmd, unsigned long arg);
 __EXPORT int		px4_poll(px4_pollfd_struct_t *fds, nfds_t nfds, int timeout);
 __EXPORT int		px4_fsync(int fd);
+
+/**
+ * Register fds[0..nfds) with their devices. Invalid descriptors are
+ * ignored, as with px4_poll(). A descriptor stays registered until
+ * px4_pollset_deinit(), or until it is closed.
+ *
+ * @return 0 on success, -1 with px4_errno set on failure
+ */
+__EXPORT int		px4_pollset_init(px4_pollset_t *set, px4_pollfd_struct_t *fds, nfds_t nfds);
+
+/**
+ * Wait for events on a poll set. Results are reported in fds[i].revents.
+ * Like poll(), a descriptor stays ready until its state is consumed (for
+ * example by orb_copy()).
+ *
+ * @param timeout	in ms, 0 to return immediately, < 0 to wait forever
+ * @return		number of ready descriptors, 0 on timeout
+ */
+__EXPORT int		px4_pollset_wait(px4_pollset_t *set, int timeout);
+
+/**
+ * Unregister the descriptors of a poll set.
+ */
+__EXPORT void		px4_pollset_deinit(px4_pollset_t *set);
 __EXPORT int		px4_access(const char *pathname, int mode);
 __EXPORT unsigned long	px4_getpid(void);
 
@@ -39,8 +39,13 @@
 
 #include <px4_defines.h>
 #include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <drivers/drv_hrt.h>
 #include "systemlib/err.h"
 #include "systemlib/param/param.h"
+#include "systemlib/bson/tinybson.h"
 #include "tests_main.h"
 
 #define PARAM_MAGIC1 12345678
@@ -108,3 +113,186 @@ test_param(int argc, char *argv[])
 
 	return 0;
 }
+
+#define PARAM_BENCH_FILE	PX4_ROOTFSDIR"/fs/microsd/param_bench.bson"
+#define PARAM_BENCH_BLOCK	512
+
+/**
+ * Write the whole parameter set to the benchmark file, as param_export does for changed parameters.
+ * @param buf staging buffer, or NULL to write every field directly
+ */
+static int
+param_bench_save(uint8_t *buf)
+{
+	struct bson_encoder_s encoder;
+	int fd = open(PARAM_BENCH_FILE, O_WRONLY | O_CREAT | O_TRUNC, PX4_O_MODE_666);
+
+	if (fd < 0) {
+		warnx("cannot open %s", PARAM_BENCH_FILE);
+		return -1;
+	}
+
+	int result = (buf != NULL) ? bson_encoder_init_buf_file(&encoder, fd, buf, PARAM_BENCH_BLOCK)
+		     : bson_encoder_init_file(&encoder, fd);
+
+	for (unsigned i = 0; result == 0 && i < param_count(); i++) {
+		param_t p = param_for_index(i);
+		int32_t val_i;
+		float val_f;
+
+		switch (param_type(p)) {
+		case PARAM_TYPE_INT32:
+			param_get(p, &val_i);
+			result = bson_encoder_append_int(&encoder, param_name(p), val_i);
+			break;
+
+		case PARAM_TYPE_FLOAT:
+			param_get(p, &val_f);
+			result = bson_encoder_append_double(&encoder, param_name(p), val_f);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	if (result == 0) {
+		result = bson_encoder_fini(&encoder);
+	}
+
+	close(fd);
+	return result;
+}
+
+static int
+param_bench_callback(bson_decoder_t decoder, void *private, bson_node_t node)
+{
+	if (node->type == BSON_EOO) {
+		return 0;
+	}
+
+	(*(unsigned *)private)++;
+	return 1;
+}
+
+/**
+ * Read the benchmark file back.
+ * @param buf readahead buffer, or NULL to read every field directly
+ * @return number of parameters read, -1 on error
+ */
+static int
+param_bench_load(uint8_t *buf)
+{
+	struct bson_decoder_s decoder;
+	unsigned nodes = 0;
+	int fd = open(PARAM_BENCH_FILE, O_RDONLY);
+
+	if (fd < 0) {
+		warnx("cannot open %s", PARAM_BENCH_FILE);
+		return -1;
+	}
+
+	int result = (buf != NULL) ? bson_decoder_init_buf_file(&decoder, fd, buf, PARAM_BENCH_BLOCK,
+			param_bench_callback, &nodes)
+		     : bson_decoder_init_file(&decoder, fd, param_bench_callback, &nodes);
+
+	if (result == 0) {
+		do {
+			result = bson_decoder_next(&decoder);
+		} while (result > 0);
+	}
+
+	close(fd);
+	return (result == 0) ? (int)nodes : -1;
+}
+
+int
+test_param_bench(int argc, char *argv[])
+{
+	const unsigned count = param_count();
+	hrt_abstime start;
+
+	/* lookup of every parameter by name, as done by all modules on startup */
+	start = hrt_absolute_time();
+
+	for (unsigned i = 0; i < count; i++) {
+		param_t p = param_for_index(i);
+
+		if (param_find_no_notification(param_name(p)) != p) {
+			warnx("param_find failed for %s", param_name(p));
+			return 1;
+		}
+	}
+
+	hrt_abstime find_time = hrt_elapsed_time(&start);
+
+	/* reference: linear search over all names, the previous param_find implementation */
+	start = hrt_absolute_time();
+	unsigned found = 0;
+
+	for (unsigned i = 0; i < count; i++) {
+		const char *name = param_name(param_for_index(i));
+
+		for (unsigned j = 0; j < count; j++) {
+			if (strcmp(param_name(param_for_index(j)), name) == 0) {
+				found++;
+				break;
+			}
+		}
+	}
+
+	hrt_abstime linear_time = hrt_elapsed_time(&start);
+
+	/* changed value lookup, as done by param_get() */
+	start = hrt_absolute_time();
+	unsigned changed = 0;
+
+	for (unsigned i = 0; i < count; i++) {
+		if (!param_value_is_default(param_for_index(i))) {
+			changed++;
+		}
+	}
+
+	hrt_abstime changed_time = hrt_elapsed_time(&start);
+
+	printf("param bench: %u params (%u changed)\n", count, changed);
+	printf("  param_find (all):        %llu us\n", (unsigned long long)find_time);
+	printf("  linear name search (all): %llu us (%u found)\n", (unsigned long long)linear_time, found);
+	printf("  changed lookup (all):    %llu us\n", (unsigned long long)changed_time);
+
+	/* save and load of the whole set, with a write/read per field and block-buffered */
+	uint8_t block[PARAM_BENCH_BLOCK];
+	hrt_abstime io_time[2][2];
+	int loaded[2];
+
+	for (unsigned buffered = 0; buffered < 2; buffered++) {
+		uint8_t *buf = buffered ? block : NULL;
+
+		start = hrt_absolute_time();
+
+		if (param_bench_save(buf) != 0) {
+			warnx("save failed");
+			return 1;
+		}
+
+		io_time[buffered][0] = hrt_elapsed_time(&start);
+
+		start = hrt_absolute_time();
+		loaded[buffered] = param_bench_load(buf);
+		io_time[buffered][1] = hrt_elapsed_time(&start);
+
+		if (loaded[buffered] < 0) {
+			warnx("load failed");
+			return 1;
+		}
+	}
+
+	unlink(PARAM_BENCH_FILE);
+
+	printf("  save (all, unbuffered):  %llu us\n", (unsigned long long)io_time[0][0]);
+	printf("  save (all, buffered):    %llu us\n", (unsigned long long)io_time[1][0]);
+	printf("  load (all, unbuffered):  %llu us (%d params)\n", (unsigned long long)io_time[0][1], loaded[0]);
+	printf("  load (all, buffered):    %llu us (%d params)\n", (unsigned long long)io_time[1][1], loaded[1]);
+
+	return 0;
+}
@@ -34,10 +34,23 @@
 #include <px4_config.h>
 #include <px4_posix.h>
 
+#include <string.h>
+
 #include <systemlib/perf_counter.h>
 
 #include "tests_main.h"
 
+static void
+test_perf_find_cb(perf_counter_t handle, void *user)
+{
+	struct perf_counter_summary summary;
+	perf_get_summary(handle, &summary);
+
+	if (strcmp(summary.name, "test_histogram") == 0) {
+		(*(unsigned *)user)++;
+	}
+}
+
 int
 test_perf(int argc, char *argv[])
 {
@@ -65,5 +78,51 @@ test_perf(int argc, char *argv[])
 	perf_free(cc);
 	perf_free(ec);
 
+	perf_counter_t hc = perf_alloc(PC_HISTOGRAM, "test_histogram");
+
+	if (hc == NULL) {
+		printf("perf: histogram alloc failed\n");
+		return 1;
+	}
+
+	for (int i = 1; i <= 1000; i++) {
+		perf_set_elapsed(hc, i);
+	}
+
+	/* percentiles are bucket upper bounds, at most 12.5% above the exact value */
+	uint64_t p50 = perf_percentile(hc, 0.5f);
+	uint64_t p99 = perf_percentile(hc, 0.99f);
+
+	if (perf_event_count(hc) != 1000 || p50 < 500 || p50 > 563 || p99 < 990 || p99 > 1000) {
+		printf("perf: histogram percentiles wrong (p50 %llu, p99 %llu)\n",
+		       (unsigned long long)p50, (unsigned long long)p99);
+		perf_free(hc);
+		return 1;
+	}
+
+	printf("perf: expect 1000 events, p50 about 500us, p99 about 990us\n");
+	perf_print_counter(hc);
+
+	struct perf_counter_summary summary;
+	perf_get_summary(hc, &summary);
+
+	if (summary.type != PC_HISTOGRAM || summary.event_count != 1000 || summary.time_avg != 500 ||
+	    summary.time_max != 1000 || summary.time_p99 != p99) {
+		printf("perf: histogram summary wrong\n");
+		perf_free(hc);
+		return 1;
+	}
+
+	unsigned found = 0;
+	perf_iterate_all(test_perf_find_cb, &found);
+
+	if (found != 1) {
+		printf("perf: iterating found the counter %u times\n", found);
+		perf_free(hc);
+		return 1;
+	}
+
+	perf_free(hc);
+
 	return OK;
 }
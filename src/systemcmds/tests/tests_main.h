@@ -71,6 +71,7 @@ extern int	test_matrix(int argc, char *argv[]);
 extern int	test_mixer(int argc, char *argv[]);
 extern int	test_mount(int argc, char *argv[]);
 extern int	test_param(int argc, char *argv[]);
+extern int	test_param_bench(int argc, char *argv[]);
 extern int	test_perf(int argc, char *argv[]);
 extern int	test_ppm(int argc, char *argv[]);
 extern int	test_ppm_loopback(int argc, char *argv[]);
@@ -1,6 +1,9 @@
 #include <systemlib/visibility.h>
 #include <systemlib/param/param.h>
 
+#include <stdio.h>
+#include <unistd.h>
+
 #include "gtest/gtest.h"
 
 /*
@@ -152,3 +155,51 @@ TEST(ParamTest, ResetAllExcludesWildcard)
 	_assert_parameter_int_value((param_t)2, 50);
 	_assert_parameter_int_value((param_t)3, 50);
 }
+
+TEST(ParamTest, JournalSaveLoad)
+{
+	_add_parameters();
+	param_reset_all();
+
+	unlink("param_test_file");
+	unlink("param_test_file.journal");
+	param_set_default_file("param_test_file");
+
+	// first save writes the snapshot, the next ones append to the journal
+	int32_t value = 50;
+	param_set((param_t)0, &value);
+	ASSERT_EQ(0, param_save_default());
+	ASSERT_NE(0, access("param_test_file.journal", F_OK));
+
+	value = 60;
+	param_set((param_t)1, &value);
+	ASSERT_EQ(0, param_save_default());
+	ASSERT_EQ(0, access("param_test_file.journal", F_OK));
+
+	// a torn record at the end of the journal is ignored
+	FILE *journal = fopen("param_test_file.journal", "a");
+	ASSERT_NE(nullptr, journal);
+	fputs("torn", journal);
+	fclose(journal);
+
+	param_reset_all();
+	ASSERT_EQ(0, param_load_default());
+
+	_assert_parameter_int_value((param_t)0, 50);
+	_assert_parameter_int_value((param_t)1, 60);
+	_assert_parameter_int_value((param_t)2, 8);
+
+	// after a reset the next save writes a new snapshot
+	param_reset((param_t)0);
+	ASSERT_EQ(0, param_save_default());
+	ASSERT_NE(0, access("param_test_file.journal", F_OK));
+
+	param_reset_all();
+	ASSERT_EQ(0, param_load_default());
+
+	_assert_parameter_int_value((param_t)0, 2);
+	_assert_parameter_int_value((param_t)1, 60);
+
+	unlink("param_test_file");
+	param_set_default_file(NULL);
+}